@@ -1,10 +1,20 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <limits.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "easel.h"
 #include "esl_alphabet.h"
 #include "esl_distance.h"
 #include "esl_msa.h"
 #include "esl_msafile.h"
+#include "esl_random.h"
 #include "esl_sq.h"
 #include "esl_sqio.h"
+#include "esl_ssi.h"
 #include "esl_vectorops.h"
 #include "esl_wuss.h"
 #include "esl_msaweight.h"
@@ -50,6 +60,47 @@ void _c_int_copy_array_perl_to_c (AV *perlAR, int *cA, int len)
   return;
 }
 
+/* Function:  _c_packed_doubles()
+ * Synopsis:  Create a new string SV holding <n> native doubles
+ *            copied from <valA>, compatible with Perl's 
+ *            unpack("d*", ...) and with a PDL double piddle's data.
+ *            Used to return per-position statistics without 
+ *            creating one SV per position.
+ * Returns:   new SV, caller must mortalize it
+ */
+SV *_c_packed_doubles(const double *valA, int n)
+{
+  SV *packedSV = newSV(sizeof(double) * ESL_MAX(1, n));
+
+  SvPOK_only(packedSV);
+  if(n > 0) memcpy(SvPVX(packedSV), valA, sizeof(double) * n);
+  SvCUR_set(packedSV, sizeof(double) * n);
+  SvPVX(packedSV)[SvCUR(packedSV)] = '\0';
+
+  return packedSV;
+}
+
+/* Function:  _c_packed_int32s()
+ * Synopsis:  Create a new string SV holding <n> native 32-bit ints
+ *            converted from <valA>, compatible with Perl's 
+ *            unpack("l*", ...) and with a PDL long piddle's data.
+ * Returns:   new SV, caller must mortalize it
+ */
+SV *_c_packed_int32s(const int *valA, int n)
+{
+  SV      *packedSV = newSV(sizeof(int32_t) * ESL_MAX(1, n));
+  int32_t *dest;
+  int      i;
+
+  SvPOK_only(packedSV);
+  dest = (int32_t *) SvPVX(packedSV);
+  for(i = 0; i < n; i++) dest[i] = (int32_t) valA[i];
+  SvCUR_set(packedSV, sizeof(int32_t) * n);
+  SvPVX(packedSV)[SvCUR(packedSV)] = '\0';
+
+  return packedSV;
+}
+
 /* Function:  _c_read_msa()
  * Incept:    EPN, Sat Feb  2 14:14:20 2013
  * Synopsis:  Open a alignment file, read an msa, and close the file.
@@ -127,6 +178,153 @@ void _c_read_msa (char *infile, char *reqdFormat, int digitize, int is_rna, int
   return;
 }    
 
+/* Function:  _c_create_ssi_index()
+ * Synopsis:  Create an SSI index file <infile>.ssi for a (possibly
+ *            multi-MSA) alignment file. Each MSA is indexed by its
+ *            name (#=GF ID) with its accession (#=GF AC), if any,
+ *            as an alias. Based on easel's miniapps/esl-afetch.c::create_ssi_index.
+ * Args:      infile: name of alignment file to index, must be a
+ *                    regular (not gzipped) file
+ * Returns:   number of MSAs indexed
+ * Dies:      via croak with informative error message upon an error,
+ *            including if any MSA lacks a name.
+ */
+
+int _c_create_ssi_index (char *infile)
+{
+  int          status;          /* Easel status code */
+  ESL_MSAFILE *afp     = NULL;  /* open alignment file, text mode */
+  ESL_MSA     *msa     = NULL;  /* an alignment */
+  ESL_NEWSSI  *ns      = NULL;  /* the new SSI index */
+  char        *ssifile = NULL;  /* name of SSI file */
+  uint16_t     fh;              /* file handle SSI associates with infile */
+  int          nali    = 0;     /* number of MSAs indexed */
+
+  if ((status = esl_msafile_Open(NULL, infile, NULL, eslMSAFILE_UNKNOWN, NULL, &afp)) != eslOK) { 
+    croak("Error opening alignment file %s: %s\n", infile, (afp != NULL) ? afp->errmsg : "unknown error");
+  }
+  if (afp->bf->mode_is != eslBUFFER_FILE && afp->bf->mode_is != eslBUFFER_ALLFILE && afp->bf->mode_is != eslBUFFER_MMAP) { 
+    croak("can't create SSI index for alignment file %s, it must be a regular (not gzipped) file", infile);
+  }
+
+  esl_strdup(infile, -1, &ssifile);
+  esl_strcat(&ssifile, -1, ".ssi", 4);
+  status = esl_newssi_Open(ssifile, TRUE, &ns); /* TRUE is for allowing overwrite. */
+  if      (status == eslENOTFOUND)   croak("failed to open SSI index %s", ssifile);
+  else if (status == eslEOVERWRITE)  croak("SSI index %s already exists; delete or rename it", ssifile); /* won't happen, see TRUE above... */
+  else if (status != eslOK)          croak("failed to create a new SSI index");
+
+  if (esl_newssi_AddFile(ns, infile, afp->format, &fh) != eslOK)
+    croak("Failed to add alignment file %s to new SSI index\n", infile);
+
+  while ((status = esl_msafile_Read(afp, &msa)) == eslOK)
+    {
+      nali++;
+      if (msa->name == NULL) croak("Every alignment must have a name (#=GF ID) to be indexed. Failed to find name of alignment #%d\n", nali);
+
+      if (esl_newssi_AddKey(ns, msa->name, fh, msa->offset, 0, 0) != eslOK)
+        croak("Failed to add key %s to SSI index", msa->name);
+
+      if (msa->acc != NULL) {
+        if (esl_newssi_AddAlias(ns, msa->acc, msa->name) != eslOK)
+          croak("Failed to add secondary key %s to SSI index", msa->acc);
+      }
+      esl_msa_Destroy(msa);
+      msa = NULL;
+    }
+  if (status != eslEOF) croak("Alignment file %s read failed with error code %d: %s\n", infile, status, afp->errmsg);
+
+  /* Save the SSI file to disk */
+  if (esl_newssi_Write(ns) != eslOK)  croak("Failed to write keys to ssi file %s\n", ssifile);
+
+  free(ssifile);
+  esl_newssi_Close(ns);
+  esl_msafile_Close(afp);
+
+  return nali;
+}    
+
+/* Function:  _c_read_msa_given_name()
+ * Synopsis:  Open an alignment file and its SSI index, position
+ *            the file at the MSA named (or with accession) <key>, read
+ *            only that MSA, and close the file.
+ * Args:      infile:     name of alignment file, <infile>.ssi must exist
+ *            key:        name or accession of the MSA to read
+ *            reqdFormat: required format, "unknown" for no specific format required
+ *            digitize:   '1' to read alignment in digital mode, '0' to read in text mode
+ *            is_rna:     '1' to force RNA alphabet
+ *            is_dna:     '1' to force DNA alphabet
+ *            is_amino:   '1' to force amino alphabet
+ *            (see _c_read_msa() for restrictions on these)
+ * 
+ * Returns:   an ESL_MSA and a string describing it's format
+ * Dies:      via croak if SSI index can't be opened, <key> is not
+ *            in the index, the MSA can't be read, or the MSA read
+ *            has neither name nor accession <key> (stale index).
+ */
+
+void _c_read_msa_given_name (char *infile, char *key, char *reqdFormat, int digitize, int is_rna, int is_dna, int is_amino)
+{
+  Inline_Stack_Vars;
+
+  int           status;         /* Easel status code */
+  ESL_MSAFILE  *afp     = NULL; /* open input alignment file */
+  ESL_MSA      *msa     = NULL; /* the alignment */
+  ESL_ALPHABET *abc     = NULL; /* alphabet for MSA, see _c_read_msa() */
+  char         *ssifile = NULL; /* name of SSI file */
+  int           fmt;            /* int code for format string */
+  char         *actual_format = NULL; /* string describing format of file, e.g. "Stockholm" */
+
+  if(is_rna && is_dna)   croak("Error in _c_read_msa_given_name, is_rna and is_dna are both true");
+  if(is_rna && is_amino) croak("Error in _c_read_msa_given_name, is_rna and is_amino are both true");
+  if(is_dna && is_amino) croak("Error in _c_read_msa_given_name, is_dna and is_amino are both true");
+  if((is_rna || is_dna || is_amino) && (! digitize)) { 
+    croak("Error in _c_read_msa_given_name, alphabet is specified by digitize is FALSE");
+  }
+
+  fmt = esl_msafile_EncodeFormat(reqdFormat);
+  
+  if      (is_rna)   abc = esl_alphabet_Create(eslRNA);
+  else if (is_dna)   abc = esl_alphabet_Create(eslDNA);
+  else if (is_amino) abc = esl_alphabet_Create(eslAMINO); 
+
+  if ((status = esl_msafile_Open((digitize) ? &abc : NULL, infile, NULL, fmt, NULL, &afp)) != eslOK) { 
+    croak("Error reading alignment file %s: %s\n", infile, (afp != NULL) ? afp->errmsg : "unknown error");
+  }
+
+  /* open the SSI index and position the file at the MSA */
+  esl_strdup(infile, -1, &ssifile);
+  esl_strcat(&ssifile, -1, ".ssi", 4);
+  status = esl_ssi_Open(ssifile, &(afp->ssi));
+  if      (status == eslENOTFOUND) croak("SSI index %s does not exist\n", ssifile);
+  else if (status == eslEFORMAT)   croak("SSI index %s is in incorrect format\n", ssifile);
+  else if (status == eslERANGE)    croak("SSI index %s is in 64-bit format and we can't read it\n", ssifile);
+  else if (status != eslOK)        croak("Failed to open SSI index %s\n", ssifile);
+  free(ssifile);
+
+  status = esl_msafile_PositionByKey(afp, key);
+  if      (status == eslENOTFOUND) croak("MSA %s not found in SSI index for %s\n", key, infile);
+  else if (status == eslEFORMAT)   croak("Failed to parse SSI index for %s\n", infile);
+  else if (status != eslOK)        croak("Failed to look up location of MSA %s in SSI index of %s\n", key, infile);
+
+  status = esl_msafile_Read(afp, &msa);
+  if(status != eslOK) croak("Alignment file %s read failed with error code %d\n", infile, status);
+  if((msa->name == NULL || strcmp(msa->name, key) != 0) && (msa->acc == NULL || strcmp(msa->acc, key) != 0)) { 
+    croak("whoa, internal error; found the wrong MSA %s, not %s; is SSI index for %s out of date?\n", (msa->name != NULL) ? msa->name : "(unnamed)", key, infile);
+  }
+  
+  actual_format = esl_msafile_DecodeFormat(afp->format);
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(perl_obj(msa, "ESL_MSA"));
+  Inline_Stack_Push(newSVpvn(actual_format, strlen(actual_format)));
+  Inline_Stack_Done;
+
+  esl_msafile_Close(afp); /* closes afp->ssi too */
+
+  Inline_Stack_Return(2);
+}    
+
 /* Function:  _c_write_msa()
  * Incept:    EPN, Sat Feb  2 14:23:28 2013
  * Synopsis:  Open an output file, write an msa, and close the file.
@@ -263,6 +461,217 @@ int _c_write_single_unaligned_seq(ESL_MSA *msa, int idx, char *outfile, int do_a
   return eslOK;
 }
 
+/* Copy-on-write clones. _c_clone_msa_cow() makes a clone that points
+ * to its parent's aligned rows (ax or aseq), per-sequence SS, SA and
+ * PP rows and per-column RF, MM, SS_cons, SA_cons and PP_cons strings
+ * instead of copying them. Every buffer pointed to by more than one
+ * MSA has an entry in <bemsa_cow>, keyed by its address, holding the
+ * number of MSAs that point to it; a buffer with no entry belongs to
+ * a single MSA. Functions that write into one of these buffers first
+ * call bemsa_cow_own() (one buffer) or bemsa_cow_own_all() (all of
+ * them), which replace a shared buffer with a private copy, and
+ * _c_free_msa() releases an MSA's shared buffers before
+ * esl_msa_Destroy() frees the rest. Functions that only permute row
+ * pointers, like _c_reorder(), need nothing because the table is
+ * keyed by address. The table is empty unless a clone is sharing
+ * something, and all of these functions return immediately then.
+ */
+typedef struct {
+  void   **keyA;   /* [0..h..nalloc-1] shared buffer in slot h, NULL if slot is empty */
+  int     *cntA;   /* [0..h..nalloc-1] number of MSAs pointing to keyA[h], always >= 2 */
+  int64_t  nalloc; /* number of slots, 0 or a power of 2 */
+  int64_t  n;      /* number of used slots */
+} BEMSA_COW_TABLE;
+
+static BEMSA_COW_TABLE bemsa_cow = { NULL, NULL, 0, 0 };
+
+/* home slot of buffer <p> in a table with <nalloc> slots */
+static int64_t bemsa_cow_home(const void *p, int64_t nalloc)
+{
+  uint64_t h = (uint64_t) (uintptr_t) p;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (int64_t) (h & (uint64_t) (nalloc-1));
+}
+
+/* slot holding <p>, or the empty slot where it would go (linear probing) */
+static int64_t bemsa_cow_slot(const void *p)
+{
+  int64_t h = bemsa_cow_home(p, bemsa_cow.nalloc);
+  while(bemsa_cow.keyA[h] != NULL && bemsa_cow.keyA[h] != p) h = (h+1) & (bemsa_cow.nalloc-1);
+  return h;
+}
+
+/* double the size of the table, keeping it at most half full */
+static void bemsa_cow_grow(void)
+{
+  int      status;
+  void   **old_keyA   = bemsa_cow.keyA;
+  int     *old_cntA   = bemsa_cow.cntA;
+  int64_t  old_nalloc = bemsa_cow.nalloc;
+  int64_t  h, g;
+
+  bemsa_cow.nalloc = (old_nalloc == 0) ? 1024 : old_nalloc * 2;
+  bemsa_cow.keyA   = NULL;
+  bemsa_cow.cntA   = NULL;
+  ESL_ALLOC(bemsa_cow.keyA, sizeof(void *) * bemsa_cow.nalloc);
+  ESL_ALLOC(bemsa_cow.cntA, sizeof(int)    * bemsa_cow.nalloc);
+  for(h = 0; h < bemsa_cow.nalloc; h++) bemsa_cow.keyA[h] = NULL;
+  for(h = 0; h < old_nalloc; h++) { 
+    if(old_keyA[h] != NULL) { 
+      g = bemsa_cow_slot(old_keyA[h]);
+      bemsa_cow.keyA[g] = old_keyA[h];
+      bemsa_cow.cntA[g] = old_cntA[h];
+    }
+  }
+  if(old_keyA != NULL) free(old_keyA);
+  if(old_cntA != NULL) free(old_cntA);
+  return;
+
+ ERROR:
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* another MSA now points to <p> */
+static void bemsa_cow_ref(void *p)
+{
+  int64_t h;
+
+  if(p == NULL) return;
+  if((bemsa_cow.n+1) * 2 > bemsa_cow.nalloc) bemsa_cow_grow();
+  h = bemsa_cow_slot(p);
+  if(bemsa_cow.keyA[h] == NULL) { 
+    bemsa_cow.keyA[h] = p;
+    bemsa_cow.cntA[h] = 2;
+    bemsa_cow.n++;
+  }
+  else bemsa_cow.cntA[h]++;
+  return;
+}
+
+/* an MSA no longer points to <p>; returns TRUE if <p> was shared, in
+ * which case the caller must not free or write it, else FALSE (the
+ * caller was the only owner). The entry is removed when one owner is
+ * left, using backward shift deletion so no tombstones are needed. */
+static int bemsa_cow_unref(void *p)
+{
+  int64_t h, i, j, k;
+  int64_t mask = bemsa_cow.nalloc-1;
+
+  if(p == NULL || bemsa_cow.n == 0) return FALSE;
+  h = bemsa_cow_slot(p);
+  if(bemsa_cow.keyA[h] == NULL) return FALSE;
+  if(--bemsa_cow.cntA[h] > 1)   return TRUE;
+
+  i = h;
+  bemsa_cow.keyA[i] = NULL;
+  for(j = (i+1) & mask; bemsa_cow.keyA[j] != NULL; j = (j+1) & mask) { 
+    k = bemsa_cow_home(bemsa_cow.keyA[j], bemsa_cow.nalloc);
+    /* leave keyA[j] if its home slot is cyclically in (i, j] */
+    if((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) continue;
+    bemsa_cow.keyA[i] = bemsa_cow.keyA[j];
+    bemsa_cow.cntA[i] = bemsa_cow.cntA[j];
+    bemsa_cow.keyA[j] = NULL;
+    i = j;
+  }
+  bemsa_cow.n--;
+  return TRUE;
+}
+
+/* return a buffer the caller can write: <p> itself if it is not shared,
+ * else a private copy of its first <size> bytes */
+static void *bemsa_cow_own(void *p, size_t size)
+{
+  int   status;
+  void *q = NULL;
+
+  if(p == NULL || bemsa_cow.n == 0 || (! bemsa_cow_unref(p))) return p;
+  ESL_ALLOC(q, size);
+  memcpy(q, p, size);
+  return q;
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* free <p> unless it is shared, in which case drop a reference to it */
+static void bemsa_cow_free(void *p)
+{
+  if(p != NULL && (! bemsa_cow_unref(p))) free(p);
+  return;
+}
+
+/* make every shared buffer of <msa> private, before an in place
+ * edit of its rows or columns */
+static void bemsa_cow_own_all(ESL_MSA *msa)
+{
+  int i;
+
+  if(bemsa_cow.n == 0) return;
+  for(i = 0; i < msa->nseq; i++) { 
+    if(msa->flags & eslMSA_DIGITAL) msa->ax[i]   = bemsa_cow_own(msa->ax[i],   msa->alen+2);
+    else                            msa->aseq[i] = bemsa_cow_own(msa->aseq[i], msa->alen+1);
+    if(msa->ss != NULL) msa->ss[i] = bemsa_cow_own(msa->ss[i], msa->alen+1);
+    if(msa->sa != NULL) msa->sa[i] = bemsa_cow_own(msa->sa[i], msa->alen+1);
+    if(msa->pp != NULL) msa->pp[i] = bemsa_cow_own(msa->pp[i], msa->alen+1);
+  }
+  msa->rf      = bemsa_cow_own(msa->rf,      msa->alen+1);
+  msa->mm      = bemsa_cow_own(msa->mm,      msa->alen+1);
+  msa->ss_cons = bemsa_cow_own(msa->ss_cons, msa->alen+1);
+  msa->sa_cons = bemsa_cow_own(msa->sa_cons, msa->alen+1);
+  msa->pp_cons = bemsa_cow_own(msa->pp_cons, msa->alen+1);
+  return;
+}
+
+/* drop <msa>'s references to its shared buffers and set its pointers
+ * to them to NULL, so esl_msa_Destroy() frees only what it owns */
+static void bemsa_cow_release(ESL_MSA *msa)
+{
+  int i;
+
+  if(bemsa_cow.n == 0) return;
+  for(i = 0; i < msa->nseq; i++) { 
+    if(msa->ax   != NULL && bemsa_cow_unref(msa->ax[i]))   msa->ax[i]   = NULL;
+    if(msa->aseq != NULL && bemsa_cow_unref(msa->aseq[i])) msa->aseq[i] = NULL;
+    if(msa->ss   != NULL && bemsa_cow_unref(msa->ss[i]))   msa->ss[i]   = NULL;
+    if(msa->sa   != NULL && bemsa_cow_unref(msa->sa[i]))   msa->sa[i]   = NULL;
+    if(msa->pp   != NULL && bemsa_cow_unref(msa->pp[i]))   msa->pp[i]   = NULL;
+  }
+  if(bemsa_cow_unref(msa->rf))      msa->rf      = NULL;
+  if(bemsa_cow_unref(msa->mm))      msa->mm      = NULL;
+  if(bemsa_cow_unref(msa->ss_cons)) msa->ss_cons = NULL;
+  if(bemsa_cow_unref(msa->sa_cons)) msa->sa_cons = NULL;
+  if(bemsa_cow_unref(msa->pp_cons)) msa->pp_cons = NULL;
+  return;
+}
+
+/* a new array of <nalloc> strings, the first <n> of which point to
+ * (if <do_share>) or are copies of (if ! <do_share>) those in <sA>;
+ * NULL if <sA> is NULL */
+static char **bemsa_cow_strarray(char **sA, int n, int nalloc, int do_share)
+{
+  int    status;
+  char **newA = NULL;
+  int    i;
+
+  if(sA == NULL) return NULL;
+  ESL_ALLOC(newA, sizeof(char *) * nalloc);
+  for(i = 0; i < nalloc; i++) newA[i] = NULL;
+  for(i = 0; i < n; i++) { 
+    if(sA[i] == NULL) continue;
+    if(do_share) { newA[i] = sA[i]; bemsa_cow_ref(sA[i]); }
+    else if(esl_strdup(sA[i], -1, &(newA[i])) != eslOK) goto ERROR;
+  }
+  return newA;
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
 /* Function:  _c_free_msa()
  * Incept:    EPN, Sat Feb  2 14:33:15 2013
  * Synopsis:  Free an MSA.
@@ -270,6 +679,7 @@ int _c_write_single_unaligned_seq(ESL_MSA *msa, int idx, char *outfile, int do_a
  */
 void _c_free_msa (ESL_MSA *msa)
 {
+  bemsa_cow_release(msa);
   esl_msa_Destroy(msa);
   return;
 }
@@ -379,7 +789,7 @@ void _c_set_rf (ESL_MSA *msa, char *rfstr)
 {
   int rflen = strlen(rfstr);
   if(rflen != msa->alen) croak("_c_set_rf() trying to set RF with string of incorrect length");
-  if(msa->rf) free(msa->rf);
+  bemsa_cow_free(msa->rf);
 
   esl_strdup(rfstr, rflen, &(msa->rf));
   return;
@@ -407,7 +817,7 @@ void _c_set_ss_cons (ESL_MSA *msa, char *ss_cons_str, int do_full_wuss)
   int status;
   int ss_cons_len = strlen(ss_cons_str);
   if(ss_cons_len != msa->alen) croak("_c_set_ss_cons() trying to set SS_cons with string of incorrect length");
-  if(msa->ss_cons) free(msa->ss_cons);
+  bemsa_cow_free(msa->ss_cons);
 
   esl_strdup(ss_cons_str, ss_cons_len, &(msa->ss_cons));
   if(do_full_wuss) { 
@@ -431,6 +841,7 @@ void _c_set_blank_ss_cons (ESL_MSA *msa)
   if(msa->ss_cons == NULL) { 
     ESL_ALLOC(msa->ss_cons, sizeof(char) * (msa->alen+1)); 
   }
+  else msa->ss_cons = bemsa_cow_own(msa->ss_cons, msa->alen+1);
   for(i = 0; i < msa->alen; i++) { 
     msa->ss_cons[i] = '.';
   }
@@ -447,13 +858,16 @@ void _c_set_blank_ss_cons (ESL_MSA *msa)
  * Incept:    EPN, Mon Jul  7 09:34:01 2014
  * Synopsis:  Return a 'CT' array describing the consensus secondary structure
  *            for the alignment.
- * Args:      msa: the alignment
+ * Args:      msa:       the alignment
+ *            do_packed: '1' to return the array as a single string of
+ *                       packed int32s (see _c_packed_int32s()), '0' to
+ *                       return it as a list
  * Returns:   a ct[] array, [1..alen]:
  *            ct[i] is the position that position 'i' pairs to
  *                  or '0' if position 'i' is unpaired.
  * Dies:      with croak, if we can't make a CT array for some reason
  */
-void _c_get_ss_cons_ct (ESL_MSA *msa)
+void _c_get_ss_cons_ct (ESL_MSA *msa, int do_packed)
 {
   Inline_Stack_Vars;
 
@@ -472,16 +886,20 @@ void _c_get_ss_cons_ct (ESL_MSA *msa)
     croak("ERROR in _c_get_ss_cons_ct(), problem converting SS_cons to CT array"); 
   }
 
-  /* calculate sequence conservation, and fill return array */
+  /* fill return array */
   Inline_Stack_Reset;
-  for(apos = 0; apos <= msa->alen; apos++) { 
-    Inline_Stack_Push(newSViv(ct[apos])); 
+  if(do_packed) { 
+    Inline_Stack_Push(sv_2mortal(_c_packed_int32s(ct, msa->alen+1)));
+  }
+  else { 
+    for(apos = 0; apos <= msa->alen; apos++) { 
+      Inline_Stack_Push(sv_2mortal(newSViv(ct[apos]))); 
+    }
   }
   Inline_Stack_Done;
-  Inline_Stack_Return(msa->alen+1);
 
-  if(ct) free(ct);
-  return;
+  free(ct);
+  Inline_Stack_Return(do_packed ? 1 : msa->alen+1);
 
  ERROR: 
   croak("out of memory");
@@ -652,145 +1070,1010 @@ int _c_any_allgap_columns (ESL_MSA *msa, char *gapstr)
   return FALSE;
 }   
 
-/* Function:  _c_average_id()
- * Incept:    EPN, Sat Feb  2 14:38:18 2013
- * Purpose:   Calculate and return average fractional identity of 
- *            an alignment. If more than max_nseq sequences exist
- *            take a sample of (max_nseq)^2 pairs and return the 
- *            average fractional identity of those.
- * Returns:   Average fractional identity.
+/* Pairwise identities for many pairs at once are computed by a
+ * BEMSA_PID 'engine'. For digital MSAs it holds per-sequence bit
+ * vectors ('bitplanes'), one per canonical residue: bit p of plane k
+ * of sequence i is set if ax[i][p+1] == k. The number of identities
+ * between two sequences is then the popcount of the AND of their
+ * planes, computed over K * (alen/64) words instead of alen byte
+ * comparisons. Identities are defined exactly as in esl_dst_XPairId():
+ * identical canonical residues divided by the canonical length of the
+ * shorter sequence. Text MSAs use esl_dst_CPairId().
+ *
+ * _c_pid_fill() computes rows of identities with <nthreads> POSIX
+ * threads, each claiming the next unfinished row until none remain.
+ * Each value is computed independently, and callers reduce the filled
+ * rows serially in the same order as the original double loops, so
+ * results do not depend on the number of threads.
  */
-float _c_average_id(ESL_MSA *msa, int max_nseq) 
+#if defined(__GNUC__) || defined(__clang__)
+#define bemsa_popcount64(x) __builtin_popcountll(x)
+#else
+static int bemsa_popcount64(uint64_t x)
 {
-  double avgid;
-  
-  if(msa->flags & eslMSA_DIGITAL) { 
-    esl_dst_XAverageId(msa->abc, msa->ax, msa->nseq, (max_nseq * max_nseq), &avgid);
-  }
-  else { 
-    esl_dst_CAverageId(msa->aseq, msa->nseq, (max_nseq * max_nseq), &avgid);
-  }
-  return (float) avgid;
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (int) ((x * 0x0101010101010101ULL) >> 56);
 }
-
-/* Function:  _c_get_sqstring_aligned()
- * Incept:    EPN, Fri May 24 11:03:49 2013
- * Purpose:   Return aligned sequence <seqidx>.
- * Returns:   Aligned sequence <seqidx>.
+#endif
+
+/* maximum number of doubles in the row buffer used by the tiled
+ * all-pairs reductions, _c_rfam_pid_stats() and _c_average_id() */
+#define BEMSA_PID_TILE_NDBL 4194304
+
+typedef struct {
+  ESL_MSA  *msa;     /* the alignment, not owned */
+  int       nseq;    /* number of sequences compared */
+  const int     *seqA;  /* [0..i..nseq-1] index in <msa> of seq i, NULL if all seqs, not owned */
+  const int64_t *colA;  /* [0..c..ncol-1] index in <msa> of column c, NULL if all columns, not owned */
+  int64_t   ncol;    /* number of columns compared */
+  int       K;       /* alphabet size, digital mode only */
+  int       nw;      /* number of 64-bit words per bitplane, digital mode only */
+  uint64_t *planes;  /* [0..i*K*nw + k*nw + w..nseq*K*nw-1] the bitplanes, NULL in text mode */
+  int      *lenA;    /* [0..i..nseq-1] number of canonical residues in seq i, NULL in text mode */
+} BEMSA_PID;
+
+typedef struct {
+  BEMSA_PID       *pid;     /* the engine */
+  const int       *rowA;    /* [0..r..nrows-1] sequence index for row r */
+  int              nrows;   /* number of rows */
+  int              upper;   /* TRUE to only fill columns j > rowA[r] */
+  double          *mx;      /* [0..r*nseq+j..nrows*nseq-1] the rows to fill */
+  int              next;    /* next row to claim, protected by <mutex> */
+  int              nerr;    /* number of failed comparisons, protected by <mutex> */
+  pthread_mutex_t  mutex;   
+} BEMSA_PID_WORK;
+
+/* Function: _c_pid_create_view
+ * Purpose:  Create a pairwise identity engine for <nseq> sequences
+ *           <seqA> and <ncol> columns <colA> of <msa>, without 
+ *           copying the alignment; identities are those of the 
+ *           corresponding subset MSA. Sequence i of the engine is
+ *           seqA[i] of <msa>. <seqA> and <colA> must remain valid
+ *           for the life of the engine; either may be NULL for all
+ *           sequences or columns. In digital mode this creates the
+ *           residue bitplanes (see above) and canonical lengths 
+ *           for all sequences.
+ *
+ * Returns:  newly allocated BEMSA_PID, free with _c_pid_destroy()
+ * Dies:     if out of memory
  */
-SV *_c_get_sqstring_aligned(ESL_MSA *msa, int seqidx)
+BEMSA_PID *
+_c_pid_create_view(ESL_MSA *msa, const int *seqA, int nseq, const int64_t *colA, int64_t ncol)
 {
-  int status;
-  SV *seqstringSV;  /* SV version of msa->ax[->seq */
-  char *seqstring;
-
-  ESL_ALLOC(seqstring, sizeof(char) * (msa->alen + 1));
-  if(msa->flags & eslMSA_DIGITAL) { 
-    if((status = esl_abc_Textize(msa->abc, msa->ax[seqidx], msa->alen, seqstring)) != eslOK) croak("failed to textize digitized aligned sequence");
+  int        status;
+  BEMSA_PID *pid = NULL;
+  uint64_t  *row;
+  ESL_DSQ   *ax;
+  int64_t    c;
+  int        i;
+  ESL_DSQ    x;
+
+  ESL_ALLOC(pid, sizeof(BEMSA_PID));
+  pid->msa    = msa;
+  pid->nseq   = nseq;
+  pid->seqA   = seqA;
+  pid->colA   = colA;
+  pid->ncol   = ncol;
+  pid->K      = 0;
+  pid->nw     = 0;
+  pid->planes = NULL;
+  pid->lenA   = NULL;
+  if(! (msa->flags & eslMSA_DIGITAL)) return pid;
+
+  pid->K  = msa->abc->K;
+  pid->nw = (ncol + 63) / 64;
+  ESL_ALLOC(pid->planes, sizeof(uint64_t) * ESL_MAX(1, (size_t) nseq * pid->K * pid->nw));
+  ESL_ALLOC(pid->lenA,   sizeof(int)      * ESL_MAX(1, nseq));
+  memset(pid->planes, 0, sizeof(uint64_t) * ESL_MAX(1, (size_t) nseq * pid->K * pid->nw));
+
+  for(i = 0; i < nseq; i++) { 
+    row          = pid->planes + (size_t) i * pid->K * pid->nw;
+    ax           = msa->ax[(seqA == NULL) ? i : seqA[i]];
+    pid->lenA[i] = 0;
+    for(c = 0; c < ncol; c++) { 
+      x = ax[((colA == NULL) ? c : colA[c]) + 1];
+      if(x < pid->K) { 
+        row[x * pid->nw + (c / 64)] |= ((uint64_t) 1) << (c % 64);
+        pid->lenA[i]++;
+      }
+    }
   }
-  else { /* text mode */
-    if((status = esl_strdup(msa->aseq[seqidx], msa->alen, &seqstring)) != eslOK) croak("failed to duplicate text aligned sequence");
-  }    
-
-  seqstringSV = newSVpv(seqstring, msa->alen);
-  free(seqstring);
-
-  return seqstringSV;
+  return pid;
 
  ERROR: 
   croak("out of memory");
-  return NULL;
+  return NULL; /* NEVER REACHED */
 }
 
-/* Function:  _c_set_sqstring_aligned()
- * Incept:    EPN, Fri Feb 19 06:55:52 2021
- * Purpose:   Set aligned sequence <seqidx> to <seqstring>.
- * Returns:   void
- * Dies:      if len(seqstring) != alen
- *            if msa is digitized and unable to digitize string
+/* Function: _c_pid_create
+ * Purpose:  Create a pairwise identity engine for all sequences
+ *           and columns of <msa>, with _c_pid_create_view().
+ *
+ * Returns:  newly allocated BEMSA_PID, free with _c_pid_destroy()
+ * Dies:     if out of memory
  */
-void _c_set_sqstring_aligned(ESL_MSA *msa, char *seqstring, int seqidx)
+BEMSA_PID *
+_c_pid_create(ESL_MSA *msa)
 {
-  int status;
-  
-  int alen = strlen(seqstring);
-  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set seqstring with string of incorrect length");
-
-  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
-  if(msa->flags & eslMSA_DIGITAL) { 
-    /* do not need to free msa->ax[seqidx], we will just overwrite it */
-    if((status = esl_abc_Digitize(msa->abc, seqstring, msa->ax[seqidx])) != eslOK) croak("_c_set_sqstring_aligned() failed to set digitized aligned sequence");
-  }
-  else { /* text mode */
-    strcpy(msa->aseq[seqidx], seqstring);
-  }
-  return;
-
+  return _c_pid_create_view(msa, NULL, msa->nseq, NULL, msa->alen);
 }
 
-/* Function:  _c_set_existing_ppstring_aligned()
- * Incept:    EPN, Fri Feb 19 11:12:32 2021
- * Purpose:   Set PP for sequence <seqidx> to <ppstring>. It must already be allocated!
- * Returns:   void
- * Dies:      if len(ppstring) != alen
- *            if msa->pp == NULL or msa->pp[idx] == NULL
+/* Function: _c_pid_destroy
+ * Purpose:  Free a BEMSA_PID created by _c_pid_create().
+ * Returns:  void
  */
-void _c_set_existing_ppstring_aligned(ESL_MSA *msa, char *ppstring, int idx)
+void
+_c_pid_destroy(BEMSA_PID *pid)
 {
-  int alen = strlen(ppstring);
-  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set ppstring with string of incorrect length");
-
-  if(msa->pp      == NULL) croak("_c_set_existing_ppstring_aligned() trying to set ppstring but msa->pp is NULL");
-  if(msa->pp[idx] == NULL) croak("_c_set_existing_ppstring_aligned() trying to set ppstring but msa->pp[idx] is NULL");
-  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
-  strcpy(msa->pp[idx], ppstring);
-
+  if(pid == NULL) return;
+  if(pid->planes) free(pid->planes);
+  if(pid->lenA)   free(pid->lenA);
+  free(pid);
   return;
 }
 
-/* Function:  _c_set_existing_sastring_aligned()
- * Incept:    EPN, Fri Feb 19 13:07:52 2021
- * Purpose:   Set SA for sequence <seqidx> to <sastring>. It must already be allocated!
- * Returns:   void
- * Dies:      if len(sastring) != alen
- *            if msa->sa == NULL or msa->sa[idx] == NULL
+/* Function: _c_pid_pair
+ * Purpose:  Calculate fractional identity between seqs i and j,
+ *           identical to the value _c_pairwise_identity() returns.
+ *           Safe to call from multiple threads.
+ *
+ * Returns:  eslOK on success, and <*ret_pid> is the identity.
+ *           eslEINVAL if the aligned strings differ in length (text mode).
  */
-void _c_set_existing_sastring_aligned(ESL_MSA *msa, char *sastring, int idx)
+int
+_c_pid_pair(const BEMSA_PID *pid, int i, int j, double *ret_pid)
 {
-  int alen = strlen(sastring);
-  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set sastring with string of incorrect length");
+  const uint64_t *pi;
+  const uint64_t *pj;
+  int64_t         idents = 0;
+  int             minlen;
+  int             w;
+  const char     *ai, *aj;
+  int64_t         c, apos;
+  int             leni = 0;
+  int             lenj = 0;
+
+  if(pid->planes == NULL) { 
+    ai = pid->msa->aseq[(pid->seqA == NULL) ? i : pid->seqA[i]];
+    aj = pid->msa->aseq[(pid->seqA == NULL) ? j : pid->seqA[j]];
+    if(pid->colA == NULL) return esl_dst_CPairId(ai, aj, ret_pid, NULL, NULL);
+    /* a subset of columns: count as esl_dst_CPairId() would */
+    for(c = 0; c < pid->ncol; c++) { 
+      apos = pid->colA[c];
+      if(isalpha(ai[apos])) leni++;
+      if(isalpha(aj[apos])) lenj++;
+      if(isalpha(ai[apos]) && isalpha(aj[apos]) && toupper(ai[apos]) == toupper(aj[apos])) idents++;
+    }
+    minlen   = ESL_MIN(leni, lenj);
+    *ret_pid = (minlen == 0) ? 0. : (double) idents / (double) minlen;
+    return eslOK;
+  }
 
-  if(msa->sa      == NULL) croak("_c_set_existing_sastring_aligned() trying to set sastring but msa->sa is NULL");
-  if(msa->sa[idx] == NULL) croak("_c_set_existing_sastring_aligned() trying to set sastring but msa->sa[idx] is NULL");
-  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
-  strcpy(msa->sa[idx], sastring);
+  pi     = pid->planes + (size_t) i * pid->K * pid->nw;
+  pj     = pid->planes + (size_t) j * pid->K * pid->nw;
+  minlen = ESL_MIN(pid->lenA[i], pid->lenA[j]);
+  for(w = 0; w < pid->K * pid->nw; w++) idents += bemsa_popcount64(pi[w] & pj[w]);
 
-  return;
+  *ret_pid = (minlen == 0) ? 0. : (double) idents / (double) minlen;
+  return eslOK;
 }
 
-/* Function:  _c_set_existing_ssstring_aligned()
- * Incept:    EPN, Fri Feb 19 11:12:32 2021
- * Purpose:   Set SS for sequence <seqidx> to <ssstring>. It must already be allocated!
- * Returns:   void
- * Dies:      if len(ssstring) != alen
- *            if msa->ss == NULL or msa->ss[idx] == NULL
+/* Function: _c_pid_fill_thread
+ * Purpose:  Worker for _c_pid_fill(): repeatedly claim the next
+ *           unfilled row and fill it, until all rows are claimed.
+ * Returns:  NULL
  */
-void _c_set_existing_ssstring_aligned(ESL_MSA *msa, char *ssstring, int idx)
+void *
+_c_pid_fill_thread(void *arg)
 {
-  int alen = strlen(ssstring);
-  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set ssstring with string of incorrect length");
-
-  if(msa->ss      == NULL) croak("_c_set_existing_ssstring_aligned() trying to set ssstring but msa->ss is NULL");
-  if(msa->ss[idx] == NULL) croak("_c_set_existing_ssstring_aligned() trying to set ssstring but msa->ss[idx] is NULL");
-  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
-  strcpy(msa->ss[idx], ssstring);
+  BEMSA_PID_WORK *work = (BEMSA_PID_WORK *) arg;
+  int             nseq = work->pid->nseq;
+  int             nerr = 0;
+  double         *mxrow;
+  int             r, i, j;
+
+  for(;;) { 
+    pthread_mutex_lock(&work->mutex);
+    r = work->next++;
+    pthread_mutex_unlock(&work->mutex);
+    if(r >= work->nrows) break;
+
+    i     = work->rowA[r];
+    mxrow = work->mx + (size_t) r * nseq;
+    for(j = (work->upper ? i+1 : 0); j < nseq; j++) { 
+      if(_c_pid_pair(work->pid, i, j, &(mxrow[j])) != eslOK) nerr++;
+    }
+  }
 
-  return;
+  if(nerr > 0) { 
+    pthread_mutex_lock(&work->mutex);
+    work->nerr += nerr;
+    pthread_mutex_unlock(&work->mutex);
+  }
+  return NULL;
 }
 
-
-/* Function:  _c_check_ppidx()
- * Incept:    EPN, Mon Jul  7 09:15:48 2014
+/* Function: _c_pid_fill
+ * Purpose:  Fill <nrows> rows of <mx>: mx[r*nseq + j] is the
+ *           identity between seq rowA[r] and seq j. If <upper>
+ *           is TRUE only columns j > rowA[r] are filled. Rows are
+ *           split between <nthreads> threads; the caller's
+ *           thread is used if <nthreads> is 1 or less, and joins
+ *           in if fewer threads than requested can be created.
+ *
+ * Returns:  void
+ * Dies:     if a comparison fails
+ */
+void
+_c_pid_fill(BEMSA_PID *pid, const int *rowA, int nrows, int upper, double *mx, int nthreads)
+{
+  int             status;
+  BEMSA_PID_WORK  work;
+  pthread_t      *tidA = NULL;
+  int             t;
+  int             nstarted;   /* number of threads successfully created */
+
+  work.pid   = pid;
+  work.rowA  = rowA;
+  work.nrows = nrows;
+  work.upper = upper;
+  work.mx    = mx;
+  work.next  = 0;
+  work.nerr  = 0;
+  pthread_mutex_init(&work.mutex, NULL);
+
+  nthreads = ESL_MIN(nthreads, nrows);
+  if(nthreads <= 1) { 
+    _c_pid_fill_thread(&work);
+  }
+  else { 
+    ESL_ALLOC(tidA, sizeof(pthread_t) * nthreads);
+    for(nstarted = 0; nstarted < nthreads; nstarted++) { 
+      if(pthread_create(&(tidA[nstarted]), NULL, _c_pid_fill_thread, &work) != 0) break;
+    }
+    /* if a thread couldn't be created, help with the rest of the work
+     * ourselves; never croak while <work> is in use by other threads */
+    if(nstarted < nthreads) _c_pid_fill_thread(&work);
+    for(t = 0; t < nstarted; t++) pthread_join(tidA[t], NULL);
+    free(tidA);
+  }
+  pthread_mutex_destroy(&work.mutex);
+
+  if(work.nerr > 0) croak("_c_pid_fill() error, aligned seqs different lengths");
+  return;
+
+ ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function: _c_pid_upper_triangle_reduce
+ * Purpose:  Sum all pairwise identities i < j, and determine their
+ *           minimum and maximum, filling rows in tiles of at most
+ *           BEMSA_PID_TILE_NDBL values with _c_pid_fill() and
+ *           adding them up serially in (i,j) order, so the sum is
+ *           identical to that of a serial double loop.
+ *
+ * Args:     msa:      the alignment
+ *           nthreads: number of threads to use
+ *           ret_sum:  RETURN: summed identity of all pairs
+ *           ret_min:  RETURN: minimum identity, 1. if < 2 seqs
+ *           ret_max:  RETURN: maximum identity, 0. if < 2 seqs
+ *
+ * Returns:  void
+ * Dies:     if out of memory
+ */
+void
+_c_pid_upper_triangle_reduce(ESL_MSA *msa, int nthreads, double *ret_sum, double *ret_min, double *ret_max)
+{
+  int        status;
+  BEMSA_PID *pid   = _c_pid_create(msa);
+  int        ntile = ESL_MAX(1, ESL_MIN(msa->nseq, BEMSA_PID_TILE_NDBL / ESL_MAX(1, msa->nseq)));
+  int       *rowA  = NULL;
+  double    *mx    = NULL;
+  double     sum   = 0.;
+  double     min   = 1.;
+  double     max   = 0.;
+  int        i0, r, i, j, nrows;
+  double     x;
+
+  ntile = ESL_MAX(ntile, ESL_MIN(msa->nseq, nthreads));
+  ESL_ALLOC(rowA, sizeof(int)    * ntile);
+  ESL_ALLOC(mx,   sizeof(double) * (size_t) ntile * ESL_MAX(1, msa->nseq));
+
+  for(i0 = 0; i0 < msa->nseq; i0 += ntile) { 
+    nrows = ESL_MIN(ntile, msa->nseq - i0);
+    for(r = 0; r < nrows; r++) rowA[r] = i0 + r;
+    _c_pid_fill(pid, rowA, nrows, TRUE, mx, nthreads);
+    for(r = 0; r < nrows; r++) { 
+      i = rowA[r];
+      for(j = i+1; j < msa->nseq; j++) { 
+        x    = mx[(size_t) r * msa->nseq + j];
+        min  = ESL_MIN(min, x);
+        max  = ESL_MAX(max, x);
+        sum += x;
+      }
+    }
+  }
+
+  free(rowA);
+  free(mx);
+  _c_pid_destroy(pid);
+
+  *ret_sum = sum;
+  *ret_min = min;
+  *ret_max = max;
+  return;
+
+ ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function: _c_pid_matrix_from_pid
+ * Purpose:  Fill and return the packed matrix for _c_pid_matrix()
+ *           and _c_view_pid_matrix() with identity engine <pid>;
+ *           indices in <rowsAR> are engine sequence indices.
+ *
+ * Returns:  packed string of nrows * pid->nseq doubles
+ * Dies:     if any index in <rowsAR> is out of bounds, or out of memory
+ */
+SV *
+_c_pid_matrix_from_pid(BEMSA_PID *pid, AV *rowsAR, int nrows, int nthreads)
+{
+  int        status;
+  int       *rowA   = NULL;  /* [0..r..nrows-1] C copy of rowsAR */
+  size_t     nbytes = sizeof(double) * (size_t) nrows * pid->nseq;
+  SV        *mxSV;           /* the packed matrix */
+  int        r;              /* row counter */
+
+  ESL_ALLOC(rowA, sizeof(int) * ESL_MAX(1, nrows));
+  _c_int_copy_array_perl_to_c(rowsAR, rowA, nrows);
+  for(r = 0; r < nrows; r++) { 
+    if(rowA[r] < 0 || rowA[r] >= pid->nseq) croak("_c_pid_matrix() contract violation, idx %d out of bounds (nseq: %d)", rowA[r], pid->nseq);
+  }
+
+  mxSV = newSV(nbytes);
+  SvPOK_only(mxSV);
+  SvCUR_set(mxSV, nbytes);
+  SvPVX(mxSV)[nbytes] = '\0';
+
+  _c_pid_fill(pid, rowA, nrows, FALSE, (double *) SvPVX(mxSV), nthreads);
+  free(rowA);
+
+  return mxSV;
+
+ ERROR: 
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function: _c_pid_matrix
+ * Purpose:  Calculate fractional identities between each sequence 
+ *           listed in <rowsAR> and all sequences in the MSA, and
+ *           return them as a packed string of doubles: row r,
+ *           column j (value at double offset r*nseq + j) is the 
+ *           identity between seq rowsAR[r] and seq j, as 
+ *           _c_pairwise_identity() would calculate it. Pass all
+ *           sequence indices in <rowsAR> for the full matrix.
+ *
+ * Args:     msa:      the alignment
+ *           rowsAR:   [0..r..nrows-1] sequence indices for the matrix rows
+ *           nrows:    number of elements in <rowsAR>
+ *           nthreads: number of threads to use
+ *
+ * Returns:  packed string of nrows * nseq doubles
+ * Dies:     if any index in <rowsAR> is out of bounds, or out of memory
+ */
+SV *
+_c_pid_matrix(ESL_MSA *msa, AV *rowsAR, int nrows, int nthreads)
+{
+  BEMSA_PID *pid = _c_pid_create(msa);  /* the identity engine */
+  SV        *mxSV;                      /* the packed matrix */
+
+  mxSV = _c_pid_matrix_from_pid(pid, rowsAR, nrows, nthreads);
+  _c_pid_destroy(pid);
+
+  return mxSV;
+}
+
+/* The greedy identity filter used by _c_filter_msa_subset() and
+ * _c_filter_msa_subset_target_nseq() keeps the first of any pair of
+ * used sequences more than <idf> identical. Identities between used
+ * sequences are cached in a BEMSA_PID_CACHE and only computed when
+ * first needed, i.e. for pairs that are both still live when the 
+ * first is reached, so repeated filtering at different thresholds
+ * during the binary search reuses them. Only rows of sequences that
+ * have been kept are allocated, so the cache holds at most 
+ * nkeep * nuse identities (nkeep summed over the distinct sequences
+ * kept at any threshold), not the full nuse * nuse triangle.
+ */
+typedef struct {
+  BEMSA_PID *pid;    /* the identity engine */
+  int        nuse;   /* number of used sequences */
+  int       *useA;   /* [0..u..nuse-1] sequence index of used seq u */
+  double   **rowA;   /* [0..u..nuse-1] identities of used seq u to used seqs v > u, in rowA[u][v-u-1], 
+                      * -1. if not yet computed; rowA[u] is NULL until u is first kept */
+  int       *colA;   /* [0..nuse-1] scratch: used seqs whose identity to the current one is needed */
+  double    *pidA;   /* [0..nuse-1] scratch: identities for colA */
+} BEMSA_PID_CACHE;
+
+typedef struct {
+  BEMSA_PID       *pid;    /* the engine */
+  int              i;      /* sequence to compare to all in colA */
+  const int       *colA;   /* [0..c..ncol-1] sequences to compare <i> to */
+  int              ncol;   /* number of elements in colA */
+  double          *pidA;   /* [0..c..ncol-1] RETURN: identity of <i> and colA[c] */
+  int              next;   /* next column to claim, protected by <mutex> */
+  int              nerr;   /* number of failed comparisons, protected by <mutex> */
+  pthread_mutex_t  mutex;
+} BEMSA_PID_COLWORK;
+
+#define BEMSA_PID_COLCHUNK 64 /* number of columns claimed at once by a thread */
+
+/* Function: _c_pid_cols_thread
+ * Purpose:  Worker for _c_pid_cols(): repeatedly claim the next
+ *           BEMSA_PID_COLCHUNK columns and compute them.
+ * Returns:  NULL
+ */
+void *
+_c_pid_cols_thread(void *arg)
+{
+  BEMSA_PID_COLWORK *work = (BEMSA_PID_COLWORK *) arg;
+  int                nerr = 0;
+  int                c, c0;
+
+  for(;;) { 
+    pthread_mutex_lock(&work->mutex);
+    c0 = work->next;
+    work->next += BEMSA_PID_COLCHUNK;
+    pthread_mutex_unlock(&work->mutex);
+    if(c0 >= work->ncol) break;
+
+    for(c = c0; c < ESL_MIN(c0 + BEMSA_PID_COLCHUNK, work->ncol); c++) { 
+      if(_c_pid_pair(work->pid, work->i, work->colA[c], &(work->pidA[c])) != eslOK) nerr++;
+    }
+  }
+
+  if(nerr > 0) { 
+    pthread_mutex_lock(&work->mutex);
+    work->nerr += nerr;
+    pthread_mutex_unlock(&work->mutex);
+  }
+  return NULL;
+}
+
+/* Function: _c_pid_cols
+ * Purpose:  Compute identities between seq <i> and each of the
+ *           <ncol> seqs in <colA>, using up to <nthreads> threads,
+ *           storing them in <pidA>. The caller's thread takes part
+ *           if fewer threads than requested can be created.
+ *
+ * Returns:  void
+ * Dies:     if a comparison fails
+ */
+void
+_c_pid_cols(BEMSA_PID *pid, int i, const int *colA, int ncol, double *pidA, int nthreads)
+{
+  int                status;
+  BEMSA_PID_COLWORK  work;
+  pthread_t         *tidA = NULL;
+  int                t;
+  int                nstarted;   /* number of threads successfully created */
+
+  work.pid  = pid;
+  work.i    = i;
+  work.colA = colA;
+  work.ncol = ncol;
+  work.pidA = pidA;
+  work.next = 0;
+  work.nerr = 0;
+  pthread_mutex_init(&work.mutex, NULL);
+
+  nthreads = ESL_MIN(nthreads, (ncol + BEMSA_PID_COLCHUNK - 1) / BEMSA_PID_COLCHUNK);
+  if(nthreads <= 1) { 
+    _c_pid_cols_thread(&work);
+  }
+  else { 
+    ESL_ALLOC(tidA, sizeof(pthread_t) * nthreads);
+    for(nstarted = 0; nstarted < nthreads; nstarted++) { 
+      if(pthread_create(&(tidA[nstarted]), NULL, _c_pid_cols_thread, &work) != 0) break;
+    }
+    /* as in _c_pid_fill() */
+    if(nstarted < nthreads) _c_pid_cols_thread(&work);
+    for(t = 0; t < nstarted; t++) pthread_join(tidA[t], NULL);
+    free(tidA);
+  }
+  pthread_mutex_destroy(&work.mutex);
+
+  if(work.nerr > 0) croak("_c_pid_cols() error, aligned seqs different lengths");
+  return;
+
+ ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function: _c_pid_cache_create
+ * Purpose:  Create an empty identity cache for the sequences i
+ *           for which useA[i] is TRUE. Rows are allocated and
+ *           filled by _c_pid_cache_filter() as they're needed.
+ *
+ * Args:     msa:  the alignment
+ *           useA: [0..i..msa->nseq-1] TRUE to use seq i
+ *
+ * Returns:  newly allocated BEMSA_PID_CACHE, free with _c_pid_cache_destroy()
+ * Dies:     if out of memory
+ */
+BEMSA_PID_CACHE *
+_c_pid_cache_create(ESL_MSA *msa, const int *useA)
+{
+  int              status;
+  BEMSA_PID_CACHE *cache = NULL;
+  int              i, u;
+
+  ESL_ALLOC(cache, sizeof(BEMSA_PID_CACHE));
+  cache->nuse = 0;
+  for(i = 0; i < msa->nseq; i++) if(useA[i]) cache->nuse++;
+
+  ESL_ALLOC(cache->useA, sizeof(int)    * ESL_MAX(1, cache->nuse));
+  ESL_ALLOC(cache->rowA, sizeof(double *) * ESL_MAX(1, cache->nuse));
+  ESL_ALLOC(cache->colA, sizeof(int)    * ESL_MAX(1, cache->nuse));
+  ESL_ALLOC(cache->pidA, sizeof(double) * ESL_MAX(1, cache->nuse));
+  cache->nuse = 0;
+  for(i = 0; i < msa->nseq; i++) if(useA[i]) cache->useA[cache->nuse++] = i;
+  for(u = 0; u < cache->nuse; u++) cache->rowA[u] = NULL;
+  cache->pid = _c_pid_create(msa);
+
+  return cache;
+
+ ERROR: 
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function: _c_pid_cache_destroy
+ * Purpose:  Free a BEMSA_PID_CACHE.
+ * Returns:  void
+ */
+void
+_c_pid_cache_destroy(BEMSA_PID_CACHE *cache)
+{
+  int u;
+
+  if(cache == NULL) return;
+  _c_pid_destroy(cache->pid);
+  for(u = 0; u < cache->nuse; u++) if(cache->rowA[u] != NULL) free(cache->rowA[u]);
+  free(cache->useA);
+  free(cache->rowA);
+  free(cache->colA);
+  free(cache->pidA);
+  free(cache);
+  return;
+}
+
+/* Function: _c_pid_cache_filter
+ * Purpose:  Greedily filter the used sequences in <cache> such
+ *           that no two kept sequences are more than <idf> 
+ *           fractionally identical, computing any identities not
+ *           yet in the cache. Identical to the filter done by 
+ *           the original Perl filter_msa_subset().
+ *
+ * Args:     cache:    the identity cache
+ *           idf:      fractional identity threshold
+ *           nthreads: number of threads to compute identities with
+ *           keepA:    [0..u..nuse-1] RETURN: TRUE if used seq u is kept
+ *
+ * Returns:  number of kept sequences
+ */
+int
+_c_pid_cache_filter(BEMSA_PID_CACHE *cache, double idf, int nthreads, int *keepA)
+{
+  int     status;
+  int     nuse  = cache->nuse;
+  int     nkeep = nuse;
+  int     ncol;
+  int     u, v, c;
+  double *row;
+
+  for(u = 0; u < nuse; u++) keepA[u] = TRUE;
+
+  for(u = 0; u < nuse; u++) { 
+    if(! keepA[u]) continue;
+
+    /* u is kept, allocate its row if this is the first time */
+    if(cache->rowA[u] == NULL) { 
+      ESL_ALLOC(cache->rowA[u], sizeof(double) * ESL_MAX(1, nuse-u-1));
+      for(v = u+1; v < nuse; v++) cache->rowA[u][v-u-1] = -1.;
+    }
+    row = cache->rowA[u];
+
+    /* compute all missing identities between u and live seqs after it */
+    ncol = 0;
+    for(v = u+1; v < nuse; v++) { 
+      if(keepA[v] && row[v-u-1] < 0.) cache->colA[ncol++] = cache->useA[v];
+    }
+    if(ncol > 0) { 
+      _c_pid_cols(cache->pid, cache->useA[u], cache->colA, ncol, cache->pidA, nthreads);
+      c = 0;
+      for(v = u+1; v < nuse; v++) { 
+        if(keepA[v] && row[v-u-1] < 0.) row[v-u-1] = cache->pidA[c++];
+      }
+    }
+
+    for(v = u+1; v < nuse; v++) { 
+      if(keepA[v] && row[v-u-1] > idf) { 
+        keepA[v] = FALSE;
+        nkeep--;
+      }
+    }
+  }
+
+  return nkeep;
+
+ ERROR: 
+  croak("out of memory");
+  return 0; /* NEVER REACHED */
+}
+
+/* Function: _c_pid_cache_keep_by_seq
+ * Purpose:  Convert per-used-sequence keep flags from 
+ *           _c_pid_cache_filter() into per-sequence flags.
+ *
+ * Args:     cache:    the identity cache
+ *           nseq:     number of sequences in the MSA
+ *           keepA:    [0..u..nuse-1] TRUE if used seq u is kept
+ *           seqkeepA: [0..i..nseq-1] RETURN: TRUE if seq i is kept
+ * Returns:  void
+ */
+void
+_c_pid_cache_keep_by_seq(const BEMSA_PID_CACHE *cache, int nseq, const int *keepA, int *seqkeepA)
+{
+  int u;
+
+  esl_vec_ISet(seqkeepA, nseq, FALSE);
+  for(u = 0; u < cache->nuse; u++) seqkeepA[cache->useA[u]] = keepA[u];
+  return;
+}
+
+/* Function: _c_filter_msa_subset
+ * Purpose:  Filter a subset of sequences in an MSA such that no
+ *           two sequences in the filtered subset are more than <idf>
+ *           fractionally identical. See filter_msa_subset() in 
+ *           MSA.pm.
+ *
+ * Args:     msa:      the alignment
+ *           usemeAR:  [0..i..msa->nseq-1] '1' to consider seq i, else '0'
+ *           idf:      fractional identity threshold
+ *           nthreads: number of threads to compute identities with
+ *
+ * Returns:  nseq+1 values: the number of kept sequences, then
+ *           '1' or '0' for each sequence: '1' if it was kept.
+ * Dies:     if out of memory
+ */
+void
+_c_filter_msa_subset(ESL_MSA *msa, AV *usemeAR, double idf, int nthreads)
+{
+  Inline_Stack_Vars;
+
+  int              status;
+  int             *useA  = NULL;  /* [0..i..nseq-1] C copy of usemeAR */
+  int             *keepA = NULL;  /* [0..u..nuse-1] TRUE if used seq u is kept */
+  BEMSA_PID_CACHE *cache = NULL;  /* identities between used seqs */
+  int              nkeep;
+  int              i;
+
+  ESL_ALLOC(useA, sizeof(int) * ESL_MAX(1, msa->nseq));
+  _c_int_copy_array_perl_to_c(usemeAR, useA, msa->nseq);
+  cache = _c_pid_cache_create(msa, useA);
+  ESL_ALLOC(keepA, sizeof(int) * ESL_MAX(1, cache->nuse));
+
+  nkeep = _c_pid_cache_filter(cache, idf, nthreads, keepA);
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSViv(nkeep)));
+  _c_pid_cache_keep_by_seq(cache, msa->nseq, keepA, useA); /* useA is no longer needed, reuse it */
+  for(i = 0; i < msa->nseq; i++) Inline_Stack_Push(sv_2mortal(newSViv(useA[i] ? 1 : 0)));
+  Inline_Stack_Done;
+
+  _c_pid_cache_destroy(cache);
+  free(useA);
+  free(keepA);
+
+  Inline_Stack_Return(msa->nseq + 1);
+  return;
+
+ ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function: _c_filter_msa_subset_target_nseq
+ * Purpose:  Binary search for the maximum fractional identity 
+ *           threshold, to the nearest 0.01, for which
+ *           _c_pid_cache_filter() keeps <= <target_nseq> sequences,
+ *           then filter at that threshold. See
+ *           filter_msa_subset_target_nseq() in MSA.pm, whose 
+ *           search this reproduces exactly. Identities are 
+ *           computed at most once, and only when first needed.
+ *
+ * Args:     msa:         the alignment
+ *           usemeAR:     [0..i..msa->nseq-1] '1' to consider seq i, else '0'
+ *           target_nseq: maximum number of sequences to keep
+ *           nthreads:    number of threads to compute identities with
+ *
+ * Returns:  nseq+2 values: the threshold used, the number of 
+ *           kept sequences, then '1' or '0' for each sequence: 
+ *           '1' if it was kept.
+ * Dies:     if the target can't be reached with a threshold of 
+ *           at least 0.01, or out of memory
+ */
+void
+_c_filter_msa_subset_target_nseq(ESL_MSA *msa, AV *usemeAR, int target_nseq, int nthreads)
+{
+  Inline_Stack_Vars;
+
+  int              status;
+  int             *useA  = NULL;  /* [0..i..nseq-1] C copy of usemeAR */
+  int             *keepA = NULL;  /* [0..u..nuse-1] TRUE if used seq u is kept */
+  BEMSA_PID_CACHE *cache = NULL;  /* identities between used seqs */
+  double           f_min = 0.01;  /* minimum threshold */
+  double           f_opt = 0.01;  /* max threshold found so far that gives <= target_nseq seqs */
+  double           f_prv = 1.0;   /* previous threshold */
+  double           f_cur = f_min; /* current threshold */
+  double           diff;
+  int              n;
+  int              i;
+
+  ESL_ALLOC(useA, sizeof(int) * ESL_MAX(1, msa->nseq));
+  _c_int_copy_array_perl_to_c(usemeAR, useA, msa->nseq);
+  cache = _c_pid_cache_create(msa, useA);
+  ESL_ALLOC(keepA, sizeof(int) * ESL_MAX(1, cache->nuse));
+
+  diff = fabs(f_prv - f_cur);
+  while(diff > 0.00999) { 
+    n = _c_pid_cache_filter(cache, f_cur, nthreads, keepA);
+
+    f_prv = f_cur;
+    if(n > target_nseq) { /* too many seqs, lower f_cur */
+      f_cur -= (diff / 2.);
+    }
+    else { /* too few seqs, raise f_cur */
+      if(f_cur > f_opt) f_opt = f_cur;
+      f_cur += (diff / 2.);
+    }
+    /* round to nearest percentage point (0.01) */
+    f_cur = ((double) ((int) ((f_cur * 100) + 0.5))) / 100;
+
+    if(f_cur < f_min) { 
+      _c_pid_cache_destroy(cache);
+      free(useA);
+      free(keepA);
+      croak("filter_msa_subset_target_nseq: couldn't reach %d sequences, with fractional id > %g\n", target_nseq, f_min);
+    }
+    diff = fabs(f_prv - f_cur);
+  }
+  n = _c_pid_cache_filter(cache, f_opt, nthreads, keepA);
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSVnv(f_opt)));
+  Inline_Stack_Push(sv_2mortal(newSViv(n)));
+  _c_pid_cache_keep_by_seq(cache, msa->nseq, keepA, useA); /* useA is no longer needed, reuse it */
+  for(i = 0; i < msa->nseq; i++) Inline_Stack_Push(sv_2mortal(newSViv(useA[i] ? 1 : 0)));
+  Inline_Stack_Done;
+
+  _c_pid_cache_destroy(cache);
+  free(useA);
+  free(keepA);
+
+  Inline_Stack_Return(msa->nseq + 2);
+  return;
+
+ ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function:  _c_average_id()
+ * Incept:    EPN, Sat Feb  2 14:38:18 2013
+ * Purpose:   Calculate and return average fractional identity of 
+ *            an alignment. If more than max_nseq sequences exist
+ *            take a sample of (max_nseq)^2 pairs and return the 
+ *            average fractional identity of those.
+ *
+ *            If <nthreads> is more than 1 and all pairs are 
+ *            compared, the identities are computed with that many
+ *            threads, and summed in the same order as 
+ *            esl_dst_{X,C}AverageId() would sum them.
+ *
+ * Returns:   Average fractional identity.
+ */
+float _c_average_id(ESL_MSA *msa, int max_nseq, int nthreads) 
+{
+  double avgid;
+  double pid_min, pid_max;  /* unused */
+  int    max_comparisons = max_nseq * max_nseq;
+  
+  if(nthreads > 1 && msa->nseq > 1 && 
+     msa->nseq <= max_comparisons && 
+     msa->nseq <= sqrt(2. * max_comparisons) && 
+     (msa->nseq * (msa->nseq-1) / 2) <= max_comparisons) { 
+    /* same all-pairs criteria esl_dst_{X,C}AverageId() use */
+    _c_pid_upper_triangle_reduce(msa, nthreads, &avgid, &pid_min, &pid_max);
+    avgid /= (double) (msa->nseq * (msa->nseq-1) / 2);
+  }
+  else if(msa->flags & eslMSA_DIGITAL) { 
+    esl_dst_XAverageId(msa->abc, msa->ax, msa->nseq, (max_nseq * max_nseq), &avgid);
+  }
+  else { 
+    esl_dst_CAverageId(msa->aseq, msa->nseq, (max_nseq * max_nseq), &avgid);
+  }
+  return (float) avgid;
+}
+
+/* Function:  _c_textize_row()
+ * Purpose:   Write sequence <seqidx> of <msa> as text into <dest>,
+ *            aligned if <do_aligned>, else with gaps removed. 
+ *            Gaps are removed as esl_sq_FetchFromMSA() removes 
+ *            them: gap and missing data symbols in digital mode, 
+ *            '-_.~' in text mode. <dest> must have room for 
+ *            msa->alen+1 chars, it is '\0' terminated.
+ * Returns:   Number of chars written, not including the '\0'.
+ */
+int64_t _c_textize_row(ESL_MSA *msa, int seqidx, int do_aligned, char *dest)
+{
+  int64_t apos;
+  int64_t n = 0;
+  ESL_DSQ x;
+  char    c;
+
+  if(msa->flags & eslMSA_DIGITAL) { 
+    if(do_aligned) { 
+      if(esl_abc_Textize(msa->abc, msa->ax[seqidx], msa->alen, dest) != eslOK) croak("failed to textize digitized aligned sequence");
+      return msa->alen;
+    }
+    for(apos = 1; apos <= msa->alen; apos++) { 
+      x = msa->ax[seqidx][apos];
+      if(! esl_abc_XIsGap(msa->abc, x) && ! esl_abc_XIsMissing(msa->abc, x)) dest[n++] = msa->abc->sym[x];
+    }
+  }
+  else { /* text mode */
+    if(do_aligned) { 
+      memcpy(dest, msa->aseq[seqidx], msa->alen);
+      dest[msa->alen] = '\0';
+      return msa->alen;
+    }
+    for(apos = 0; apos < msa->alen; apos++) { 
+      c = msa->aseq[seqidx][apos];
+      if(strchr("-_.~", c) == NULL) dest[n++] = c;
+    }
+  }
+  dest[n] = '\0';
+  return n;
+}
+
+/* Function:  _c_sqstring_sv()
+ * Purpose:   Create a new string SV holding sequence <seqidx>,
+ *            aligned if <do_aligned>, textized directly into 
+ *            the SV's buffer with _c_textize_row().
+ * Returns:   new SV, caller must mortalize it if necessary
+ */
+SV *_c_sqstring_sv(ESL_MSA *msa, int seqidx, int do_aligned)
+{
+  SV *seqstringSV = newSV(msa->alen + 1);
+
+  SvPOK_only(seqstringSV);
+  SvCUR_set(seqstringSV, _c_textize_row(msa, seqidx, do_aligned, SvPVX(seqstringSV)));
+
+  return seqstringSV;
+}
+
+/* Function:  _c_get_sqstring_aligned()
+ * Incept:    EPN, Fri May 24 11:03:49 2013
+ * Purpose:   Return aligned sequence <seqidx>.
+ * Returns:   Aligned sequence <seqidx>.
+ */
+SV *_c_get_sqstring_aligned(ESL_MSA *msa, int seqidx)
+{
+  return _c_sqstring_sv(msa, seqidx, TRUE);
+}
+
+/* Function:  _c_set_sqstring_aligned()
+ * Incept:    EPN, Fri Feb 19 06:55:52 2021
+ * Purpose:   Set aligned sequence <seqidx> to <seqstring>.
+ * Returns:   void
+ * Dies:      if len(seqstring) != alen
+ *            if msa is digitized and unable to digitize string
+ */
+void _c_set_sqstring_aligned(ESL_MSA *msa, char *seqstring, int seqidx)
+{
+  int status;
+  
+  int alen = strlen(seqstring);
+  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set seqstring with string of incorrect length");
+
+  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
+  if(msa->flags & eslMSA_DIGITAL) { 
+    /* do not need to free msa->ax[seqidx], we will just overwrite it (after copying it if it's shared) */
+    msa->ax[seqidx] = bemsa_cow_own(msa->ax[seqidx], msa->alen+2);
+    if((status = esl_abc_Digitize(msa->abc, seqstring, msa->ax[seqidx])) != eslOK) croak("_c_set_sqstring_aligned() failed to set digitized aligned sequence");
+  }
+  else { /* text mode */
+    msa->aseq[seqidx] = bemsa_cow_own(msa->aseq[seqidx], msa->alen+1);
+    strcpy(msa->aseq[seqidx], seqstring);
+  }
+  return;
+
+}
+
+/* Function:  _c_set_existing_ppstring_aligned()
+ * Incept:    EPN, Fri Feb 19 11:12:32 2021
+ * Purpose:   Set PP for sequence <seqidx> to <ppstring>. It must already be allocated!
+ * Returns:   void
+ * Dies:      if len(ppstring) != alen
+ *            if msa->pp == NULL or msa->pp[idx] == NULL
+ */
+void _c_set_existing_ppstring_aligned(ESL_MSA *msa, char *ppstring, int idx)
+{
+  int alen = strlen(ppstring);
+  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set ppstring with string of incorrect length");
+
+  if(msa->pp      == NULL) croak("_c_set_existing_ppstring_aligned() trying to set ppstring but msa->pp is NULL");
+  if(msa->pp[idx] == NULL) croak("_c_set_existing_ppstring_aligned() trying to set ppstring but msa->pp[idx] is NULL");
+  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
+  msa->pp[idx] = bemsa_cow_own(msa->pp[idx], msa->alen+1);
+  strcpy(msa->pp[idx], ppstring);
+
+  return;
+}
+
+/* Function:  _c_set_existing_sastring_aligned()
+ * Incept:    EPN, Fri Feb 19 13:07:52 2021
+ * Purpose:   Set SA for sequence <seqidx> to <sastring>. It must already be allocated!
+ * Returns:   void
+ * Dies:      if len(sastring) != alen
+ *            if msa->sa == NULL or msa->sa[idx] == NULL
+ */
+void _c_set_existing_sastring_aligned(ESL_MSA *msa, char *sastring, int idx)
+{
+  int alen = strlen(sastring);
+  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set sastring with string of incorrect length");
+
+  if(msa->sa      == NULL) croak("_c_set_existing_sastring_aligned() trying to set sastring but msa->sa is NULL");
+  if(msa->sa[idx] == NULL) croak("_c_set_existing_sastring_aligned() trying to set sastring but msa->sa[idx] is NULL");
+  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
+  msa->sa[idx] = bemsa_cow_own(msa->sa[idx], msa->alen+1);
+  strcpy(msa->sa[idx], sastring);
+
+  return;
+}
+
+/* Function:  _c_set_existing_ssstring_aligned()
+ * Incept:    EPN, Fri Feb 19 11:12:32 2021
+ * Purpose:   Set SS for sequence <seqidx> to <ssstring>. It must already be allocated!
+ * Returns:   void
+ * Dies:      if len(ssstring) != alen
+ *            if msa->ss == NULL or msa->ss[idx] == NULL
+ */
+void _c_set_existing_ssstring_aligned(ESL_MSA *msa, char *ssstring, int idx)
+{
+  int alen = strlen(ssstring);
+  if(alen != msa->alen) croak("_c_set_sqstring_aligned() trying to set ssstring with string of incorrect length");
+
+  if(msa->ss      == NULL) croak("_c_set_existing_ssstring_aligned() trying to set ssstring but msa->ss is NULL");
+  if(msa->ss[idx] == NULL) croak("_c_set_existing_ssstring_aligned() trying to set ssstring but msa->ss[idx] is NULL");
+  /* we do not free and reallocate here, going against the convention of other subroutines (e.g. _c_set_rf) */
+  msa->ss[idx] = bemsa_cow_own(msa->ss[idx], msa->alen+1);
+  strcpy(msa->ss[idx], ssstring);
+
+  return;
+}
+
+
+/* Function:  _c_check_ppidx()
+ * Incept:    EPN, Mon Jul  7 09:15:48 2014
  * Synposis:  Return '1' if sequence <idx> has PP annotation in the MSA, else return '0';
  */
 int _c_check_ppidx(ESL_MSA *msa, int idx)
@@ -910,28 +2193,58 @@ SV *_c_get_ssstring_aligned(ESL_MSA *msa, int seqidx)
  */
 SV *_c_get_sqstring_unaligned(ESL_MSA *msa, int seqidx)
 {
-  int status;
-  ESL_SQ *sq = NULL;    /* the sequence, fetched from the msa */
-  SV     *seqstringSV;  /* SV version of sq->seq */
-  
-  status = esl_sq_FetchFromMSA(msa, seqidx, &sq);
-  if(status != eslOK) croak("failed to fetch seq %d from msa\n", seqidx);
+  return _c_sqstring_sv(msa, seqidx, FALSE);
+}
 
-  if(msa->flags & eslMSA_DIGITAL) { 
-    /* convert digital mode to text mode */
-    if(sq->dsq == NULL) croak("fetched seq %d from digitized msa, and it's unexpectedly NOT digitized", seqidx);
-    if((status = esl_sq_Textize(sq)) != eslOK) croak("failed to textize fetched seq from MSA");
-  }
-  else { /*text mode, no need to digitize, but verify */
-    if(sq->seq == NULL) croak("fetched seq %d from textized msa, and it's unexpectedly not in text mode", seqidx);
-  }
+/* Function:  _c_get_all_sqstrings()
+ * Purpose:   Return all sequences, aligned if <do_aligned>, 
+ *            in a single call, textizing each directly into 
+ *            its return SV.
+ *
+ *            If <do_concat> is FALSE, return nseq strings. 
+ *            If <do_concat> is TRUE, return a single string 
+ *            with all sequences concatenated, and then:
+ *              if <do_aligned>: the row stride (alen), 
+ *                sequence i starts at i * stride;
+ *              else: nseq+1 offsets, sequence i is chars 
+ *                offset[i]..offset[i+1]-1.
+ *
+ * Returns:   see above, on the Perl stack.
+ */
+void _c_get_all_sqstrings(ESL_MSA *msa, int do_aligned, int do_concat)
+{
+  Inline_Stack_Vars;
 
-  seqstringSV = newSVpv(sq->seq, sq->n);
-  esl_sq_Destroy(sq);
+  SV     *bufSV;     /* concatenated sequences */
+  char   *buf;       /* SvPVX(bufSV) */
+  STRLEN  offset;    /* offset of next sequence in <buf> */
+  int     i;
 
-  return seqstringSV;
+  Inline_Stack_Reset;
+  if(! do_concat) { 
+    for(i = 0; i < msa->nseq; i++) { 
+      Inline_Stack_Push(sv_2mortal(_c_sqstring_sv(msa, i, do_aligned)));
+    }
+    Inline_Stack_Done;
+    Inline_Stack_Return(msa->nseq);
+  }
+
+  bufSV = newSV((STRLEN) msa->nseq * (STRLEN) msa->alen + 1);
+  SvPOK_only(bufSV);
+  buf    = SvPVX(bufSV);
+  offset = 0;
+  Inline_Stack_Push(sv_2mortal(bufSV));
+  for(i = 0; i < msa->nseq; i++) { 
+    if(! do_aligned) Inline_Stack_Push(sv_2mortal(newSViv((IV) offset)));
+    offset += _c_textize_row(msa, i, do_aligned, buf + offset);
+  }
+  SvCUR_set(bufSV, offset);
+  if(do_aligned) Inline_Stack_Push(sv_2mortal(newSViv((IV) msa->alen)));
+  else           Inline_Stack_Push(sv_2mortal(newSViv((IV) offset)));
+  Inline_Stack_Done;
+  Inline_Stack_Return(do_aligned ? 2 : msa->nseq+2);
 }
- 
+
 /* Function:  _c_get_sqlen()
  * Incept:    EPN, Sat Feb  2 14:38:18 2013
  * Purpose:   Return unaligned sequence length of sequence <seqidx>.
@@ -1470,70 +2783,483 @@ int _c_getGC_tagidx (ESL_MSA *msa, char *tag)
  * Returns:   idx of GR annotation with tag <tag>
  * Dies:      if the idx does not exist
  */
-int _c_getGR_tagidx (ESL_MSA *msa, char *tag)
+int _c_getGR_tagidx (ESL_MSA *msa, char *tag)
+{
+  int status;
+  int tagidx;
+
+  if(msa->ngr > 0) { 
+    status = esl_keyhash_Lookup(msa->gr_idx, tag, -1, &tagidx);
+    if(status == eslOK) return tagidx;
+  }
+  
+  croak("_c_getGR_tagidx, no such tag exists");
+  return -1; /* never reached */
+}   
+
+/* Function:  _c_weight_GSC()
+ * Incept:    EPN, Fri May 24 10:40:00 2013
+ * Purpose:   Calculate sequence weights using the GSC (Gerstein/Sonnhammer/Chotia) 
+ *            algorithm.
+ * Returns:   eslOK on success, ! eslOK on failure.
+ */
+int _c_weight_GSC(ESL_MSA *msa) 
+{
+  int    status;
+  status = esl_msaweight_GSC(msa);
+  return status;
+}
+
+/* Function:  _c_msaweight_IDFilter()
+ * Incept:    March 1, 2013
+ * Purpose:   Calculate and output msa after %id weight filtering
+ * Returns:   weighted msa object on success
+ *            NULL on failure
+ */
+
+SV *_c_msaweight_IDFilter(ESL_MSA *msa_in, double maxid)
+{
+  int status;
+  ESL_MSA      *msa_out;        /* an alignment */
+  
+  status = esl_msaweight_IDFilter(msa_in, maxid, &msa_out);
+  if(status != eslOK)
+  {
+    fprintf(stderr, "Failure code %d when attempting to call esl_msaweight_IDFilter", status);
+    return NULL;
+  } 
+  
+  return perl_obj(msa_out, "ESL_MSA");
+}
+
+/* A BEMSA_PROFILE holds per-column residue counts for an MSA,
+ * built in a single pass over msa->ax into one flat, contiguous
+ * matrix (column-major blocks of K+1 counts). The per-position 
+ * statistics (entropy, conservation, coverage, most informative 
+ * sequence and consensus) are all derived from it without any
+ * further passes over the sequences. Counts are accumulated exactly
+ * as esl_abc_DCount() would accumulate them. The parts of the 
+ * alphabet that are needed are copied, so a profile remains valid
+ * after its MSA is freed.
+ */
+typedef struct {
+  int      alen;         /* number of columns */
+  int      nseq;         /* number of sequences */
+  int      K;            /* canonical alphabet size */
+  int      Kp;           /* full alphabet size */
+  int      use_weights;  /* TRUE if counts are weighted by msa->wgt */
+  char    *sym;          /* [0..x..Kp-1] copy of abc->sym */
+  char    *degen;        /* [0..x*K+a..Kp*K-1] copy of abc->degen: TRUE if residue x includes canonical residue a */
+  double  *ct;           /* [0..apos*(K+1)+a..alen*(K+1)-1] count of residue a in column apos, a == K: gaps */
+  int     *ncanonA;      /* [0..apos..alen-1] unweighted number of canonical residues in column apos */
+  double  *bgA;          /* [0..a..K] background counts used by the most informative sequence, see _c_profile_create() */
+} BEMSA_PROFILE;
+
+/* Function:  _c_profile_build_view()
+ * Synopsis:  Count the residues in each of <ncol> columns <colA> 
+ *            of <nseq> sequences <seqA> of a digitized MSA in one 
+ *            pass and return a new BEMSA_PROFILE, identical to 
+ *            that of the corresponding subset MSA. Either <seqA> or
+ *            <colA> may be NULL for all sequences or columns.
+ *
+ *            The background counts, bgA, reproduce those 
+ *            historically used by _c_most_informative_sequence(),
+ *            which added the running column counts to the total
+ *            after each residue was counted, so that the count
+ *            contributed by sequence i is included (nseq - i) times.
+ *
+ * Args:      msa:         the alignment, must be digitized
+ *            seqA:        [0..i..nseq-1] index in <msa> of seq i, or NULL
+ *            nseq:        number of sequences to count
+ *            colA:        [0..apos..ncol-1] index in <msa> of column apos, or NULL
+ *            ncol:        number of columns to count
+ *            use_weights: '1' to weight counts by msa->wgt, '0' not to
+ * Returns:   a new BEMSA_PROFILE, free with _c_profile_destroy()
+ * Dies:      if MSA is not digitized, <use_weights> is '1' but 
+ *            weights are not valid, or out of memory
+ */
+BEMSA_PROFILE *_c_profile_build_view(ESL_MSA *msa, const int *seqA, int nseq, const int64_t *colA, int64_t ncol, int use_weights)
+{
+  int            status;
+  BEMSA_PROFILE *prof = NULL;
+  int            K1;           /* K+1, stride of prof->ct */
+  int            i, a, x;      /* counters */
+  int            sqidx;        /* index of sequence i in <msa> */
+  int64_t        apos;         /* alignment position */
+  ESL_DSQ       *ax;           /* current digitized aligned sequence */
+  double        *col;          /* current column of counts */
+  double         wt;           /* weight of current sequence */
+  double         bgwt;         /* background weight of current sequence */
+  double         dwt;          /* weight for each canonical residue a degenerate residue represents */
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_profile_build() contract violation, MSA is not digitized");
+  if((! (msa->flags & eslMSA_HASWGTS)) && (use_weights)) croak("_c_profile_build() trying to use weights, but they're not valid in the msa");
+
+  ESL_ALLOC(prof, sizeof(BEMSA_PROFILE));
+  prof->alen        = ncol;
+  prof->nseq        = nseq;
+  prof->K           = msa->abc->K;
+  prof->Kp          = msa->abc->Kp;
+  prof->use_weights = use_weights;
+  K1                = prof->K + 1;
+
+  ESL_ALLOC(prof->sym,     sizeof(char)   * (prof->Kp + 1));
+  ESL_ALLOC(prof->degen,   sizeof(char)   * prof->Kp * prof->K);
+  ESL_ALLOC(prof->ct,      sizeof(double) * ESL_MAX(1, (size_t) prof->alen * K1));
+  ESL_ALLOC(prof->ncanonA, sizeof(int)    * ESL_MAX(1, prof->alen));
+  ESL_ALLOC(prof->bgA,     sizeof(double) * K1);
+  memcpy(prof->sym, msa->abc->sym, prof->Kp);
+  prof->sym[prof->Kp] = '\0';
+  for(x = 0; x < prof->Kp; x++) { 
+    for(a = 0; a < prof->K; a++) prof->degen[x * prof->K + a] = msa->abc->degen[x][a] ? TRUE : FALSE;
+  }
+  esl_vec_DSet(prof->ct,      (size_t) prof->alen * K1, 0.);
+  esl_vec_ISet(prof->ncanonA, prof->alen, 0);
+  esl_vec_DSet(prof->bgA,     K1, 0.);
+
+  for(i = 0; i < nseq; i++) { 
+    sqidx = (seqA == NULL) ? i : seqA[i];
+    ax    = msa->ax[sqidx];
+    wt    = (use_weights) ? (float) msa->wgt[sqidx] : 1.0; /* float, as in the original per-statistic functions */
+    bgwt  = wt * (double) (nseq - i);
+    for(apos = 0; apos < ncol; apos++) { 
+      x   = ax[((colA == NULL) ? apos : colA[apos]) + 1];
+      col = prof->ct + (size_t) apos * K1;
+      if(x <= prof->K) { /* canonical or gap */
+        col[x]         += wt;
+        prof->bgA[x]   += bgwt;
+        if(x < prof->K) prof->ncanonA[apos]++;
+      }
+      else if(esl_abc_XIsDegenerate(msa->abc, x)) { 
+        dwt = wt / (double) msa->abc->ndegen[x];
+        for(a = 0; a < prof->K; a++) { 
+          if(msa->abc->degen[x][a]) { 
+            col[a]       += dwt;
+            prof->bgA[a] += bgwt / (double) msa->abc->ndegen[x];
+          }
+        }
+      }
+      /* missing residues and nonresidues are not counted */
+    }
+  }
+
+  return prof;
+
+ ERROR:
+  croak("out of memory in _c_profile_build()");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_profile_build()
+ * Synopsis:  Count the residues in each column of a digitized
+ *            MSA with _c_profile_build_view() and return a new
+ *            BEMSA_PROFILE.
+ */
+BEMSA_PROFILE *_c_profile_build(ESL_MSA *msa, int use_weights)
+{
+  return _c_profile_build_view(msa, NULL, msa->nseq, NULL, msa->alen, use_weights);
+}
+
+/* Function:  _c_profile_create()
+ * Synopsis:  Build a profile of a digitized MSA with 
+ *            _c_profile_build() and return it to Perl.
+ * Returns:   a new BEMSA_PROFILE
+ */
+SV *_c_profile_create(ESL_MSA *msa, int use_weights)
+{
+  return perl_obj(_c_profile_build(msa, use_weights), "BEMSA_PROFILE");
+}
+
+/* Function:  _c_profile_destroy()
+ * Synopsis:  Free a BEMSA_PROFILE.
+ * Returns:   void
+ */
+void _c_profile_destroy(BEMSA_PROFILE *prof)
+{
+  if(prof == NULL) return;
+  if(prof->sym)     free(prof->sym);
+  if(prof->degen)   free(prof->degen);
+  if(prof->ct)      free(prof->ct);
+  if(prof->ncanonA) free(prof->ncanonA);
+  if(prof->bgA)     free(prof->bgA);
+  free(prof);
+  return;
+}
+
+/* Function:  _c_profile_alen()
+ * Synopsis:  Return the number of columns in a BEMSA_PROFILE.
+ */
+int _c_profile_alen(BEMSA_PROFILE *prof)
+{
+  return prof->alen;
+}
+
+/* Function:  _c_profile_nseq()
+ * Synopsis:  Return the number of sequences counted in a BEMSA_PROFILE.
+ */
+int _c_profile_nseq(BEMSA_PROFILE *prof)
+{
+  return prof->nseq;
+}
+
+/* Function:  _c_profile_fill_entropy()
+ * Synopsis:  Fill <entA> [0..apos..alen-1] with the entropy of each
+ *            column, calculated from nongap counts only (eqn 11.8,
+ *            BSA book; Durbin, Eddy, Krogh, Mitchison 1998):
+ *            - sum_i P(x_i) log_2 P(x_i)
+ * Returns:   void
+ */
+void _c_profile_fill_entropy(const BEMSA_PROFILE *prof, double *entA)
+{
+  double  freqA[256];  /* normalized counts for the current column */
+  int     apos, a;
+
+  for(apos = 0; apos < prof->alen; apos++) { 
+    esl_vec_DCopy(prof->ct + (size_t) apos * (prof->K+1), prof->K, freqA);
+    esl_vec_DNorm(freqA, prof->K); /* note: only normalize the first K values, this ignores gaps */
+    entA[apos] = 0.;
+    for(a = 0; a < prof->K; a++) { 
+      if(freqA[a] > eslSMALLX1) { /* above zero */
+        entA[apos] += freqA[a] * (log(freqA[a]) / log(2)); /* convert natural log to log base 2 */
+      }
+    }
+    entA[apos] *= -1.; /* convert to a negative number */
+  }
+  return;
+}
+
+/* Function:  _c_profile_fill_conservation()
+ * Synopsis:  Fill <consA> [0..apos..alen-1] with the 'sequence 
+ *            conservation' of each column: the maximum frequency 
+ *            of any residue, with gaps included when normalizing.
+ * Returns:   void
+ */
+void _c_profile_fill_conservation(const BEMSA_PROFILE *prof, double *consA)
+{
+  double  freqA[256];  /* normalized counts for the current column */
+  int     apos, a;
+
+  for(apos = 0; apos < prof->alen; apos++) { 
+    esl_vec_DCopy(prof->ct + (size_t) apos * (prof->K+1), prof->K+1, freqA);
+    esl_vec_DNorm(freqA, prof->K+1); /* note: normalize all K+1 values (including gaps), this differs from entropy */
+    consA[apos] = 0.;
+    for(a = 0; a < prof->K; a++) { /* look at all non-gaps for most common one */
+      if(freqA[a] > consA[apos]) consA[apos] = freqA[a];
+    }
+  }
+  return;
+}
+
+/* Function:  _c_profile_fill_coverage()
+ * Synopsis:  Fill <covA> [0..apos..alen-1] with the fraction of
+ *            (unweighted) sequences that have a canonical residue
+ *            in each column.
+ * Returns:   void
+ */
+void _c_profile_fill_coverage(const BEMSA_PROFILE *prof, double *covA)
+{
+  int apos;
+
+  for(apos = 0; apos < prof->alen; apos++) covA[apos] = (double) prof->ncanonA[apos] / (double) prof->nseq;
+  return;
+}
+
+/* Function:  _c_profile_mis()
+ * Synopsis:  Return a newly allocated string: the 'most informative
+ *            sequence' (Freyhult, Moulton and Gardner, 2005), see
+ *            _c_most_informative_sequence().
+ * Args:      prof:      the profile
+ *            gapthresh: only positions with >= gapthresh nongaps will become a nongap residue in the MIS
+ * Returns:   the most informative sequence, caller must free it
+ * Dies:      if no residue matches a column, or out of memory
+ */
+char *_c_profile_mis(const BEMSA_PROFILE *prof, float gapthresh)
+{
+  int      status;
+  int      apos, a, a2;       /* counters */
+  double   bgA[256];          /* normalized background frequencies */
+  double   freq;              /* frequency of a residue in a column */
+  double   sum;               /* sum of nongap counts in a column */
+  int      above_bgA[256];    /* [0..a..K-1] '1' if freq of residue 'a' is above background in current column */
+  int      amatch;            /* degenerate residue index that matches current column */
+  int      found_mismatch;    /* set to '1' when candidate degenerate residue doesn't match */
+  char    *mis = NULL;        /* the most informative sequence */
+  const double *col;          /* counts for current column */
+  float    tol = 0.0001;      /* tolerance, see _c_most_informative_sequence() */
+
+  ESL_ALLOC(mis, sizeof(char) * (prof->alen+1)); 
+  mis[prof->alen] = '\0';
+
+  esl_vec_DCopy(prof->bgA, prof->K+1, bgA);
+  esl_vec_DNorm(bgA, prof->K); /* only normalize the first K values (omit gaps) */
+
+  for(apos = 0; apos < prof->alen; apos++) { 
+    col    = prof->ct + (size_t) apos * (prof->K+1);
+    sum    = esl_vec_DSum((double *) col, prof->K); /* only sum first K values (omit gaps) */
+    amatch = -1;
+    if((sum / prof->nseq) < gapthresh) { /* most seqs are gaps at this posn, set mis residue as a gap */
+      amatch = prof->K;
+    }
+    else { 
+      for(a = 0; a < prof->K; a++) { 
+        freq         = (col[a] / sum) + tol; /* normalize, then add a 'tolerance' (which guarantees at least one nt is above bg) */
+        above_bgA[a] = (freq > bgA[a]) ? 1 : 0;
+      }
+      for(a = 0; a <= prof->Kp-3 && amatch == -1; a++) { /* for each residue, including degenerate ones */
+        found_mismatch = 0;
+        for(a2 = 0; a2 < prof->K; a2++) { 
+          if(prof->degen[a * prof->K + a2] != above_bgA[a2]) found_mismatch = 1;
+        }
+        if(! found_mismatch) amatch = a;
+      }
+    }
+    if(amatch == -1) { free(mis); croak("unable to find a matching degenerate residue for position %d\n", apos+1); }
+    mis[apos] = prof->sym[amatch];
+  }
+
+  return mis;
+
+ ERROR:
+  croak("out of memory in _c_profile_mis()");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_profile_consensus()
+ * Synopsis:  Return a newly allocated majority-rule consensus
+ *            sequence: the most frequent canonical residue in each
+ *            column (lowest index on ties), or a gap if the column
+ *            has fewer than <gapthresh> nongaps, as a fraction of
+ *            nseq.
+ * Returns:   the consensus sequence, caller must free it
+ * Dies:      if out of memory
+ */
+char *_c_profile_consensus(const BEMSA_PROFILE *prof, float gapthresh)
 {
-  int status;
-  int tagidx;
+  int      status;
+  int      apos, a, amax;
+  double   sum;
+  char    *cons = NULL;
+  const double *col;
+
+  ESL_ALLOC(cons, sizeof(char) * (prof->alen+1)); 
+  cons[prof->alen] = '\0';
+
+  for(apos = 0; apos < prof->alen; apos++) { 
+    col  = prof->ct + (size_t) apos * (prof->K+1);
+    sum  = esl_vec_DSum((double *) col, prof->K);
+    amax = prof->K; /* gap */
+    if(sum > 0. && (sum / prof->nseq) >= gapthresh) { 
+      amax = 0;
+      for(a = 1; a < prof->K; a++) if(col[a] > col[amax]) amax = a;
+    }
+    cons[apos] = prof->sym[amax];
+  }
 
-  if(msa->ngr > 0) { 
-    status = esl_keyhash_Lookup(msa->gr_idx, tag, -1, &tagidx);
-    if(status == eslOK) return tagidx;
+  return cons;
+
+ ERROR:
+  croak("out of memory in _c_profile_consensus()");
+  return NULL; /* NEVER REACHED */
+}
+
+/* which per-column statistic _c_profile_values() computes */
+#define BEMSA_PROFILE_ENTROPY      0
+#define BEMSA_PROFILE_CONSERVATION 1
+#define BEMSA_PROFILE_COVERAGE     2
+
+/* Function:  _c_profile_values()
+ * Synopsis:  Return a newly allocated array [0..apos..alen-1] of a
+ *            per-column statistic derived from a profile.
+ * Args:      prof:  the profile
+ *            which: BEMSA_PROFILE_ENTROPY, BEMSA_PROFILE_CONSERVATION
+ *                   or BEMSA_PROFILE_COVERAGE
+ * Returns:   the values, caller must free them
+ * Dies:      if <which> is invalid, or out of memory
+ */
+double *_c_profile_values(const BEMSA_PROFILE *prof, int which)
+{
+  int     status;
+  double *valA = NULL;
+
+  ESL_ALLOC(valA, sizeof(double) * ESL_MAX(1, prof->alen));
+  switch(which) { 
+  case BEMSA_PROFILE_ENTROPY:      _c_profile_fill_entropy(prof, valA);      break;
+  case BEMSA_PROFILE_CONSERVATION: _c_profile_fill_conservation(prof, valA); break;
+  case BEMSA_PROFILE_COVERAGE:     _c_profile_fill_coverage(prof, valA);     break;
+  default: free(valA); croak("_c_profile_values() contract violation, invalid statistic %d", which);
   }
-  
-  croak("_c_getGR_tagidx, no such tag exists");
-  return -1; /* never reached */
-}   
+  return valA;
 
-/* Function:  _c_weight_GSC()
- * Incept:    EPN, Fri May 24 10:40:00 2013
- * Purpose:   Calculate sequence weights using the GSC (Gerstein/Sonnhammer/Chotia) 
- *            algorithm.
- * Returns:   eslOK on success, ! eslOK on failure.
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_profile_push_values()
+ * Synopsis:  Return a per-column statistic derived from a profile,
+ *            as an array in Perl's return stack.
+ * Args:      prof:      the profile
+ *            which:     0: entropy, 1: sequence conservation, 2: coverage
+ *            do_packed: '1' to return a single string of packed doubles, '0' for a list
+ * Returns:   prof->alen values
  */
-int _c_weight_GSC(ESL_MSA *msa) 
+void _c_profile_push_values(BEMSA_PROFILE *prof, int which, int do_packed)
 {
-  int    status;
-  status = esl_msaweight_GSC(msa);
-  return status;
+  Inline_Stack_Vars;
+
+  double *valA = _c_profile_values(prof, which);
+  int     apos;
+
+  Inline_Stack_Reset;
+  if(do_packed) Inline_Stack_Push(sv_2mortal(_c_packed_doubles(valA, prof->alen)));
+  else          for(apos = 0; apos < prof->alen; apos++) Inline_Stack_Push(sv_2mortal(newSVnv(valA[apos])));
+  Inline_Stack_Done;
+  free(valA);
+  Inline_Stack_Return(do_packed ? 1 : prof->alen);
 }
 
-/* Function:  _c_msaweight_IDFilter()
- * Incept:    March 1, 2013
- * Purpose:   Calculate and output msa after %id weight filtering
- * Returns:   weighted msa object on success
- *            NULL on failure
+/* Function:  _c_profile_get_mis()
+ * Synopsis:  Return the most informative sequence derived from a profile.
+ * Returns:   the most informative sequence
  */
+SV *_c_profile_get_mis(BEMSA_PROFILE *prof, float gapthresh)
+{
+  char *mis   = _c_profile_mis(prof, gapthresh);
+  SV   *misSV = newSVpv(mis, prof->alen);
 
-SV *_c_msaweight_IDFilter(ESL_MSA *msa_in, double maxid)
+  free(mis);
+  return misSV;
+}
+
+/* Function:  _c_profile_get_consensus()
+ * Synopsis:  Return the majority-rule consensus derived from a profile.
+ * Returns:   the consensus sequence
+ */
+SV *_c_profile_get_consensus(BEMSA_PROFILE *prof, float gapthresh)
 {
-  int status;
-  ESL_MSA      *msa_out;        /* an alignment */
-  
-  status = esl_msaweight_IDFilter(msa_in, maxid, &msa_out);
-  if(status != eslOK)
-  {
-    fprintf(stderr, "Failure code %d when attempting to call esl_msaweight_IDFilter", status);
-    return NULL;
-  } 
-  
-  return perl_obj(msa_out, "ESL_MSA");
+  char *cons   = _c_profile_consensus(prof, gapthresh);
+  SV   *consSV = newSVpv(cons, prof->alen);
+
+  free(cons);
+  return consSV;
 }
 
 /* Function:  _c_percent_coverage()
  * Incept:    March 4, 2013
  * Purpose:   Calculate and output sequence coverage ratios for each alignment position in an msa
+ * Args:      msa:       the alignment
+ *            do_packed: '1' to return a single string of packed doubles, '0' for a list
  * Returns:   array of size 0 to msa->alen, represents position in alignemnt coverage ratio
  *            Nothing on failure
  */
 
-void _c_percent_coverage(ESL_MSA *msa)
+void _c_percent_coverage(ESL_MSA *msa, int do_packed)
 {
   Inline_Stack_Vars;
   
-  int status;
-  int apos, i;
-  double **abc_ct = NULL;
-  double ret = 0.0;
+  BEMSA_PROFILE *prof;
+  double        *covA;
+  int            apos;
   
   //don't let user divide by 0
   if(msa->nseq <= 0)
@@ -1542,45 +3268,28 @@ void _c_percent_coverage(ESL_MSA *msa)
     return;// NULL;
   }
   
-  //first allocate abc_ct matrix
-  ESL_ALLOC(abc_ct, sizeof(double *) * msa->alen); 
-  for(apos = 0; apos < msa->alen; apos++) 
-  { 
-    ESL_ALLOC(abc_ct[apos], sizeof(double) * (msa->abc->K+1));
-    esl_vec_DSet(abc_ct[apos], (msa->abc->K+1), 0.);
-  }
-  
-  //populate abc_ct
-  for(i = 0; i < msa->nseq; i++) 
-  { 
-    for(apos = 0; apos < msa->alen; apos++) 
-    { /* update appropriate abc count, careful, ax ranges from 1..msa->alen (but abc_ct is 0..msa->alen-1) */
-      if(! esl_abc_XIsDegenerate(msa->abc, msa->ax[i][apos+1])) 
-      {
-        if((status = esl_abc_DCount(msa->abc, abc_ct[apos], msa->ax[i][apos+1], 1.0)) != eslOK)
-        {
-          fprintf(stderr, "problem counting residue %d of seq %d", apos, i);
-          return;
-        }
-      }
-    }
-  }
+  prof = _c_profile_build(msa, FALSE);
+  covA = _c_profile_values(prof, BEMSA_PROFILE_COVERAGE);
   
   Inline_Stack_Reset;
   
-  //determine coverage ratio for each position, push it onto the perl return stack
-  for(apos = 0; apos < msa->alen; apos++)
+  //push coverage ratio for each position onto the perl return stack
+  if(do_packed)
   {
-    ret = esl_vec_DSum(abc_ct[apos], msa->abc->K);
-    Inline_Stack_Push(sv_2mortal(newSVnv(ret / (double) msa->nseq)));
-  } 
+    Inline_Stack_Push(sv_2mortal(_c_packed_doubles(covA, msa->alen)));
+  }
+  else
+  {
+    for(apos = 0; apos < msa->alen; apos++)
+    {
+      Inline_Stack_Push(sv_2mortal(newSVnv(covA[apos])));
+    }
+  }
   
   Inline_Stack_Done;
-  Inline_Stack_Return(msa->alen);
-  
-  ERROR:
-    fprintf(stderr, "Memory allocation in _c_percent_coverage failed");
-    return;
+  free(covA);
+  _c_profile_destroy(prof);
+  Inline_Stack_Return(do_packed ? 1 : msa->alen);
 }
 
 /* Function: _c_bp_dist
@@ -1700,6 +3409,21 @@ _c_bp_is_canonical(int a, int b)
   return FALSE;
 }
 
+/* Function: _c_bp_cov_contrib
+ * Purpose:  Helper function for _c_rfam_bp_stats()
+ *           Return the unweighted covariation contribution of
+ *           comparing base pair a1:b1 with a2:b2: the number
+ *           of differences between them (_c_bp_dist()), positive
+ *           if both pairs are canonical (_c_bp_is_canonical()),
+ *           else negative.
+ */
+int 
+_c_bp_cov_contrib(int a1, int b1, int a2, int b2) 
+{
+  int d = _c_bp_dist(a1, b1, a2, b2);
+  return (_c_bp_is_canonical(a1, b1) && _c_bp_is_canonical(a2, b2)) ? d : -1 * d;
+}
+
 /* Function: _c_max_rna_two_letter_ambiguity
  * Incept:   EPN, Mon Jul 15 13:24:33 2013
  * Purpose:  Helper function for _c_rfam_qc_stats().
@@ -1877,7 +3601,7 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
   int       *ct = NULL;            /* 0..alen-1 base pair partners array for current sequence */
   char      *ss_nopseudo = NULL;   /* no-pseudoknot version of structure */
   int        have_weights;         /* set to '1' if MSA has valid weights, else it does not and we'll use 1.0 as the weight for all sequences */
-  double     seqwt1, seqwt2;       /* weight of current sequences */
+  double     seqwt1;               /* weight of current sequence */
   int        nbp = 0;              /* number of canonical basepairs in the (possibly deknotted) consensus secondary structure */
   int       *seq_canA = NULL;      /* [0..i..msa->nseq-1]: number of canonical basepairs in sequence i */
   int       *rposA    = NULL;      /* [0..apos..msa->alen-1]: right position for basepair with left half position of 'apos', else -1 if 'apos' is not left half of a pair (apos always < rpos) */
@@ -1885,15 +3609,21 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
   double    *covA     = NULL;      /* [0..apos..msa->alen-1]: covariation per basepair */
   double    *cov_cntA = NULL;      /* [0..apos..msa->alen-1]: weighted count of basepair covariation per basepair */
   int        apos, rpos;           /* counters over alignment positions */
-  int        i, j;                 /* counters over sequences */
+  int        i;                    /* counter over sequences */
 
   /* variables used when calculating covariation statistic */
-  int a1, b1;            /* int index of left, right half of basepair 1 */
-  int a2, b2;            /* int index of left, right half of basepair 1 */
-  int d;                 /* distance between a1:b1 and a2:b2 (number of differences) */
-  int iscanonical1;      /* is a1:b1 a canonical pair? (by Paul's definition, see _c_bp_is_canonical() */
-  int iscanonical2;      /* is a2:b2 a canonical pair? (by Paul's definition, see _c_bp_is_canonical() */
-  double contrib = 0.;   /* contribution of current a1:b1 compared to a2:b2 */
+  int a1, b1;            /* int index of left, right half of basepair */
+  int K, Kp;             /* msa->abc->K, msa->abc->Kp */
+  int nclass;            /* number of basepair classes, Kp*Kp, class of a1:b1 is a1*Kp+b1 */
+  int c1, c2;            /* basepair classes */
+  int x, y;              /* counters over occupied classes */
+  int nocc;              /* number of occupied classes at current basepair */
+  int *occA     = NULL;  /* [0..x..nocc-1]: occupied classes at current basepair */
+  double *cls_nA = NULL; /* [0..c..nclass-1]: number of non-double-gap seqs with basepair class c */
+  double *cls_wA = NULL; /* [0..c..nclass-1]: summed weight of non-double-gap seqs with basepair class c */
+  double f;              /* unweighted contribution, see _c_bp_cov_contrib() */
+  double ng, wg;         /* number, summed weight of non-double-gap seqs seen so far */
+  double gap_n, gap_w;   /* contribution of seqs seen so far against a double gap, unweighted and weighted */
   double mean_cov = 0.;  /* mean covariation statistic */
 
   have_weights = (msa->flags & eslMSA_HASWGTS) ? 1 : 0;
@@ -1935,49 +3665,87 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
    * original script. Best documentation is probably the code below,
    * unfortunately.
    *
-   * Note this is O(N^2) for N sequences because we have to look at
-   * each pair of sequences. I was fairly certain a O(N) algorithm
-   * existed, but I had trouble getting it to work properly and gave
-   * up lest I waste too much time trying to fix it. This O(N^2) 
-   * approach is from Paul's rqc-ss-cons.pl.
+   * Paul's version compares every pair of sequences i < j at each
+   * basepair, which is O(N^2) for N sequences. Sequence i is only
+   * compared with later sequences if it is not a gap at both
+   * positions, but every later sequence j is included. The
+   * contribution of a pair, d * (w_i + w_j) with d from
+   * _c_bp_cov_contrib(), only depends on the basepair classes
+   * (a1:b1, a2:b2) of the two sequences and on their weights, so we
+   * instead do a single pass over the sequences per basepair and:
+   *
+   * - for non-double-gap sequences, accumulate the number and total
+   *   weight of sequences in each of the Kp*Kp basepair classes. Pairs
+   *   of these are summed in closed form over pairs of occupied classes
+   *   c1, c2 after the pass, as f(c1,c2) * (n_c1 * w_c2 + n_c2 * w_c1).
+   *   Same-class pairs contribute 0 to the covariation.
+   *
+   * - for double-gap sequences j, add the contribution against all
+   *   non-double-gap sequences seen so far, which we keep as running
+   *   sums, since those are the only earlier sequences it is compared
+   *   with.
+   *
+   * This is O(N) per basepair (plus the square of the number of
+   * occupied classes) and gives the same result as the pairwise
+   * approach up to floating point summation order.
    */
+  K      = msa->abc->K;
+  Kp     = msa->abc->Kp;
+  nclass = Kp * Kp;
   ESL_ALLOC(covA,     sizeof(double) * msa->alen);
   ESL_ALLOC(cov_cntA, sizeof(double) * msa->alen);
+  ESL_ALLOC(cls_nA,   sizeof(double) * nclass);
+  ESL_ALLOC(cls_wA,   sizeof(double) * nclass);
+  ESL_ALLOC(occA,     sizeof(int)    * nclass);
   esl_vec_DSet(covA,     msa->alen, 0.);
   esl_vec_DSet(cov_cntA, msa->alen, 0.);
-  for(i = 0; i < msa->nseq; i++) { 
-    seqwt1 = (have_weights) ? msa->wgt[i] : 1.0;
-    for(apos = 0; apos < msa->alen; apos++) { 
-      if(rposA[apos] != -1) { 
-        rpos = rposA[apos]; 
-        a1 = msa->ax[i][apos+1];
-        b1 = msa->ax[i][rpos+1];
-        if(a1 != msa->abc->K || b1 != msa->abc->K) { 
-          iscanonical1 = _c_bp_is_canonical(a1, b1);
-          if(iscanonical1) { 
-            seq_canA[i]++;
-            pos_canA[apos]++;
-          }
-          /* for every other sequence, add contribution of covariation */
-          for(j = i+1; j < msa->nseq; j++) { 
-            seqwt2 = (have_weights) ? msa->wgt[j] : 1.0;
-            a2 = msa->ax[j][apos+1];
-            b2 = msa->ax[j][rpos+1];
-            iscanonical2 = _c_bp_is_canonical(a2, b2);
-            d = _c_bp_dist(a1, b1, a2, b2);
-            if(iscanonical1 && iscanonical2) { 
-              contrib = d * (seqwt1 + seqwt2);
-            }
-            else { 
-              contrib = -1 * d * (seqwt1 + seqwt2);
-            }
-            covA[apos]     += contrib;
-            cov_cntA[apos] += (seqwt1 + seqwt2);
-          }
+  for(apos = 0; apos < msa->alen; apos++) { 
+    if(rposA[apos] == -1) continue;
+    rpos = rposA[apos]; 
+    esl_vec_DSet(cls_nA, nclass, 0.);
+    esl_vec_DSet(cls_wA, nclass, 0.);
+    nocc  = 0;
+    ng    = wg    = 0.;
+    gap_n = gap_w = 0.;
+    for(i = 0; i < msa->nseq; i++) { 
+      seqwt1 = (have_weights) ? msa->wgt[i] : 1.0;
+      a1 = msa->ax[i][apos+1];
+      b1 = msa->ax[i][rpos+1];
+      if(a1 != K || b1 != K) { 
+        if(_c_bp_is_canonical(a1, b1)) { 
+          seq_canA[i]++;
+          pos_canA[apos]++;
         }
+        c1 = a1 * Kp + b1;
+        if(cls_nA[c1] == 0.) occA[nocc++] = c1;
+        cls_nA[c1] += 1.;
+        cls_wA[c1] += seqwt1;
+        f      = _c_bp_cov_contrib(a1, b1, K, K);
+        gap_n += f;
+        gap_w += f * seqwt1;
+        ng    += 1.;
+        wg    += seqwt1;
+      }
+      else { 
+        /* double gap: compared with every earlier non-double-gap sequence */
+        covA[apos]     += gap_n * seqwt1 + gap_w;
+        cov_cntA[apos] += ng    * seqwt1 + wg;
+      }
+    }
+    /* all pairs of non-double-gap sequences, each weight is in ng-1 of them */
+    if(ng > 0.) cov_cntA[apos] += (ng - 1.) * wg;
+    for(x = 0; x < nocc; x++) { 
+      c1 = occA[x];
+      for(y = x+1; y < nocc; y++) { 
+        c2 = occA[y];
+        f  = _c_bp_cov_contrib(c1 / Kp, c1 % Kp, c2 / Kp, c2 % Kp);
+        if(f != 0.) covA[apos] += f * (cls_nA[c1] * cls_wA[c2] + cls_nA[c2] * cls_wA[c1]);
       }
     }
   }
+  free(cls_nA); cls_nA = NULL;
+  free(cls_wA); cls_wA = NULL;
+  free(occA);   occA   = NULL;
 
   /* calculate mean covariation statistic */
   mean_cov = (nbp == 0) ? 0. : esl_vec_DSum(covA, msa->alen) / esl_vec_DSum(cov_cntA, msa->alen);
@@ -2009,6 +3777,9 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
   if(seq_canA) free(seq_canA);
   if(pos_canA) free(pos_canA);
   if(covA)     free(covA);
+  if(cls_nA)   free(cls_nA);
+  if(cls_wA)   free(cls_wA);
+  if(occA)     free(occA);
 
   croak("out of memory");
 
@@ -2021,10 +3792,9 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
  *           average, maximum and minimum percent identity between
  *           all pairs of sequences.
  *
- *           Note: this is slow for very large alignments, but the
- *           largest seed in Rfam 11.0 is 1020 (glnA) so * it's
- *           probably safe at least for seeds, which is what it's
- *           designed for.
+ *           This is O(N^2 L); for large alignments pass <nthreads> > 1
+ *           to compute identities in parallel with _c_pid_fill().
+ *           Results do not depend on <nthreads>.
  *
  * Returns:  ret_pid_mean:  mean    pairwise identity between all pairs of seqs 
  *           ret_pid_min:   minimum pairwise identity between all pairs of seqs 
@@ -2033,29 +3803,14 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
  *           eslOK if successful
  */
 int
-_c_rfam_pid_stats(ESL_MSA *msa, double *ret_pid_mean, double *ret_pid_min, double *ret_pid_max)
-{
-  int    status;         /* Easel status */
-  int    i, j;           /* sequence index counters */
-  double pid_mean = 0.;  /* mean    pairwise id between all pairs of seqs */
-  double pid_min  = 1.;  /* minimum pairwise id between all pairs of seqs */
-  double pid_max  = 0.;  /* maximum pairwise id between all pairs of seqs */
-  double pid;            /* current pairwise id */
-
-  for (i = 0; i < msa->nseq; i++) { 
-    for (j = i+1; j < msa->nseq; j++) { 
-      if(msa->flags & eslMSA_DIGITAL) { 
-        if ((status = esl_dst_XPairId(msa->abc, msa->ax[i], msa->ax[j], &pid, NULL, NULL)) != eslOK) return status;
-      }
-      else { /* text mode */
-        if ((status = esl_dst_CPairId(msa->aseq[i], msa->aseq[j], &pid, NULL, NULL)) != eslOK) return status;
-      }
-      pid_min   = ESL_MIN(pid_min, pid);
-      pid_max   = ESL_MAX(pid_max, pid);
-      pid_mean += pid;
-    }
-  }
-  pid_mean /= (double) (msa->nseq * (msa->nseq-1) / 2);
+_c_rfam_pid_stats(ESL_MSA *msa, int nthreads, double *ret_pid_mean, double *ret_pid_min, double *ret_pid_max)
+{
+  double pid_mean;  /* mean    pairwise id between all pairs of seqs */
+  double pid_min;   /* minimum pairwise id between all pairs of seqs */
+  double pid_max;   /* maximum pairwise id between all pairs of seqs */
+
+  _c_pid_upper_triangle_reduce(msa, nthreads, &pid_mean, &pid_min, &pid_max);
+  pid_mean /= ((double) msa->nseq * (msa->nseq-1) / 2.);
 
   *ret_pid_mean = pid_mean;
   *ret_pid_min  = pid_min;
@@ -2099,7 +3854,8 @@ _c_rfam_pid_stats(ESL_MSA *msa, double *ret_pid_mean, double *ret_pid_min, doubl
  * Helper functions do all the dirty work for this function:
  * _c_rfam_comp_and_len_stats(): sequence length and composition stats
  * _c_rfam_bp_stats():           all basepair-related stats
- * _c_rfam_pid_stats():          percent identity stats
+ * _c_rfam_pid_stats():          percent identity stats, computed with
+ *                               <nthreads> threads
  *
  * This function reproduces all functionality in Paul Gardner's
  * rqc-ss-cons.pl script, last used in Rfam 10.0 and deprecated during
@@ -2108,7 +3864,7 @@ _c_rfam_pid_stats(ESL_MSA *msa, double *ret_pid_mean, double *ret_pid_min, doubl
  * Returns:   eslOK on success.
  */
 
-int _c_rfam_qc_stats(ESL_MSA *msa, char *fam_outfile, char *seq_outfile, char *bp_outfile)
+int _c_rfam_qc_stats(ESL_MSA *msa, char *fam_outfile, char *seq_outfile, char *bp_outfile, int nthreads)
 {
   FILE  *ffp;          /* open output per-family   stats output file */
   FILE  *sfp;          /* open output per-sequence stats output file */
@@ -2159,7 +3915,7 @@ int _c_rfam_qc_stats(ESL_MSA *msa, char *fam_outfile, char *seq_outfile, char *b
   if((bfp = fopen(bp_outfile,  "w"))  == NULL) { croak("unable to open %s for writing", bp_outfile); }
 
   _c_rfam_comp_and_len_stats(msa, &abcAA, &abc_totA, &lenA, &len_tot, &len_min, &len_max);
-  _c_rfam_pid_stats         (msa, &pid_mean, &pid_min, &pid_max);
+  _c_rfam_pid_stats         (msa, nthreads, &pid_mean, &pid_min, &pid_max);
   _c_rfam_bp_stats          (msa, &nbp, &rposA, &seq_canA, &pos_canA, &covA, &mean_cov);
 
   /* calc most common 2-letter ambiguity for full alignment */
@@ -2317,6 +4073,88 @@ _c_clone_msa(ESL_MSA *msa)
   return perl_obj(new_msa, "ESL_MSA");
 }
 
+/* Function: _c_clone_msa_cow
+ * Purpose:  Duplicates an MSA without copying its alignment:
+ *           the new MSA shares the aligned rows, the per-sequence
+ *           SS, SA and PP rows and the RF, MM, SS_cons, SA_cons
+ *           and PP_cons strings of <msa>, and a shared buffer is
+ *           copied only when either MSA first writes to it (see
+ *           the comment above bemsa_cow_own()). Names, accessions,
+ *           descriptions, weights and GF, GS, GC and GR annotation
+ *           are copied, as esl_msa_Clone() does.
+ *
+ *           Creating the clone is O(nseq) plus the size of that
+ *           annotation, instead of O(nseq * alen).
+ *
+ * Args:     msa:   the input alignment
+ *
+ * Returns:  the new msa
+ * Dies:     via croak if out of memory
+ */
+SV *
+_c_clone_msa_cow(ESL_MSA *msa)
+{
+  ESL_MSA *new_msa = NULL;
+  int      i, t;
+
+  if(msa->nseq == 0) return _c_clone_msa(msa);
+
+  /* create with zero length rows, which we replace with the parent's */
+  new_msa = (msa->flags & eslMSA_DIGITAL) ? esl_msa_CreateDigital(msa->abc, msa->nseq, 0) : esl_msa_Create(msa->nseq, 0);
+  if(new_msa == NULL) croak("out of memory");
+  for(i = 0; i < msa->nseq; i++) { 
+    if(msa->flags & eslMSA_DIGITAL) { free(new_msa->ax[i]);   new_msa->ax[i]   = msa->ax[i];   bemsa_cow_ref(msa->ax[i]);   }
+    else                            { free(new_msa->aseq[i]); new_msa->aseq[i] = msa->aseq[i]; bemsa_cow_ref(msa->aseq[i]); }
+  }
+  new_msa->alen  = msa->alen;
+  new_msa->flags = msa->flags;
+  esl_vec_DCopy(msa->wgt, msa->nseq, new_msa->wgt);
+  memcpy(new_msa->cutoff, msa->cutoff, sizeof(float) * eslMSA_NCUTS);
+  memcpy(new_msa->cutset, msa->cutset, sizeof(int)   * eslMSA_NCUTS);
+
+  /* shared per-sequence and per-column annotation */
+  new_msa->ss = bemsa_cow_strarray(msa->ss, msa->nseq, new_msa->sqalloc, TRUE);
+  new_msa->sa = bemsa_cow_strarray(msa->sa, msa->nseq, new_msa->sqalloc, TRUE);
+  new_msa->pp = bemsa_cow_strarray(msa->pp, msa->nseq, new_msa->sqalloc, TRUE);
+  new_msa->rf      = msa->rf;      bemsa_cow_ref(msa->rf);
+  new_msa->mm      = msa->mm;      bemsa_cow_ref(msa->mm);
+  new_msa->ss_cons = msa->ss_cons; bemsa_cow_ref(msa->ss_cons);
+  new_msa->sa_cons = msa->sa_cons; bemsa_cow_ref(msa->sa_cons);
+  new_msa->pp_cons = msa->pp_cons; bemsa_cow_ref(msa->pp_cons);
+
+  /* copied annotation */
+  if(esl_strdup(msa->name, -1, &(new_msa->name)) != eslOK) croak("out of memory");
+  if(esl_strdup(msa->desc, -1, &(new_msa->desc)) != eslOK) croak("out of memory");
+  if(esl_strdup(msa->acc,  -1, &(new_msa->acc))  != eslOK) croak("out of memory");
+  if(esl_strdup(msa->au,   -1, &(new_msa->au))   != eslOK) croak("out of memory");
+  for(i = 0; i < msa->nseq; i++) { 
+    if(msa->sqname[i] != NULL && esl_msa_SetSeqName(new_msa, i, msa->sqname[i], -1) != eslOK) croak("out of memory");
+  }
+  new_msa->sqacc  = bemsa_cow_strarray(msa->sqacc,  msa->nseq, new_msa->sqalloc, FALSE);
+  new_msa->sqdesc = bemsa_cow_strarray(msa->sqdesc, msa->nseq, new_msa->sqalloc, FALSE);
+  for(t = 0; t < msa->ncomment; t++) { 
+    if(esl_msa_AddComment(new_msa, msa->comment[t], -1) != eslOK) croak("out of memory");
+  }
+  for(t = 0; t < msa->ngf; t++) { 
+    if(esl_msa_AddGF(new_msa, msa->gf_tag[t], -1, msa->gf[t], -1) != eslOK) croak("_c_clone_msa_cow(), unable to add GF annotation");
+  }
+  for(t = 0; t < msa->ngs; t++) { 
+    for(i = 0; i < msa->nseq; i++) { 
+      if(msa->gs[t][i] != NULL && esl_msa_AddGS(new_msa, msa->gs_tag[t], -1, i, msa->gs[t][i], -1) != eslOK) croak("_c_clone_msa_cow(), unable to add GS annotation");
+    }
+  }
+  for(t = 0; t < msa->ngc; t++) { 
+    if(esl_msa_AppendGC(new_msa, msa->gc_tag[t], msa->gc[t]) != eslOK) croak("_c_clone_msa_cow(), unable to add GC annotation");
+  }
+  for(t = 0; t < msa->ngr; t++) { 
+    for(i = 0; i < msa->nseq; i++) { 
+      if(msa->gr[t][i] != NULL && esl_msa_AppendGR(new_msa, msa->gr_tag[t], i, msa->gr[t][i]) != eslOK) croak("_c_clone_msa_cow(), unable to add GR annotation");
+    }
+  }
+
+  return perl_obj(new_msa, "ESL_MSA");
+}
+
 /* Function: _c_sequence_subset
  * Incept:   EPN, Thu Nov 14 10:41:06 2013
  * Purpose:  Create a new MSA and return it, with a 
@@ -2376,6 +4214,181 @@ _c_sequence_subset(ESL_MSA *msa, AV *usemeAR)
   return NULL; /* NEVERREACHED */
 }
 
+/* BEMSA_ALIAS: Walker alias table for drawing index i with
+ * probability proportional to a weight w[i], in O(1) per draw */
+typedef struct {
+  int     n;       /* number of indices */
+  double *probA;   /* [0..i..n-1] probability of taking i when i is rolled */
+  int    *aliasA;  /* [0..i..n-1] index taken instead of i otherwise */
+  int    *stackA;  /* [0..i..n-1] workspace for building the table */
+} BEMSA_ALIAS;
+
+/* Function:  _c_alias_build()
+ * Synopsis:  (Re)build alias table <at> for weights <wA>, ignoring
+ *            indices i for which <skipA> is non-NULL and skipA[i] 
+ *            is TRUE (they get probability 0). 
+ * Purpose:   Vose's method: scale weights so their mean is 1, 
+ *            then repeatedly pair an index with scaled weight < 1
+ *            with one >= 1, which donates the difference. Small and
+ *            large indices share one stack, small from the bottom,
+ *            large from the top.
+ * Returns:   void
+ */
+void _c_alias_build(BEMSA_ALIAS *at, const double *wA, const int *skipA)
+{
+  int    n = at->n;
+  int    i, s, l;
+  int    nsmall = 0;
+  int    nlarge = 0;
+  int    anypos = 0;  /* an index with positive weight, alias for zero weight leftovers */
+  double sum    = 0.;
+
+  for(i = 0; i < n; i++) { 
+    if(skipA == NULL || ! skipA[i]) { 
+      sum += wA[i];
+      if(wA[i] > 0.) anypos = i;
+    }
+  }
+  for(i = 0; i < n; i++) { 
+    at->probA[i]  = (skipA == NULL || ! skipA[i]) ? wA[i] * n / sum : 0.;
+    at->aliasA[i] = i;
+    if(at->probA[i] < 1.) at->stackA[nsmall++]       = i;
+    else                  at->stackA[n - 1 - nlarge++] = i;
+  }
+  while(nsmall > 0 && nlarge > 0) { 
+    s = at->stackA[--nsmall];
+    l = at->stackA[n - nlarge];
+    at->aliasA[s] = l;
+    at->probA[l] -= 1. - at->probA[s];
+    if(at->probA[l] < 1.) { /* l is now small */
+      nlarge--;
+      at->stackA[nsmall++] = l;
+    }
+  }
+  /* whatever is left is 1. up to roundoff */
+  while(nlarge > 0) at->probA[at->stackA[n - nlarge--]] = 1.;
+  while(nsmall > 0) { 
+    s = at->stackA[--nsmall];
+    if(at->probA[s] > 0.) at->probA[s] = 1.;
+    else                  at->aliasA[s] = anypos;
+  }
+  return;
+}
+
+/* Function:  _c_alias_draw()
+ * Synopsis:  Draw an index from alias table <at>, in O(1).
+ */
+int _c_alias_draw(BEMSA_ALIAS *at, ESL_RANDOMNESS *r)
+{
+  int i = (int) (esl_random(r) * at->n);
+
+  return (esl_random(r) < at->probA[i]) ? i : at->aliasA[i];
+}
+
+/* Function:  _c_weighted_sample()
+ * Purpose:   Sample <k> sequences from <msa> with probability 
+ *            proportional to their weights msa->wgt (all 1.0 if 
+ *            the MSA has none) and return a new MSA of them, 
+ *            made by esl_msa_SequenceSubset(), so sequences are
+ *            in their original order.
+ *
+ *            Draws are made from a Walker alias table, in O(1)
+ *            each. With <with_replacement>, each distinct sequence
+ *            drawn is kept once and its weight in the new MSA is 
+ *            the number of times it was drawn. Without, draws 
+ *            of already chosen sequences are rejected, which is
+ *            the same as drawing from the remaining sequences in
+ *            proportion to their weights; the table is rebuilt 
+ *            without them whenever they make up more than half 
+ *            of the table's weight, so the expected number of 
+ *            draws per sequence stays below 2. Weights are 
+ *            transferred exactly.
+ *
+ * Args:     msa:              the input alignment
+ *           k:                number of draws 
+ *           r:                ESL_RANDOMNESS
+ *           with_replacement: TRUE to sample with replacement
+ *
+ * Returns:  new subset msa
+ * Dies:     with croak if <k> is not positive, a weight is negative,
+ *           there are fewer than <k> sequences with positive 
+ *           weight when sampling without replacement, or out 
+ *           of memory.
+ */
+SV *
+_c_weighted_sample(ESL_MSA *msa, long k, ESL_RANDOMNESS *r, int with_replacement)
+{
+  int          status;            /* status */
+  ESL_MSA     *new_msa = NULL;    /* the new msa we'll create and return */
+  BEMSA_ALIAS  at;                /* the alias table */
+  int         *countA  = NULL;    /* [0..i..nseq-1] number of times seq i was drawn */
+  int          npos    = 0;       /* number of seqs with positive weight */
+  double       tot     = 0.;      /* total weight */
+  double       tabtot;            /* total weight of table when last built */
+  double       taken   = 0.;      /* weight of seqs chosen since table was last built */
+  long         d;                 /* counter over draws */
+  int          i, j;              /* counters */
+
+  at.probA = NULL; at.aliasA = NULL; at.stackA = NULL;
+  at.n     = msa->nseq;
+
+  if(k < 1) croak("in _c_weighted_sample(), number of sequences to sample (%ld) must be positive", k);
+  for(i = 0; i < msa->nseq; i++) { 
+    if(msa->wgt[i] < 0.) croak("in _c_weighted_sample(), sequence %d has negative weight", i+1);
+    if(msa->wgt[i] > 0.) npos++;
+    tot += msa->wgt[i];
+  }
+  if(npos == 0)                          croak("in _c_weighted_sample(), all sequences have zero weight");
+  if((! with_replacement) && k > npos)   croak("in _c_weighted_sample(), trying to sample %ld seqs without replacement but only %d have positive weight", k, npos);
+
+  ESL_ALLOC(countA,    sizeof(int)    * msa->nseq);
+  ESL_ALLOC(at.probA,  sizeof(double) * msa->nseq);
+  ESL_ALLOC(at.aliasA, sizeof(int)    * msa->nseq);
+  ESL_ALLOC(at.stackA, sizeof(int)    * msa->nseq);
+  for(i = 0; i < msa->nseq; i++) countA[i] = 0;
+
+  _c_alias_build(&at, msa->wgt, NULL);
+  tabtot = tot;
+  for(d = 0; d < k; d++) { 
+    i = _c_alias_draw(&at, r);
+    if(with_replacement) { countA[i]++; continue; }
+
+    while(countA[i]) i = _c_alias_draw(&at, r);
+    countA[i] = 1;
+    taken += msa->wgt[i];
+    tot   -= msa->wgt[i];
+    if(d < k-1 && taken > 0.5 * tabtot) { 
+      _c_alias_build(&at, msa->wgt, countA);
+      tabtot = tot;
+      taken  = 0.;
+    }
+  }
+  status = esl_msa_SequenceSubset(msa, countA, &new_msa);
+  if     (status == eslEINVAL) croak("in _c_weighted_sample(), no sequences in input msa"); 
+  else if(status == eslEMEM)   croak("in _c_weighted_sample(), out of memory");
+  else if(status != eslOK)     croak("in _c_weighted_sample(), esl_msa_SequenceSubset() had a problem");
+
+  if(with_replacement) { 
+    for(i = 0, j = 0; i < msa->nseq; i++) if(countA[i]) new_msa->wgt[j++] = countA[i];
+    new_msa->flags |= eslMSA_HASWGTS;
+  }
+
+  free(countA);
+  free(at.probA);
+  free(at.aliasA);
+  free(at.stackA);
+
+  return perl_obj(new_msa, "ESL_MSA");
+
+ ERROR:
+  if(countA)    free(countA);
+  if(at.probA)  free(at.probA);
+  if(at.aliasA) free(at.aliasA);
+  if(at.stackA) free(at.stackA);
+  croak("in _c_weighted_sample(), out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
 /* Function: _c_remove_all_gap_columns
  * Incept:   EPN, Thu Nov 14 13:44:02 2013
  * Purpose:  Remove columns containing all gap symbols
@@ -2404,6 +4417,7 @@ _c_remove_all_gap_columns(ESL_MSA *msa, int consider_rf)
   int  status;              /* status */
   char errbuf[eslERRBUFSIZE];
 
+  bemsa_cow_own_all(msa);
   if (msa->flags & eslMSA_DIGITAL) { /* digital mode, pass in NULL for gap string */
     status = esl_msa_MinimGaps(msa, errbuf, NULL, consider_rf); 
   }
@@ -2446,6 +4460,7 @@ _c_column_subset(ESL_MSA *msa, AV *usemeAR)
   _c_int_copy_array_perl_to_c(usemeAR, useme, msa->alen);
 
   /* remove the columns in place */
+  bemsa_cow_own_all(msa);
   status = esl_msa_ColumnSubset(msa, errbuf, useme);
   if(status != eslOK) croak ("ERROR, _c_column_subset: %s\n", errbuf);
   
@@ -2537,7 +4552,8 @@ _c_is_residue(ESL_MSA *msa, int sqidx, int apos)
  * Incept:   EPN, Mon Feb  3 14:43:36 2014
  * Purpose:  Reorder sequences in an MSA by swapping pointers.
  *           Copied and slightly modified from esl-alimanip.c's
- *           reorder_msa().
+ *           reorder_msa(). Because only pointers move, rows 
+ *           shared with a copy-on-write clone stay shared.
  *
  * Args:     msa:     the alignment
  *           orderAR: int array specifying new order (orderAR[2] = x ==> x becomes 3rd sequence)
@@ -2612,30 +4628,318 @@ _c_reorder(ESL_MSA *msa, AV *orderAR)
     for(i = 0; i < msa->nseq; i++) msa->sa[i] = tmp[order[i]];
   }
 
-  /* swap pp, if they exist */
-  if(msa->pp != NULL) { 
-    for(i = 0; i < msa->nseq; i++) tmp[i] = msa->pp[i];
-    for(i = 0; i < msa->nseq; i++) msa->pp[i] = tmp[order[i]];
-  }
+  /* swap pp, if they exist */
+  if(msa->pp != NULL) { 
+    for(i = 0; i < msa->nseq; i++) tmp[i] = msa->pp[i];
+    for(i = 0; i < msa->nseq; i++) msa->pp[i] = tmp[order[i]];
+  }
+
+  /* swap gs annotation, if it exists */
+  for(a = 0; a < msa->ngs; a++) {
+    for(i = 0; i < msa->nseq; i++) tmp[i] = msa->gs[a][i];
+    for(i = 0; i < msa->nseq; i++) msa->gs[a][i] = tmp[order[i]];
+  }
+
+  /* swap gr annotation, if it exists */
+  for(a = 0; a < msa->ngr; a++) {
+    for(i = 0; i < msa->nseq; i++) tmp[i] = msa->gr[a][i];
+    for(i = 0; i < msa->nseq; i++) msa->gr[a][i] = tmp[order[i]];
+  }
+  free(tmp);
+
+  free(order);
+  return;
+
+ ERROR:
+  croak("_c_reorder() out of memory");
+}
+
+/* A BEMSA_VIEW is a read-only subset of the sequences and columns
+ * of a parent MSA that is never copied: it holds only the indices
+ * of its sequences and columns, so creating one is O(nseq + alen)
+ * rather than the O(nseq * alen) of esl_msa_SequenceSubset() or
+ * esl_msa_Clone(). The identity and profile engines and the 
+ * sequence string functions below read the parent through the
+ * indices. The parent must not be modified or freed while the 
+ * view exists; Bio::Easel::MSA::View holds a reference to it, 
+ * checks before every use that the parent's ESL_MSA hasn't been
+ * freed or replaced since (by comparing generation counts, as the
+ * pointer alone can be reused), and then calls _c_view_check() to
+ * catch a parent resized in place (e.g. by column_subset()).
+ */
+typedef struct {
+  ESL_MSA *msa;      /* the parent alignment, not owned */
+  int      msa_nseq; /* msa->nseq when the view was created */
+  int64_t  msa_alen; /* msa->alen when the view was created */
+  int      nseq;     /* number of sequences in the view */
+  int     *seqA;   /* [0..i..nseq-1] index in <msa> of view seq i */
+  int64_t  alen;   /* number of columns in the view */
+  int64_t *colA;   /* [0..apos..alen-1] index (0..msa->alen-1) in <msa> of view column apos */
+} BEMSA_VIEW;
+
+/* Function:  _c_view_destroy()
+ * Synopsis:  Free a BEMSA_VIEW, but not its parent MSA.
+ * Returns:   void
+ */
+void _c_view_destroy(BEMSA_VIEW *view)
+{
+  if(view == NULL) return;
+  if(view->seqA) free(view->seqA);
+  if(view->colA) free(view->colA);
+  free(view);
+  return;
+}
+
+/* Function:  _c_view_create()
+ * Synopsis:  Create a view of sequences <seqsAR> and the columns
+ *            of <msa> for which <colmaskAR> is '1'.
+ * Args:      msa:       the parent alignment
+ *            seqsAR:    [0..i..nseq-1] index in <msa> of view seq i, no duplicates
+ *            nseq:      number of elements in <seqsAR>
+ *            colmaskAR: [0..apos..msa->alen-1] '1' to include column apos, '0' not to
+ * Returns:   a new BEMSA_VIEW
+ * Dies:      if an index in <seqsAR> is out of bounds or duplicated,
+ *            or out of memory
+ */
+SV *_c_view_create(ESL_MSA *msa, AV *seqsAR, int nseq, AV *colmaskAR)
+{
+  int         status;
+  BEMSA_VIEW *view  = NULL;  /* the view */
+  int        *maskA = NULL;  /* [0..apos..msa->alen-1] C copy of colmaskAR, then used to check seqA for duplicates */
+  int64_t     apos;          /* alignment position */
+  int         i;             /* sequence counter */
+  int         bad = 0;       /* invalid or duplicate sequence index */
+
+  ESL_ALLOC(view, sizeof(BEMSA_VIEW));
+  view->msa      = msa;
+  view->msa_nseq = msa->nseq;
+  view->msa_alen = msa->alen;
+  view->nseq     = nseq;
+  view->seqA = NULL;
+  view->alen = 0;
+  view->colA = NULL;
+
+  ESL_ALLOC(maskA,      sizeof(int)     * ESL_MAX(1, ESL_MAX(msa->alen, msa->nseq)));
+  ESL_ALLOC(view->seqA, sizeof(int)     * ESL_MAX(1, nseq));
+  ESL_ALLOC(view->colA, sizeof(int64_t) * ESL_MAX(1, msa->alen));
+
+  _c_int_copy_array_perl_to_c(colmaskAR, maskA, msa->alen);
+  for(apos = 0; apos < msa->alen; apos++) if(maskA[apos]) view->colA[view->alen++] = apos;
+
+  _c_int_copy_array_perl_to_c(seqsAR, view->seqA, nseq);
+  esl_vec_ISet(maskA, msa->nseq, FALSE);
+  for(i = 0; i < nseq; i++) { 
+    bad = view->seqA[i];
+    if(bad < 0 || bad >= msa->nseq || maskA[bad]) break;
+    maskA[bad] = TRUE;
+  }
+  free(maskA);
+  if(i < nseq) { 
+    _c_view_destroy(view);
+    if(bad < 0 || bad >= msa->nseq) croak("_c_view_create(), sequence index %d out of bounds (nseq: %d)", bad, msa->nseq);
+    else                            croak("_c_view_create(), sequence index %d listed twice", bad);
+  }
+
+  return perl_obj(view, "BEMSA_VIEW");
+
+ ERROR:
+  if(maskA != NULL) free(maskA);
+  _c_view_destroy(view);
+  croak("out of memory in _c_view_create()");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_view_check()
+ * Synopsis:  Check that a view's parent MSA still has the same 
+ *            number of sequences and columns as when the view was
+ *            created. The caller must already know the parent is
+ *            alive, see Bio::Easel::MSA::View::_check_view().
+ * Returns:   void
+ * Dies:      via croak if it doesn't.
+ */
+void _c_view_check(BEMSA_VIEW *view)
+{
+  ESL_MSA *msa = view->msa;
+
+  if(msa->nseq != view->msa_nseq || msa->alen != view->msa_alen) { 
+    croak("parent MSA of view was modified after the view was created (nseq: %d, alen: %" PRId64 "; was nseq: %d, alen: %" PRId64 ")", msa->nseq, msa->alen, view->msa_nseq, view->msa_alen);
+  }
+  return;
+}
+
+/* Function:  _c_view_nseq()
+ * Synopsis:  Return the number of sequences in a BEMSA_VIEW.
+ */
+int _c_view_nseq(BEMSA_VIEW *view)
+{
+  return view->nseq;
+}
+
+/* Function:  _c_view_alen()
+ * Synopsis:  Return the number of columns in a BEMSA_VIEW.
+ */
+int _c_view_alen(BEMSA_VIEW *view)
+{
+  return (int) view->alen;
+}
+
+/* Function:  _c_view_sqidx()
+ * Synopsis:  Return the index in the parent MSA of view sequence <i>.
+ */
+int _c_view_sqidx(BEMSA_VIEW *view, int i)
+{
+  if(i < 0 || i >= view->nseq) croak("_c_view_sqidx(), sequence index %d out of bounds (nseq: %d)", i, view->nseq);
+  return view->seqA[i];
+}
+
+/* Function:  _c_view_get_sqstring_aligned()
+ * Purpose:   Return aligned sequence <i> of a view, its residues 
+ *            in the view's columns, written directly into the 
+ *            returned SV.
+ * Returns:   Aligned sequence <i>.
+ */
+SV *_c_view_get_sqstring_aligned(BEMSA_VIEW *view, int i)
+{
+  ESL_MSA *msa   = view->msa;
+  int      sqidx = _c_view_sqidx(view, i);
+  SV      *seqstringSV;
+  char    *p;
+  int64_t  apos;
+
+  seqstringSV = newSV(view->alen + 1);
+  SvPOK_on(seqstringSV);
+  p = SvPVX(seqstringSV);
+  if(msa->flags & eslMSA_DIGITAL) { 
+    for(apos = 0; apos < view->alen; apos++) p[apos] = msa->abc->sym[msa->ax[sqidx][view->colA[apos]+1]];
+  }
+  else { 
+    for(apos = 0; apos < view->alen; apos++) p[apos] = msa->aseq[sqidx][view->colA[apos]];
+  }
+  p[view->alen] = '\0';
+  SvCUR_set(seqstringSV, view->alen);
+
+  return seqstringSV;
+}
+
+/* Function:  _c_view_get_sqstring_unaligned()
+ * Purpose:   Return unaligned sequence <i> of a view, its residues
+ *            in the view's columns: gaps and missing data are 
+ *            removed as esl_sq_FetchFromMSA() removes them.
+ * Returns:   Unaligned sequence <i>.
+ */
+SV *_c_view_get_sqstring_unaligned(BEMSA_VIEW *view, int i)
+{
+  ESL_MSA *msa   = view->msa;
+  int      sqidx = _c_view_sqidx(view, i);
+  SV      *seqstringSV;
+  char    *p;
+  int64_t  apos;
+  int64_t  n = 0;
+  ESL_DSQ  x;
+  char     c;
+
+  seqstringSV = newSV(view->alen + 1);
+  SvPOK_on(seqstringSV);
+  p = SvPVX(seqstringSV);
+  if(msa->flags & eslMSA_DIGITAL) { 
+    for(apos = 0; apos < view->alen; apos++) { 
+      x = msa->ax[sqidx][view->colA[apos]+1];
+      if(! (esl_abc_XIsGap(msa->abc, x) || esl_abc_XIsMissing(msa->abc, x))) p[n++] = msa->abc->sym[x];
+    }
+  }
+  else { 
+    for(apos = 0; apos < view->alen; apos++) { 
+      c = msa->aseq[sqidx][view->colA[apos]];
+      if(strchr("-_.~", c) == NULL) p[n++] = c;
+    }
+  }
+  p[n] = '\0';
+  SvCUR_set(seqstringSV, n);
+
+  return seqstringSV;
+}
+
+/* Function:  _c_view_pid_matrix()
+ * Purpose:   As _c_pid_matrix(), for the sequences and columns of
+ *            a view; indices are view sequence indices. Values are 
+ *            identical to those of the corresponding subset MSA.
+ * Returns:   packed string of nrows * view->nseq doubles
+ */
+SV *_c_view_pid_matrix(BEMSA_VIEW *view, AV *rowsAR, int nrows, int nthreads)
+{
+  BEMSA_PID *pid = _c_pid_create_view(view->msa, view->seqA, view->nseq, view->colA, view->alen);
+  SV        *mxSV;
+
+  mxSV = _c_pid_matrix_from_pid(pid, rowsAR, nrows, nthreads);
+  _c_pid_destroy(pid);
+
+  return mxSV;
+}
+
+/* Function:  _c_view_profile_create()
+ * Synopsis:  Build a profile of the sequences and columns of a 
+ *            view of a digitized MSA with _c_profile_build_view()
+ *            and return it to Perl.
+ * Returns:   a new BEMSA_PROFILE
+ */
+SV *_c_view_profile_create(BEMSA_VIEW *view, int use_weights)
+{
+  return perl_obj(_c_profile_build_view(view->msa, view->seqA, view->nseq, view->colA, view->alen, use_weights), "BEMSA_PROFILE");
+}
 
-  /* swap gs annotation, if it exists */
-  for(a = 0; a < msa->ngs; a++) {
-    for(i = 0; i < msa->nseq; i++) tmp[i] = msa->gs[a][i];
-    for(i = 0; i < msa->nseq; i++) msa->gs[a][i] = tmp[order[i]];
+/* Function:  _c_view_materialize()
+ * Purpose:   Create a new MSA holding a copy of the sequences and
+ *            columns of a view, in view order, for writing it with
+ *            Easel's MSA writers. Made with esl_msa_SequenceSubset()
+ *            and esl_msa_ColumnSubset(), so annotation is handled 
+ *            as sequence_subset() and column_subset() handle it.
+ * Returns:   new msa, the caller must free it
+ * Dies:      with croak upon an error
+ */
+SV *_c_view_materialize(BEMSA_VIEW *view)
+{
+  int      status;
+  ESL_MSA *new_msa = NULL;  /* the new msa */
+  int     *useme   = NULL;  /* [0..i..msa->nseq-1] then [0..apos..msa->alen-1]: TRUE to keep seq i/col apos */
+  AV      *orderAV = NULL;  /* order for _c_reorder(), if view seqs aren't in parent order */
+  char     errbuf[eslERRBUFSIZE];
+  int64_t  apos;
+  int      i, rank;
+  int      is_sorted = TRUE;
+
+  ESL_ALLOC(useme, sizeof(int) * ESL_MAX(1, ESL_MAX(view->msa->nseq, view->msa->alen)));
+  esl_vec_ISet(useme, view->msa->nseq, FALSE);
+  for(i = 0; i < view->nseq; i++) { 
+    useme[view->seqA[i]] = TRUE;
+    if(i > 0 && view->seqA[i] < view->seqA[i-1]) is_sorted = FALSE;
+  }
+  status = esl_msa_SequenceSubset(view->msa, useme, &new_msa);
+  if     (status == eslEINVAL) croak("in _c_view_materialize(), no sequences in view"); 
+  else if(status != eslOK)     croak("in _c_view_materialize(), esl_msa_SequenceSubset() had a problem");
+
+  if(view->alen < view->msa->alen) { 
+    esl_vec_ISet(useme, view->msa->alen, FALSE);
+    for(apos = 0; apos < view->alen; apos++) useme[view->colA[apos]] = TRUE;
+    if(esl_msa_ColumnSubset(new_msa, errbuf, useme) != eslOK) croak("in _c_view_materialize(), esl_msa_ColumnSubset() had a problem: %s", errbuf);
   }
 
-  /* swap gr annotation, if it exists */
-  for(a = 0; a < msa->ngr; a++) {
-    for(i = 0; i < msa->nseq; i++) tmp[i] = msa->gr[a][i];
-    for(i = 0; i < msa->nseq; i++) msa->gr[a][i] = tmp[order[i]];
+  if(! is_sorted) { 
+    /* useme[i]: rank of parent seq i in new_msa */
+    esl_vec_ISet(useme, view->msa->nseq, FALSE);
+    for(i = 0; i < view->nseq; i++) useme[view->seqA[i]] = TRUE;
+    for(i = 0, rank = 0; i < view->msa->nseq; i++) if(useme[i]) useme[i] = rank++;
+    orderAV = newAV();
+    for(i = 0; i < view->nseq; i++) av_push(orderAV, newSViv(useme[view->seqA[i]]));
+    _c_reorder(new_msa, orderAV);
+    SvREFCNT_dec((SV *) orderAV);
   }
-  free(tmp);
+  free(useme);
 
-  free(order);
-  return;
+  return perl_obj(new_msa, "ESL_MSA");
 
  ERROR:
-  croak("_c_reorder() out of memory");
+  croak("out of memory in _c_view_materialize()");
+  return NULL; /* NEVER REACHED */
 }
 
 /* Function:  _c_check_index()
@@ -2672,6 +4976,7 @@ void _c_capitalize_based_on_rf(ESL_MSA *msa)
 
   if(msa->rf == NULL)             croak("ERROR, _c_capitalize_based_on_rf() RF annotation does not exist"); 
   if(msa->flags & eslMSA_DIGITAL) croak("ERROR, _c_capitalize_based_on_rf() MSA is not in text mode"); 
+  for(i = 0; i < msa->nseq; i++) msa->aseq[i] = bemsa_cow_own(msa->aseq[i], msa->alen+1);
 
   for (apos = 0; apos < msa->alen; apos++) {
     if(strchr("-_.~", msa->rf[apos]) == NULL) { /* nongap RF character */
@@ -2748,114 +5053,19 @@ char *_c_get_gf(ESL_MSA *msa, int idx)
  * Returns:   the 'most informative sequence' calculated here.
  * Dies:      if MSA is NOT digitized, or if use_weights is '1' and weights are invalid
  */
-char *_c_most_informative_sequence(ESL_MSA *msa, float gapthresh, int use_weights)
+SV *_c_most_informative_sequence(ESL_MSA *msa, float gapthresh, int use_weights)
 {
-  int        status;           /* Easel status */
-  int        i;                /* counter over sequences */
-  int        a, a2;            /* counters over alphabet indices (residues) */
-  int        apos;             /* alignment position counter [0..alen-1] and [0..rflen-1], respectively */
-  double   **abcAA    = NULL;  /* [0..apos..msa->alen-1][0..a..abc->K]: count of nt 'a' in column 'apos', a==abc->K are gaps, missing residues or nonresidues */
-  double    *abc_totA = NULL;  /* [0..a..abc->K]: count of nt 'a' in all sequences, a==abc->K are gaps, missing residues or nonresidues */
-  double     sum;              /* sum of a vector, used in several contexts */
-  char      *mis = NULL;       /* the most informative sequence, allocated below */
-  int       *above_bgA = NULL; /* [0..a..abc->K-1] above_bg[a] is '1' if freq of nt 'a' is above background in current column */
-  int        amatch;           /* degenerate residue index that matches current column */
-  int        found_mismatch;   /* set to '1' when we found a mismatch for current column and candidate degenerate residue */
-  float      seqwt = 0.;       /* weight of current sequence, always 1.0 if use_weights == FALSE */
-  float      tol = 0.0001;     /* tolerance, amount of leeway we allow for defining if a nt in a column is above background, 
-                                * we add this to the observed frequency. This reproduces how Paul Gardner implemented the MSI 
-                                * calculation originally for Rfam 11.0 and earlier, possibly because it guarantees at least one nt is 
-                                * always above background.
-                                */
+  BEMSA_PROFILE *prof;   /* residue counts per column */
+  SV            *misSV;  /* the most informative sequence */
 
   if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_most_informative_sequence() contract violation, MSA is not digitized");
   if((! (msa->flags & eslMSA_HASWGTS)) && (use_weights)) croak("_c_most_informative_sequence() trying to use weights, but they're not valid in the msa");
-    
-  /* allocate and initialize */
-  ESL_ALLOC(abcAA,       sizeof(double *)  * msa->alen); 
-  ESL_ALLOC(abc_totA,    sizeof(double) * (msa->abc->K+1)); 
-  esl_vec_DSet(abc_totA, msa->abc->K+1, 0.);
-
-  for(apos = 0; apos < msa->alen; apos++) { 
-    ESL_ALLOC(abcAA[apos], sizeof(double) * (msa->abc->K+1));
-    esl_vec_DSet(abcAA[apos], (msa->abc->K+1), 0.);
-  }
-  ESL_ALLOC(mis, sizeof(char) * (msa->alen+1)); 
-  mis[msa->alen] = '\0';
-  ESL_ALLOC(above_bgA, sizeof(int) * msa->abc->K);
-  
-  /* compile counts */
-  for(i = 0; i < msa->nseq; i++) { 
-    seqwt = (use_weights) ? msa->wgt[i] : 1.0;
-    for(apos = 0; apos < msa->alen; apos++) { 
-      if((status = esl_abc_DCount(msa->abc, abcAA[apos], msa->ax[i][apos+1], seqwt)) != eslOK) croak("problem counting residue %d of seq %d", apos, i);
-      esl_vec_DAdd(abc_totA, abcAA[apos], msa->abc->K+1); /* add this seqs count to the abc_totA array */
-    }
-  }
-
-  /* normalize the nongap chars in the abc_totA vector */
-  esl_vec_DNorm(abc_totA, msa->abc->K); /* only normalize the first K values (omit gaps) */
-
-  /* determine the most informative (possibly degenerate) residue at each position */
-  for(apos = 0; apos < msa->alen; apos++) { 
-    esl_vec_ISet(above_bgA, msa->abc->K, 0);  /* initialize above_bgA */
-    sum = esl_vec_DSum(abcAA[apos], msa->abc->K); /* only sum first K values (omit nonresidues) */
-    amatch = -1; /* this is set to a valid a [0..msa->abc->Kp-3] when we find it, and acts as a flag if we don't find one (which is an error) */
-    /* fprintf(stderr, "apos: %4d sum/nseq: %.3f gapthresh: %.3f\n", apos, sum/msa->nseq, gapthresh); */
-    if((sum / msa->nseq) < gapthresh) { /* most seqs are gaps at this posn, set mis residue as a gap */
-      amatch = msa->abc->K; /* gap character */
-    }
-    else { /* not mostly gaps, calculate most informative residue */
-      esl_vec_ISet(above_bgA, msa->abc->K, 0);
-      for(a = 0; a < msa->abc->K; a++) { 
-        abcAA[apos][a] = (abcAA[apos][a] / sum) + tol; /* normalize, then add  a 'tolerance' of 0.0001 (which guarantees at least one nt is above bg) */
-        /*fprintf(stderr, "apos: %3d a: %d freq: %.3f bg: %.3f\n", apos, a, abcAA[apos][a], abc_totA[a]);*/
-        if(abcAA[apos][a] > abc_totA[a]) above_bgA[a] = 1;
-      }
-      for(a = 0; a <= msa->abc->Kp-3; a++) { /* for each nucleotide, including degenerate ones */
-        found_mismatch = 0;
-        for(a2 = 0; a2 < msa->abc->K; a2++) {
-          if(msa->abc->degen[a][a2] != above_bgA[a2]) { /* a non-match */
-            found_mismatch = 1;
-          }
-        }
-        if(! found_mismatch) { 
-          amatch = a;
-          a = msa->abc->Kp; /* breaks us out of 'for(a = 0)' loop */
-        }
-      }
-    }
-    if(amatch == -1) { croak("unable to find a matching degenerate residue for position %d\n", apos+1); }
-    mis[apos] = msa->abc->sym[amatch];
-  }
-
-  /* clean up and return */
-  if(abcAA) {
-    for(apos = 0; apos < msa->alen; apos++) { 
-      if(abcAA[apos]) { 
-        free(abcAA[apos]);
-      }
-    }
-  }
-  free(abcAA);
-  if(above_bgA) free(above_bgA);
-  if(abc_totA) free(abc_totA);
 
-  return mis;
+  prof  = _c_profile_build(msa, use_weights);
+  misSV = _c_profile_get_mis(prof, gapthresh);
+  _c_profile_destroy(prof);
 
- ERROR:
-  if(abcAA) {
-    for(apos = 0; apos < msa->alen; apos++) { 
-      if(abcAA[apos]) { 
-        free(abcAA[apos]);
-      }
-    }
-  }
-  free(abcAA);
-  if(above_bgA) free(above_bgA);
-  if(abc_totA) free(abc_totA);
-  croak("out of memory in _c_most_informative_sequence()");
-  return NULL; /* not reached */
+  return misSV;
 }
 
 /* Function:  _c_map_rfpos_to_apos()
@@ -2933,10 +5143,11 @@ int _c_map_rfpos_to_apos(ESL_MSA *msa, ESL_ALPHABET *abc, int **ret_i_am_rf, int
 /* Function:  _c_pos_fcbp()
  * Incept:    EPN, Mon May 19 13:39:53 2014
  * Synopsis:  Calculate and return fraction of canonical basepairs at each alignment position.
- * Args:      msa: the alignment
+ * Args:      msa:       the alignment
+ *            do_packed: '1' to return a single string of packed doubles, '0' for a list
  * Returns:   the fraction of canonical basepairs at each aln position (as an array in Perl's return stack) 
  */
-void _c_pos_fcbp(ESL_MSA *msa)
+void _c_pos_fcbp(ESL_MSA *msa, int do_packed)
 {
   Inline_Stack_Vars;
 
@@ -2963,21 +5174,21 @@ void _c_pos_fcbp(ESL_MSA *msa)
 
   /* fill Perl's return stack */
   Inline_Stack_Reset;
-  for(apos = 0; apos < msa->alen; apos++) { 
-    /* fprintf(stderr, "C: apos: %3d fcbp: %.3f\n", apos, fcbpA[apos]); */
-    Inline_Stack_Push(newSVnv(fcbpA[apos])); 
-    /* is the following line the proper way? both this and the above line seem to work fine...: 
-     * Inline_Stack_Push(sv_2mortal(newSVnv(fcbpA[apos]))); 
-     */
+  if(do_packed) { 
+    Inline_Stack_Push(sv_2mortal(_c_packed_doubles(fcbpA, msa->alen)));
+  }
+  else { 
+    for(apos = 0; apos < msa->alen; apos++) { 
+      Inline_Stack_Push(sv_2mortal(newSVnv(fcbpA[apos]))); 
+    }
   }
   Inline_Stack_Done;
-  Inline_Stack_Return(msa->alen);
   
   /* clean up and return */
   if(fcbpA)    free(fcbpA);
   if(rposA)    free(rposA);
   if(pos_canA) free(pos_canA);
-  return;
+  Inline_Stack_Return(do_packed ? 1 : msa->alen);
 
  ERROR:
   if(fcbpA)    free(fcbpA);
@@ -2990,10 +5201,11 @@ void _c_pos_fcbp(ESL_MSA *msa)
 /* Function:  _c_pos_covariation()
  * Incept:    EPN, Tue May 20 09:26:03 2014
  * Synopsis:  Calculate and return the covariation statistic (Lindgreen, Gardner, Krogh, 2006) at each alignment position.
- * Args:      msa: the alignment
+ * Args:      msa:       the alignment
+ *            do_packed: '1' to return a single string of packed doubles, '0' for a list
  * Returns:   the covariation statistics at each aln position (as an array in Perl's return stack) 
  */
-void _c_pos_covariation(ESL_MSA *msa)
+void _c_pos_covariation(ESL_MSA *msa, int do_packed)
 {
   Inline_Stack_Vars;
 
@@ -3006,102 +5218,66 @@ void _c_pos_covariation(ESL_MSA *msa)
   /* calculate covariation statistic */
   _c_rfam_bp_stats (msa, NULL, &rposA, NULL, NULL, &covA, NULL);
   
-  /* _c_rfam_bp_stats() only sets covA to a non-zero value for the left half posns of basepairs, 
-   * copy those values to the corresponding right half posns, and while you're at it, fill the
-   * return array. 
-   */
-  Inline_Stack_Reset;
   for(apos = 0; apos < msa->alen; apos++) { 
     if(rposA[apos] != -1) { 
       covA[rposA[apos]] = covA[apos]; /* set covA value for right position equal to left position */
     }
-    Inline_Stack_Push(newSVnv(covA[apos])); 
+  }
+  Inline_Stack_Reset;
+  if(do_packed) { 
+    Inline_Stack_Push(sv_2mortal(_c_packed_doubles(covA, msa->alen)));
+  }
+  else { 
+    for(apos = 0; apos < msa->alen; apos++) { 
+      Inline_Stack_Push(sv_2mortal(newSVnv(covA[apos]))); 
+    }
   }
   Inline_Stack_Done;
-  Inline_Stack_Return(msa->alen);
   
   /* clean up and return */
   if(rposA) free(rposA);
   if(covA)  free(covA);
-  return;
+  Inline_Stack_Return(do_packed ? 1 : msa->alen);
 }
 
 /* Function:  _c_pos_entropy()
  * Incept:    EPN, Tue May 20 10:45:41 2014
  * Synopsis:  Calculate and return the entropy at each alignment position.
- * Args:      msa: the alignment
+ * Args:      msa:         the alignment
+ *            use_weights: '1' to use weights, '0' not to
+ *            do_packed:   '1' to return a single string of packed doubles, '0' for a list
  * Returns:   the entropy at each aln position (as an array in Perl's return stack) 
  */
-void _c_pos_entropy(ESL_MSA *msa, int use_weights)
+void _c_pos_entropy(ESL_MSA *msa, int use_weights, int do_packed)
 {
   Inline_Stack_Vars;
 
-  int        status;           /* error status */
-  int        apos;             /* counter over alignment positions */
-  int        i;                /* counter over sequences */
-  int        a;                /* counter over residues in an alphabet */
-  float      seqwt = 0.;       /* weight of current sequence, always 1.0 if use_weights == FALSE */
-  double   **abcAA    = NULL;  /* [0..apos..msa->alen-1][0..a..abc->K]: count of nt 'a' in column 'apos', a==abc->K are gaps, missing residues or nonresidues */
-  double    *entA     = NULL;  /* [0..apos..msa->alen-1] entropy of column apos */
+  int            apos;   /* counter over alignment positions */
+  BEMSA_PROFILE *prof;   /* residue counts per column */
+  double        *valA;   /* [0..apos..msa->alen-1] entropy of column apos */
 
   if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_pos_entropy() contract violation, MSA is not digitized");
   if((! (msa->flags & eslMSA_HASWGTS)) && (use_weights)) croak("_c_pos_entropy() trying to use weights, but they're not valid in the msa");
 
-  /* entropy (eqn 11.8, BSA book; Durbin, Eddy, Krogh, Mitchison 1998) 
-   * - sum_i P(x_i) log P(x_i)
-   * where i ranges over each residue in the alphabet (e.g. nucleotides) 
-   */
+  prof = _c_profile_build(msa, use_weights);
+  valA = _c_profile_values(prof, BEMSA_PROFILE_ENTROPY);
 
-  /* allocate and initialize */
-  ESL_ALLOC(abcAA, sizeof(double *)  * msa->alen); 
-  for(apos = 0; apos < msa->alen; apos++) { 
-    ESL_ALLOC(abcAA[apos], sizeof(double) * (msa->abc->K+1));
-    esl_vec_DSet(abcAA[apos], (msa->abc->K+1), 0.);
+  /* fill return array */
+  Inline_Stack_Reset;
+  if(do_packed) { 
+    Inline_Stack_Push(sv_2mortal(_c_packed_doubles(valA, msa->alen)));
   }
-  ESL_ALLOC(entA, sizeof(double) * msa->alen);
-  esl_vec_DSet(entA, msa->alen, 0.);
-
-  /* compile counts */
-  for(i = 0; i < msa->nseq; i++) { 
-    seqwt = (use_weights) ? msa->wgt[i] : 1.0;
+  else { 
     for(apos = 0; apos < msa->alen; apos++) { 
-      if((status = esl_abc_DCount(msa->abc, abcAA[apos], msa->ax[i][apos+1], seqwt)) != eslOK) croak("problem counting residue %d of seq %d", apos, i);
-    }
-  }
-
-  /* calculate entropy, and fill return array */
-  Inline_Stack_Reset;
-  for(apos = 0; apos < msa->alen; apos++) { 
-    esl_vec_DNorm(abcAA[apos], msa->abc->K); /* note: only normalize the first msa->abc->K values, this will ignore gaps and normalize nongap counts */
-    for(a = 0; a < msa->abc->K; a++) { 
-      if(abcAA[apos][a] > eslSMALLX1) { /* above zero */
-        entA[apos] += abcAA[apos][a] * (log(abcAA[apos][a]) / log(2)); /* convert natural log to log base 2 */
-        /*fprintf(stderr, "apos %3d a %3d added %5.3f to entA[apos], new value: %5.3f\n", apos, a, abcAA[apos][a] * (log(abcAA[apos][a]) / log(2)), entA[apos]);*/
-      }
+      Inline_Stack_Push(sv_2mortal(newSVnv(valA[apos]))); 
     }
-    entA[apos] *= -1.; /* convert to a negative number */
-    /*fprintf(stderr, "entA[%2d]: %.3f\n", apos, entA[apos]);*/
-    Inline_Stack_Push(newSVnv(entA[apos])); 
   }
   Inline_Stack_Done;
-  Inline_Stack_Return(msa->alen);
 
   /* clean up and return */
-  if(abcAA) { 
-    for(i = 0; i < msa->nseq; i++) { if(abcAA[i]) free(abcAA[i]); }
-    free(abcAA);
-  }
-  if(entA)  free(entA);
-  return;
-
- ERROR:
-  if(abcAA) { 
-    for(i = 0; i < msa->nseq; i++) { if(abcAA[i]) free(abcAA[i]); }
-    free(abcAA);
-  }
-  if(entA)  free(entA);
-  croak("ERROR: _c_pos_entropy(), out of memory");
-  return;
+  free(valA);
+  _c_profile_destroy(prof);
+  Inline_Stack_Return(do_packed ? 1 : msa->alen);
 }
 
 
@@ -3112,72 +5288,41 @@ void _c_pos_entropy(ESL_MSA *msa, int use_weights)
  *            residue in a column, where frequency is number of occurences divided by
  *            number of sequences (so no column with >=1 gap can have a conservation of 1.0).
  *            And all gap columns have a conservation of 0.0.
- * Args:      msa: the alignment
+ * Args:      msa:         the alignment
+ *            use_weights: '1' to use weights, '0' not to
+ *            do_packed:   '1' to return a single string of packed doubles, '0' for a list
  * Returns:   the sequence conservation at each aln position (as an array in Perl's return stack) 
  */
-void _c_pos_conservation(ESL_MSA *msa, int use_weights)
+void _c_pos_conservation(ESL_MSA *msa, int use_weights, int do_packed)
 {
   Inline_Stack_Vars;
 
-  int        status;           /* error status */
-  int        apos;             /* counter over alignment positions */
-  int        i;                /* counter over sequences */
-  int        a;                /* counter over residues in an alphabet */
-  float      seqwt = 0.;       /* weight of current sequence, always 1.0 if use_weights == FALSE */
-  double   **abcAA    = NULL;  /* [0..apos..msa->alen-1][0..a..abc->K]: count of nt 'a' in column 'apos', a==abc->K are gaps, missing residues or nonresidues */
-  double    *consA    = NULL;  /* [0..apos..msa->alen-1] sequence conservation of column apos */
+  int            apos;   /* counter over alignment positions */
+  BEMSA_PROFILE *prof;   /* residue counts per column */
+  double        *valA;   /* [0..apos..msa->alen-1] sequence conservation of column apos */
 
   if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_pos_conservation() contract violation, MSA is not digitized");
   if((! (msa->flags & eslMSA_HASWGTS)) && (use_weights)) croak("_c_pos_conservation() trying to use weights, but they're not valid in the msa");
 
-  /* allocate and initialize */
-  ESL_ALLOC(abcAA, sizeof(double *)  * msa->alen); 
-  for(apos = 0; apos < msa->alen; apos++) { 
-    ESL_ALLOC(abcAA[apos], sizeof(double) * (msa->abc->K+1));
-    esl_vec_DSet(abcAA[apos], (msa->abc->K+1), 0.);
-  }
-  ESL_ALLOC(consA, sizeof(double) * msa->alen);
-  esl_vec_DSet(consA, msa->alen, 0.);
-
-  /* compile counts */
-  for(i = 0; i < msa->nseq; i++) { 
-    seqwt = (use_weights) ? msa->wgt[i] : 1.0;
-    for(apos = 0; apos < msa->alen; apos++) { 
-      if((status = esl_abc_DCount(msa->abc, abcAA[apos], msa->ax[i][apos+1], seqwt)) != eslOK) croak("problem counting residue %d of seq %d", apos, i);
-    }
-  }
+  prof = _c_profile_build(msa, use_weights);
+  valA = _c_profile_values(prof, BEMSA_PROFILE_CONSERVATION);
 
-  /* calculate sequence conservation, and fill return array */
+  /* fill return array */
   Inline_Stack_Reset;
-  for(apos = 0; apos < msa->alen; apos++) { 
-    esl_vec_DNorm(abcAA[apos], msa->abc->K+1); /* note: normalize all msa->abc->K+1 values (including gaps) this differs from what we did in _c_pos_entropy() */
-    for(a = 0; a < msa->abc->K; a++) { /* look at all non-gaps for most common one */
-      if(abcAA[apos][a] > consA[apos]) { 
-        consA[apos] = abcAA[apos][a];
-      }
+  if(do_packed) { 
+    Inline_Stack_Push(sv_2mortal(_c_packed_doubles(valA, msa->alen)));
+  }
+  else { 
+    for(apos = 0; apos < msa->alen; apos++) { 
+      Inline_Stack_Push(sv_2mortal(newSVnv(valA[apos]))); 
     }
-    /*fprintf(stderr, "consA[%2d]: %.3f\n", apos, consA[apos]);*/
-    Inline_Stack_Push(newSVnv(consA[apos])); 
   }
   Inline_Stack_Done;
-  Inline_Stack_Return(msa->alen);
 
   /* clean up and return */
-  if(abcAA) { 
-    for(i = 0; i < msa->nseq; i++) { if(abcAA[i]) free(abcAA[i]); }
-    free(abcAA);
-  }
-  if(consA)  free(consA);
-  return;
-
- ERROR:
-  if(abcAA) { 
-    for(i = 0; i < msa->nseq; i++) { if(abcAA[i]) free(abcAA[i]); }
-    free(abcAA);
-  }
-  if(consA)  free(consA);
-  croak("ERROR: _c_pos_conservation(), out of memory");
-  return;
+  free(valA);
+  _c_profile_destroy(prof);
+  Inline_Stack_Return(do_packed ? 1 : msa->alen);
 }
     
 /* Function:  _c_remove_gap_rf_basepairs()
@@ -3197,6 +5342,7 @@ void _c_remove_gap_rf_basepairs(ESL_MSA *msa, int do_wussify)
 
   if(msa->rf      == NULL) croak("ERROR, _c_remove_gap_rf_basepairs() RF annotation does not exist"); 
   if(msa->ss_cons == NULL) croak("ERROR, _c_remove_gap_rf_basepairs() SS_cons annotation does not exist"); 
+  msa->ss_cons = bemsa_cow_own(msa->ss_cons, msa->alen+1);
 
   ESL_ALLOC(i_am_rf, sizeof(int) * (msa->alen+1));
   esl_vec_ISet(i_am_rf, (msa->alen+1), 0);
@@ -3273,3 +5419,490 @@ int _c_rfpos_to_aligned_pos (ESL_MSA *msa, int rfpos, char *gapstr)
 
   return -1; /* NEVER REACHED */
 }   
+
+/* Binary MSA files, written by _c_save_binary() and read by 
+ * _c_load_binary(). A fixed size header (BEMSA_BIN_HEADER) is
+ * followed by a payload: the digitized ax rows (alen+2 bytes each,
+ * including sentinels), weights, cutoffs, then all name and
+ * annotation strings, each stored as an int64_t length (-1 for
+ * NULL) followed by its characters (no terminal '\0'). The header
+ * stores the payload size and a Jenkins one-at-a-time hash of the
+ * payload. Values are in native byte order, files written on a
+ * machine with different byte order fail the <byteorder> check.
+ * Increment BEMSA_BIN_VERSION whenever the layout changes.
+ */
+#define BEMSA_BIN_MAGIC     "BEMSABIN"
+#define BEMSA_BIN_VERSION   1
+#define BEMSA_BIN_BYTEORDER 0x01020304
+
+typedef struct {
+  char     magic[8];      /* BEMSA_BIN_MAGIC, not '\0' terminated */
+  uint32_t version;       /* BEMSA_BIN_VERSION */
+  uint32_t byteorder;     /* BEMSA_BIN_BYTEORDER */
+  uint32_t checksum;      /* Jenkins one-at-a-time hash of the payload */
+  int32_t  abc_type;      /* msa->abc->type */
+  int32_t  flags;         /* msa->flags */
+  int32_t  reserved;      /* unused, 0 */
+  uint64_t payload_size;  /* number of bytes following the header */
+  int64_t  nseq;          /* msa->nseq */
+  int64_t  alen;          /* msa->alen */
+} BEMSA_BIN_HEADER;
+
+typedef struct {
+  FILE     *fp;      /* open output file */
+  uint32_t  hash;    /* running (unfinalized) hash of bytes written so far */
+  uint64_t  nbytes;  /* number of payload bytes written so far */
+} BEMSA_BIN_WRITER;
+
+typedef struct {
+  const char *p;     /* current position in the mapped payload */
+  const char *end;   /* one past the last byte of the mapped payload */
+} BEMSA_BIN_READER;
+
+/* Function:  _c_bin_hash()
+ * Synopsis:  Update a running Jenkins one-at-a-time hash (the same 
+ *            hash esl_msa_Checksum() uses) with <n> bytes from <p>.
+ *            Finalize with _c_bin_hash_final().
+ * Returns:   updated hash
+ */
+uint32_t _c_bin_hash (const unsigned char *p, uint64_t n, uint32_t hash)
+{
+  uint64_t i;
+
+  for(i = 0; i < n; i++) { 
+    hash += p[i];
+    hash += (hash << 10);
+    hash ^= (hash >> 6);
+  }
+  return hash;
+}
+
+/* Function:  _c_bin_hash_final()
+ * Synopsis:  Finalize a hash computed with _c_bin_hash().
+ * Returns:   final hash
+ */
+uint32_t _c_bin_hash_final (uint32_t hash)
+{
+  hash += (hash << 3);
+  hash ^= (hash >> 11);
+  hash += (hash << 15);
+  return hash;
+}
+
+/* Function:  _c_bin_write()
+ * Synopsis:  Write <n> bytes from <data> to a binary MSA file, 
+ *            updating the writer's hash and byte count.
+ * Returns:   void
+ * Dies:      if write fails
+ */
+void _c_bin_write (BEMSA_BIN_WRITER *w, const void *data, uint64_t n)
+{
+  if(n == 0) return;
+  if(fwrite(data, 1, n, w->fp) != n) croak("_c_save_binary(), write failed");
+  w->hash    = _c_bin_hash((const unsigned char *) data, n, w->hash);
+  w->nbytes += n;
+  return;
+}
+
+/* Function:  _c_bin_write_int64()
+ * Synopsis:  Write an int64_t to a binary MSA file.
+ * Returns:   void
+ */
+void _c_bin_write_int64 (BEMSA_BIN_WRITER *w, int64_t value)
+{
+  _c_bin_write(w, &value, sizeof(int64_t));
+  return;
+}
+
+/* Function:  _c_bin_write_str()
+ * Synopsis:  Write a (possibly NULL) string to a binary MSA file.
+ * Returns:   void
+ */
+void _c_bin_write_str (BEMSA_BIN_WRITER *w, const char *s)
+{
+  int64_t len = (s == NULL) ? -1 : (int64_t) strlen(s);
+
+  _c_bin_write_int64(w, len);
+  if(len > 0) _c_bin_write(w, s, len);
+  return;
+}
+
+/* Function:  _c_bin_write_strarray()
+ * Synopsis:  Write a (possibly NULL) array of <n> (possibly NULL)
+ *            strings to a binary MSA file: a flag that is 1 if
+ *            the array exists, followed by the <n> strings if so.
+ * Returns:   void
+ */
+void _c_bin_write_strarray (BEMSA_BIN_WRITER *w, char **sA, int n)
+{
+  int i;
+
+  _c_bin_write_int64(w, (sA == NULL) ? 0 : 1);
+  if(sA != NULL) { 
+    for(i = 0; i < n; i++) _c_bin_write_str(w, sA[i]);
+  }
+  return;
+}
+
+/* Function:  _c_bin_read()
+ * Synopsis:  Copy <n> bytes from a mapped binary MSA file to <dest>.
+ * Returns:   void
+ * Dies:      if fewer than <n> bytes remain
+ */
+void _c_bin_read (BEMSA_BIN_READER *r, void *dest, uint64_t n)
+{
+  if((uint64_t) (r->end - r->p) < n) croak("_c_load_binary(), binary MSA file is truncated or corrupt");
+  memcpy(dest, r->p, n);
+  r->p += n;
+  return;
+}
+
+/* Function:  _c_bin_read_int64()
+ * Synopsis:  Read an int64_t from a mapped binary MSA file.
+ * Returns:   the value
+ */
+int64_t _c_bin_read_int64 (BEMSA_BIN_READER *r)
+{
+  int64_t value;
+
+  _c_bin_read(r, &value, sizeof(int64_t));
+  return value;
+}
+
+/* Function:  _c_bin_read_str()
+ * Synopsis:  Read a string from a mapped binary MSA file without
+ *            copying it.
+ * Returns:   pointer to the (not '\0' terminated) string in the 
+ *            mapping, or NULL if a NULL string was stored;
+ *            <*ret_len> is set to the string's length.
+ * Dies:      if the file is truncated or corrupt
+ */
+const char *_c_bin_read_str (BEMSA_BIN_READER *r, int64_t *ret_len)
+{
+  const char *s;
+  int64_t     len = _c_bin_read_int64(r);
+
+  *ret_len = 0;
+  if(len < 0) return NULL;
+  if(r->end - r->p < len) croak("_c_load_binary(), binary MSA file is truncated or corrupt");
+  s     = r->p;
+  r->p += len;
+  *ret_len = len;
+  return s;
+}
+
+/* Function:  _c_bin_read_strdup()
+ * Synopsis:  Read a string from a mapped binary MSA file into
+ *            newly allocated, '\0' terminated memory.
+ * Returns:   void, <*ret_s> is the new string, or NULL if a NULL
+ *            string was stored.
+ */
+void _c_bin_read_strdup (BEMSA_BIN_READER *r, char **ret_s)
+{
+  const char *s;
+  int64_t     len;
+
+  s = _c_bin_read_str(r, &len);
+  *ret_s = NULL;
+  if(s != NULL && esl_memstrdup(s, len, ret_s) != eslOK) croak("out of memory");
+  return;
+}
+
+/* Function:  _c_bin_read_strarray()
+ * Synopsis:  Read an array of <n> strings written by 
+ *            _c_bin_write_strarray() into newly allocated memory.
+ *            <alloc> is the number of elements to allocate (>= <n>),
+ *            extra elements are set to NULL.
+ * Returns:   void, <*ret_sA> is the new array, or NULL if a NULL
+ *            array was stored.
+ */
+void _c_bin_read_strarray (BEMSA_BIN_READER *r, int n, int alloc, char ***ret_sA)
+{
+  int    status;
+  char **sA = NULL;
+  int    i;
+
+  *ret_sA = NULL;
+  if(_c_bin_read_int64(r) == 0) return;
+
+  ESL_ALLOC(sA, sizeof(char *) * ESL_MAX(alloc, 1));
+  for(i = 0; i < alloc; i++) sA[i] = NULL;
+  for(i = 0; i < n;     i++) _c_bin_read_strdup(r, &(sA[i]));
+
+  *ret_sA = sA;
+  return;
+
+ ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function:  _c_bin_free_strarray()
+ * Synopsis:  Free an array of <n> strings read by _c_bin_read_strarray().
+ * Returns:   void
+ */
+void _c_bin_free_strarray (char **sA, int n)
+{
+  int i;
+
+  if(sA == NULL) return;
+  for(i = 0; i < n; i++) if(sA[i] != NULL) free(sA[i]);
+  free(sA);
+  return;
+}
+
+/* Function:  _c_save_binary()
+ * Synopsis:  Save a digitized MSA, including all of its names and
+ *            annotation, to a binary file that can be loaded with
+ *            _c_load_binary() without parsing.
+ * Args:      msa:     the digitized alignment
+ *            outfile: name of binary file to write
+ * Returns:   eslOK on success; 
+ *            eslFAIL if unable to open file for writing.
+ *            eslEWRITE if a write fails.
+ * Dies:      if <msa> is not digitized.
+ */
+int _c_save_binary (ESL_MSA *msa, char *outfile)
+{
+  FILE             *fp;   /* open output file */
+  BEMSA_BIN_HEADER  hdr;  /* file header */
+  BEMSA_BIN_WRITER  w;    /* payload writer */
+  int               i;    /* counter */
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_save_binary(), MSA must be digitized");
+
+  if((fp = fopen(outfile, "wb")) == NULL) return eslFAIL;
+
+  memset(&hdr, 0, sizeof(BEMSA_BIN_HEADER));
+  memcpy(hdr.magic, BEMSA_BIN_MAGIC, 8);
+  hdr.version   = BEMSA_BIN_VERSION;
+  hdr.byteorder = BEMSA_BIN_BYTEORDER;
+  hdr.abc_type  = msa->abc->type;
+  hdr.flags     = msa->flags;
+  hdr.nseq      = msa->nseq;
+  hdr.alen      = msa->alen;
+  /* write the header now to reserve space, we rewrite it after the 
+   * payload, when we know its size and checksum */
+  if(fwrite(&hdr, sizeof(BEMSA_BIN_HEADER), 1, fp) != 1) { fclose(fp); return eslEWRITE; }
+
+  w.fp     = fp;
+  w.hash   = 0;
+  w.nbytes = 0;
+
+  /* the alignment and weights */
+  for(i = 0; i < msa->nseq; i++) _c_bin_write(&w, msa->ax[i], msa->alen+2);
+  _c_bin_write(&w, msa->wgt,    sizeof(double) * msa->nseq);
+  _c_bin_write(&w, msa->cutoff, sizeof(float)  * eslMSA_NCUTS);
+  _c_bin_write(&w, msa->cutset, sizeof(int)    * eslMSA_NCUTS);
+
+  /* per-alignment annotation */
+  _c_bin_write_str(&w, msa->name);
+  _c_bin_write_str(&w, msa->desc);
+  _c_bin_write_str(&w, msa->acc);
+  _c_bin_write_str(&w, msa->au);
+  _c_bin_write_str(&w, msa->ss_cons);
+  _c_bin_write_str(&w, msa->sa_cons);
+  _c_bin_write_str(&w, msa->pp_cons);
+  _c_bin_write_str(&w, msa->rf);
+  _c_bin_write_str(&w, msa->mm);
+
+  /* per-sequence names and annotation */
+  _c_bin_write_strarray(&w, msa->sqname, msa->nseq);
+  _c_bin_write_strarray(&w, msa->sqacc,  msa->nseq);
+  _c_bin_write_strarray(&w, msa->sqdesc, msa->nseq);
+  _c_bin_write_strarray(&w, msa->ss,     msa->nseq);
+  _c_bin_write_strarray(&w, msa->sa,     msa->nseq);
+  _c_bin_write_strarray(&w, msa->pp,     msa->nseq);
+
+  /* comments and GF, GS, GC, GR annotation */
+  _c_bin_write_int64(&w, msa->ncomment);
+  _c_bin_write_strarray(&w, msa->comment, msa->ncomment);
+  _c_bin_write_int64(&w, msa->ngf);
+  _c_bin_write_strarray(&w, msa->gf_tag, msa->ngf);
+  _c_bin_write_strarray(&w, msa->gf,     msa->ngf);
+  _c_bin_write_int64(&w, msa->ngs);
+  for(i = 0; i < msa->ngs; i++) { 
+    _c_bin_write_str     (&w, msa->gs_tag[i]);
+    _c_bin_write_strarray(&w, msa->gs[i], msa->nseq);
+  }
+  _c_bin_write_int64(&w, msa->ngc);
+  _c_bin_write_strarray(&w, msa->gc_tag, msa->ngc);
+  _c_bin_write_strarray(&w, msa->gc,     msa->ngc);
+  _c_bin_write_int64(&w, msa->ngr);
+  for(i = 0; i < msa->ngr; i++) { 
+    _c_bin_write_str     (&w, msa->gr_tag[i]);
+    _c_bin_write_strarray(&w, msa->gr[i], msa->nseq);
+  }
+
+  /* finalize and rewrite the header */
+  hdr.payload_size = w.nbytes;
+  hdr.checksum     = _c_bin_hash_final(w.hash);
+  if(fseek(fp, 0, SEEK_SET) != 0)                        { fclose(fp); return eslEWRITE; }
+  if(fwrite(&hdr, sizeof(BEMSA_BIN_HEADER), 1, fp) != 1) { fclose(fp); return eslEWRITE; }
+  if(fclose(fp) != 0) return eslEWRITE;
+
+  return eslOK;
+}
+
+/* Function:  _c_load_binary()
+ * Synopsis:  Load a digitized MSA from a binary file written by 
+ *            _c_save_binary(). The file is memory mapped and its
+ *            version and checksum are verified, then the ax rows
+ *            are copied directly out of the mapping and the
+ *            annotation is set, with no parsing. (The rows are copied
+ *            rather than referenced because an ESL_MSA owns, and
+ *            frees, its row buffers.)
+ * Args:      infile: name of binary file to read
+ * Returns:   the new ESL_MSA
+ * Dies:      via croak if the file can't be mapped, has the wrong
+ *            magic number, version or byte order, or fails the 
+ *            checksum or size checks.
+ */
+SV *_c_load_binary (char *infile)
+{
+  int               fd;            /* file descriptor */
+  struct stat       st;            /* for file size */
+  char             *map = NULL;    /* the memory mapped file */
+  BEMSA_BIN_HEADER  hdr;           /* file header */
+  BEMSA_BIN_READER  r;             /* payload reader */
+  ESL_ALPHABET     *abc = NULL;    /* alphabet */
+  ESL_MSA          *msa = NULL;    /* the new MSA */
+  const char       *s;             /* a string in the mapping */
+  int64_t           len;           /* length of <s> */
+  char            **tagA = NULL;   /* GF or GC tags */
+  char             *tag = NULL;    /* a GS or GR tag */
+  char             *value = NULL;  /* a GC or GR value */
+  int64_t           n;             /* number of comments or GF, GS, GC, GR tags */
+  int64_t           t;             /* counter over tags */
+  int               i;             /* counter over sequences */
+  int               has_arr;       /* TRUE if a per-sequence array was stored */
+
+  if((fd = open(infile, O_RDONLY)) == -1) croak("_c_load_binary(), unable to open %s", infile);
+  if(fstat(fd, &st) != 0)                 { close(fd); croak("_c_load_binary(), unable to stat %s", infile); }
+  if(st.st_size < (off_t) sizeof(BEMSA_BIN_HEADER)) { close(fd); croak("_c_load_binary(), %s is too small to be a binary MSA file", infile); }
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED) croak("_c_load_binary(), unable to memory map %s", infile);
+
+  memcpy(&hdr, map, sizeof(BEMSA_BIN_HEADER));
+  if(memcmp(hdr.magic, BEMSA_BIN_MAGIC, 8) != 0)  { munmap(map, st.st_size); croak("_c_load_binary(), %s is not a binary MSA file", infile); }
+  if(hdr.byteorder != BEMSA_BIN_BYTEORDER)         { munmap(map, st.st_size); croak("_c_load_binary(), %s was written on a machine with different byte order", infile); }
+  if(hdr.version   != BEMSA_BIN_VERSION)           { munmap(map, st.st_size); croak("_c_load_binary(), %s is binary MSA format version %d, expected version %d", infile, hdr.version, BEMSA_BIN_VERSION); }
+  if(hdr.payload_size != (uint64_t) (st.st_size - sizeof(BEMSA_BIN_HEADER))) { munmap(map, st.st_size); croak("_c_load_binary(), %s is truncated", infile); }
+  if(hdr.nseq < 0 || hdr.nseq > INT_MAX || hdr.alen < 0) { munmap(map, st.st_size); croak("_c_load_binary(), %s is corrupt", infile); }
+
+  r.p   = map + sizeof(BEMSA_BIN_HEADER);
+  r.end = map + st.st_size;
+  if(_c_bin_hash_final(_c_bin_hash((const unsigned char *) r.p, hdr.payload_size, 0)) != hdr.checksum) { 
+    munmap(map, st.st_size); 
+    croak("_c_load_binary(), %s failed checksum test, file is corrupt", infile);
+  }
+
+  if((abc = esl_alphabet_Create(hdr.abc_type)) == NULL) croak("_c_load_binary(), unable to create alphabet of type %d", hdr.abc_type);
+  if((msa = esl_msa_CreateDigital(abc, hdr.nseq, hdr.alen)) == NULL) croak("out of memory");
+
+  /* the alignment and weights */
+  for(i = 0; i < msa->nseq; i++) _c_bin_read(&r, msa->ax[i], msa->alen+2);
+  _c_bin_read(&r, msa->wgt,    sizeof(double) * msa->nseq);
+  _c_bin_read(&r, msa->cutoff, sizeof(float)  * eslMSA_NCUTS);
+  _c_bin_read(&r, msa->cutset, sizeof(int)    * eslMSA_NCUTS);
+  if(hdr.flags & eslMSA_HASWGTS) msa->flags |= eslMSA_HASWGTS;
+
+  /* per-alignment annotation */
+  _c_bin_read_strdup(&r, &(msa->name));
+  _c_bin_read_strdup(&r, &(msa->desc));
+  _c_bin_read_strdup(&r, &(msa->acc));
+  _c_bin_read_strdup(&r, &(msa->au));
+  _c_bin_read_strdup(&r, &(msa->ss_cons));
+  _c_bin_read_strdup(&r, &(msa->sa_cons));
+  _c_bin_read_strdup(&r, &(msa->pp_cons));
+  _c_bin_read_strdup(&r, &(msa->rf));
+  _c_bin_read_strdup(&r, &(msa->mm));
+
+  /* per-sequence names and annotation; sqname is always allocated
+   * by esl_msa_CreateDigital(), the others are optional */
+  if((has_arr = _c_bin_read_int64(&r)) != 0) { 
+    for(i = 0; i < msa->nseq; i++) { 
+      s = _c_bin_read_str(&r, &len);
+      if(s != NULL && esl_msa_SetSeqName(msa, i, s, len) != eslOK) croak("out of memory");
+    }
+  }
+  _c_bin_read_strarray(&r, msa->nseq, msa->sqalloc, &(msa->sqacc));
+  _c_bin_read_strarray(&r, msa->nseq, msa->sqalloc, &(msa->sqdesc));
+  _c_bin_read_strarray(&r, msa->nseq, msa->sqalloc, &(msa->ss));
+  _c_bin_read_strarray(&r, msa->nseq, msa->sqalloc, &(msa->sa));
+  _c_bin_read_strarray(&r, msa->nseq, msa->sqalloc, &(msa->pp));
+
+  /* comments and GF annotation */
+  n = _c_bin_read_int64(&r);
+  if(_c_bin_read_int64(&r) != 0) { 
+    for(t = 0; t < n; t++) { 
+      s = _c_bin_read_str(&r, &len);
+      if(esl_msa_AddComment(msa, (char *) s, len) != eslOK) croak("out of memory");
+    }
+  }
+  n = _c_bin_read_int64(&r);
+  _c_bin_read_strarray(&r, n, n, &tagA);
+  if(_c_bin_read_int64(&r) != 0) { 
+    for(t = 0; t < n; t++) { 
+      s = _c_bin_read_str(&r, &len);
+      if(esl_msa_AddGF(msa, tagA[t], -1, (char *) s, len) != eslOK) croak("_c_load_binary(), unable to add GF annotation");
+    }
+  }
+  _c_bin_free_strarray(tagA, n);
+  tagA = NULL;
+
+  /* GS annotation */
+  n = _c_bin_read_int64(&r);
+  for(t = 0; t < n; t++) { 
+    _c_bin_read_strdup(&r, &tag);
+    if(_c_bin_read_int64(&r) != 0) { 
+      for(i = 0; i < msa->nseq; i++) { 
+        s = _c_bin_read_str(&r, &len);
+        if(s != NULL && esl_msa_AddGS(msa, tag, -1, i, (char *) s, len) != eslOK) croak("_c_load_binary(), unable to add GS annotation");
+      }
+    }
+    free(tag);
+    tag = NULL;
+  }
+
+  /* GC annotation */
+  n = _c_bin_read_int64(&r);
+  _c_bin_read_strarray(&r, n, n, &tagA);
+  if(_c_bin_read_int64(&r) != 0) { 
+    for(t = 0; t < n; t++) { 
+      _c_bin_read_strdup(&r, &value);
+      if(esl_msa_AppendGC(msa, tagA[t], value) != eslOK) croak("_c_load_binary(), unable to add GC annotation");
+      free(value);
+      value = NULL;
+    }
+  }
+  _c_bin_free_strarray(tagA, n);
+  tagA = NULL;
+
+  /* GR annotation */
+  n = _c_bin_read_int64(&r);
+  for(t = 0; t < n; t++) { 
+    _c_bin_read_strdup(&r, &tag);
+    if(_c_bin_read_int64(&r) != 0) { 
+      for(i = 0; i < msa->nseq; i++) { 
+        _c_bin_read_strdup(&r, &value);
+        if(value != NULL) { 
+          if(esl_msa_AppendGR(msa, tag, i, value) != eslOK) croak("_c_load_binary(), unable to add GR annotation");
+          free(value);
+          value = NULL;
+        }
+      }
+    }
+    free(tag);
+    tag = NULL;
+  }
+
+  if(r.p != r.end) { 
+    munmap(map, st.st_size);
+    croak("_c_load_binary(), %s has unexpected trailing data", infile);
+  }
+  munmap(map, st.st_size);
+
+  return perl_obj(msa, "ESL_MSA");
+}
@@ -70,7 +70,7 @@ use Inline
   VERSION  => '0.01',
   ENABLE   => 'AUTOWRAP',
   INC      => "-I$easel_src_dir",
-  LIBS     => "-L$easel_src_dir -leasel",
+  LIBS     => "-L$easel_src_dir -leasel -lpthread",
   TYPEMAPS => $typemaps,
   NAME     => 'Bio::Easel::MSA';
 
@@ -112,6 +112,13 @@ No functions currently exported.
            : <isRna>:        '1' to force RNA alphabet
            : <isDna>:        '1' to force DNA alphabet
            : <isAmino>:      '1' to force protein alphabet
+           : <name>:         optional: name (#=GF ID) or accession (#=GF AC)
+           :                 of the MSA to read from a multi-MSA <fileLocation>;
+           :                 uses (and creates, if it doesn't exist or is older
+           :                 than <fileLocation>) the SSI index
+           :                 <fileLocation>.ssi to read only that MSA
+           : <forceIndex>:   '1' to index <fileLocation>, even if .ssi file
+           :                 already exists
            :
   Returns  : Bio::Easel::MSA object
 
@@ -124,6 +131,10 @@ sub new {
 
   bless( $self, $caller );
 
+  # incremented whenever {esl_msa} is freed or replaced, so
+  # Bio::Easel::MSA::View objects can tell their parent changed
+  $self->{generation} = 0;
+
   # set flag to digitize, unless forceText passed in
   if ( defined $args->{forceText} && $args->{forceText}) { 
     $self->{digitize} = 0;
@@ -141,6 +152,9 @@ sub new {
   if ( defined $args->{isAmino} ) { 
     $self->{isAmino} = $args->{isAmino};
   }
+  if ( defined $args->{name} ) { 
+    $self->{fetchName} = $args->{name};
+  }
 
   # First check that the file exists. If it exists, read it with
   # Easel and populate the object from the ESL_MSA object
@@ -151,6 +165,10 @@ sub new {
         $self->{reqdFormat} = $args->{reqdFormat};
         $self->_check_reqd_format();
       }
+      # index the file, if forceIndex set
+      if ( defined $args->{forceIndex} && $args->{forceIndex}) { 
+        create_ssi_index($self->{path});
+      }
       $self->read_msa();
     };    # end of eval
     if ($@) {
@@ -266,6 +284,10 @@ sub is_digitized {
   Incept   : EPN, Mon Jan 28 09:26:24 2013
   Usage    : $msaObject->read_msa($fileLocation)
   Function : Opens $fileLocation, reads first MSA, sets it.
+           : If $self->{fetchName} is set (<name> passed to new()),
+           : reads the MSA with that name or accession instead, 
+           : using the SSI index, which is (re)created if it doesn't 
+           : exist or is older than the alignment file.
   Args     : <fileLocation>: file location of alignment, required unless $self->{path} already set
            : <reqdFormat>:   optional, required format of alignment file
            : <do_text>:      optional, TRUE to read alignment in text mode
@@ -312,7 +334,17 @@ sub read_msa {
     $self->_check_reqd_format();
   }
 
-  ($self->{esl_msa}, $self->{informat}) = _c_read_msa( $self->{path}, $informat, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino});
+  if (defined $self->{fetchName}) { 
+    my $ssifile = $self->{path} . ".ssi";
+    if ((! -e $ssifile) || (-M $ssifile > -M $self->{path})) { 
+      create_ssi_index($self->{path});
+    }
+    ($self->{esl_msa}, $self->{informat}) = _c_read_msa_given_name( $self->{path}, $self->{fetchName}, $informat, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino});
+  }
+  else { 
+    ($self->{esl_msa}, $self->{informat}) = _c_read_msa( $self->{path}, $informat, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino});
+  }
+  $self->{generation}++;
   # Possible values for 'format', a string, derived from esl_msafile.c::esl_msafile_DecodeFormat(): 
   # "unknown", "Stockholm", "Pfam", "UCSC A2M", "PSI-BLAST", "SELEX", "aligned FASTA", "Clustal", 
   # "Clustal-like", "PHYLIP (interleaved)", or "PHYLIP (sequential)".
@@ -322,6 +354,32 @@ sub read_msa {
 
 #-------------------------------------------------------------------------------
 
+=head2 create_ssi_index
+
+  Title    : create_ssi_index
+  Usage    : Bio::Easel::MSA::create_ssi_index($fileLocation)
+  Function : Create an SSI index <$fileLocation>.ssi for a (possibly
+           : multi-MSA) alignment file, so that individual MSAs can
+           : be read by name (#=GF ID) or accession (#=GF AC) by 
+           : passing <name> to new().
+  Args     : $fileLocation: alignment file to index, not gzipped
+  Returns  : number of MSAs indexed
+  Dies     : if any MSA lacks a name, or upon any other error, with croak
+
+=cut
+
+sub create_ssi_index {
+  my ( $fileLocation ) = @_;
+
+  if ( ! defined $fileLocation || ! -e $fileLocation ) { 
+    croak "trying to create SSI index but alignment file is undefined or does not exist";
+  }
+
+  return _c_create_ssi_index($fileLocation);
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 nseq
 
   Title    : nseq
@@ -549,18 +607,24 @@ sub get_ss_cons_dot_parantheses {
   Usage    : $msaObject->get_ss_cons_ct()
   Function : Returns a 'CT' array describing the consensus secondary structure
            : of an msa.
-  Args     : msa
+  Args     : $ret_type: OPTIONAL: "list" (default) to return a list,
+           :            "packed" to return a single string of packed 
+           :            32-bit ints (unpack("l*", ...)), or "pdl" to
+           :            return a PDL piddle of longs (requires PDL)
   Returns  : a 'CT' array, msa->alen+1 elements
            : ct[i] is the position that 'i' basepairs to, else '0' [1..alen] (NOT 0..alen-1)
 
 =cut
 
 sub get_ss_cons_ct {
-  my ( $self ) = @_;
+  my ( $self, $ret_type ) = @_;
 
    $self->_check_msa();
   if(! $self->has_ss_cons()) { croak "Trying to get a CT array for a SS_cons from MSA but SS_cons does not exist"; }
-  my @ctA = _c_get_ss_cons_ct($self->{esl_msa});
+  if(_ret_type_is_packed($ret_type)) { 
+    return _packed_to_ret_type(_c_get_ss_cons_ct($self->{esl_msa}, 1), $ret_type, 1);
+  }
+  my @ctA = _c_get_ss_cons_ct($self->{esl_msa}, 0);
 
   return @ctA;
 }
@@ -909,6 +973,92 @@ sub write_msa {
 
 #-------------------------------------------------------------------------------
 
+=head2 save_binary
+
+  Title    : save_binary
+  Usage    : $msaObject->save_binary($outfile)
+  Function : Save the MSA, including all names and annotation, to
+           : a binary file that load_binary() can reload much faster 
+           : than the alignment can be reparsed. The file format is 
+           : versioned and checksummed, and specific to the byte
+           : order of the machine it was written on.
+  Args     : $outfile: name of binary file to write
+  Returns  : void
+  Dies     : if MSA is not digitized or file can't be written, with croak
+
+=cut
+
+sub save_binary {
+  my ( $self, $outfile ) = @_;
+
+  $self->_check_msa();
+  if ( ! defined $outfile ) { 
+    croak "trying to save_binary but outfile is undefined";
+  }
+  if ( ! $self->is_digitized ) { 
+    croak "trying to save_binary but MSA is not digitized";
+  }
+
+  my $status = _c_save_binary( $self->{esl_msa}, $outfile );
+  if ( $status == $ESLFAIL ) {
+    croak "problem saving binary msa, unable to open $outfile for writing"; 
+  }
+  elsif ( $status != $ESLOK ) { 
+    croak "problem saving binary msa, write to $outfile failed"; 
+  }
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 load_binary
+
+  Title    : load_binary
+  Usage    : $msaObject = Bio::Easel::MSA->load_binary($infile)
+           : OR
+           : $msaObject->load_binary($infile)
+  Function : Load an MSA from a binary file written by save_binary().
+           : The file is memory mapped and its version and checksum
+           : are verified before the MSA is created from it.
+           : If called as a class method, returns a new MSA object.
+           : If called on an existing object, replaces its MSA, and
+           : later calls to revert_to_original() reload $infile.
+  Args     : $infile: name of binary file to load
+  Returns  : a new Bio::Easel::MSA object if called as a class method,
+           : else void
+  Dies     : if $infile doesn't exist, is not a binary MSA file of 
+           : the current version, or fails its checksum, with croak
+
+=cut
+
+sub load_binary {
+  my ( $caller, $infile ) = @_;
+
+  if ( ! defined $infile || ! -e $infile ) { 
+    croak "trying to load_binary but file is undefined or does not exist";
+  }
+  my $esl_msa = _c_load_binary($infile);
+
+  if ( ref $caller ) { 
+    $caller->free_msa() if defined $caller->{esl_msa};
+    $caller->{esl_msa}     = $esl_msa;
+    $caller->{generation}++;
+    $caller->{binary_path} = $infile;
+    $caller->{digitize}    = 1;
+    return;
+  }
+
+  my $new_msa = Bio::Easel::MSA->new({
+    esl_msa => $esl_msa,
+  });
+  $new_msa->{binary_path} = $infile;
+  $new_msa->{digitize}    = 1;
+
+  return $new_msa;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 write_single_unaligned_seq
 
   Title    : write_single_unaligned_seq
@@ -977,6 +1127,8 @@ sub any_allgap_columns {
            : sequences exist in the seed, an average is computed
            : over a stochastic sample (the sample and thus the 
            : result with vary over multiple runs).
+           : If all pairs are compared, set_num_threads() controls
+           : how many threads are used.
   Args     : max number of sequences for brute force calculation
   Returns  : average percent id of all seq pairs or a sample
   
@@ -992,7 +1144,7 @@ sub average_id {
 
   # average percent id is expensive to calculate, so we set it once calc'ed
   if ( !defined $self->{average_id} ) {
-    $self->{average_id} = _c_average_id( $self->{esl_msa}, $max_nseq );
+    $self->{average_id} = _c_average_id( $self->{esl_msa}, $max_nseq, $self->get_num_threads() );
   }
   return $self->{average_id};
 }
@@ -1273,6 +1425,73 @@ sub get_sqstring_unaligned {
 
 #-------------------------------------------------------------------------------
 
+=head2 get_all_sqstrings_aligned
+
+  Title    : get_all_sqstrings_aligned
+  Usage    : $seqAR = $msaObject->get_all_sqstrings_aligned()
+           : ($buffer, $stride) = $msaObject->get_all_sqstrings_aligned(1)
+  Function : Return all aligned sequences from an MSA in a single
+           : call, much faster than calling get_sqstring_aligned()
+           : for each sequence of a large alignment.
+           : If $do_concat is '1', return all sequences concatenated
+           : in a single string, sequence $i is 
+           : substr($buffer, $i * $stride, $stride).
+  Args     : $do_concat: OPTIONAL: '1' to return a single string
+  Returns  : If ! $do_concat: ref to array of aligned sequences [0..nseq-1]
+           : If   $do_concat: two values: 
+           :   $buffer: all aligned sequences concatenated
+           :   $stride: length of each sequence in $buffer (alen)
+
+=cut
+
+sub get_all_sqstrings_aligned {
+  my ( $self, $do_concat ) = @_;
+
+  $self->_check_msa();
+  if(defined $do_concat && $do_concat) { 
+    return _c_get_all_sqstrings( $self->{esl_msa}, 1, 1 );
+  }
+  my @seqA = _c_get_all_sqstrings( $self->{esl_msa}, 1, 0 );
+  return \@seqA;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 get_all_sqstrings_unaligned
+
+  Title    : get_all_sqstrings_unaligned
+  Usage    : $seqAR = $msaObject->get_all_sqstrings_unaligned()
+           : ($buffer, $offsetAR) = $msaObject->get_all_sqstrings_unaligned(1)
+  Function : Return all unaligned sequences from an MSA in a single
+           : call, much faster than calling get_sqstring_unaligned()
+           : for each sequence of a large alignment.
+           : If $do_concat is '1', return all sequences concatenated
+           : in a single string, sequence $i is 
+           : substr($buffer, $offsetAR->[$i], $offsetAR->[$i+1] - $offsetAR->[$i]).
+  Args     : $do_concat: OPTIONAL: '1' to return a single string
+  Returns  : If ! $do_concat: ref to array of unaligned sequences [0..nseq-1]
+           : If   $do_concat: two values: 
+           :   $buffer:   all unaligned sequences concatenated
+           :   $offsetAR: ref to array [0..nseq] of start of each 
+           :              sequence in $buffer, $offsetAR->[nseq] is
+           :              length($buffer)
+
+=cut
+
+sub get_all_sqstrings_unaligned {
+  my ( $self, $do_concat ) = @_;
+
+  $self->_check_msa();
+  if(defined $do_concat && $do_concat) { 
+    my ($buffer, @offsetA) = _c_get_all_sqstrings( $self->{esl_msa}, 0, 1 );
+    return ($buffer, \@offsetA);
+  }
+  my @seqA = _c_get_all_sqstrings( $self->{esl_msa}, 0, 0 );
+  return \@seqA;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 get_sqstring_unaligned_and_truncated
 
   Title    : get_sqstring_unaligned_and_truncated
@@ -1424,7 +1643,7 @@ sub rfam_qc_stats {
   my ( $self, $fam_outfile, $seq_outfile, $bp_outfile ) = @_;
 
   $self->_check_msa();
-  my $status = _c_rfam_qc_stats( $self->{esl_msa}, $fam_outfile, $seq_outfile, $bp_outfile);
+  my $status = _c_rfam_qc_stats( $self->{esl_msa}, $fam_outfile, $seq_outfile, $bp_outfile, $self->get_num_threads() );
   if ( $status != $ESLOK ) {
     croak "ERROR: unable to calculate rfam qc stats";
   }
@@ -2206,6 +2425,7 @@ sub free_msa {
 
   # don't call _check_msa, if we don't have it, that's okay
   _c_free_msa( $self->{esl_msa} );
+  $self->{generation}++;
   return;
 }
 
@@ -2217,7 +2437,9 @@ sub free_msa {
   Incept   : EPN, Sat Feb  2 14:53:27 2013
   Usage    : $msaObject->revert_to_original()
   Function : Frees current $msaObject->{esl_msa} object
-             and rereads it from $msaObject->{path}
+             and rereads it from $msaObject->{path}, or, if
+             it was loaded from a binary file with load_binary(), 
+             reloads that file.
   Args     : none
   Returns  : void
 
@@ -2226,6 +2448,10 @@ sub free_msa {
 sub revert_to_original {
   my ($self) = @_;
 
+  if ( defined $self->{binary_path} ) {
+    $self->load_binary($self->{binary_path});
+    return;
+  }
   if ( !defined $self->{path} ) {
     croak "trying to revert_to_original but path not set";
   }
@@ -2255,6 +2481,7 @@ sub weight_id_filter
   my $msa_out = _c_msaweight_IDFilter($msa_in, $idf);
   
   $self->{esl_msa} = $msa_out;
+  $self->{generation}++;
   
   _c_free_msa($msa_in);
   
@@ -2273,7 +2500,9 @@ sub weight_id_filter
             : fractionally identical, where $idf is the maximum value
             : that results in <= $nseq sequences (within 0.01, that is, 
             : $idf + 0.01 gives > $nseq sequences).
-            : $idf is found by a binary search.
+            : $idf is found by a binary search, done in C: each
+            : pairwise identity is computed at most once, only when
+            : first needed, and reused by later rounds of the search.
   Args      : $usemeAR:  [0..$i..$self->nseq]: '1' if we should consider sequence $i, else ignore it.
             :            set to all '1' to consider all sequences in the msa.
             : $nseq:     fractional identity threshold no pair of seqs in $keepmeAR will exceed
@@ -2287,40 +2516,13 @@ sub weight_id_filter
 sub filter_msa_subset_target_nseq
 {
   my($self, $usemeAR, $nseq, $keepmeAR) = @_;
-  
-  # binary search for max fractional id ($f_cur) that results in $nseq sequences
-  # we'll filter the alignment such that no two seqs are more than $f_cur similar to each other
-  # (or as close as we can get to $nseq by minimal change of 0.01)
-  # initializations
-  my $f_min = 0.01;
-  my $f_opt = 0.01;
-  my $f_prv = 1.0;
-  my $f_cur = $f_min;
-  my ($i, $n);
-  my $diff = abs($f_prv - $f_cur);
-  while($diff > 0.00999) { # while abs($f_prv - $f_cur) > 0.00999
-    # filter based on percent identity
-    $n = $self->filter_msa_subset($usemeAR, $f_cur, $keepmeAR);
-          
-    $f_prv = $f_cur;
-    # adjust $f_cur for next round based on how many seqs we have
-    if($n > $nseq) { # too many seqs, lower $f_cur
-      $f_cur -= ($diff / 2.); 
-    }
-    else { # too few seqs, raise $f_cur
-      if($f_cur > $f_opt) { $f_opt = $f_cur; }
-      $f_cur += ($diff / 2.); 
-    }
-          
-    # round to nearest percentage point (0.01)
-    $f_cur = (int(($f_cur * 100) + 0.5)) / 100;
-          
-    if($f_cur < $f_min) { croak "filter_msa_subset_target_nseq: couldn't reach $nseq sequences, with fractional id > $f_min\n"; }
-    $diff = abs($f_prv - $f_cur);
-  }    
-  # $f_opt is our optimal fractional id, the max fractional id that gives <= $nseq seqs
-  # call filter_msa_subset once more, to redefine keepmeA
-  $n = $self->filter_msa_subset($usemeAR, $f_opt, $keepmeAR);
+
+  $self->_check_msa();
+
+  # the binary search for max fractional id that results in <= $nseq
+  # sequences is done in C, computing each pairwise identity at most once
+  my ($f_opt, $n, @keepA) = _c_filter_msa_subset_target_nseq($self->{esl_msa}, $self->_filter_useme_array($usemeAR), $nseq, $self->get_num_threads());
+  @{$keepmeAR} = @keepA;
 
   return($f_opt, $n);
 }
@@ -2338,6 +2540,10 @@ sub filter_msa_subset_target_nseq
             : Similar to weight_id_filter() except does not create a new
             : MSA of only the filtered set, and this function is flexible
             : to only considering a subset of the passed in alignment.
+            : Sequences are considered in order, and each kept 
+            : sequence removes all later ones more than $idf 
+            : identical to it. Done in C, with set_num_threads() 
+            : threads.
   Args      : $usemeAR:  [0..$i..$self->nseq]: '1' if we should consider sequence $i, else ignore it.
             : $idf:      fractional identity threshold no pair of seqs in $keepmeAR will exceed
             : $keepmeAR: [0..$i..$self->nseq]: '1' if seq $i survives the filtering.
@@ -2349,30 +2555,11 @@ sub filter_msa_subset_target_nseq
 sub filter_msa_subset
 {
   my($self, $usemeAR, $idf, $keepmeAR) = @_;
-  
-  my ($i, $j, $pid);  # counters and a pid (pairwise identity) value
-  my $nseq = $self->nseq;
-  my $nkeep = 0;
 
-  # copy usemeA to keepmeA
-  for($i = 0; $i < $nseq; $i++) { 
-    $keepmeAR->[$i] = $usemeAR->[$i]; 
-    if($keepmeAR->[$i]) { $nkeep++; }
-  }
-  
-  for($i = 0; $i < $nseq; $i++) { 
-    if($keepmeAR->[$i]) { # we haven't removed it yet
-      for($j = $i+1; $j < $nseq; $j++) { # for every other seq that ... 
-        if($keepmeAR->[$j]) { # ... we haven't removed yet
-          $pid = _c_pairwise_identity($self->{esl_msa}, $i, $j); # get fractional identity
-          if($pid > $idf) { 
-            $keepmeAR->[$j] = 0; # remove it
-            $nkeep--;
-          }
-        }
-      }
-    }
-  }
+  $self->_check_msa();
+
+  my ($nkeep, @keepA) = _c_filter_msa_subset($self->{esl_msa}, $self->_filter_useme_array($usemeAR), $idf, $self->get_num_threads());
+  @{$keepmeAR} = @keepA;
 
   return $nkeep;
 }
@@ -2385,7 +2572,11 @@ sub filter_msa_subset
   Incept    : March 5, 2013
   Usage     : $msaObject->alignment_coverage_id()
   Function  : determine coverage ratios of msa
-  Args      : None
+  Args      : $idf:      ignored, accepted for backwards compatibility
+            : $ret_type: OPTIONAL: "list" (default) to return a list,
+            :            "packed" to return a single string of packed 
+            :            doubles (unpack("d*", ...)), or "pdl" to return
+            :            a PDL piddle of doubles (requires PDL)
   Returns   : Success:
                 Array from 0 to msa->alen, contains decimals from 0 to 1
                 representing coverage ratio of that msa position
@@ -2396,11 +2587,14 @@ sub filter_msa_subset
 
 sub alignment_coverage
 {
-  my ($self, $idf) = @_;
+  my ($self, $idf, $ret_type) = @_;
   
   my $msa_in = $self->{esl_msa};
   
-  my @output = _c_percent_coverage($msa_in);
+  if(_ret_type_is_packed($ret_type)) { 
+    return _packed_to_ret_type(_c_percent_coverage($msa_in, 1), $ret_type, 0);
+  }
+  my @output = _c_percent_coverage($msa_in, 0);
   
   return @output;
 }
@@ -2430,6 +2624,54 @@ sub count_msa
 
 #-------------------------------------------------------------------------------
 
+=head2 set_num_threads
+
+  Title     : set_num_threads
+  Usage     : $msaObject->set_num_threads($n)
+  Function  : Set the number of threads used to compute pairwise
+            : identities by rfam_qc_stats(), average_id(), 
+            : pid_matrix() and the identity-based filters that 
+            : use it. Results do not depend on the number of
+            : threads. Default is 1.
+  Args      : $n: number of threads, must be >= 1
+  Returns   : void
+  Dies      : if $n is not a positive integer, with croak
+
+=cut
+
+sub set_num_threads
+{
+  my ($self, $n) = @_;
+
+  if(! defined $n || $n !~ m/^\d+$/ || $n < 1) { 
+    croak "set_num_threads(): number of threads must be a positive integer";
+  }
+  $self->{nthreads} = $n;
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 get_num_threads
+
+  Title     : get_num_threads
+  Usage     : $n = $msaObject->get_num_threads()
+  Function  : Return the number of threads set by set_num_threads().
+  Args      : None
+  Returns   : number of threads, 1 if never set
+
+=cut
+
+sub get_num_threads
+{
+  my ($self) = @_;
+
+  return (defined $self->{nthreads}) ? $self->{nthreads} : 1;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 pairwise_identity
 
   Title     : pairwise_identity
@@ -2451,6 +2693,87 @@ sub pairwise_identity
 
 #-------------------------------------------------------------------------------
 
+=head2 pid_matrix
+
+  Title     : pid_matrix
+  Usage     : $pidmxHR = $msaObject->pid_matrix($rowsAR)
+  Function  : Compute fractional identities between each sequence in
+            : @{$rowsAR} and all sequences in the MSA in a single pass
+            : in C, and return them as a packed matrix that can be 
+            : queried with pid_matrix_get(). Values are identical to
+            : those returned by pairwise_identity(). The matrix takes
+            : 8 * scalar(@{$rowsAR}) * nseq bytes.
+            : The matrix is a snapshot, it is not updated if the MSA
+            : is subsequently modified. set_num_threads() controls
+            : how many threads are used.
+  Args      : $rowsAR: OPTIONAL: ref to array of sequence indices to 
+            :          compute identities for, all seqs if undefined.
+  Returns   : hash ref, the matrix, with keys:
+            :   "nseq":   number of sequences (columns) in the matrix
+            :   "rowH":   hash, key: sequence index, value: row in "packed"
+            :   "packed": string of packed doubles, row-major
+  Dies      : if any index in @{$rowsAR} is invalid, with croak
+
+=cut
+
+sub pid_matrix
+{
+  my ($self, $rowsAR) = @_;
+
+  $self->_check_msa();
+  my $nseq = $self->nseq;
+  if(! defined $rowsAR) { 
+    my @rowsA = (0..$nseq-1);
+    $rowsAR = \@rowsA;
+  }
+
+  my %rowH = ();
+  for(my $r = 0; $r < scalar(@{$rowsAR}); $r++) { 
+    $self->_check_sqidx($rowsAR->[$r]);
+    $rowH{$rowsAR->[$r]} = $r;
+  }
+
+  my %pidmxH = ();
+  $pidmxH{"nseq"}   = $nseq;
+  $pidmxH{"rowH"}   = \%rowH;
+  $pidmxH{"packed"} = _c_pid_matrix($self->{esl_msa}, $rowsAR, scalar(@{$rowsAR}), $self->get_num_threads());
+
+  return \%pidmxH;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 pid_matrix_get
+
+  Title     : pid_matrix_get
+  Usage     : $pid = $msaObject->pid_matrix_get($pidmxHR, $i, $j)
+  Function  : Return fractional identity between seqs $i and $j
+            : from a matrix returned by pid_matrix(). Either $i
+            : or $j must be a row of the matrix.
+  Args      : $pidmxHR: the matrix, from pid_matrix()
+            : $i:       index of first sequence
+            : $j:       index of second sequence
+  Returns   : fractional identity of i and j
+  Dies      : if neither $i nor $j is a row of $pidmxHR, with croak
+
+=cut
+
+sub pid_matrix_get
+{
+  my ($self, $pidmxHR, $i, $j) = @_;
+
+  if(! exists $pidmxHR->{"rowH"}{$i}) { 
+    if(! exists $pidmxHR->{"rowH"}{$j}) { 
+      croak "pid_matrix_get(): neither seq $i nor $j is a row of the pid matrix"; 
+    }
+    ($i, $j) = ($j, $i); # identity is symmetric
+  }
+
+  return unpack("d", substr($pidmxHR->{"packed"}, 8 * (($pidmxHR->{"rowH"}{$i} * $pidmxHR->{"nseq"}) + $j), 8));
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 check_if_prefix_added_to_sqnames
 
   Title     : check_if_prefix_added_to_sqnames
@@ -2532,20 +2855,33 @@ sub remove_prefix_from_sqname
 
   Title     : clone_msa
   Incept    : EPN, Thu Nov 21 09:38:23 2013
-  Usage     : $newmsaObject = $msaObject->clone_msa()
+  Usage     : $newmsaObject = $msaObject->clone_msa($do_cow)
   Function  : Creates a new MSA, a duplicate of $self.
-  Args      : None
+            : If $do_cow is '1', the new MSA is a copy-on-write
+            : clone: it shares the aligned sequences, per-sequence
+            : SS, SA and PP and per-column RF, MM, SS_cons, SA_cons 
+            : and PP_cons strings with $self rather than copying
+            : them, and each of those is copied only when either
+            : MSA first modifies it (e.g. with set_sqstring_aligned()
+            : or column_subset()). This makes a clone that is 
+            : discarded, or only partly edited, much cheaper to 
+            : create for large alignments. Reordering sequences 
+            : does not copy anything. Names and all other 
+            : annotation are always copied.
+  Args      : $do_cow: OPTIONAL: '1' to make a copy-on-write clone
   Returns   : $new_msa: a new Bio::Easel::MSA object, a duplicate of $self
 
 =cut
 
 sub clone_msa
 {
-  my ($self) = @_;
+  my ($self, $do_cow) = @_;
 
   $self->_check_msa();
 
-  my $new_esl_msa = _c_clone_msa($self->{esl_msa});
+  my $new_esl_msa = (defined $do_cow && $do_cow) ? 
+      _c_clone_msa_cow($self->{esl_msa}) : 
+      _c_clone_msa($self->{esl_msa});
 
   my $new_msa = Bio::Easel::MSA->new({
     esl_msa => $new_esl_msa,
@@ -2709,6 +3045,54 @@ sub sequence_subset_and_reorder
 
   return $new_msa;
 }
+
+#-------------------------------------------------------------------------------
+
+=head2 weighted_sample
+
+  Title     : weighted_sample
+  Usage     : $newmsaObject = $msaObject->weighted_sample($k, $rng, $with_replacement)
+  Function  : Create a new MSA containing $k sequences sampled
+            : from a passed in MSA with probability proportional
+            : to their weights (e.g. from weight_GSC(); all equal
+            : if the MSA has none), drawn in C from a Walker alias
+            : table. Sequences are kept in their original order.
+            : Without replacement, $k distinct sequences are 
+            : sampled and weights are transferred exactly. With
+            : replacement, $k draws are made, each distinct 
+            : sequence drawn is kept once and its weight in the 
+            : new MSA is the number of times it was drawn.
+            : All gap columns will not be removed from the MSA,
+            : caller may want to do that immediately with
+            : remove_all_gap_columns().
+  Args      : $k:                number of sequences to sample
+            : $rng:              Bio::Easel::Random object
+            : $with_replacement: '1' to sample with replacement
+  Returns   : $new_msa: a new Bio::Easel::MSA object, with 
+            :           a subset of the sequences in $self.
+  Dies      : if $k is not a positive integer, $rng is undefined,
+            : a weight is negative, or without replacement if fewer
+            : than $k sequences have positive weight, with croak
+=cut
+
+sub weighted_sample
+{
+  my ($self, $k, $rng, $with_replacement) = @_;
+
+  $self->_check_msa();
+  if(! defined $k || $k !~ m/^\d+$/ || $k < 1) { croak "weighted_sample(): number of sequences must be a positive integer"; }
+  if(! defined $rng) { croak "weighted_sample(): Bio::Easel::Random object undefined"; }
+  if(! defined $with_replacement) { $with_replacement = 0; }
+
+  my $new_esl_msa = _c_weighted_sample($self->{esl_msa}, $k, $rng->randomness(), ($with_replacement) ? 1 : 0);
+
+  # create new Bio::Easel::MSA object from $new_esl_msa
+  my $new_msa = Bio::Easel::MSA->new({
+    esl_msa => $new_esl_msa,
+  });
+
+  return $new_msa;
+}
 #-------------------------------------------------------------------------------
 
 =head2 column_subset
@@ -2933,6 +3317,8 @@ sub remove_rf_gap_columns
             : Example: if sequence idx 5 is $id_thr or less fractionally identical to all
             :          sequences in the subset, but closest to sequence index 11 at 0.73,
             :          then $divAR->[5] = 1, $nnidxAR->[5] = 11, $nnfidAR->[5] = 0.73.
+            : $pidmxHR: OPTIONAL: identity matrix from pid_matrix() with a row for
+            :           every seq in the subset, computed here if undefined
   Returns   : Number of divergent seqs found. This will also be the size of @{$divAR}, @{$nnidxAR} and @{$nnfidAR}
   Dies      : if no sequences exist in $subsetAR, or any indices are invalid
             : with croak
@@ -2940,9 +3326,10 @@ sub remove_rf_gap_columns
 
 sub find_divergent_seqs_from_subset
 {
-  my ($self, $subsetAR, $id_thr, $divAR, $nnidxAR, $nnfidAR) = @_;
+  my ($self, $subsetAR, $id_thr, $divAR, $nnidxAR, $nnfidAR, $pidmxHR) = @_;
 
   $self->_check_msa();
+  if(! defined $pidmxHR) { $pidmxHR = $self->pid_matrix($self->_pid_matrix_rows($subsetAR)); }
 
   my $nseq = $self->nseq;
   my $ndiv = 0;
@@ -2955,7 +3342,7 @@ sub find_divergent_seqs_from_subset
       $iamdivergent = 1; # until proven otherwise
       for(my $j = 0; $j < $self->nseq; $j++) {
         if($subsetAR->[$j]) { 
-          my $id = _c_pairwise_identity($self->{esl_msa}, $i, $j);
+          my $id = $self->pid_matrix_get($pidmxHR, $j, $i);
           if($id > $id_thr) { $iamdivergent = 0; $j = $self->nseq+1; } # setting j this way breaks us out of the loop
           if($id > $maxid)  { $maxidx = $j; $maxid = $id; }
         }
@@ -2993,6 +3380,8 @@ sub find_divergent_seqs_from_subset
             : not in the subset that are <= $id_thr fractionally
             : identical to *all* seqs in the subset.
   Args      : $subsetAR: [0..$i..$msa->nseq-1] '1' if sequence i is in the subset, else 0
+            : $pidmxHR:  OPTIONAL: identity matrix from pid_matrix() with a row for
+            :            every seq in the subset, computed here if undefined
   Returns   : $idx: Index of sequence in $msa that is most divergent from all seqs in
             :       subsetAR, that is, the sequence for which the fractional identity
             :       to its closest neighbor in subsetAR is minimized.
@@ -3004,10 +3393,11 @@ sub find_divergent_seqs_from_subset
 
 sub find_most_divergent_seq_from_subset
 {
-  my ($self, $subsetAR) = @_;
+  my ($self, $subsetAR, $pidmxHR) = @_;
 
   $self->_check_msa();
   my $nsubset = 0;
+  if(! defined $pidmxHR) { $pidmxHR = $self->pid_matrix($self->_pid_matrix_rows($subsetAR)); }
 
   my $nseq = $self->nseq;
   my $min_max_id = 1.0;
@@ -3019,7 +3409,7 @@ sub find_most_divergent_seq_from_subset
       my $max_idx = -1;
       for(my $j = 0; $j < $self->nseq; $j++) {
         if($subsetAR->[$j]) { 
-          my $id = _c_pairwise_identity($self->{esl_msa}, $i, $j);
+          my $id = $self->pid_matrix_get($pidmxHR, $j, $i);
           if($id > $min_max_id) { $j = $self->nseq+1; } # setting j this way breaks us out of the loop
           if($id > $max_id)     { $max_id = $id; $max_idx = $j; }
         }
@@ -3057,6 +3447,8 @@ sub find_most_divergent_seq_from_subset
            : $usemeAR: OPTIONAL: if defined: 
            :           [0..$j..nseq-1]: '1' if we should consider
            :           seq $j in calculation of avg/min/max.
+           : $pidmxHR: OPTIONAL: identity matrix from pid_matrix() with
+           :           a row for $idx, computed here if undefined
   Returns  : $avg_pid: average fractional id b/t $idx and all other seqs
            : $min_pid: minimum fractional id b/t $idx and all other seqs
            : $min_idx: index of seq that gives $min_pid to $idx
@@ -3066,7 +3458,7 @@ sub find_most_divergent_seq_from_subset
 =cut
 
 sub avg_min_max_pid_to_seq {
-  my ($self, $idx, $usemeAR) = @_;
+  my ($self, $idx, $usemeAR, $pidmxHR) = @_;
   
   my $pid;
   my $avg_pid = 0.;
@@ -3077,10 +3469,12 @@ sub avg_min_max_pid_to_seq {
   my $max_idx = -1;
 
   $self->_check_msa();
+  if(! defined $pidmxHR) { $pidmxHR = $self->pid_matrix([$idx]); }
+  my @pidA = $self->_pid_matrix_row($pidmxHR, $idx);
 
   for(my $i = 0; $i < $self->nseq; $i++) { 
     if($i != $idx && (! defined $usemeAR || $usemeAR->[$i])) { 
-      $pid = _c_pairwise_identity($self->{esl_msa}, $idx, $i); # get fractional identity
+      $pid = $pidA[$i]; # get fractional identity
       if($pid < $min_pid) { $min_pid = $pid; $min_idx = $i; }
       if($pid > $max_pid) { $max_pid = $pid; $max_idx = $i; }
       $avg_pid += $pid;
@@ -3225,6 +3619,64 @@ sub get_all_GF
 
 #-------------------------------------------------------------------------------
 
+=head2 profile
+
+  Title     : profile
+  Usage     : $profile = $msaObject->profile($use_weights)
+  Function  : Count residues in each column of the MSA in a single
+            : pass and return the counts as a Bio::Easel::MSA::Profile
+            : object, from which entropy, conservation, coverage, the
+            : most informative sequence and a consensus sequence can
+            : all be derived without recounting. Use this instead of
+            : calling several of pos_entropy(), pos_conservation(),
+            : alignment_coverage() and most_informative_sequence().
+  Args      : $use_weights: '1' to use weights in the MSA, '0' not to
+  Returns   : a new Bio::Easel::MSA::Profile object
+  Dies      : if MSA is not digitized, or $use_weights is '1' and
+            : the MSA has no valid weights
+=cut
+
+sub profile
+{
+  my ($self, $use_weights) = @_;
+
+  require Bio::Easel::MSA::Profile;
+
+  return Bio::Easel::MSA::Profile->new({ msa => $self, use_weights => $use_weights });
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 view
+
+  Title     : view
+  Usage     : $view = $msaObject->view($seqsAR, $colmaskAR)
+  Function  : Return a read-only Bio::Easel::MSA::View of a subset
+            : of the sequences and columns of the MSA, without
+            : copying it. Use instead of sequence_subset() or 
+            : clone_msa() when the subset is only needed for
+            : identities, profiles, sequence strings or output.
+            : The MSA must not be modified while the view exists.
+  Args      : $seqsAR:    ref to array of indices of sequences in the
+            :             view, in view order; undef for all
+            : $colmaskAR: [0..apos..alen-1] ref to array with value
+            :             '1' to include column apos; undef for all
+  Returns   : a new Bio::Easel::MSA::View object
+  Dies      : if a sequence is invalid or listed twice, or 
+            : $colmaskAR is not of length alen
+=cut
+
+sub view
+{
+  my ($self, $seqsAR, $colmaskAR) = @_;
+
+  require Bio::Easel::MSA::View;
+
+  return Bio::Easel::MSA::View->new({ msa => $self, seqs => $seqsAR, colmask => $colmaskAR });
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 most_informative_sequence
 
   Title     : most_informative_sequence
@@ -3258,16 +3710,22 @@ sub most_informative_sequence
   Incept    : EPN, Mon May 19 13:23:33 2014
   Usage     : $msaObject->pos_fcbp
   Function  : Calculate the fraction of canonical basepairs for each nongap RF position in a MSA. 
-  Args      : none
+  Args      : $ret_type: OPTIONAL: "list" (default) to return a list,
+            :            "packed" to return a single string of packed 
+            :            doubles (unpack("d*", ...)), or "pdl" to return
+            :            a PDL piddle of doubles (requires PDL)
   Returns   : array of length msa->alen: the fraction of canonical bps
             : at each position, 0. for non-paired positions.
 =cut
 
 sub pos_fcbp
 {
-  my ($self) = @_;
+  my ($self, $ret_type) = @_;
 
-  my @retA = _c_pos_fcbp($self->{esl_msa});
+  if(_ret_type_is_packed($ret_type)) { 
+    return _packed_to_ret_type(_c_pos_fcbp($self->{esl_msa}, 1), $ret_type, 0);
+  }
+  my @retA = _c_pos_fcbp($self->{esl_msa}, 0);
   return @retA;
 }
 
@@ -3280,16 +3738,22 @@ sub pos_fcbp
   Usage     : $msaObject->pos_covariation
   Function  : Calculate the 'RNAalifold covariation statistic (Lindgreen, Gardner, Krogh, 2006)'
             : for each basepair in an alignment and return as an array [0..alen-1].
-  Args      : none
+  Args      : $ret_type: OPTIONAL: "list" (default) to return a list,
+            :            "packed" to return a single string of packed 
+            :            doubles (unpack("d*", ...)), or "pdl" to return
+            :            a PDL piddle of doubles (requires PDL)
   Returns   : array of length msa->alen: the covariation statistic
             : at each position, 0. for non-paired positions.
 =cut
 
 sub pos_covariation
 {
-  my ($self) = @_;
+  my ($self, $ret_type) = @_;
 
-  my @retA = _c_pos_covariation($self->{esl_msa});
+  if(_ret_type_is_packed($ret_type)) { 
+    return _packed_to_ret_type(_c_pos_covariation($self->{esl_msa}, 1), $ret_type, 0);
+  }
+  my @retA = _c_pos_covariation($self->{esl_msa}, 0);
   return @retA;
 }
 
@@ -3302,16 +3766,23 @@ sub pos_covariation
   Usage     : $msaObject->pos_entropy
   Function  : Calculate and return the entropy at each position of an msa.
   Args      : $use_weights: '1' to use weights in the MSA, '0' not to
+            : $ret_type:    OPTIONAL: "list" (default) to return a list,
+            :               "packed" to return a single string of packed 
+            :               doubles (unpack("d*", ...)), or "pdl" to return
+            :               a PDL piddle of doubles (requires PDL)
   Returns   : array of length msa->alen: the entropy at each posn
 =cut
 
 sub pos_entropy
 {
-  my ($self, $use_weights) = @_;
+  my ($self, $use_weights, $ret_type) = @_;
 
   if(! defined $use_weights) { $use_weights = 0; }
 
-  my @retA = _c_pos_entropy($self->{esl_msa}, $use_weights);
+  if(_ret_type_is_packed($ret_type)) { 
+    return _packed_to_ret_type(_c_pos_entropy($self->{esl_msa}, $use_weights, 1), $ret_type, 0);
+  }
+  my @retA = _c_pos_entropy($self->{esl_msa}, $use_weights, 0);
 
   return @retA;
 }
@@ -3329,16 +3800,23 @@ sub pos_entropy
             :  number of sequences (so no column with >=1 gap can have a conservation of 1.0).
             :  And all gap columns have a conservation of 0.0.
   Args      : $use_weights: '1' to use weights in the MSA, '0' not to
+            : $ret_type:    OPTIONAL: "list" (default) to return a list,
+            :               "packed" to return a single string of packed 
+            :               doubles (unpack("d*", ...)), or "pdl" to return
+            :               a PDL piddle of doubles (requires PDL)
   Returns   : array of length msa->alen: the 'sequence conservation' at each posn
 =cut
 
 sub pos_conservation
 {
-  my ($self, $use_weights) = @_;
+  my ($self, $use_weights, $ret_type) = @_;
 
   if(! defined $use_weights) { $use_weights = 0; }
 
-  my @retA = _c_pos_conservation($self->{esl_msa}, $use_weights);
+  if(_ret_type_is_packed($ret_type)) { 
+    return _packed_to_ret_type(_c_pos_conservation($self->{esl_msa}, $use_weights, 1), $ret_type, 0);
+  }
+  my @retA = _c_pos_conservation($self->{esl_msa}, $use_weights, 0);
 
   return @retA;
 }
@@ -3671,6 +4149,138 @@ sub _check_sqidx {
 }
 #-------------------------------------------------------------------------------
 
+=head2 _ret_type_is_packed
+
+  Title    : _ret_type_is_packed
+  Usage    : if(_ret_type_is_packed($ret_type)) { ... }
+  Function : Check a return type for the per-position statistic 
+           : functions and return '1' if the C function should return
+           : a packed string, i.e. if $ret_type is "packed" or "pdl".
+  Args     : $ret_type: "list", "packed", "pdl" or undef (same as "list")
+  Returns  : '1' or '0'
+  Dies     : if $ret_type is invalid, with croak
+
+=cut
+
+sub _ret_type_is_packed
+{
+  my ($ret_type) = @_;
+
+  if(! defined $ret_type || $ret_type eq "list") { return 0; }
+  if($ret_type eq "packed" || $ret_type eq "pdl") { return 1; }
+  croak "invalid return type $ret_type, must be \"list\", \"packed\" or \"pdl\"";
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _packed_to_ret_type
+
+  Title    : _packed_to_ret_type
+  Usage    : return _packed_to_ret_type($packed, $ret_type, $is_int)
+  Function : Return a packed string of values from a C function in the 
+           : requested form: the string itself if $ret_type is "packed",
+           : or a PDL piddle wrapping the same data if it is "pdl".
+  Args     : $packed:   string of packed doubles, or 32-bit ints if $is_int
+           : $ret_type: "packed" or "pdl"
+           : $is_int:   '1' if $packed holds 32-bit ints, '0' for doubles
+  Returns  : $packed, or a 1D PDL piddle
+  Dies     : if $ret_type is "pdl" and PDL is not installed, with croak
+
+=cut
+
+sub _packed_to_ret_type
+{
+  my ($packed, $ret_type, $is_int) = @_;
+
+  if($ret_type eq "packed") { return $packed; }
+
+  if(! eval { require PDL; 1; }) { croak "return type \"pdl\" requested, but PDL is not installed"; }
+  my $size = ($is_int) ? 4 : 8;
+  my $pdl  = PDL->new_from_specification((($is_int) ? PDL::long() : PDL::double()), length($packed) / $size);
+  ${$pdl->get_dataref} = $packed;
+  $pdl->upd_data();
+
+  return $pdl;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _filter_useme_array
+
+  Title    : _filter_useme_array
+  Usage    : $useAR = $msaObject->_filter_useme_array($usemeAR)
+  Function : Return a ref to an array of nseq '1' or '0' values,
+           : '1' for each $i for which $usemeAR->[$i] is true, for
+           : passing to the _c_filter_msa_subset*() functions.
+  Args     : $usemeAR: [0..$i..nseq-1]: true to use seq $i
+  Returns  : ref to array of nseq '1' or '0' values
+
+=cut
+
+sub _filter_useme_array
+{
+  my ($self, $usemeAR) = @_;
+
+  my @useA = ();
+  for(my $i = 0; $i < $self->nseq; $i++) { 
+    push(@useA, ($usemeAR->[$i]) ? 1 : 0);
+  }
+
+  return \@useA;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _pid_matrix_rows
+
+  Title    : _pid_matrix_rows
+  Usage    : $rowsAR = $msaObject->_pid_matrix_rows($usemeAR)
+  Function : Return a ref to an array of the indices $i for which
+           : $usemeAR->[$i] is '1', for passing to pid_matrix().
+  Args     : $usemeAR: [0..$i..nseq-1]: '1' to include seq $i
+  Returns  : ref to array of sequence indices
+
+=cut
+
+sub _pid_matrix_rows
+{
+  my ($self, $usemeAR) = @_;
+
+  my @rowsA = ();
+  for(my $i = 0; $i < $self->nseq; $i++) { 
+    if($usemeAR->[$i]) { push(@rowsA, $i); }
+  }
+
+  return \@rowsA;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _pid_matrix_row
+
+  Title    : _pid_matrix_row
+  Usage    : @pidA = $msaObject->_pid_matrix_row($pidmxHR, $i)
+  Function : Return all fractional identities for seq $i, which
+           : must be a row of $pidmxHR.
+  Args     : $pidmxHR: the matrix, from pid_matrix()
+           : $i:       sequence index
+  Returns  : array [0..$j..nseq-1], identity between seq $i and $j
+  Dies     : if $i is not a row of $pidmxHR, with croak
+
+=cut
+
+sub _pid_matrix_row
+{
+  my ($self, $pidmxHR, $i) = @_;
+
+  if(! exists $pidmxHR->{"rowH"}{$i}) { croak "_pid_matrix_row(): seq $i is not a row of the pid matrix"; }
+  my $nseq = $pidmxHR->{"nseq"};
+
+  return unpack("d*", substr($pidmxHR->{"packed"}, 8 * $pidmxHR->{"rowH"}{$i} * $nseq, 8 * $nseq));
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 _check_ppidx
 
   Title    : _check_ppidx
@@ -4008,7 +4618,13 @@ sub _get_nongap_numbering_for_aligned_string {
 
 #-------------------------------------------------------------------------------
 
+=head2 _c_packed_doubles
+=head2 _c_packed_int32s
 =head2 _c_read_msa
+=head2 _c_read_msa_given_name
+=head2 _c_create_ssi_index
+=head2 _c_save_binary
+=head2 _c_load_binary
 =head2 _c_write_msa
 =head2 _c_nseq
 =head2 _c_alen
@@ -4018,6 +4634,35 @@ sub _get_nongap_numbering_for_aligned_string {
 =head2 _c_set_sqname
 =head2 _c_any_allgap_columns
 =head2 _c_average_id
+=head2 _c_pid_create
+=head2 _c_pid_destroy
+=head2 _c_pid_pair
+=head2 _c_pid_fill_thread
+=head2 _c_pid_fill
+=head2 _c_pid_upper_triangle_reduce
+=head2 _c_pid_matrix
+=head2 _c_pid_cols_thread
+=head2 _c_pid_cols
+=head2 _c_pid_cache_create
+=head2 _c_pid_cache_destroy
+=head2 _c_pid_cache_filter
+=head2 _c_pid_cache_keep_by_seq
+=head2 _c_filter_msa_subset
+=head2 _c_filter_msa_subset_target_nseq
+=head2 _c_profile_build
+=head2 _c_profile_create
+=head2 _c_profile_destroy
+=head2 _c_profile_alen
+=head2 _c_profile_nseq
+=head2 _c_profile_fill_entropy
+=head2 _c_profile_fill_conservation
+=head2 _c_profile_fill_coverage
+=head2 _c_profile_mis
+=head2 _c_profile_consensus
+=head2 _c_profile_values
+=head2 _c_profile_push_values
+=head2 _c_profile_get_mis
+=head2 _c_profile_get_consensus
 =head2 _c_get_sqlen
 =head2 _c_average_sqlen
 =head2 _c_addGF
@@ -0,0 +1,327 @@
+package Bio::Easel::MSA::Profile;
+
+use strict;
+use warnings;
+use Carp;
+
+use Bio::Easel::MSA;
+
+=head1 NAME
+
+Bio::Easel::MSA::Profile - per-column residue counts of an MSA
+
+=head1 VERSION
+
+Version 0.01
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+our $VERSION = '0.01';
+
+# per-column statistics computed by Bio::Easel::MSA::_c_profile_push_values(),
+# these must match the BEMSA_PROFILE_* values in MSA.c
+our $PROFILE_ENTROPY      = 0;
+our $PROFILE_CONSERVATION = 1;
+our $PROFILE_COVERAGE     = 2;
+
+=head1 SYNOPSIS
+
+Count the residues in each column of a digitized alignment once, in
+a single pass, and derive per-position statistics from the counts
+without further passes over the sequences. The C code lives in 
+Bio::Easel::MSA (see _c_profile_build() in MSA.c).
+
+    use Bio::Easel::MSA;
+    use Bio::Easel::MSA::Profile;
+
+    my $msa     = Bio::Easel::MSA->new({"fileLocation" => $alnfile});
+    my $profile = Bio::Easel::MSA::Profile->new({"msa" => $msa});
+    my @entA    = $profile->entropy();
+    my @consA   = $profile->conservation();
+    my $mis     = $profile->most_informative_sequence(0.5);
+
+=head1 EXPORT
+
+No functions currently exported.
+
+=head1 SUBROUTINES/METHODS
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+=head2 new
+
+  Title    : new
+  Usage    : Bio::Easel::MSA::Profile->new
+  Function : Generates a new Bio::Easel::MSA::Profile object by
+           : counting the residues in each column of an MSA.
+           : Degenerate residues are split evenly between the
+           : canonical residues they represent. The profile does
+           : not change if the MSA is subsequently modified.
+  Args     : <msa>:         Bio::Easel::MSA object, must be digitized, or a
+           :                Bio::Easel::MSA::View of one, to count only the
+           :                view's sequences and columns
+           : <use_weights>: optional: '1' to weight counts by the
+           :                sequence weights in the MSA, default '0'
+  Returns  : Bio::Easel::MSA::Profile object
+  Dies     : if <msa> is not passed in or not digitized, or if
+           : <use_weights> is '1' and the MSA has no valid weights
+
+=cut
+
+sub new {
+  my ( $caller, $args ) = @_;
+  my $class = ref($caller) || $caller;
+  my $self = {};
+
+  bless( $self, $caller );
+
+  if ( ! defined $args->{msa} ) {
+    confess("Expected to receive an MSA");
+  }
+  $self->{use_weights} = (defined $args->{use_weights} && $args->{use_weights}) ? 1 : 0;
+
+  if ( $args->{msa}->isa("Bio::Easel::MSA::View") ) {
+    $args->{msa}->_check_view();
+    $self->{esl_profile} = Bio::Easel::MSA::_c_view_profile_create($args->{msa}->{esl_view}, $self->{use_weights});
+  }
+  else {
+    $args->{msa}->_check_msa();
+    $self->{esl_profile} = Bio::Easel::MSA::_c_profile_create($args->{msa}->{esl_msa}, $self->{use_weights});
+  }
+
+  return $self;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 alen
+
+  Title    : alen
+  Usage    : $profileObject->alen()
+  Function : Get number of columns in the profile.
+  Args     : none
+  Returns  : number of columns
+
+=cut
+
+sub alen {
+  my ($self) = @_;
+
+  return Bio::Easel::MSA::_c_profile_alen($self->{esl_profile});
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 nseq
+
+  Title    : nseq
+  Usage    : $profileObject->nseq()
+  Function : Get number of sequences counted in the profile.
+  Args     : none
+  Returns  : number of sequences
+
+=cut
+
+sub nseq {
+  my ($self) = @_;
+
+  return Bio::Easel::MSA::_c_profile_nseq($self->{esl_profile});
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 use_weights
+
+  Title    : use_weights
+  Usage    : $profileObject->use_weights()
+  Function : Return '1' if counts are weighted, '0' if not.
+  Args     : none
+  Returns  : '1' or '0'
+
+=cut
+
+sub use_weights {
+  my ($self) = @_;
+
+  return $self->{use_weights};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 entropy
+
+  Title    : entropy
+  Usage    : @entA = $profileObject->entropy($ret_type)
+  Function : Return the entropy (in bits) of the nongap residues 
+           : at each position, as Bio::Easel::MSA::pos_entropy().
+  Args     : $ret_type: OPTIONAL: "list" (default), "packed" or "pdl",
+           :            see Bio::Easel::MSA::pos_entropy()
+  Returns  : array of length alen: the entropy at each position
+
+=cut
+
+sub entropy {
+  my ($self, $ret_type) = @_;
+
+  if(Bio::Easel::MSA::_ret_type_is_packed($ret_type)) { 
+    return Bio::Easel::MSA::_packed_to_ret_type(Bio::Easel::MSA::_c_profile_push_values($self->{esl_profile}, $PROFILE_ENTROPY, 1), $ret_type, 0);
+  }
+  return Bio::Easel::MSA::_c_profile_push_values($self->{esl_profile}, $PROFILE_ENTROPY, 0);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 conservation
+
+  Title    : conservation
+  Usage    : @consA = $profileObject->conservation($ret_type)
+  Function : Return the 'sequence conservation' at each position,
+           : the maximum frequency of any residue with gaps 
+           : included, as Bio::Easel::MSA::pos_conservation().
+  Args     : $ret_type: OPTIONAL: "list" (default), "packed" or "pdl",
+           :            see Bio::Easel::MSA::pos_entropy()
+  Returns  : array of length alen: the conservation at each position
+
+=cut
+
+sub conservation {
+  my ($self, $ret_type) = @_;
+
+  if(Bio::Easel::MSA::_ret_type_is_packed($ret_type)) { 
+    return Bio::Easel::MSA::_packed_to_ret_type(Bio::Easel::MSA::_c_profile_push_values($self->{esl_profile}, $PROFILE_CONSERVATION, 1), $ret_type, 0);
+  }
+  return Bio::Easel::MSA::_c_profile_push_values($self->{esl_profile}, $PROFILE_CONSERVATION, 0);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 coverage
+
+  Title    : coverage
+  Usage    : @covA = $profileObject->coverage($ret_type)
+  Function : Return the fraction of sequences with a canonical 
+           : residue at each position, as 
+           : Bio::Easel::MSA::alignment_coverage(). Coverage is
+           : never weighted.
+  Args     : $ret_type: OPTIONAL: "list" (default), "packed" or "pdl",
+           :            see Bio::Easel::MSA::pos_entropy()
+  Returns  : array of length alen: the coverage at each position
+
+=cut
+
+sub coverage {
+  my ($self, $ret_type) = @_;
+
+  if(Bio::Easel::MSA::_ret_type_is_packed($ret_type)) { 
+    return Bio::Easel::MSA::_packed_to_ret_type(Bio::Easel::MSA::_c_profile_push_values($self->{esl_profile}, $PROFILE_COVERAGE, 1), $ret_type, 0);
+  }
+  return Bio::Easel::MSA::_c_profile_push_values($self->{esl_profile}, $PROFILE_COVERAGE, 0);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 most_informative_sequence
+
+  Title    : most_informative_sequence
+  Usage    : $mis = $profileObject->most_informative_sequence($gapthresh)
+  Function : Return the "most informative sequence" (Freyhult, 
+           : Moulton and Gardner, 2005), as 
+           : Bio::Easel::MSA::most_informative_sequence().
+  Args     : $gapthresh: only columns with >= $gapthresh nongaps will be
+           :             a nongap residue, default 0.5
+  Returns  : a string of length alen, the most informative sequence
+
+=cut
+
+sub most_informative_sequence {
+  my ($self, $gapthresh) = @_;
+
+  if(! defined $gapthresh) { $gapthresh = 0.5; }
+
+  return Bio::Easel::MSA::_c_profile_get_mis($self->{esl_profile}, $gapthresh);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 consensus
+
+  Title    : consensus
+  Usage    : $cons = $profileObject->consensus($gapthresh)
+  Function : Return the majority-rule consensus sequence: the
+           : most frequent canonical residue at each position,
+           : or a gap if fewer than $gapthresh of the sequences
+           : have a residue there.
+  Args     : $gapthresh: only columns with >= $gapthresh nongaps will be
+           :             a nongap residue, default 0.5
+  Returns  : a string of length alen, the consensus sequence
+
+=cut
+
+sub consensus {
+  my ($self, $gapthresh) = @_;
+
+  if(! defined $gapthresh) { $gapthresh = 0.5; }
+
+  return Bio::Easel::MSA::_c_profile_get_consensus($self->{esl_profile}, $gapthresh);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 DESTROY
+
+  Title    : DESTROY
+  Usage    : $profileObject->DESTROY()
+  Function : Frees the profile
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub DESTROY {
+  my ($self) = @_;
+
+  if ( defined $self->{esl_profile} ) {
+    Bio::Easel::MSA::_c_profile_destroy($self->{esl_profile});
+  }
+  $self->{esl_profile} = undef;
+
+  return;
+}
+
+=head1 AUTHORS
+
+Eric Nawrocki, C<< <nawrocke at ncbi.nlm.nih.gov> >>
+
+=head1 BUGS
+
+Please report any bugs or feature requests to C<bug-bio-easel at rt.cpan.org>.
+
+=head1 SUPPORT
+
+You can find documentation for this module with the perldoc command.
+
+    perldoc Bio::Easel::MSA::Profile
+
+=head1 ACKNOWLEDGEMENTS
+
+Sean R. Eddy is the author of the Easel C library of functions for
+biological sequence analysis, upon which this module is based.
+
+=head1 LICENSE AND COPYRIGHT
+
+Copyright 2013 Eric Nawrocki.
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of either: the GNU General Public License as published
+by the Free Software Foundation; or the Artistic License.
+
+See http://dev.perl.org/licenses/ for more information.
+
+
+=cut
+
+1;
@@ -0,0 +1,475 @@
+package Bio::Easel::MSA::View;
+
+use strict;
+use warnings;
+use Carp;
+
+use Bio::Easel::MSA;
+
+=head1 NAME
+
+Bio::Easel::MSA::View - read-only subset of the sequences and columns of an MSA
+
+=head1 VERSION
+
+Version 0.01
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+our $VERSION = '0.01';
+
+=head1 SYNOPSIS
+
+Select a subset of the sequences and columns of an alignment without
+copying it. A view holds only the indices of its sequences and
+columns, so creating one costs O(nseq + alen), whereas
+sequence_subset() and clone_msa() copy every residue. Identities,
+profiles and sequence strings are computed by reading the parent
+alignment through the indices, and give the same results as they
+would for the equivalent subset MSA. The C code lives in
+Bio::Easel::MSA (see BEMSA_VIEW in MSA.c).
+
+The parent alignment must not be modified while a view of it
+exists; the view keeps a reference to it so it is not freed, and
+every method dies if the parent's ESL_MSA has since been freed or
+replaced (e.g. by free_msa(), read_msa() or revert_to_original()), or
+its number of sequences or columns has changed.
+
+    use Bio::Easel::MSA;
+    use Bio::Easel::MSA::View;
+
+    my $msa  = Bio::Easel::MSA->new({"fileLocation" => $alnfile});
+    my $view = Bio::Easel::MSA::View->new({"msa" => $msa, "seqs" => [0, 2, 5]});
+    my $pidmxHR = $view->pid_matrix();
+    my @entA    = $view->profile()->entropy();
+    $view->write_msa("subset.sto");
+
+=head1 EXPORT
+
+No functions currently exported.
+
+=head1 SUBROUTINES/METHODS
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+=head2 new
+
+  Title    : new
+  Usage    : Bio::Easel::MSA::View->new
+  Function : Generates a new Bio::Easel::MSA::View object over
+           : a subset of the sequences and columns of an MSA.
+  Args     : <msa>:     Bio::Easel::MSA object, the parent
+           : <seqs>:    optional: ref to array of indices of the
+           :            sequences in the view, in view order, no
+           :            duplicates; default all sequences
+           : <names>:   optional: ref to array of names of the
+           :            sequences in the view, in view order,
+           :            instead of <seqs>
+           : <colmask>: optional: [0..apos..alen-1] ref to array
+           :            with value '1' to include column apos in
+           :            the view, '0' not to; default all columns
+  Returns  : Bio::Easel::MSA::View object
+  Dies     : if <msa> is not passed in, both <seqs> and <names> are,
+           : a sequence is invalid or listed twice, or <colmask>
+           : is not of length alen
+
+=cut
+
+sub new {
+  my ( $caller, $args ) = @_;
+  my $class = ref($caller) || $caller;
+  my $self = {};
+
+  bless( $self, $caller );
+
+  if ( ! defined $args->{msa} ) {
+    confess("Expected to receive an MSA");
+  }
+  if ( defined $args->{seqs} && defined $args->{names} ) {
+    confess("Expected to receive seqs or names, not both");
+  }
+  my $msa = $args->{msa};
+  $msa->_check_msa();
+  $self->{msa} = $msa;
+
+  my $seqsAR = $args->{seqs};
+  if ( defined $args->{names} ) {
+    $msa->_check_index();
+    my @seqsA = ();
+    foreach my $name (@{$args->{names}}) {
+      my $seqidx = Bio::Easel::MSA::_c_get_sqidx($msa->{esl_msa}, $name);
+      if($seqidx == -1) { confess("Unable to find sequence $name"); }
+      push(@seqsA, $seqidx);
+    }
+    $seqsAR = \@seqsA;
+  }
+  if ( ! defined $seqsAR ) {
+    my @seqsA = (0..$msa->nseq-1);
+    $seqsAR = \@seqsA;
+  }
+
+  my $colmaskAR = $args->{colmask};
+  if ( ! defined $colmaskAR ) {
+    my @colmaskA = (1) x $msa->alen;
+    $colmaskAR = \@colmaskA;
+  }
+  if ( scalar(@{$colmaskAR}) != $msa->alen ) {
+    confess("Expected column mask of length " . $msa->alen . ", got " . scalar(@{$colmaskAR}));
+  }
+
+  $self->{msa_generation} = $msa->{generation};
+  $self->{esl_view} = Bio::Easel::MSA::_c_view_create($msa->{esl_msa}, $seqsAR, scalar(@{$seqsAR}), $colmaskAR);
+
+  return $self;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 msa
+
+  Title    : msa
+  Usage    : $viewObject->msa()
+  Function : Accessor for the parent MSA.
+  Args     : none
+  Returns  : Bio::Easel::MSA object
+
+=cut
+
+sub msa {
+  my ($self) = @_;
+
+  return $self->{msa};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 nseq
+
+  Title    : nseq
+  Usage    : $viewObject->nseq()
+  Function : Get number of sequences in the view.
+  Args     : none
+  Returns  : number of sequences
+
+=cut
+
+sub nseq {
+  my ($self) = @_;
+
+  $self->_check_view();
+
+  return Bio::Easel::MSA::_c_view_nseq($self->{esl_view});
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 alen
+
+  Title    : alen
+  Usage    : $viewObject->alen()
+  Function : Get number of columns in the view.
+  Args     : none
+  Returns  : number of columns
+
+=cut
+
+sub alen {
+  my ($self) = @_;
+
+  $self->_check_view();
+
+  return Bio::Easel::MSA::_c_view_alen($self->{esl_view});
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 get_msa_sqidx
+
+  Title    : get_msa_sqidx
+  Usage    : $viewObject->get_msa_sqidx($idx)
+  Function : Return the index in the parent MSA of sequence $idx
+           : of the view.
+  Args     : $idx: index of sequence in the view (0..nseq-1)
+  Returns  : index of the sequence in the parent MSA
+  Dies     : if $idx is invalid, with croak
+
+=cut
+
+sub get_msa_sqidx {
+  my ($self, $idx) = @_;
+
+  $self->_check_view();
+
+  return Bio::Easel::MSA::_c_view_sqidx($self->{esl_view}, $idx);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 get_sqname
+
+  Title    : get_sqname
+  Usage    : $viewObject->get_sqname($idx)
+  Function : Returns name of sequence $idx in the view.
+  Args     : $idx: index of sequence in the view (0..nseq-1)
+  Returns  : name of sequence $idx
+
+=cut
+
+sub get_sqname {
+  my ($self, $idx) = @_;
+
+  return $self->{msa}->get_sqname($self->get_msa_sqidx($idx));
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 get_sqstring_aligned
+
+  Title    : get_sqstring_aligned
+  Usage    : $viewObject->get_sqstring_aligned($idx)
+  Function : Return aligned sequence $idx of the view: its
+           : characters in the view's columns.
+  Args     : $idx: index of sequence in the view (0..nseq-1)
+  Returns  : aligned sequence $idx
+  Dies     : if $idx is invalid, with croak
+
+=cut
+
+sub get_sqstring_aligned {
+  my ($self, $idx) = @_;
+
+  $self->_check_view();
+
+  return Bio::Easel::MSA::_c_view_get_sqstring_aligned($self->{esl_view}, $idx);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 get_sqstring_unaligned
+
+  Title    : get_sqstring_unaligned
+  Usage    : $viewObject->get_sqstring_unaligned($idx)
+  Function : Return unaligned sequence $idx of the view: its
+           : residues in the view's columns.
+  Args     : $idx: index of sequence in the view (0..nseq-1)
+  Returns  : unaligned sequence $idx
+  Dies     : if $idx is invalid, with croak
+
+=cut
+
+sub get_sqstring_unaligned {
+  my ($self, $idx) = @_;
+
+  $self->_check_view();
+
+  return Bio::Easel::MSA::_c_view_get_sqstring_unaligned($self->{esl_view}, $idx);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 pid_matrix
+
+  Title    : pid_matrix
+  Usage    : $pidmxHR = $viewObject->pid_matrix($rowsAR)
+  Function : As Bio::Easel::MSA::pid_matrix(), for the sequences
+           : and columns of the view; sequence indices are view
+           : indices. The parent MSA's set_num_threads() controls
+           : how many threads are used. Query the matrix with
+           : pid_matrix_get().
+  Args     : $rowsAR: OPTIONAL: ref to array of view sequence indices
+           :          to compute identities for, all seqs if undefined.
+  Returns  : hash ref, the matrix, see Bio::Easel::MSA::pid_matrix()
+  Dies     : if any index in @{$rowsAR} is invalid, with croak
+
+=cut
+
+sub pid_matrix {
+  my ($self, $rowsAR) = @_;
+
+  $self->_check_view();
+  my $nseq = $self->nseq;
+  if(! defined $rowsAR) {
+    my @rowsA = (0..$nseq-1);
+    $rowsAR = \@rowsA;
+  }
+
+  my %rowH = ();
+  for(my $r = 0; $r < scalar(@{$rowsAR}); $r++) {
+    if($rowsAR->[$r] < 0 || $rowsAR->[$r] >= $nseq) {
+      croak (sprintf("invalid sequence index %d (must be [0..%d])", $rowsAR->[$r], $nseq-1));
+    }
+    $rowH{$rowsAR->[$r]} = $r;
+  }
+
+  my %pidmxH = ();
+  $pidmxH{"nseq"}   = $nseq;
+  $pidmxH{"rowH"}   = \%rowH;
+  $pidmxH{"packed"} = Bio::Easel::MSA::_c_view_pid_matrix($self->{esl_view}, $rowsAR, scalar(@{$rowsAR}), $self->{msa}->get_num_threads());
+
+  return \%pidmxH;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 pid_matrix_get
+
+  Title    : pid_matrix_get
+  Usage    : $pid = $viewObject->pid_matrix_get($pidmxHR, $i, $j)
+  Function : Return fractional identity between view seqs $i and $j
+           : from a matrix returned by pid_matrix(), as
+           : Bio::Easel::MSA::pid_matrix_get().
+  Args     : $pidmxHR: the matrix, from pid_matrix()
+           : $i:       index of first sequence
+           : $j:       index of second sequence
+  Returns  : fractional identity of i and j
+  Dies     : if neither $i nor $j is a row of $pidmxHR, with croak
+
+=cut
+
+sub pid_matrix_get {
+  my ($self, $pidmxHR, $i, $j) = @_;
+
+  return $self->{msa}->pid_matrix_get($pidmxHR, $i, $j);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 profile
+
+  Title    : profile
+  Usage    : $profile = $viewObject->profile($use_weights)
+  Function : Count residues in each column of the view in a single
+           : pass and return the counts as a Bio::Easel::MSA::Profile,
+           : as Bio::Easel::MSA::profile().
+  Args     : $use_weights: '1' to use weights in the parent MSA, '0' not to
+  Returns  : a new Bio::Easel::MSA::Profile object
+  Dies     : if the parent MSA is not digitized, or $use_weights is
+           : '1' and it has no valid weights
+
+=cut
+
+sub profile {
+  my ($self, $use_weights) = @_;
+
+  $self->_check_view();
+  require Bio::Easel::MSA::Profile;
+
+  return Bio::Easel::MSA::Profile->new({ msa => $self, use_weights => $use_weights });
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 write_msa
+
+  Title    : write_msa
+  Usage    : $viewObject->write_msa($outfile, $format, $do_append_if_exists)
+  Function : Write the sequences and columns of the view to a file,
+           : as Bio::Easel::MSA::write_msa(). Easel's writers need an
+           : ESL_MSA, so a copy of the view (not of the parent) is
+           : made for the duration of the write, annotated as
+           : sequence_subset() and column_subset() would annotate it.
+  Args     : see Bio::Easel::MSA::write_msa()
+  Returns  : void
+
+=cut
+
+sub write_msa {
+  my ($self, $outfile, $format, $do_append_if_exists) = @_;
+
+  $self->_check_view();
+  my $new_msa = Bio::Easel::MSA->new({
+    esl_msa => Bio::Easel::MSA::_c_view_materialize($self->{esl_view}),
+  });
+  $new_msa->write_msa($outfile, $format, $do_append_if_exists);
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _check_view
+
+  Title    : _check_view
+  Usage    : $viewObject->_check_view()
+  Function : Check that the parent MSA has not been modified
+           : since the view was created: that its ESL_MSA has not
+           : been freed or replaced, which bumps the parent's
+           : generation, and still has the same nseq and alen.
+  Args     : none
+  Returns  : void
+  Dies     : if the parent MSA has been freed, replaced or resized,
+           : with croak
+
+=cut
+
+sub _check_view {
+  my ($self) = @_;
+
+  if ( ! defined $self->{msa}->{esl_msa} || $self->{msa}->{generation} != $self->{msa_generation} ) {
+    croak "parent MSA of view was freed or replaced after the view was created";
+  }
+  Bio::Easel::MSA::_c_view_check($self->{esl_view});
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 DESTROY
+
+  Title    : DESTROY
+  Usage    : $viewObject->DESTROY()
+  Function : Frees the view, but not its parent MSA
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub DESTROY {
+  my ($self) = @_;
+
+  if ( defined $self->{esl_view} ) {
+    Bio::Easel::MSA::_c_view_destroy($self->{esl_view});
+  }
+  $self->{esl_view} = undef;
+
+  return;
+}
+
+=head1 AUTHORS
+
+Eric Nawrocki, C<< <nawrocke at ncbi.nlm.nih.gov> >>
+
+=head1 BUGS
+
+Please report any bugs or feature requests to C<bug-bio-easel at rt.cpan.org>.
+
+=head1 SUPPORT
+
+You can find documentation for this module with the perldoc command.
+
+    perldoc Bio::Easel::MSA::View
+
+=head1 ACKNOWLEDGEMENTS
+
+Sean R. Eddy is the author of the Easel C library of functions for
+biological sequence analysis, upon which this module is based.
+
+=head1 LICENSE AND COPYRIGHT
+
+Copyright 2013 Eric Nawrocki.
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of either: the GNU General Public License as published
+by the Free Software Foundation; or the Artistic License.
+
+See http://dev.perl.org/licenses/ for more information.
+
+
+=cut
+
+1;
@@ -0,0 +1,129 @@
+#include "easel.h"
+#include "esl_alphabet.h"
+#include "esl_buffer.h"
+#include "esl_msa.h"
+#include "esl_msafile.h"
+
+/* Macros for converting C structs to perl, and back again)
+ * from: http://www.mail-archive.com/inline@perl.org/msg03389.html
+ * note the typedef in ~/perl/tw_modules/typedef
+ */
+#define perl_obj(pointer,class) ({                      \
+      SV* ref=newSViv(0); SV* obj=newSVrv(ref, class);  \
+      sv_setiv(obj, (IV) pointer); SvREADONLY_on(obj);  \
+      ref;                                              \
+    })
+
+#define c_obj(sv,type) (                                                \
+                        (sv_isobject(sv) && sv_derived_from(sv, #type)) \
+                        ? ((type*)SvIV(SvRV(sv)))                       \
+                        : NULL                                          \
+                                                   )
+
+/* Function:  _c_open_msafile()
+ * Synopsis:  Open an alignment file for reading one or more MSAs
+ *            sequentially with _c_read_next_msa().
+ * Args:      infile:     name of file to open, "-" for stdin; gzipped
+ *                        files (.gz suffix) are read through a pipe
+ *            reqdFormat: required format, "unknown" for no specific format required
+ *            digitize:   '1' to read alignments in digital mode, '0' to read in text mode
+ *            is_rna:     '1' to force RNA alphabet
+ *            is_dna:     '1' to force DNA alphabet
+ *            is_amino:   '1' to force amino alphabet
+ *
+ *            Only one of is_rna, is_dna, and is_amino can be TRUE, if any is true, digitize
+ *            must also be true. In digital mode the alphabet is created (or guessed)
+ *            once here and shared by every MSA subsequently read from the file.
+ *
+ * Returns:   an ESL_MSAFILE
+ * Dies:      with croak if file can't be opened or format is invalid.
+ */
+
+SV *_c_open_msafile (char *infile, char *reqdFormat, int digitize, int is_rna, int is_dna, int is_amino)
+{
+  int           status;      /* Easel status code */
+  ESL_MSAFILE  *afp = NULL;  /* open input alignment file */
+  ESL_ALPHABET *abc = NULL;  /* alphabet, NULL to guess it when digitize is TRUE */
+  int           fmt;         /* int code for format string */
+
+  if(is_rna && is_dna)   croak("Error in _c_open_msafile, is_rna and is_dna are both true");
+  if(is_rna && is_amino) croak("Error in _c_open_msafile, is_rna and is_amino are both true");
+  if(is_dna && is_amino) croak("Error in _c_open_msafile, is_dna and is_amino are both true");
+  if((is_rna || is_dna || is_amino) && (! digitize)) {
+    croak("Error in _c_open_msafile, alphabet is specified but digitize is FALSE");
+  }
+
+  fmt = esl_msafile_EncodeFormat(reqdFormat);
+  if(fmt == eslMSAFILE_UNKNOWN && strcmp(reqdFormat, "unknown") != 0) {
+    croak("Error in _c_open_msafile, invalid required format %s", reqdFormat);
+  }
+
+  if      (is_rna)   abc = esl_alphabet_Create(eslRNA);
+  else if (is_dna)   abc = esl_alphabet_Create(eslDNA);
+  else if (is_amino) abc = esl_alphabet_Create(eslAMINO);
+
+  if ((status = esl_msafile_Open((digitize) ? &abc : NULL, infile, NULL, fmt, NULL, &afp)) != eslOK) {
+    croak("Error opening alignment file %s: %s\n", infile, (afp != NULL) ? afp->errmsg : "unknown error");
+  }
+
+  return perl_obj(afp, "ESL_MSAFILE");
+}
+
+/* Function:  _c_read_next_msa()
+ * Synopsis:  Read the next MSA from an open alignment file.
+ * Args:      afp: the open ESL_MSAFILE
+ * Returns:   two values: the next ESL_MSA and the byte offset in the
+ *            file at which reading of that record began.
+ *            Returns an empty list if no more MSAs remain (EOF).
+ * Dies:      with croak if a parse error occurs.
+ */
+
+void _c_read_next_msa (ESL_MSAFILE *afp)
+{
+  Inline_Stack_Vars;
+
+  int        status;      /* Easel status code */
+  ESL_MSA   *msa = NULL;  /* the alignment */
+  esl_pos_t  offset;      /* offset of the record in the file */
+
+  offset = esl_buffer_GetOffset(afp->bf);
+  status = esl_msafile_Read(afp, &msa);
+
+  Inline_Stack_Reset;
+  if(status == eslEOF) {
+    Inline_Stack_Done;
+    Inline_Stack_Return(0);
+    return;
+  }
+  if(status != eslOK) {
+    croak("Alignment file read failed with error code %d at line %ld: %s\n", status, (long) afp->linenumber, afp->errmsg);
+  }
+
+  Inline_Stack_Push(perl_obj(msa, "ESL_MSA"));
+  Inline_Stack_Push(sv_2mortal(newSViv((IV) offset)));
+  Inline_Stack_Done;
+  Inline_Stack_Return(2);
+}
+
+/* Function:  _c_get_format()
+ * Synopsis:  Return a string describing the format of an open alignment file.
+ * Returns:   format string, e.g. "Stockholm"
+ */
+
+SV *_c_get_format (ESL_MSAFILE *afp)
+{
+  return newSVpv(esl_msafile_DecodeFormat(afp->format), 0);
+}
+
+/* Function:  _c_close_msafile()
+ * Synopsis:  Close an open alignment file. The alphabet is not
+ *            freed, because any MSAs read from the file still
+ *            refer to it.
+ * Returns:   void
+ */
+
+void _c_close_msafile (ESL_MSAFILE *afp)
+{
+  if(afp) esl_msafile_Close(afp);
+  return;
+}
@@ -0,0 +1,387 @@
+package Bio::Easel::MSAFile;
+
+use strict;
+use warnings;
+use File::Spec;
+use Carp;
+
+use Bio::Easel::MSA;
+
+=head1 NAME
+
+Bio::Easel::MSAFile - sequential reading of multi-MSA files
+
+=head1 VERSION
+
+Version 0.01
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+our $VERSION = '0.01';
+
+my $src_file      = undef;
+my $typemaps      = undef;
+my $easel_src_dir = undef;
+
+BEGIN {
+  $src_file = __FILE__;
+  $src_file =~ s/\.pm/\.c/;
+
+  my $file = __FILE__;
+  ($easel_src_dir) = $file =~ /^(.*)\/blib/;
+  $easel_src_dir = File::Spec->catfile( $easel_src_dir, 'src/easel' );
+
+  $typemaps = __FILE__;
+  $typemaps =~ s/\.pm/\.typemap/;
+}
+
+use Inline
+  C        => "$src_file",
+  VERSION  => '0.01',
+  ENABLE   => 'AUTOWRAP',
+  INC      => "-I$easel_src_dir",
+  LIBS     => "-L$easel_src_dir -leasel",
+  TYPEMAPS => $typemaps,
+  NAME     => 'Bio::Easel::MSAFile';
+
+=head1 SYNOPSIS
+
+Read each alignment in a multi-MSA file (e.g. Rfam.seed) in turn,
+keeping a single Easel ESL_MSAFILE open for the whole pass.
+
+    use Bio::Easel::MSAFile;
+
+    my $msafile = Bio::Easel::MSAFile->new({"fileLocation" => $alnfile});
+    while(my $msa = $msafile->next_msa()) {
+      printf("%s at offset %d\n", $msa->get_name, $msafile->offset);
+    }
+    $msafile->close_msafile();
+
+=head1 EXPORT
+
+No functions currently exported.
+
+=head1 SUBROUTINES/METHODS
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+=head2 new
+
+  Title    : new
+  Usage    : Bio::Easel::MSAFile->new
+  Function : Generates a new Bio::Easel::MSAFile object, and
+           : opens the alignment file for reading.
+  Args     : <fileLocation>: file location of alignment file, "-" for stdin
+           : <reqdFormat>:   optional: string defining requested/required format
+           :                 (see Bio::Easel::MSA::new() for valid strings)
+           : <forceText>:    '1' to read the alignments in text mode
+           : <isRna>:        '1' to force RNA alphabet
+           : <isDna>:        '1' to force DNA alphabet
+           : <isAmino>:      '1' to force protein alphabet
+  Returns  : Bio::Easel::MSAFile object
+  Dies     : if file does not exist or can't be opened
+
+=cut
+
+sub new {
+  my ( $caller, $args ) = @_;
+  my $class = ref($caller) || $caller;
+  my $self = {};
+
+  bless( $self, $caller );
+
+  if ( ! defined $args->{fileLocation} ) {
+    confess("Expected to receive a file location");
+  }
+  if ( $args->{fileLocation} ne "-" && ! -e $args->{fileLocation} ) {
+    confess("Expected to receive a valid file location path (@{[$args->{fileLocation}]} doesn\'t exist)");
+  }
+  $self->{path}       = $args->{fileLocation};
+  $self->{reqdFormat} = (defined $args->{reqdFormat}) ? $args->{reqdFormat} : "unknown";
+  $self->{digitize}   = (defined $args->{forceText} && $args->{forceText}) ? 0 : 1;
+  $self->{isRna}      = (defined $args->{isRna})   ? $args->{isRna}   : 0;
+  $self->{isDna}      = (defined $args->{isDna})   ? $args->{isDna}   : 0;
+  $self->{isAmino}    = (defined $args->{isAmino}) ? $args->{isAmino} : 0;
+
+  eval {
+    $self->open_msafile();
+  }; # end of eval
+  if ($@) {
+    confess("Error opening alignment file @{[$args->{fileLocation}]}, $@\n");
+  }
+
+  return $self;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 msafile
+
+  Title    : msafile
+  Usage    : $msafileObject->msafile()
+  Function : Accessor for the ESL_MSAFILE: opens (if nec) and returns it.
+  Args     : none
+  Returns  : ESL_MSAFILE
+
+=cut
+
+sub msafile {
+  my ($self) = @_;
+
+  $self->_check_msafile();
+  return $self->{esl_msafile};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 path
+
+  Title    : path
+  Usage    : $msafileObject->path()
+  Function : Accessor for path, read only.
+  Args     : none
+  Returns  : string containing path to the alignment file
+
+=cut
+
+sub path {
+  my ($self) = @_;
+
+  return $self->{path};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 format
+
+  Title    : format
+  Usage    : $msafileObject->format()
+  Function : Gets the format of the open alignment file.
+  Args     : none
+  Returns  : String of the format, e.g. "Stockholm".
+
+=cut
+
+sub format {
+  my ($self) = @_;
+
+  return $self->{informat};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 offset
+
+  Title    : offset
+  Usage    : $msafileObject->offset()
+  Function : Return the byte offset in the file at which reading of
+           : the MSA most recently returned by next_msa() began.
+  Args     : none
+  Returns  : byte offset, or undef if no MSA has been read yet
+
+=cut
+
+sub offset {
+  my ($self) = @_;
+
+  return $self->{offset};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 nread
+
+  Title    : nread
+  Usage    : $msafileObject->nread()
+  Function : Return the number of MSAs read so far by next_msa().
+  Args     : none
+  Returns  : number of MSAs read
+
+=cut
+
+sub nread {
+  my ($self) = @_;
+
+  return $self->{nread};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 open_msafile
+
+  Title    : open_msafile
+  Usage    : $msafileObject->open_msafile()
+  Function : Opens the alignment file in $self->{path}, positioned
+           : at its first MSA.
+  Args     : none
+  Returns  : void
+  Dies     : if unable to open the file
+
+=cut
+
+sub open_msafile {
+  my ($self) = @_;
+
+  if ( defined $self->{esl_msafile} ) {
+    $self->close_msafile();
+  }
+  $self->{esl_msafile} = _c_open_msafile($self->{path}, $self->{reqdFormat}, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino});
+  $self->{informat}    = _c_get_format($self->{esl_msafile});
+  $self->{offset}      = undef;
+  $self->{nread}       = 0;
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 next_msa
+
+  Title    : next_msa
+  Usage    : $msa = $msafileObject->next_msa()
+  Function : Read the next alignment from the open file. In digital
+           : mode all MSAs share the alphabet determined when the
+           : file was opened. After a successful read, offset()
+           : returns the byte offset at which the record began.
+  Args     : none
+  Returns  : a new Bio::Easel::MSA object, or undef if there are
+           : no more alignments in the file.
+  Dies     : upon a parse error, with croak
+
+=cut
+
+sub next_msa {
+  my ($self) = @_;
+
+  $self->_check_msafile();
+
+  my ($esl_msa, $offset) = _c_read_next_msa($self->{esl_msafile});
+  if ( ! defined $esl_msa ) {
+    return undef;
+  }
+
+  my $msa = Bio::Easel::MSA->new({
+    esl_msa => $esl_msa,
+  });
+  $msa->{informat} = $self->{informat};
+  $msa->{digitize} = $self->{digitize};
+
+  $self->{offset} = $offset;
+  $self->{nread}++;
+
+  return $msa;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 close_msafile
+
+  Title    : close_msafile
+  Usage    : $msafileObject->close_msafile()
+  Function : Closes the open alignment file. MSAs previously
+           : returned by next_msa() remain valid.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub close_msafile {
+  my ($self) = @_;
+
+  if ( defined $self->{esl_msafile} ) {
+    _c_close_msafile($self->{esl_msafile});
+  }
+  $self->{esl_msafile} = undef;
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 DESTROY
+
+  Title    : DESTROY
+  Usage    : $msafileObject->DESTROY()
+  Function : Closes the alignment file, if it is open
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub DESTROY {
+  my ($self) = @_;
+
+  $self->close_msafile();
+  return;
+}
+
+#############################
+# Internal helper subroutines
+#############################
+
+#-------------------------------------------------------------------------------
+
+=head2 _check_msafile
+
+  Title    : _check_msafile
+  Usage    : $msafileObject->_check_msafile()
+  Function : Opens the alignment file only if it is not currently open
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub _check_msafile {
+  my ($self) = @_;
+
+  if ( ! defined $self->{esl_msafile} ) {
+    $self->open_msafile();
+  }
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _c_open_msafile
+=head2 _c_read_next_msa
+=head2 _c_get_format
+=head2 _c_close_msafile
+=head2 dl_load_flags
+
+=head1 AUTHORS
+
+Eric Nawrocki, C<< <nawrocke at ncbi.nlm.nih.gov> >>
+
+=head1 BUGS
+
+Please report any bugs or feature requests to C<bug-bio-easel at rt.cpan.org>.
+
+=head1 SUPPORT
+
+You can find documentation for this module with the perldoc command.
+
+    perldoc Bio::Easel::MSAFile
+
+=head1 ACKNOWLEDGEMENTS
+
+Sean R. Eddy is the author of the Easel C library of functions for
+biological sequence analysis, upon which this module is based.
+
+=head1 LICENSE AND COPYRIGHT
+
+Copyright 2013 Eric Nawrocki.
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of either: the GNU General Public License as published
+by the Free Software Foundation; or the Artistic License.
+
+See http://dev.perl.org/licenses/ for more information.
+
+
+=cut
+
+1;
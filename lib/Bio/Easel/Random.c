@@ -48,6 +48,202 @@ unsigned long _c_roll (ESL_RANDOMNESS *r, unsigned long range)
   return (unsigned long) (esl_random(r) * (range));
 }
 
+/* Function:  _c_roll64()
+ * Synopsis:  Return a uniformly distributed integer in the range 0..range-1,
+ *            exactly as _c_roll() does, for 64-bit ranges.
+ */
+int64_t _c_roll64 (ESL_RANDOMNESS *r, int64_t range)
+{
+  return (int64_t) (esl_random(r) * (range));
+}
+
+/* Function:  _c_new_packed()
+ * Synopsis:  Create a string SV with room for <n> native int64s 
+ *            (Perl unpack() template "q*") and length <n> int64s,
+ *            for filling in place through SvPVX().
+ */
+SV *_c_new_packed (int64_t n)
+{
+  SV *sv = newSV(sizeof(int64_t) * n + 1); 
+
+  SvPOK_on(sv);
+  SvCUR_set(sv, sizeof(int64_t) * n);
+  *(SvPVX(sv) + sizeof(int64_t) * n) = '\0';
+  return sv;
+}
+
+/* Function:  _c_shuffle_indices()
+ * Synopsis:  Return a random permutation of 0..n-1.
+ * Purpose:   Fisher-Yates shuffle, done in place in the returned
+ *            packed int64 buffer: for i from n-1 down to 1, swap
+ *            element i with a randomly chosen element 0..i. Uses 
+ *            n-1 draws from <r>, so the result is determined by 
+ *            <r>'s seed and state.
+ * Args:      r: ESL_RANDOMNESS
+ *            n: number of indices
+ * Returns:   String of n native int64s (unpack with "q*").
+ */
+SV *_c_shuffle_indices (ESL_RANDOMNESS *r, long n)
+{
+  SV      *retSV;   /* string to return */
+  int64_t *a;       /* its buffer */
+  int64_t  i, j;    /* indices */
+  int64_t  tmp;     /* for swapping */
+
+  if(n < 0) croak("_c_shuffle_indices, n (%ld) is negative", n);
+  retSV = _c_new_packed(n);
+  a     = (int64_t *) SvPVX(retSV);
+  for(i = 0; i < n; i++) a[i] = i;
+  for(i = n-1; i > 0; i--) { 
+    j = _c_roll64(r, i+1);
+    tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+  }
+  return retSV;
+}
+
+/* Function:  _c_sample_indices()
+ * Synopsis:  Return <k> distinct indices sampled uniformly from 0..n-1,
+ *            in random order.
+ * Purpose:   If <k> is a sizable fraction of <n> (at least n/4) a
+ *            partial Fisher-Yates shuffle of 0..n-1 is done in place
+ *            in the returned buffer, which is then truncated to <k>.
+ *            Otherwise, to avoid allocating <n> elements, Floyd's
+ *            algorithm is used with an open addressing hash set of
+ *            the chosen indices: for j from n-k to n-1 pick t from 
+ *            0..j, taking j instead if t is already chosen. The 
+ *            <k> indices are then put in random order with a 
+ *            Fisher-Yates shuffle. Either way the result is
+ *            determined by <r>'s seed and state.
+ * Args:      r: ESL_RANDOMNESS
+ *            n: size of range to sample from
+ *            k: number of indices to sample, <= n
+ * Returns:   String of k native int64s (unpack with "q*").
+ * Dies:      if k > n or either is negative, or out of memory
+ */
+SV *_c_sample_indices (ESL_RANDOMNESS *r, long n, long k)
+{
+  int      status;          /* Easel status code */
+  SV      *retSV;           /* string to return */
+  int64_t *a;               /* its buffer */
+  int64_t *hashA  = NULL;   /* hash set of chosen indices, -1 for empty slots */
+  int64_t  nhash;           /* size of hashA, a power of 2 >= 2k */
+  int      shift;           /* 64 - log2(nhash) */
+  uint64_t h;               /* hash slot */
+  int64_t  i, j, t;         /* indices */
+  int64_t  tmp;             /* for swapping */
+
+  if(n < 0 || k < 0) croak("_c_sample_indices, n (%ld) and k (%ld) must not be negative", n, k);
+  if(k > n)          croak("trying to choose %ld elements from a range of size %ld", k, n);
+
+  if(k * 4 >= n) { 
+    /* partial Fisher-Yates: after step i, a[0..i] is the sample */
+    retSV = _c_new_packed(n);
+    a     = (int64_t *) SvPVX(retSV);
+    for(i = 0; i < n; i++) a[i] = i;
+    for(i = 0; i < k; i++) { 
+      j = i + _c_roll64(r, n-i);
+      tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+    }
+    SvCUR_set(retSV, sizeof(int64_t) * k);
+    *(SvPVX(retSV) + sizeof(int64_t) * k) = '\0';
+    SvPV_shrink_to_cur(retSV);
+    return retSV;
+  }
+
+  /* Floyd's algorithm */
+  retSV = _c_new_packed(k);
+  a     = (int64_t *) SvPVX(retSV);
+  for(nhash = 2, shift = 63; nhash < 2*k; nhash *= 2) shift--;
+  ESL_ALLOC(hashA, sizeof(int64_t) * nhash);
+  for(i = 0; i < nhash; i++) hashA[i] = -1;
+
+  for(i = 0, j = n-k; j < n; i++, j++) { 
+    t = _c_roll64(r, j+1);
+    /* look for t, ending on an empty slot if it's not there */
+    for(h = ((uint64_t) t * 0x9E3779B97F4A7C15ULL) >> shift; hashA[h] != -1 && hashA[h] != t; h = (h+1) & (nhash-1)) ;
+    if(hashA[h] == t) { /* t already chosen, choose j, which can't have been */
+      t = j;
+      for(h = ((uint64_t) t * 0x9E3779B97F4A7C15ULL) >> shift; hashA[h] != -1; h = (h+1) & (nhash-1)) ;
+    }
+    hashA[h] = t;
+    a[i]     = t;
+  }
+  free(hashA);
+
+  /* Floyd's algorithm gives a uniform set, but not in uniform order */
+  for(i = k-1; i > 0; i--) { 
+    j = _c_roll64(r, i+1);
+    tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+  }
+  return retSV;
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_fmix32()
+ * Synopsis:  MurmurHash3's 32-bit finalizer, a bijection on 32-bit
+ *            integers, used to scramble spawned generators' seeds.
+ */
+uint32_t _c_fmix32 (uint32_t h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+
+/* Function:  _c_spawn_seed()
+ * Synopsis:  Return the seed of child <idx> of a generator with
+ *            seed <seed>: fmix32(fmix32(seed) + (idx+1) * golden),
+ *            which is a bijection on <idx> for 0 <= idx < 2^32-1,
+ *            so children of one parent get distinct seeds. Easel
+ *            treats a seed of 0 as "arbitrary", so if that comes
+ *            up the seed for idx 2^32-1, which is never used, is
+ *            returned instead.
+ */
+uint32_t _c_spawn_seed (uint32_t seed, uint32_t idx)
+{
+  uint32_t base = _c_fmix32(seed);
+  uint32_t s    = _c_fmix32(base + (idx + 1U) * 0x9e3779b9U);
+
+  if(s == 0) s = _c_fmix32(base); /* idx + 1 == 2^32 */
+  return s;
+}
+
+/* Function:  _c_spawn_randomness()
+ * Synopsis:  Create child ESL_RANDOMNESS number <idx> of <parent>.
+ * Purpose:   Hash-based seeding: the child is an ordinary Mersenne
+ *            Twister created with esl_randomness_Create() from a 
+ *            32-bit seed hashed from <parent>'s seed and <idx> by
+ *            _c_spawn_seed(), so it is the same however many 
+ *            children are spawned and however much <parent> has
+ *            been used, and the child's seed reproduces its stream.
+ *            This is not jump-ahead: streams of different seeds 
+ *            are not guaranteed not to overlap, though for MT19937
+ *            overlap within any practical number of draws is 
+ *            vanishingly unlikely.
+ * Args:      parent: ESL_RANDOMNESS
+ *            idx:    index of the child, 0 <= idx < 2^32-1
+ * Returns:   the new ESL_RANDOMNESS
+ * Dies:      with croak if <idx> is out of range, or out of memory.
+ */
+SV *_c_spawn_randomness (ESL_RANDOMNESS *parent, long idx)
+{
+  ESL_RANDOMNESS *r = NULL;  /* the child */
+
+  if(parent == NULL)                       croak("_c_spawn_randomness, parent is NULL");
+  if(idx < 0 || (int64_t) idx >= INT64_C(4294967295)) croak("_c_spawn_randomness, idx (%ld) out of range", idx);
+
+  r = esl_randomness_Create(_c_spawn_seed(parent->seed, (uint32_t) idx));
+  if(r == NULL) croak("unable to create ESL_RANDOMNESS object, probably out of memory"); 
+
+  return perl_obj(r, "ESL_RANDOMNESS");
+}
+
 /* Function:  _c_get_seed()
  * Incept:    EPN, Tue Apr  9 09:50:21 2013
  * Synopsis:  Return seed of a ESL_RANDOMNESS object.
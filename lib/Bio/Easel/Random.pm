@@ -253,6 +253,107 @@ sub random_subset_from_array {
   return;
 }
 
+=head2 sample_indices
+
+  Title    : sample_indices
+  Usage    : $idxAR = $rng->sample_indices($n, $k)
+  Function : Sample $k distinct indices uniformly from 0..$n-1, in 
+           : random order, in a single C call: a partial 
+           : Fisher-Yates shuffle if $k is at least $n/4, else 
+           : Floyd's algorithm, which needs memory proportional to
+           : $k only. Deterministic for a given seed. Much faster 
+           : than random_subset_from_array() for large samples, 
+           : e.g. pick elements of @origA with @origA[@{$idxAR}].
+  Args     : $n:        size of range to sample from
+           : $k:        number of indices to sample, <= $n
+           : $ret_type: OPTIONAL: "arrayref" (default) for a ref to an array of indices,
+           :            "packed" for a single string of native int64s (unpack with "q*")
+  Returns  : ref to array of indices, or string of packed indices
+  Dies     : if $n or $k is not a non-negative integer, $k > $n, or
+           : $ret_type is invalid
+
+=cut
+
+sub sample_indices { 
+  my ( $self, $n, $k, $ret_type ) = @_;
+
+  $self->_check_randomness();
+  if(! defined $n || $n !~ m/^\d+$/) { croak "sample_indices(): n must be a non-negative integer"; }
+  if(! defined $k || $k !~ m/^\d+$/) { croak "sample_indices(): k must be a non-negative integer"; }
+  if($k > $n) { croak "trying to choose $k elements from a range of size $n"; }
+
+  return _packed_to_ret_type(_c_sample_indices($self->{esl_randomness}, $n, $k), $ret_type);
+}
+
+=head2 shuffle_indices
+
+  Title    : shuffle_indices
+  Usage    : $idxAR = $rng->shuffle_indices($n)
+  Function : Return a random permutation of 0..$n-1, made by a 
+           : Fisher-Yates shuffle in place in a packed buffer in a
+           : single C call. Deterministic for a given seed.
+  Args     : $n:        number of indices
+           : $ret_type: OPTIONAL: "arrayref" (default) for a ref to an array of indices,
+           :            "packed" for a single string of native int64s (unpack with "q*")
+  Returns  : ref to array of indices, or string of packed indices
+  Dies     : if $n is not a non-negative integer or $ret_type is invalid
+
+=cut
+
+sub shuffle_indices { 
+  my ( $self, $n, $ret_type ) = @_;
+
+  $self->_check_randomness();
+  if(! defined $n || $n !~ m/^\d+$/) { croak "shuffle_indices(): n must be a non-negative integer"; }
+
+  return _packed_to_ret_type(_c_shuffle_indices($self->{esl_randomness}, $n), $ret_type);
+}
+
+=head2 spawn
+
+  Title    : spawn
+  Usage    : $rngAR = $rng->spawn($k)
+  Function : Create $k child generators, e.g. one per worker for
+           : parallel sampling. This is hash-based seeding, not
+           : jump-ahead: each child is an ordinary Mersenne Twister
+           : whose 32-bit seed is a hash of this object's seed and
+           : the child's index, not of its current state, so child
+           : $i is the same however many children are spawned, how
+           : many workers use them and how much $rng has been used.
+           : Children of one parent have distinct seeds, up to 
+           : 2^32-1 of them, but their streams are not guaranteed
+           : not to overlap. A child's 
+           : seed (its {seed}, or _c_get_seed()) reproduces its 
+           : stream when passed to new(). Successive calls continue
+           : numbering children where the previous call left off,
+           : so they never return the same seed twice.
+  Args     : $k: number of generators to create
+  Returns  : ref to array of $k Bio::Easel::Random objects
+  Dies     : if $k is not a positive integer, or upon error in
+           : _c_spawn_randomness(), including more than 2^32-1 
+           : children in total, with croak
+
+=cut
+
+sub spawn { 
+  my ( $self, $k ) = @_;
+
+  $self->_check_randomness();
+  if(! defined $k || $k !~ m/^\d+$/ || $k < 1) { croak "spawn(): number of generators must be a positive integer"; }
+  if(! defined $self->{nspawned}) { $self->{nspawned} = 0; }
+
+  my @retA = ();
+  for(my $i = 0; $i < $k; $i++) { 
+    my $child = {};
+    bless( $child, ref($self) );
+    $child->{esl_randomness} = _c_spawn_randomness($self->{esl_randomness}, $self->{nspawned}++);
+    $child->{seed} = _c_get_seed( $child->{esl_randomness} );
+    push(@retA, $child);
+  }
+
+  return \@retA;
+}
+
 =head2 DESTROY
 
   Title    : DESTROY
@@ -296,6 +397,28 @@ sub _check_randomness {
   return;
 }
 
+=head2 _packed_to_ret_type
+
+  Title    : _packed_to_ret_type
+  Usage    : _packed_to_ret_type($packed, $ret_type)
+  Function : Return packed int64 indices from C as requested by
+           : $ret_type: "arrayref" (default) or "packed".
+  Args     : $packed:   string of native int64s
+           : $ret_type: "arrayref", "packed" or undef
+  Returns  : ref to array of indices, or $packed
+  Dies     : if $ret_type is invalid
+
+=cut
+
+sub _packed_to_ret_type {
+  my ($packed, $ret_type) = @_;
+
+  if(defined $ret_type && $ret_type eq "packed")   { return $packed; }
+  if(defined $ret_type && $ret_type ne "arrayref") { croak "invalid return type $ret_type, must be \"arrayref\" or \"packed\""; }
+
+  return [ unpack("q*", $packed) ];
+}
+
 =head2 dl_load_flags
 
 =head1 AUTHORS
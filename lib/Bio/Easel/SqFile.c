@@ -1,5 +1,15 @@
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 #include "easel.h"
 #include "esl_alphabet.h"
+#include "esl_random.h"
 #include "esl_sqio.h"
 #include "esl_sq.h"
 #include "esl_ssi.h"
@@ -29,20 +39,28 @@
  *            is_rna:     '1' to force RNA alphabet
  *            is_dna:     '1' to force DNA alphabet
  *            is_amino:   '1' to force amino alphabet
+ *            format:     format of the file, e.g. "fasta", "" to autodetect;
+ *                        required for stdin ("-") and gzipped files
  *           
  * Returns:   eslOK on success, dies with 'croak' upon an error.
  */
 
-SV *_c_open_sqfile (char *seqfile, int do_digital, int is_rna, int is_dna, int is_amino)
+SV *_c_open_sqfile (char *seqfile, int do_digital, int is_rna, int is_dna, int is_amino, char *format)
 {
   int           status;      /* Easel status code */
   ESL_SQFILE   *sqfp = NULL; /* open input alignment file */
+  int           fmt  = eslSQFILE_UNKNOWN; /* format of the file */
   /* used only if do_digital is TRUE */
   ESL_ALPHABET *abc       = NULL;
   int           alphatype = eslUNKNOWN;
 
+  if(format[0] != '\0') { 
+    fmt = esl_sqio_EncodeFormat(format);
+    if(fmt == eslSQFILE_UNKNOWN) croak("Unrecognized sequence file format %s\n", format);
+  }
+
   /* open input file */
-  status = esl_sqfile_Open(seqfile, eslSQFILE_UNKNOWN, NULL, &sqfp);
+  status = esl_sqfile_Open(seqfile, fmt, NULL, &sqfp);
   if      (status == eslENOTFOUND) croak("Sequence file %s not found.\n",     seqfile);
   else if (status == eslEFORMAT)   croak("Format of file %s unrecognized.\n", seqfile);
   else if (status == eslEINVAL)    croak("Can't autodetect stdin or .gz for sequence file %s\n", seqfile);
@@ -104,22 +122,294 @@ int _c_open_ssi_index (ESL_SQFILE *sqfp)
   return eslOK;
 }    
 
+/* BESQ_SSI_MIN_CHUNK: minimum number of bytes of sequence file
+ * per thread for _c_create_ssi_index() to index in parallel,
+ * smaller files aren't worth the thread startup and resync cost.
+ */
+#define BESQ_SSI_MIN_CHUNK 1048576
+
+/* BESQ_SSIKEY: one key read by a _c_ssi_chunk_thread() */
+typedef struct {
+  char    *name;  /* sequence name */
+  char    *acc;   /* accession, NULL if none */
+  off_t    roff;  /* record offset */
+  off_t    doff;  /* data offset */
+  int64_t  L;     /* sequence length */
+} BESQ_SSIKEY;
+
+/* BESQ_SSI_CHUNK: one byte range of a sequence file to index,
+ * and the keys found in it, for _c_ssi_chunk_thread().
+ */
+typedef struct {
+  char        *filename;              /* sequence file */
+  int          format;                /* its format */
+  off_t        start;                 /* offset of first record in chunk */
+  off_t        end;                   /* offset of first record after chunk, -1 for end of file */
+  BESQ_SSIKEY *keyA;                  /* [0..i..nkey-1] keys in chunk, in file order */
+  int64_t      nkey;                  /* number of keys in keyA */
+  int64_t      nalloc;                /* allocated size of keyA */
+  int64_t      bpl;                   /* bytes per line, 0 if unset, -1 if inconsistent */
+  int64_t      rpl;                   /* residues per line, 0 if unset, -1 if inconsistent */
+  int64_t      maxlast;               /* longest last line, in residues, of records read before rpl was set */
+  int          status;                /* eslOK on success */
+  char         errbuf[eslERRBUFSIZE]; /* error message if status != eslOK */
+} BESQ_SSI_CHUNK;
+
+/* Function:  _c_ssi_chunk_thread()
+ * Purpose:   pthread start routine for _c_ssi_index_parallel(). Open
+ *            the sequence file independently, position it at the
+ *            start of the chunk and read the names, offsets and
+ *            lengths of all records that start before the chunk's
+ *            end with esl_sqio_ReadInfo(). Never croaks, errors are
+ *            passed back in the chunk's status and errbuf.
+ */
+void *_c_ssi_chunk_thread(void *arg)
+{
+  BESQ_SSI_CHUNK *c    = (BESQ_SSI_CHUNK *) arg;
+  ESL_SQFILE     *sqfp = NULL;
+  ESL_SQ         *sq   = NULL;
+  BESQ_SSIKEY    *k;
+  void           *p;
+
+  c->errbuf[0] = '\0';
+  if((c->status = esl_sqfile_Open(c->filename, c->format, NULL, &sqfp)) != eslOK) { 
+    snprintf(c->errbuf, eslERRBUFSIZE, "failed to open sequence file %s", c->filename);
+    return NULL;
+  }
+  if((sq = esl_sq_Create()) == NULL) { c->status = eslEMEM; goto DONE; }
+  if(c->start > 0 && (c->status = esl_sqfile_Position(sqfp, c->start)) != eslOK) { 
+    snprintf(c->errbuf, eslERRBUFSIZE, "failed to position sequence file %s", c->filename);
+    goto DONE;
+  }
+
+  while((c->status = esl_sqio_ReadInfo(sqfp, sq)) == eslOK) { 
+    if(c->end != -1 && sq->roff >= c->end) break; /* first record of the next chunk */
+    if(sq->name[0] == '\0') { 
+      c->status = eslEFORMAT;
+      snprintf(c->errbuf, eslERRBUFSIZE, "Every sequence must have a name to be indexed, seq at offset %" PRId64 " has none", (int64_t) sq->roff);
+      goto DONE;
+    }
+    if(c->nkey == c->nalloc) { 
+      c->nalloc = (c->nalloc == 0) ? 4096 : c->nalloc * 2;
+      if((p = realloc(c->keyA, sizeof(BESQ_SSIKEY) * c->nalloc)) == NULL) { c->status = eslEMEM; goto DONE; }
+      c->keyA = (BESQ_SSIKEY *) p;
+    }
+    k = &(c->keyA[c->nkey]);
+    k->acc  = NULL;
+    if(esl_strdup(sq->name, -1, &(k->name)) != eslOK) { c->status = eslEMEM; goto DONE; }
+    c->nkey++;
+    if(sq->acc[0] != '\0' && esl_strdup(sq->acc, -1, &(k->acc)) != eslOK) { c->status = eslEMEM; goto DONE; }
+    k->roff = sq->roff;
+    k->doff = sq->doff;
+    k->L    = sq->L;
+    /* while rpl is unset every record has been a single line, which
+     * a serial read would check against the rpl of earlier chunks */
+    if(sqfp->data.ascii.rpl == 0 && sq->L > c->maxlast) c->maxlast = sq->L;
+    esl_sq_Reuse(sq);
+  }
+  if     (c->status == eslOK || c->status == eslEOF) c->status = eslOK;
+  else if(c->status == eslEFORMAT) snprintf(c->errbuf, eslERRBUFSIZE, "%s", esl_sqfile_GetErrorBuf(sqfp));
+  c->bpl = sqfp->data.ascii.bpl;
+  c->rpl = sqfp->data.ascii.rpl;
+
+ DONE:
+  if(c->status == eslEMEM && c->errbuf[0] == '\0') snprintf(c->errbuf, eslERRBUFSIZE, "out of memory");
+  if(sq   != NULL) esl_sq_Destroy(sq);
+  if(sqfp != NULL) esl_sqfile_Close(sqfp);
+  return NULL;
+}
+
+/* Function:  _c_ssi_chunks_free()
+ * Purpose:   Free the keys of chunks <cA[0..n-1]>, then <cA> itself.
+ */
+void _c_ssi_chunks_free(BESQ_SSI_CHUNK *cA, int n)
+{
+  int     c;
+  int64_t i;
+
+  for(c = 0; c < n; c++) { 
+    for(i = 0; i < cA[c].nkey; i++) { 
+      free(cA[c].keyA[i].name);
+      if(cA[c].keyA[i].acc != NULL) free(cA[c].keyA[i].acc);
+    }
+    if(cA[c].keyA != NULL) free(cA[c].keyA);
+  }
+  free(cA);
+}
+
+/* Function:  _c_ssi_resync()
+ * Purpose:   Return the offset of the first FASTA record start
+ *            (a '>' at the beginning of a line) at or after
+ *            byte <pos> of <fp>, or -1 if there is none.
+ */
+off_t _c_ssi_resync(FILE *fp, off_t pos)
+{
+  int   c;         /* current char */
+  int   prv;       /* previous char */
+  off_t off;       /* offset of c */
+
+  if(pos <= 0) return 0;
+  if(fseeko(fp, pos-1, SEEK_SET) != 0) return -1;
+  if((prv = getc(fp)) == EOF) return -1;
+  off = pos;
+  while((c = getc(fp)) != EOF) { 
+    if(c == '>' && (prv == '\n' || prv == '\r')) return off;
+    prv = c;
+    off++;
+  }
+  return -1;
+}
+
+/* Function:  _c_ssi_index_parallel()
+ * Purpose:   Add keys for all sequences in FASTA file <sqfp> to new
+ *            SSI index <ns> using <nchunk> threads. The file is split
+ *            into <nchunk> byte ranges, each resynchronized to the 
+ *            next record start, and indexed concurrently by 
+ *            _c_ssi_chunk_thread(). Keys are then added to <ns> 
+ *            in file order, so the index is identical to the one
+ *            built serially.
+ *
+ *            Bytes and residues per line are merged over chunks: 
+ *            set if every chunk that saw them agrees, -1 if any
+ *            chunk was inconsistent or two chunks disagree, or if
+ *            a chunk's single line records, read before it set 
+ *            its own rpl, have a last line longer than the rpl 
+ *            of the earlier chunks, as a serial read would find.
+ *
+ *            If a thread can't be created, the chunks that haven't
+ *            been started are indexed in the calling thread. All
+ *            threads are joined and all keys freed before any error
+ *            is reported.
+ *
+ * Args:      sqfp     - open sequence file, FASTA, not gzipped or stdin
+ *            ns       - new SSI index to add keys to
+ *            fh       - file handle of <sqfp> in <ns>
+ *            filesize - size of the sequence file in bytes
+ *            nchunk   - number of chunks/threads, >= 2
+ *            ret_bpl  - RETURN: merged bytes per line
+ *            ret_rpl  - RETURN: merged residues per line
+ *
+ * Returns:   number of sequences indexed
+ * Dies:      with croak upon an error in any chunk
+ */
+int64_t _c_ssi_index_parallel(ESL_SQFILE *sqfp, ESL_NEWSSI *ns, uint16_t fh, off_t filesize, int nchunk, int64_t *ret_bpl, int64_t *ret_rpl)
+{
+  int             status;          /* Easel status code */
+  BESQ_SSI_CHUNK *cA   = NULL;     /* [0..c..nchunk-1] chunks */
+  pthread_t      *tidA = NULL;     /* [0..c..nchunk-1] threads */
+  FILE           *fp   = NULL;     /* file for finding chunk boundaries */
+  off_t           off;             /* a chunk boundary */
+  int64_t         nseq = 0;        /* number of seqs indexed */
+  int64_t         bpl  = 0;        /* merged bytes per line */
+  int64_t         rpl  = 0;        /* merged residues per line */
+  int             c;               /* counter over chunks */
+  int             n;               /* number of non-empty chunks */
+  int             nstarted;        /* number of threads successfully created */
+  int64_t         i;               /* counter over keys */
+  char            errbuf[eslERRBUFSIZE]; /* error message */
+
+  ESL_ALLOC(cA,   sizeof(BESQ_SSI_CHUNK) * nchunk);
+  ESL_ALLOC(tidA, sizeof(pthread_t)      * nchunk);
+
+  /* find chunk boundaries, dropping chunks that resync to the same record */
+  if((fp = fopen(sqfp->filename, "rb")) == NULL) { free(cA); free(tidA); croak("failed to open sequence file %s", sqfp->filename); }
+  n = 0;
+  for(c = 0; c < nchunk; c++) { 
+    off = _c_ssi_resync(fp, (off_t) ((double) filesize * c / nchunk));
+    if(off == -1) break;
+    if(n > 0 && off <= cA[n-1].start) continue;
+    cA[n].filename = sqfp->filename;
+    cA[n].format   = sqfp->format;
+    cA[n].start    = off;
+    cA[n].end      = -1;
+    cA[n].keyA     = NULL;
+    cA[n].nkey     = 0;
+    cA[n].nalloc   = 0;
+    cA[n].bpl      = 0;
+    cA[n].rpl      = 0;
+    cA[n].maxlast  = 0;
+    cA[n].status   = eslOK;
+    if(n > 0) cA[n-1].end = off;
+    n++;
+  }
+  fclose(fp);
+
+  for(nstarted = 0; nstarted < n; nstarted++) { 
+    if(pthread_create(&(tidA[nstarted]), NULL, _c_ssi_chunk_thread, &(cA[nstarted])) != 0) break;
+  }
+  for(c = nstarted; c < n; c++) _c_ssi_chunk_thread(&(cA[c]));
+  for(c = 0; c < nstarted; c++) pthread_join(tidA[c], NULL);
+  free(tidA);
+  for(c = 0; c < n; c++) { 
+    if(cA[c].status != eslOK) { 
+      status = cA[c].status;
+      strcpy(errbuf, cA[c].errbuf);
+      _c_ssi_chunks_free(cA, n);
+      if(status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, errbuf);
+      else                     croak("Unexpected error %d reading sequence file %s: %s", status, sqfp->filename, errbuf);
+    }
+  }
+
+  /* add keys in file order and merge line lengths */
+  for(c = 0; c < n; c++) { 
+    for(i = 0; i < cA[c].nkey; i++) { 
+      nseq++;
+      if (esl_newssi_AddKey(ns, cA[c].keyA[i].name, fh, cA[c].keyA[i].roff, cA[c].keyA[i].doff, cA[c].keyA[i].L) != eslOK) { 
+        snprintf(errbuf, eslERRBUFSIZE, "Failed to add key %s to SSI index", cA[c].keyA[i].name);
+        _c_ssi_chunks_free(cA, n);
+        croak("%s", errbuf);
+      }
+      if (cA[c].keyA[i].acc != NULL) { 
+        if (esl_newssi_AddAlias(ns, cA[c].keyA[i].acc, cA[c].keyA[i].name) != eslOK) { 
+          snprintf(errbuf, eslERRBUFSIZE, "Failed to add secondary key %s to SSI index", cA[c].keyA[i].acc);
+          _c_ssi_chunks_free(cA, n);
+          croak("%s", errbuf);
+        }
+      }
+    }
+
+    if(rpl > 0 && cA[c].maxlast > rpl) { bpl = -1; rpl = -1; }
+    if     (bpl == -1 || cA[c].bpl == -1)             bpl = -1;
+    else if(cA[c].bpl != 0 && bpl == 0)                bpl = cA[c].bpl;
+    else if(cA[c].bpl != 0 && bpl != cA[c].bpl)        bpl = -1;
+    if     (rpl == -1 || cA[c].rpl == -1)             rpl = -1;
+    else if(cA[c].rpl != 0 && rpl == 0)                rpl = cA[c].rpl;
+    else if(cA[c].rpl != 0 && rpl != cA[c].rpl)        rpl = -1;
+  }
+
+  _c_ssi_chunks_free(cA, n);
+
+  *ret_bpl = bpl;
+  *ret_rpl = rpl;
+  return nseq;
+
+ ERROR:
+  croak("out of memory");
+  return 0; /* NEVER REACHED */
+}
+
 /* Function:  _c_create_ssi_index()
  * Incept:    EPN, Fri Mar  8 09:46:52 2013
  * Synopsis:  Create an SSI index file for an existing sequence file.
  *            Based on and nearly identical to easel's miniapps/esl-sfetch.c::create_ssi_index.
+ *            If <nthreads> > 1 and the file is a large enough plain
+ *            FASTA file, it is indexed in parallel by 
+ *            _c_ssi_index_parallel(), which produces the same index.
  * Returns:   eslOK on success, eslENOTFOUND if SSI file does not exist
  *            dies via croak with informative error message upon an error
  */
 
-void _c_create_ssi_index (ESL_SQFILE *sqfp)
+void _c_create_ssi_index (ESL_SQFILE *sqfp, int nthreads)
 {
   ESL_NEWSSI *ns      = NULL;
   ESL_SQ     *sq      = NULL; 
-  int         nseq    = 0;
+  int64_t     nseq    = 0;
   char       *ssifile = NULL;
   uint16_t    fh;
   int         status;
+  struct stat st;
+  int         nchunk  = 1;
+  int64_t     bpl, rpl;
 
   if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
   else                 sq = esl_sq_Create();
@@ -134,28 +424,41 @@ void _c_create_ssi_index (ESL_SQFILE *sqfp)
   if (esl_newssi_AddFile(ns, sqfp->filename, sqfp->format, &fh) != eslOK)
     croak("Failed to add sequence file %s to new SSI index\n", sqfp->filename);
 
-  while ((status = esl_sqio_ReadInfo(sqfp, sq)) == eslOK)
-    {
-      nseq++;
-      if (sq->name == NULL) croak("Every sequence must have a name to be indexed. Failed to find name of seq #%d\n", nseq);
-
-      if (esl_newssi_AddKey(ns, sq->name, fh, sq->roff, sq->doff, sq->L) != eslOK)
-	croak("Failed to add key %s to SSI index", sq->name);
+  /* only plain FASTA files can be split at record starts */
+  if(nthreads > 1 && sqfp->format == eslSQFILE_FASTA && (! sqfp->data.ascii.do_gzip) && (! sqfp->data.ascii.do_stdin) && 
+     stat(sqfp->filename, &st) == 0) { 
+    nchunk = (int) ESL_MIN((int64_t) nthreads, (int64_t) st.st_size / BESQ_SSI_MIN_CHUNK);
+  }
 
-      if (sq->acc[0] != '\0') {
-	if (esl_newssi_AddAlias(ns, sq->acc, sq->name) != eslOK)
-	  croak("Failed to add secondary key %s to SSI index", sq->acc);
+  if(nchunk > 1) { 
+    nseq = _c_ssi_index_parallel(sqfp, ns, fh, st.st_size, nchunk, &bpl, &rpl);
+  }
+  else { 
+    while ((status = esl_sqio_ReadInfo(sqfp, sq)) == eslOK)
+      {
+        nseq++;
+        if (sq->name == NULL) croak("Every sequence must have a name to be indexed. Failed to find name of seq #%" PRId64 "\n", nseq);
+
+        if (esl_newssi_AddKey(ns, sq->name, fh, sq->roff, sq->doff, sq->L) != eslOK)
+          croak("Failed to add key %s to SSI index", sq->name);
+
+        if (sq->acc[0] != '\0') {
+          if (esl_newssi_AddAlias(ns, sq->acc, sq->name) != eslOK)
+            croak("Failed to add secondary key %s to SSI index", sq->acc);
+        }
+        esl_sq_Reuse(sq);
       }
-      esl_sq_Reuse(sq);
-    }
-  if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n",
-					   sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
-  else if (status != eslEOF)     croak("Unexpected error %d reading sequence file %s",
-					    status, sqfp->filename);
+    if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n",
+                                         sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+    else if (status != eslEOF)     croak("Unexpected error %d reading sequence file %s",
+                                         status, sqfp->filename);
+    bpl = sqfp->data.ascii.bpl;
+    rpl = sqfp->data.ascii.rpl;
+  }
 
   /* Determine if the file was suitable for fast subseq lookup. */
-  if (sqfp->data.ascii.bpl > 0 && sqfp->data.ascii.rpl > 0) {
-    if ((status = esl_newssi_SetSubseq(ns, fh, sqfp->data.ascii.bpl, sqfp->data.ascii.rpl)) != eslOK) 
+  if (bpl > 0 && rpl > 0) {
+    if ((status = esl_newssi_SetSubseq(ns, fh, bpl, rpl)) != eslOK) 
       croak("Failed to set %s for fast subseq lookup.", sqfp->filename);
   }
 
@@ -169,34 +472,34 @@ void _c_create_ssi_index (ESL_SQFILE *sqfp)
   esl_newssi_Close(ns);
 }    
 
-/* Function:  _c_fetch_one_sequence()
- * Incept:    EPN, Tue Sep 25 17:29:17 2018
- * Purpose:   Fetch a single sequence named <sqname> from 
- *            <sqfp> into <sq>.
+/* Function:  _c_read_one_sequence()
+ * Purpose:   Read a single sequence named <sqname> from 
+ *            <sqfp> into existing sequence <sq>, which is
+ *            reused first, so one scratch ESL_SQ can be used
+ *            for many reads from the same file.
  *            As a special case, if <sqname> is NULL, 
- *            we fetch the next sequence in the file.
+ *            we read the next sequence in the file.
  *
- * Args:      sqfp   - open ESL_SQFILE to fetch seq from
- *            sqname - name of sequence to fetch
- *            ret_sq - ESL_SQ object to fetch sequence into, created here
+ * Args:      sqfp   - open ESL_SQFILE to read seq from
+ *            sqname - name of sequence to read
+ *            sq     - ESL_SQ to read sequence into, must be digital
+ *                     iff <sqfp> is
  *
  * Returns:   void
  *
  * Dies:      with croak if 
  *            - sequence <sqname> does not exist in <sqfp>
  *            - problem parsing SSI index for <sqfp>
- *            - unable to fetch sequence for some reason
- *            - we fetch the wrong sequence for some reason
+ *            - unable to read sequence for some reason
+ *            - we read the wrong sequence for some reason
  */
-void _c_fetch_one_sequence(ESL_SQFILE *sqfp, char *sqname, ESL_SQ **ret_sq) { 
+void _c_read_one_sequence(ESL_SQFILE *sqfp, char *sqname, ESL_SQ *sq) { 
   int      status;    /* Easel status code */
-  ESL_SQ  *sq = NULL; /* the sequence */
 
   /* make sure SSI is valid if we're going to use it */
   if ((sqname != NULL) && (sqfp->data.ascii.ssi == NULL)) croak("sequence file %s has no SSI information\n", sqfp->filename); 
 
-  if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
-  else                 sq = esl_sq_Create();
+  esl_sq_Reuse(sq);
 
   /* from esl-sfetch.c's onefetch() */
   if(sqname != NULL) { 
@@ -215,6 +518,36 @@ void _c_fetch_one_sequence(ESL_SQFILE *sqfp, char *sqname, ESL_SQ **ret_sq) {
   if (sqname != NULL && strcmp(sqname, sq->name) != 0 && strcmp(sqname, sq->acc) != 0) 
     croak("whoa, internal error; found the wrong sequence %s, not %s\n", sq->name, sqname);
 
+  return;
+}
+
+/* Function:  _c_fetch_one_sequence()
+ * Incept:    EPN, Tue Sep 25 17:29:17 2018
+ * Purpose:   Fetch a single sequence named <sqname> from 
+ *            <sqfp> into <sq>.
+ *            As a special case, if <sqname> is NULL, 
+ *            we fetch the next sequence in the file.
+ *
+ * Args:      sqfp   - open ESL_SQFILE to fetch seq from
+ *            sqname - name of sequence to fetch
+ *            ret_sq - ESL_SQ object to fetch sequence into, created here
+ *
+ * Returns:   void
+ *
+ * Dies:      with croak if 
+ *            - sequence <sqname> does not exist in <sqfp>
+ *            - problem parsing SSI index for <sqfp>
+ *            - unable to fetch sequence for some reason
+ *            - we fetch the wrong sequence for some reason
+ */
+void _c_fetch_one_sequence(ESL_SQFILE *sqfp, char *sqname, ESL_SQ **ret_sq) { 
+  ESL_SQ  *sq = NULL; /* the sequence */
+
+  if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
+  else                 sq = esl_sq_Create();
+
+  _c_read_one_sequence(sqfp, sqname, sq);
+
   *ret_sq = sq;
 
   return;
@@ -285,77 +618,124 @@ void _c_fetch_one_subsequence(ESL_SQFILE *sqfp, char *sqname, char *newname, lon
   return;
 }
 
-/* Function:  _c_sq_to_seqstring()
- * Incept:    EPN, Mon Mar 25 15:35:13 2013
- * Synopsis:  Construct a sequence string from an ESL_SQ.
- * Args:      sq    - the ESL_SQ object
+/* Function:  _c_create_scratch_sq()
+ * Synopsis:  Create an ESL_SQ to reuse for reading sequences
+ *            from <sqfp>, digital iff <sqfp> is.
+ * Returns:   The new ESL_SQ.
+ */
+SV *_c_create_scratch_sq (ESL_SQFILE *sqfp)
+{
+  ESL_SQ *sq = NULL;
+
+  if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
+  else                 sq = esl_sq_Create();
+  if(sq == NULL) croak("out of memory");
+
+  return perl_obj(sq, "ESL_SQ");
+}
+
+/* Function:  _c_destroy_sq()
+ * Synopsis:  Free an ESL_SQ created by _c_create_scratch_sq().
+ * Returns:   void
+ */
+void _c_destroy_sq (ESL_SQ *sq)
+{
+  esl_sq_Destroy(sq);
+  return;
+}
+
+/* Function:  _c_sq_fasta_length()
+ * Synopsis:  Return the exact number of characters in the FASTA
+ *            record _c_sq_write_fasta() writes for <sq>.
+ * Args:      sq    - the ESL_SQ object, text or digital
  *            textw - width for each sequence of FASTA record, -1 for unlimited.
- *            key   - key used to fetch sequence by caller, useful only for informative error output
- * Returns:   A pointer to a string that is the sequence in FASTA format.
- * Dies:      With croak, if we run out of memory or if the sequence is digitized
- *            and we are unable to textize it.
+ * Returns:   Length of the record, not including a terminating NUL.
  */
-char *_c_sq_to_seqstring (ESL_SQ *sq, int textw, char *key, int64_t *ret_n)
-{    
-  int     status = eslOK;        /* easel return status */
-  char   *seqstring = NULL;      /* the sequence string */
-  int64_t n   = 0;               /* position in string */
-  int64_t n2  = 0;               /* position in string */
-  int64_t pos = 0;               /* position in sq->seq */
+int64_t _c_sq_fasta_length (ESL_SQ *sq, int textw)
+{
+  int64_t n = 0;
 
-  if(sq->dsq) { /* sequence is digitized, textize it */
-    if((status = esl_sq_Textize(sq)) != eslOK) croak("problem converting digitized sequence to text sequence (%s)\n", key);
-  }
+  n += 1 + strlen(sq->name);                          /* '>' and name */
+  if(sq->acc[0]  != '\0') n += 1 + strlen(sq->acc);   /* ' ' and accession */
+  if(sq->desc[0] != '\0') n += 1 + strlen(sq->desc);  /* ' ' and description */
+  n++;                                                /* newline */
+  if(textw == -1) n += sq->n + 1;                     /* one line, even if empty */
+  else            n += sq->n + (sq->n + textw - 1) / textw;  
 
-  /* '>' character */
-  n = 0;
-  if (esl_strdup(">", 1, &seqstring)              != eslOK) croak("out of memory while fetching sequence %s\n", key);
-  n++;
-  /* name */
+  return n;
+}
+
+/* Function:  _c_sq_write_fasta()
+ * Synopsis:  Write a FASTA record for <sq> to <p>, which must
+ *            have room for _c_sq_fasta_length(sq, textw) chars.
+ *            Digital sequences are written through the alphabet's
+ *            symbol table, without textizing <sq>, so <sq> can be
+ *            reused for digital reads afterwards.
+ * Args:      sq    - the ESL_SQ object, text or digital
+ *            textw - width for each sequence of FASTA record, -1 for unlimited.
+ *            p     - buffer to write to
+ * Returns:   Pointer to the char after the record in <p>, no NUL is written.
+ */
+char *_c_sq_write_fasta (ESL_SQ *sq, int textw, char *p)
+{
+  int64_t n2;        /* length of current field/line */
+  int64_t pos;       /* position in sq->seq */
+  int64_t i;         /* counter over residues in a line */
+  int64_t w;         /* line width */
+
+  *p++ = '>';
   n2 = strlen(sq->name);
-  if (esl_strcat(&seqstring, n, sq->name, n2)     != eslOK) croak("out of memory while fetching sequence %s\n", key);
-  n += n2;
-  /* accession */
-  if (sq->acc[0] != 0) { 
-    if (esl_strcat(&seqstring, n, " ", 1)         != eslOK) croak("out of memory while fetching sequence %s\n", key);
-    n++;
+  memcpy(p, sq->name, n2);
+  p += n2;
+  if(sq->acc[0] != '\0') { 
+    *p++ = ' ';
     n2 = strlen(sq->acc);
-    if (esl_strcat(&seqstring, n, sq->acc, n2)    != eslOK) croak("out of memory while fetching sequence %s\n", key);
-    n += n2;
+    memcpy(p, sq->acc, n2);
+    p += n2;
   }
-  /* desc */
-  if (sq->desc[0] != 0) { 
-    if (esl_strcat(&seqstring, n, " ", 1)         != eslOK) croak("out of memory while fetching sequence %s\n", key);
-    n++;
+  if(sq->desc[0] != '\0') { 
+    *p++ = ' ';
     n2 = strlen(sq->desc);
-    if (esl_strcat(&seqstring, n, sq->desc, n2)   != eslOK) croak("out of memory while fetching sequence %s\n", key);
-    n += n2;
-  }
-  /* newline */
-  if (esl_strcat(&seqstring, n, "\n", 1)          != eslOK) croak("out of memory while fetching sequence %s\n", key);
-  n++;
-  /* sequence */
-  if (textw == -1) { /* unlimited line length */
-    if (esl_strcat(&seqstring, n, sq->seq, sq->n) != eslOK) croak("out of memory while fetching sequence %s\n", key);
-    n += sq->n;
-    /* newline */
-    if (esl_strcat(&seqstring, n, "\n", 1)        != eslOK) croak("out of memory while fetching sequence %s\n", key);
-    n++;
-  }
-  else { /* textw != -1, limit line length to textw */
-    for (pos = 0; pos < sq->n; pos += textw) { 
-      n2 = ESL_MIN(textw, sq->n - pos);
-      if (esl_strcat(&seqstring, n, sq->seq+pos, n2) != eslOK) croak("out of memory while fetching sequence %s\n", key);
-      n += n2;
-      /* newline */
-      if (esl_strcat(&seqstring, n, "\n", 1) != eslOK) croak("out of memory while fetching sequence %s\n", key);
-      n++;
-    }
+    memcpy(p, sq->desc, n2);
+    p += n2;
   }
+  *p++ = '\n';
+
+  w = (textw == -1) ? sq->n : textw;
+  pos = 0;
+  do { 
+    n2 = ESL_MIN(w, sq->n - pos);
+    if(sq->dsq != NULL) { for(i = 0; i < n2; i++) p[i] = sq->abc->sym[sq->dsq[pos+i+1]]; }
+    else                { memcpy(p, sq->seq+pos, n2); }
+    p   += n2;
+    pos += n2;
+    if(n2 > 0 || textw == -1) *p++ = '\n';
+  } while(pos < sq->n);
+
+  return p;
+}
 
-  if(ret_n != NULL) *ret_n = n;
-  
-  return seqstring;
+/* Function:  _c_sv_append_fasta()
+ * Synopsis:  Append the FASTA record for <sq> to string <sv>, 
+ *            growing its buffer once to the exact size needed
+ *            and writing the record directly into it.
+ * Args:      sv    - string SV to append to
+ *            sq    - the ESL_SQ object, text or digital
+ *            textw - width for each sequence of FASTA record, -1 for unlimited.
+ * Returns:   void
+ */
+void _c_sv_append_fasta (SV *sv, ESL_SQ *sq, int textw)
+{
+  STRLEN  cur = SvCUR(sv);                     /* current length of sv */
+  int64_t n   = _c_sq_fasta_length(sq, textw); /* length of record */
+  char   *p;                                   /* where to write the record */
+
+  p = SvGROW(sv, cur + n + 1) + cur;
+  p = _c_sq_write_fasta(sq, textw, p);
+  *p = '\0';
+  SvCUR_set(sv, cur + n);
+
+  return;
 }
 
 /* Function:  _c_fetch_seq_to_fasta_string()
@@ -363,29 +743,24 @@ char *_c_sq_to_seqstring (ESL_SQ *sq, int textw, char *key, int64_t *ret_n)
  * Synopsis:  Fetch a sequence from an open sequence file and return it as a FASTA
  *            formatted string.
  * Args:      sqfp  - open ESL_SQFILE to fetch seq from
+ *            sq    - scratch ESL_SQ for <sqfp> to read into, from _c_create_scratch_sq()
  *            key   - name or accession of sequence to fetch
  *            textw - width for each sequence of FASTA record, -1 for unlimited.
  * Returns:   A pointer to a string that is the sequence in FASTA format.
  * Dies:      if problem reading sequence
  */
-SV *_c_fetch_seq_to_fasta_string (ESL_SQFILE *sqfp, char *key, int textw)
+SV *_c_fetch_seq_to_fasta_string (ESL_SQFILE *sqfp, ESL_SQ *sq, char *key, int textw)
 {
-  ESL_SQ *sq = NULL;             /* the sequence */
-  char   *seqstring = NULL;      /* the sequence string */
-  SV     *seqstringSV;           /* SV version of seqstring */
-  int64_t n;                     /* length of seqstring */
+  SV     *seqstringSV;           /* the sequence string */
 
-  /* make sure textw makes sense and we're not in digital mode */
-  if(textw < 0 && textw != -1) croak("invalid value for textw\n"); 
+  /* make sure textw makes sense */
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
 
   /* fetch the sequence, this will die with croak if there's a problem */
-  _c_fetch_one_sequence(sqfp, key, &sq);
-
-  seqstring = _c_sq_to_seqstring(sq, textw, key, &n);
-  esl_sq_Destroy(sq);
+  _c_read_one_sequence(sqfp, key, sq);
 
-  seqstringSV = newSVpv(seqstring, n);
-  free(seqstring);
+  seqstringSV = newSVpvn("", 0);
+  _c_sv_append_fasta(seqstringSV, sq, textw);
 
   return seqstringSV;
 }
@@ -397,25 +772,20 @@ SV *_c_fetch_seq_to_fasta_string (ESL_SQFILE *sqfp, char *key, int textw)
  *            fetching by key (seqname or accn)) and return it as a FASTA
  *            formatted string.
  * Args:      sqfp  - open ESL_SQFILE to fetch seq from
+ *            sq    - scratch ESL_SQ for <sqfp> to read into, from _c_create_scratch_sq()
  *            nkey  - index of the key to return
  *            textw - width for each sequence of FASTA record, -1 for unlimited.
  * Returns:   A pointer to a string that is the sequence in FASTA format.
  * Dies:      if problem reading sequence
  */
-SV *_c_fetch_seq_to_fasta_string_given_ssi_number (ESL_SQFILE *sqfp, int nkey, int textw)
+SV *_c_fetch_seq_to_fasta_string_given_ssi_number (ESL_SQFILE *sqfp, ESL_SQ *sq, int nkey, int textw)
 {
 
   int     status;                /* Easel status code */
-  ESL_SQ *sq = NULL;             /* the sequence */
-  char   *seqstring = NULL;      /* the sequence string */
-  SV     *seqstringSV;           /* SV version of seqstring */
-  int64_t n;                     /* length of seqstring */
-
-  if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
-  else                 sq = esl_sq_Create();
+  SV     *seqstringSV;           /* the sequence string */
 
-  /* make sure textw makes sense and we're not in digital mode */
-  if(textw < 0 && textw != -1) croak("invalid value for textw\n"); 
+  /* make sure textw makes sense */
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
 
   /* adapted from esl-sfetch.c's onefetch() for PositionByNumber instead of PositionByKey */
   if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
@@ -424,16 +794,14 @@ SV *_c_fetch_seq_to_fasta_string_given_ssi_number (ESL_SQFILE *sqfp, int nkey, i
   else if (status == eslEFORMAT)   croak("Failed to parse SSI index for %s\n", sqfp->filename);
   else if (status != eslOK)        croak("Failed to look up location of seq index %d in SSI index of file %s\n", nkey, sqfp->filename);
 
+  esl_sq_Reuse(sq);
   status = esl_sqio_Read(sqfp, sq);
   if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n",  sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
   else if (status == eslEOF)     croak("Unexpected EOF reading sequence file %s\n", sqfp->filename);
   else if (status != eslOK)      croak("Unexpected error %d reading sequence file %s\n", status, sqfp->filename);
 
-  seqstring = _c_sq_to_seqstring(sq, textw, sq->name, &n);
-  esl_sq_Destroy(sq);
-
-  seqstringSV = newSVpv(seqstring, n);
-  free(seqstring);
+  seqstringSV = newSVpvn("", 0);
+  _c_sv_append_fasta(seqstringSV, sq, textw);
 
   return seqstringSV;
 }
@@ -446,13 +814,286 @@ SV *_c_fetch_seq_to_fasta_string_given_ssi_number (ESL_SQFILE *sqfp, int nkey, i
  *            I don't know how to pass a NULL value in for a char * to an inline C 
  *            function from Perl (as far as I can tell, it can't be done).
  * Args:      sqfp  - open ESL_SQFILE to fetch seq from
+ *            sq    - scratch ESL_SQ for <sqfp> to read into, from _c_create_scratch_sq()
  *            textw - width for each sequence of FASTA record, -1 for unlimited.
  * Returns:   A pointer to a string that is the sequence in FASTA format.
  */
 
-SV *_c_fetch_next_seq_to_fasta_string (ESL_SQFILE *sqfp, int textw)
+SV *_c_fetch_next_seq_to_fasta_string (ESL_SQFILE *sqfp, ESL_SQ *sq, int textw)
+{
+  return _c_fetch_seq_to_fasta_string(sqfp, sq, NULL, textw);
+}
+
+/* Function:  _c_next_name_length()
+ * Synopsis:  Read the name and length of the next sequence in 
+ *            an open sequence file, without reading its residues.
+ * Purpose:   Uses esl_sqio_ReadInfo() (as _c_create_ssi_index()
+ *            does) into the scratch sequence <sq>, so no residues
+ *            are ever copied. The file is left positioned at the
+ *            start of the following sequence.
+ * Args:      sqfp  - open ESL_SQFILE to read from
+ *            sq    - scratch ESL_SQ for <sqfp>, from _c_create_scratch_sq()
+ * Returns:   Two values on the stack: the name and length of the
+ *            next sequence, or nothing if there are no more sequences.
+ * Dies:      with croak if there's a problem reading the file
+ */
+void _c_next_name_length (ESL_SQFILE *sqfp, ESL_SQ *sq)
+{
+  Inline_Stack_Vars;
+
+  int status;  /* Easel status code */
+
+  esl_sq_Reuse(sq);
+  status = esl_sqio_ReadInfo(sqfp, sq);
+  if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+  else if (status != eslOK && status != eslEOF) croak("Unexpected error %d reading sequence file %s\n", status, sqfp->filename);
+
+  Inline_Stack_Reset;
+  if(status == eslOK) { 
+    Inline_Stack_Push(sv_2mortal(newSVpv(sq->name, 0)));
+    Inline_Stack_Push(sv_2mortal(newSViv(sq->L)));
+  }
+  Inline_Stack_Done;
+  Inline_Stack_Return((status == eslOK) ? 2 : 0);
+}
+
+/* Function:  _c_all_names_lengths()
+ * Synopsis:  Read the names and lengths of all sequences in 
+ *            a sequence file, without reading their residues.
+ * Purpose:   Rewind <sqfp>, read every sequence with 
+ *            esl_sqio_ReadInfo() and rewind it again, so 
+ *            the census is a single metadata-only scan of
+ *            the file.
+ * Args:      sqfp  - open ESL_SQFILE to read from, must be rewindable
+ *                    (not stdin or gzipped)
+ *            sq    - scratch ESL_SQ for <sqfp>, from _c_create_scratch_sq()
+ * Returns:   Two values on the stack: a reference to an array of
+ *            names and a reference to an array of lengths, both 
+ *            in file order.
+ * Dies:      with croak if <sqfp> can't be rewound or there's a 
+ *            problem reading the file
+ */
+void _c_all_names_lengths (ESL_SQFILE *sqfp, ESL_SQ *sq)
+{
+  Inline_Stack_Vars;
+
+  int  status;          /* Easel status code */
+  AV  *nameAV;          /* array of names */
+  AV  *lenAV;           /* array of lengths */
+
+  if(esl_sqfile_Position(sqfp, 0) != eslOK) croak("unable to rewind sequence file %s (stdin or gzipped?)\n", sqfp->filename);
+
+  nameAV = newAV();
+  lenAV  = newAV();
+  esl_sq_Reuse(sq);
+  while((status = esl_sqio_ReadInfo(sqfp, sq)) == eslOK) { 
+    av_push(nameAV, newSVpv(sq->name, 0));
+    av_push(lenAV,  newSViv(sq->L));
+    esl_sq_Reuse(sq);
+  }
+  if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+  else if (status != eslEOF)     croak("Unexpected error %d reading sequence file %s\n", status, sqfp->filename);
+
+  esl_sqfile_Position(sqfp, 0); /* rewind b/c we're at the end of the file */
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newRV_noinc((SV *) nameAV)));
+  Inline_Stack_Push(sv_2mortal(newRV_noinc((SV *) lenAV)));
+  Inline_Stack_Done;
+  Inline_Stack_Return(2);
+}
+
+/* BESQ_FETCH: one requested key for _c_fetch_seqs_batch(),
+ * with its SSI location so requests can be sorted by file offset.
+ */
+typedef struct {
+  uint16_t fh;    /* SSI file handle the key is in */
+  off_t    roff;  /* offset of the start of the key's record */
+  int64_t  L;     /* sequence length, from SSI */
+  int64_t  est;   /* estimated length of the key's FASTA record */
+  int      idx;   /* index of the key in the caller's list */
+} BESQ_FETCH;
+
+/* BESQ_FETCH_WINDOW: when _c_fetch_seqs_batch() or 
+ * _c_fetch_subseqs_batch() output in the caller's order, requests
+ * are handled in consecutive windows of about this many estimated
+ * bytes of output: each window is read in file order, buffered, 
+ * and output before the next is read, so at most one window is
+ * held in memory.
+ */
+#define BESQ_FETCH_WINDOW 67108864
+
+/* Function:  _c_fetch_compare()
+ * Synopsis:  qsort() comparison function for BESQ_FETCH, sorts by
+ *            (fh, roff) then by position in the caller's list.
+ */
+int _c_fetch_compare(const void *a, const void *b)
 {
-  return _c_fetch_seq_to_fasta_string(sqfp, NULL, textw);
+  const BESQ_FETCH *fa = (const BESQ_FETCH *) a;
+  const BESQ_FETCH *fb = (const BESQ_FETCH *) b;
+
+  if(fa->fh   != fb->fh)   return (fa->fh   < fb->fh)   ? -1 : 1;
+  if(fa->roff != fb->roff) return (fa->roff < fb->roff) ? -1 : 1;
+  return fa->idx - fb->idx;
+}
+
+/* Function:  _c_fetch_seqs_batch()
+ * Synopsis:  Fetch a list of sequences by name or accession in a 
+ *            single call and either output them to a FASTA file
+ *            or return them as a FASTA formatted string.
+ * Purpose:   All keys in <namesAR> are first looked up in the SSI
+ *            index and sorted by file offset so the sequence file
+ *            is read front to back, instead of seeking back and
+ *            forth once per key. Keys that occur more than once are
+ *            only read once.
+ *
+ *            If <do_file_order> is '1', sequences are written out
+ *            (or appended to the returned string) in the order they
+ *            occur in the file as they are read. Otherwise they are
+ *            output in the order of <namesAR>, as 
+ *            _c_fetch_seq_to_fasta_string() called once per key
+ *            would do: keys are taken in windows of about 
+ *            BESQ_FETCH_WINDOW bytes of output, each of which is 
+ *            read in file order, buffered, and output before the 
+ *            next, so memory use is bounded by the window and not
+ *            by the total output.
+ *
+ * Args:      sqfp          - open ESL_SQFILE to fetch seqs from, must have SSI index
+ *            namesAR       - reference to array of names/accessions of seqs to fetch
+ *            textw         - width for each sequence of FASTA record, -1 for unlimited.
+ *            outfile       - name of FASTA file to output to, "" to return the seqs as a string
+ *            do_file_order - '1' to output seqs in the order they occur in the file,
+ *                            '0' to output them in the order of <namesAR>
+ * Returns:   String of all fetched seqs if <outfile> is "", else "" (empty string).
+ * Dies:      if sequence file has no SSI index, a key is not in it,
+ *            <outfile> can't be opened, or problem reading a sequence
+ */
+SV *_c_fetch_seqs_batch (ESL_SQFILE *sqfp, ESL_SQ *sq, SV *namesAR, int textw, char *outfile, int do_file_order)
+{
+  int         status;               /* Easel status code */
+  AV         *namesAV;              /* array of names */
+  int         nkey;                 /* number of keys in namesAV */
+  int         i, k;                 /* counters over keys, in input and sorted order */
+  int         i0, i1;               /* current window is keys i0..i1-1 */
+  char       *key;                  /* current key */
+  BESQ_FETCH *fA     = NULL;        /* [0..k..nkey-1] keys, sorted by file offset within each window */
+  int        *recA   = NULL;        /* [0..i-i0..i1-i0-1] record in buf for key i, only if !do_file_order */
+  int64_t    *rstartA = NULL;       /* [0..r..nrec-1] start of record r in buf, only if !do_file_order */
+  int64_t    *rlenA  = NULL;        /* [0..r..nrec-1] length of record r in buf, only if !do_file_order */
+  int         nrec   = 0;           /* number of distinct records read in current window */
+  char       *buf    = NULL;        /* records of current window if !do_file_order, else current record if outputting to a file */
+  int64_t     nbuf   = 0;           /* used length of buf */
+  int64_t     nalloc = 0;           /* allocated length of buf */
+  int64_t     est    = 0;           /* estimated total output length */
+  int64_t     west   = 0;           /* estimated output length of current window */
+  int64_t     n      = 0;           /* length of FASTA record of current sequence */
+  FILE       *ofp    = NULL;        /* output file, NULL to return a string */
+  SV         *retSV  = NULL;        /* string to return */
+
+  /* make sure textw makes sense and SSI is valid */
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
+  if(sqfp->data.ascii.ssi == NULL) croak("sequence file %s has no SSI information\n", sqfp->filename); 
+  if((! SvROK(namesAR)) || SvTYPE(SvRV(namesAR)) != SVt_PVAV) croak("_c_fetch_seqs_batch() expected an array reference");
+  namesAV = (AV *) SvRV(namesAR);
+  nkey    = av_len(namesAV) + 1;
+
+  /* look up every key, and estimate output length from the SSI lengths */
+  ESL_ALLOC(fA, sizeof(BESQ_FETCH) * (nkey+1));
+  for(i = 0; i < nkey; i++) { 
+    key = SvPV_nolen(*(av_fetch(namesAV, i, 0)));
+    status = esl_ssi_FindName(sqfp->data.ascii.ssi, key, &(fA[i].fh), &(fA[i].roff), NULL, &(fA[i].L));
+    if     (status == eslEMEM)      croak("out of memory");
+    else if(status == eslENOTFOUND) croak("seq %s not found in SSI index for file %s\n", key, sqfp->filename); 
+    else if(status == eslEFORMAT)   croak("Failed to parse SSI index for %s\n", sqfp->filename);
+    else if(status != eslOK)        croak("Failed to look up location of seq %s in SSI index of file %s\n", key, sqfp->filename);
+    fA[i].idx = i;
+    fA[i].est = fA[i].L + ((textw == -1) ? 1 : (fA[i].L / textw) + 1) + strlen(key) + 2;
+    est += fA[i].est;
+  }
+
+  if(outfile[0] != '\0') { 
+    if((ofp = fopen(outfile, "w")) == NULL) croak("unable to open %s for writing", outfile);
+  }
+  retSV = newSVpvn("", 0);
+  if(ofp == NULL) SvGROW(retSV, est+1);
+  if(! do_file_order) { 
+    ESL_ALLOC(recA,    sizeof(int)     * (nkey+1));
+    ESL_ALLOC(rstartA, sizeof(int64_t) * (nkey+1));
+    ESL_ALLOC(rlenA,   sizeof(int64_t) * (nkey+1));
+    nalloc = ESL_MIN(est, BESQ_FETCH_WINDOW) + 1;
+    ESL_ALLOC(buf, sizeof(char) * nalloc);
+  }
+
+  for(i0 = 0; i0 < nkey; i0 = i1) { 
+    /* choose the window: all keys if outputting in file order */
+    if(do_file_order) i1 = nkey;
+    else { 
+      west = fA[i0].est;
+      for(i1 = i0+1; i1 < nkey && west + fA[i1].est <= BESQ_FETCH_WINDOW; i1++) west += fA[i1].est;
+    }
+    qsort(fA + i0, i1 - i0, sizeof(BESQ_FETCH), _c_fetch_compare);
+    nrec = 0;
+    nbuf = 0;
+
+    for(k = i0; k < i1; k++) { 
+      /* read the record, unless it's the same one as the previous key */
+      if(k == i0 || fA[k].fh != fA[k-1].fh || fA[k].roff != fA[k-1].roff) { 
+        key = SvPV_nolen(*(av_fetch(namesAV, fA[k].idx, 0)));
+        if(esl_sqfile_Position(sqfp, fA[k].roff) != eslOK) croak("Failed to position file %s for seq %s\n", sqfp->filename, key);
+        esl_sq_Reuse(sq);
+        status = esl_sqio_Read(sqfp, sq);
+        if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n",  sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+        else if (status == eslEOF)     croak("Unexpected EOF reading sequence file %s\n", sqfp->filename);
+        else if (status != eslOK)      croak("Unexpected error %d reading sequence file %s\n", status, sqfp->filename);
+        if (strcmp(key, sq->name) != 0 && strcmp(key, sq->acc) != 0) 
+          croak("whoa, internal error; found the wrong sequence %s, not %s\n", sq->name, key);
+
+        /* format the record into buf, unless we're appending it straight to retSV */
+        n = _c_sq_fasta_length(sq, textw);
+        if((! do_file_order) || ofp != NULL) { 
+          if(nbuf + n > nalloc) { 
+            nalloc = ESL_MAX(nalloc * 2, nbuf + n);
+            ESL_REALLOC(buf, sizeof(char) * nalloc);
+          }
+          _c_sq_write_fasta(sq, textw, buf + nbuf);
+        }
+        if(! do_file_order) { 
+          rstartA[nrec] = nbuf;
+          rlenA[nrec]   = n;
+          nbuf += n;
+          nrec++;
+        }
+      }
+      if(do_file_order) { 
+        if(ofp != NULL) { if(fwrite(buf, sizeof(char), n, ofp) != n) croak("error writing to %s", outfile); }
+        else            { _c_sv_append_fasta(retSV, sq, textw); }
+      }
+      else { 
+        recA[fA[k].idx - i0] = nrec-1;
+      }
+    }
+
+    /* output the window in the order of namesAR */
+    if(! do_file_order) { 
+      for(i = i0; i < i1; i++) { 
+        if(ofp != NULL) { if(fwrite(buf + rstartA[recA[i-i0]], sizeof(char), rlenA[recA[i-i0]], ofp) != rlenA[recA[i-i0]]) croak("error writing to %s", outfile); }
+        else            { sv_catpvn(retSV, buf + rstartA[recA[i-i0]], rlenA[recA[i-i0]]); }
+      }
+    }
+  }
+
+  if(ofp != NULL && fclose(ofp) != 0) croak("error closing %s", outfile);
+  if(buf     != NULL) free(buf);
+  if(recA    != NULL) free(recA);
+  if(rstartA != NULL) free(rstartA);
+  if(rlenA   != NULL) free(rlenA);
+  free(fA);
+
+  return retSV;
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
 }
 
 /* Function:  _c_fetch_subseq_to_fasta_string()
@@ -486,88 +1127,284 @@ SV *_c_fetch_next_seq_to_fasta_string (ESL_SQFILE *sqfp, int textw)
 SV *_c_fetch_subseq_to_fasta_string (ESL_SQFILE *sqfp, char *key, char *newname, long given_start, long given_end, int textw, int do_res_revcomp)
 {
   ESL_SQ *sq = NULL;             /* the sequence */
-  char   *seqstring = NULL;      /* the sequence string */
-  SV     *seqstringSV;           /* SV version of seqstring */
-  int64_t n;                     /* length of seqstring */
+  SV     *seqstringSV;           /* the sequence string */
 
   /* make sure textw makes sense */
-  if(textw < 0 && textw != -1) croak("invalid value for textw\n"); 
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
   /* make sure SSI is valid */
   if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
 
   _c_fetch_one_subsequence(sqfp, key, newname, given_start, given_end, do_res_revcomp, &sq);
 
-  seqstring = _c_sq_to_seqstring(sq, textw, key, &n);
+  seqstringSV = newSVpvn("", 0);
+  _c_sv_append_fasta(seqstringSV, sq, textw);
   esl_sq_Destroy(sq);
 
-  seqstringSV = newSVpv(seqstring, n);
-  free(seqstring);
-
   return seqstringSV;
 
 }
-/* Function:  _c_fetch_seq_name_and_length_given_ssi_number()
- * Incept:    EPN, Mon Apr  8 09:34:01 2013
- * Purpose:   Fetch the primary key of a sequence and the sequence length, 
- *            given it's rank in the SSIindex for the file. This will not 
- *            return the name and length of the <nkey>'th sequence in the 
- *            file, but rather the <nkey>'th sequence as it's ordered in 
- *            the SSI file. 
+
+/* BESQ_SUBSEQ: one requested subsequence for _c_fetch_subseqs_batch(),
+ * with its source's SSI location so requests can be sorted by source
+ * and coordinate.
+ */
+typedef struct {
+  uint16_t fh;          /* SSI file handle the source is in */
+  off_t    roff;        /* offset of the start of the source's record */
+  int64_t  L;           /* source sequence length, from SSI */
+  int64_t  start;       /* first position of subseq on top strand */
+  int64_t  end;         /* final position of subseq on top strand */
+  int      do_revcomp;  /* TRUE to reverse complement the subseq */
+  int64_t  est;         /* estimated length of the subseq's FASTA record */
+  int      idx;         /* index of the request in the caller's list */
+} BESQ_SUBSEQ;
+
+/* Function:  _c_subseq_compare()
+ * Synopsis:  qsort() comparison function for BESQ_SUBSEQ, sorts by
+ *            source (fh, roff), then by start and end, then by 
+ *            position in the caller's list.
+ */
+int _c_subseq_compare(const void *a, const void *b)
+{
+  const BESQ_SUBSEQ *sa = (const BESQ_SUBSEQ *) a;
+  const BESQ_SUBSEQ *sb = (const BESQ_SUBSEQ *) b;
+
+  if(sa->fh    != sb->fh)    return (sa->fh    < sb->fh)    ? -1 : 1;
+  if(sa->roff  != sb->roff)  return (sa->roff  < sb->roff)  ? -1 : 1;
+  if(sa->start != sb->start) return (sa->start < sb->start) ? -1 : 1;
+  if(sa->end   != sb->end)   return (sa->end   < sb->end)   ? -1 : 1;
+  return sa->idx - sb->idx;
+}
+
+/* Function:  _c_subseq_from_window()
+ * Purpose:   Copy <len> residues starting at 0-offset <offset> of 
+ *            already fetched window <win> into <piece>, name it
+ *            <newname>, and reverse complement it if <do_revcomp>.
+ *            The accession and description of <win> are kept, as
+ *            esl_sqio_FetchSubseq() would for the subseq alone.
+ *            <piece> and <win> must both be text or both digital.
+ * Returns:   void
+ * Dies:      with croak if out of memory or <piece> can't be 
+ *            reverse complemented
+ */
+void _c_subseq_from_window(ESL_SQ *win, int64_t offset, int64_t len, char *newname, int do_revcomp, ESL_SQ *piece)
+{
+  esl_sq_Reuse(piece);
+  if(esl_sq_SetName(piece, newname) != eslOK)                              croak("out of memory");
+  if(win->acc[0]  != '\0' && esl_sq_SetAccession(piece, win->acc) != eslOK) croak("out of memory");
+  if(win->desc[0] != '\0' && esl_sq_SetDesc(piece, win->desc) != eslOK)     croak("out of memory");
+  if(esl_sq_GrowTo(piece, len) != eslOK)                                   croak("out of memory");
+
+  if(win->dsq != NULL) { 
+    memcpy(piece->dsq+1, win->dsq+1+offset, sizeof(ESL_DSQ) * len);
+    piece->dsq[0] = piece->dsq[len+1] = eslDSQ_SENTINEL;
+  }
+  else { 
+    memcpy(piece->seq, win->seq+offset, sizeof(char) * len);
+    piece->seq[len] = '\0';
+  }
+  piece->n     = len;
+  piece->start = 1;
+  piece->end   = len;
+  piece->C     = 0;
+  piece->W     = len;
+  piece->L     = len;
+
+  if (do_revcomp) { 
+    if (esl_sq_ReverseComplement(piece) != eslOK) croak("Failed to reverse complement %s; is it a protein?\n", piece->name);
+  }
+
+  return;
+}
+
+/* Function:  _c_fetch_subseqs_batch()
+ * Synopsis:  Fetch a list of subsequences in a single call and either
+ *            output them to a FASTA file or return them as a FASTA
+ *            formatted string.
+ * Purpose:   Each element of <subseqsAR> is a reference to an array
+ *            [newname, start, end, source], with <start>, <end>
+ *            interpreted as by _c_fetch_subseq_to_fasta_string() 
+ *            (with do_res_revcomp FALSE). Requests are grouped by 
+ *            source sequence and sorted by coordinate, overlapping 
+ *            and adjacent requests on the same source are merged
+ *            into windows, and each window is fetched once with
+ *            esl_sqio_FetchSubseq(). Every subsequence is then cut
+ *            out of its window, reverse complemented if necessary,
+ *            and formatted.
  *
- *            The return string is a concatenation of the primary key and
- *            the sequence length, separated by a single space (' '). This
- *            is done so we don't have to return two separate values.
- *            
- * Args:      sqfp        - open ESL_SQFILE to fetch seq from
- *            nkey        - index of the key to return
+ *            If <do_file_order> is '1', subsequences are written out
+ *            (or appended to the returned string) as they are cut,
+ *            in order of source position in the file and then
+ *            coordinate. Otherwise they are output in the order of 
+ *            <subseqsAR>, as _c_fetch_subseq_to_fasta_string() 
+ *            called once per request would do: requests are taken
+ *            in windows of about BESQ_FETCH_WINDOW bytes of output,
+ *            each of which is sorted, fetched and buffered as above
+ *            and output before the next, so memory use is bounded
+ *            by the window and not by the total output.
  *
- * Returns:   A pointer to a string that is primary key of the <nkey>'th key
- *            followed by a single ' ', followed by the length of the sequence.
- *            Note that the key cannot contain any spaces, so the only ' '
- *            in the returned string will be the divider between the key
- *            and the sequence length.
+ * Args:      sqfp          - open ESL_SQFILE to fetch from, must have SSI index
+ *            sq            - scratch ESL_SQ for <sqfp> to read windows into, from _c_create_scratch_sq()
+ *            subseqsAR     - reference to array of [newname, start, end, source] array references
+ *            textw         - width for each sequence of FASTA record, -1 for unlimited.
+ *            outfile       - name of FASTA file to output to, "" to return the subseqs as a string
+ *            do_file_order - '1' to output subseqs in file and coordinate order,
+ *                            '0' to output them in the order of <subseqsAR>
+ * Returns:   String of all fetched subseqs if <outfile> is "", else "" (empty string).
+ * Dies:      if sequence file has no SSI index, a source is not in it,
+ *            coordinates are out of range, <outfile> can't be opened,
+ *            or problem fetching a subsequence
  */
+SV *_c_fetch_subseqs_batch (ESL_SQFILE *sqfp, ESL_SQ *sq, SV *subseqsAR, int textw, char *outfile, int do_file_order)
+{
+  int          status;              /* Easel status code */
+  AV          *subseqsAV;           /* array of requests */
+  AV          *rowAV;               /* one request */
+  SV         **svp;                 /* element of a request */
+  int          nreq;                /* number of requests */
+  int          i, k, w;             /* counters over requests, in input and sorted order */
+  int          i0, i1;              /* current window is requests i0..i1-1 */
+  char        *source;              /* name of current source sequence */
+  char        *newname;             /* name of current subseq */
+  long         given_start;         /* start for current request, as passed in */
+  long         given_end;           /* end for current request, as passed in */
+  int64_t      wstart, wend;        /* current window on top strand */
+  BESQ_SUBSEQ *sA      = NULL;      /* [0..k..nreq-1] requests, sorted by source and coordinate within each window */
+  ESL_SQ      *piece   = NULL;      /* current subseq, cut from sq */
+  int64_t     *rstartA = NULL;      /* [0..i-i0..i1-i0-1] start of subseq i in buf, only if !do_file_order */
+  int64_t     *rlenA   = NULL;      /* [0..i-i0..i1-i0-1] length of subseq i in buf, only if !do_file_order */
+  char        *buf     = NULL;      /* subseqs of current window if !do_file_order, else current subseq if outputting to a file */
+  int64_t      nbuf    = 0;         /* used length of buf */
+  int64_t      nalloc  = 0;         /* allocated length of buf */
+  int64_t      est     = 0;         /* estimated total output length */
+  int64_t      west    = 0;         /* estimated output length of current window */
+  int64_t      n       = 0;         /* length of FASTA record of current subseq */
+  FILE        *ofp     = NULL;      /* output file, NULL to return a string */
+  SV          *retSV   = NULL;      /* string to return */
+
+  /* make sure textw makes sense and SSI is valid */
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
+  if(sqfp->data.ascii.ssi == NULL) croak("sequence file %s has no SSI information\n", sqfp->filename); 
+  if((! SvROK(subseqsAR)) || SvTYPE(SvRV(subseqsAR)) != SVt_PVAV) croak("_c_fetch_subseqs_batch() expected an array reference");
+  subseqsAV = (AV *) SvRV(subseqsAR);
+  nreq      = av_len(subseqsAV) + 1;
+
+  /* look up every source, resolve coordinates, and estimate output length */
+  ESL_ALLOC(sA, sizeof(BESQ_SUBSEQ) * (nreq+1));
+  for(i = 0; i < nreq; i++) { 
+    svp = av_fetch(subseqsAV, i, 0);
+    if(svp == NULL || (! SvROK(*svp)) || SvTYPE(SvRV(*svp)) != SVt_PVAV) croak("ERROR fetch_subseqs, element %d is not an array reference", i);
+    rowAV = (AV *) SvRV(*svp);
+    if(av_len(rowAV) + 1 < 4) croak("ERROR fetch_subseqs, array too small (< 4 elements)");
+    given_start = SvIV(*(av_fetch(rowAV, 1, 0)));
+    given_end   = SvIV(*(av_fetch(rowAV, 2, 0)));
+    source      = SvPV_nolen(*(av_fetch(rowAV, 3, 0)));
+
+    status = esl_ssi_FindName(sqfp->data.ascii.ssi, source, &(sA[i].fh), &(sA[i].roff), NULL, &(sA[i].L));
+    if     (status == eslEMEM)      croak("out of memory");
+    else if(status == eslENOTFOUND) croak("Failed to fetch subseq: seq %s not found in SSI index for file %s\n", source, sqfp->filename); 
+    else if(status == eslEFORMAT)   croak("Failed to parse SSI index for %s\n", sqfp->filename);
+    else if(status != eslOK)        croak("Failed to look up location of seq %s in SSI index of file %s\n", source, sqfp->filename);
+
+    /* reverse complement indicated by coords, as in _c_fetch_one_subsequence() */
+    if (given_end != 0 && given_start > given_end) { sA[i].start = given_end;   sA[i].end = given_start; sA[i].do_revcomp = TRUE;  }
+    else                                           { sA[i].start = given_start; sA[i].end = given_end;   sA[i].do_revcomp = FALSE; }
+    if (sA[i].end == 0) sA[i].end = sA[i].L;
+    if (sA[i].start < 1 || sA[i].end > sA[i].L) 
+      croak("Failed to fetch subseq: %ld..%ld out of range for seq %s of length %" PRId64 "\n", given_start, given_end, source, sA[i].L);
+    sA[i].idx = i;
+    sA[i].est = (sA[i].end - sA[i].start + 1) + ((textw == -1) ? 1 : ((sA[i].end - sA[i].start + 1) / textw) + 1) + 64;
+    est += sA[i].est;
+  }
 
-SV *_c_fetch_seq_name_and_length_given_ssi_number(ESL_SQFILE *sqfp, int nkey) { 
-  int     status;             /* Easel status code */
-  char   *key_and_L   = NULL; /* key and L string to return */
-  SV     *key_and_LSV;        /* SV version of key and L string to return */
-  int64_t L;                  /* length of sequence */
-  int64_t Ldup;               /* copy of L we can modify */
-  int     Lwidth = 0;         /* number of characters we need for a string conversion of L */
-  char   *Lstr = NULL;        /* string of just L */
+  if(outfile[0] != '\0') { 
+    if((ofp = fopen(outfile, "w")) == NULL) croak("unable to open %s for writing", outfile);
+  }
+  retSV = newSVpvn("", 0);
+  if(ofp == NULL) SvGROW(retSV, est+1);
+  if(! do_file_order) { 
+    ESL_ALLOC(rstartA, sizeof(int64_t) * (nreq+1));
+    ESL_ALLOC(rlenA,   sizeof(int64_t) * (nreq+1));
+    nalloc = ESL_MIN(est, BESQ_FETCH_WINDOW) + 1;
+    ESL_ALLOC(buf, sizeof(char) * nalloc);
+  }
+  if(sqfp->do_digital) piece = esl_sq_CreateDigital(sqfp->abc);
+  else                 piece = esl_sq_Create();
+  if(piece == NULL) croak("out of memory");
 
-  /* make sure SSI is valid */
-  if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
+  for(i0 = 0; i0 < nreq; i0 = i1) { 
+    /* choose the window: all requests if outputting in file order */
+    if(do_file_order) i1 = nreq;
+    else { 
+      west = sA[i0].est;
+      for(i1 = i0+1; i1 < nreq && west + sA[i1].est <= BESQ_FETCH_WINDOW; i1++) west += sA[i1].est;
+    }
+    qsort(sA + i0, i1 - i0, sizeof(BESQ_SUBSEQ), _c_subseq_compare);
+    nbuf = 0;
+
+    k = i0;
+    while(k < i1) { 
+      /* extend the fetch window over all overlapping or adjacent requests on the same source */
+      wstart = sA[k].start;
+      wend   = sA[k].end;
+      for(w = k+1; w < i1; w++) { 
+        if(sA[w].fh != sA[k].fh || sA[w].roff != sA[k].roff || sA[w].start > wend+1) break;
+        wend = ESL_MAX(wend, sA[w].end);
+      }
 
-  /* fetch the seq name */
-  status = esl_ssi_FindNumber(sqfp->data.ascii.ssi, nkey, NULL, NULL, NULL, &L, &key_and_L);
-  if     (status == eslEMEM)      croak("out of memory");
-  else if(status == eslENOTFOUND) croak("there is no sequence %d\n", nkey);
-  else if(status == eslEFORMAT)   croak("error fetching sequence num %d, something wrong with SSI index?\n", nkey);
-  else if(status != eslOK)        croak("error fetching sequence num %d\n", nkey);
-
-  Ldup = L;
-  Lwidth = 1;
-  while(Ldup >= 10) { Ldup/=10; Lwidth++; }
-  ESL_ALLOC(Lstr, sizeof(char) * (Lwidth + 1));
-  snprintf(Lstr, Lwidth+1, "%" PRId64 "", L);
-  
-  /* add " " . L to end of key_and_L */
-  if((status = esl_strcat(&key_and_L, -1, " ", 1))        != eslOK) croak("out of memory");
-  if((status = esl_strcat(&key_and_L, -1, Lstr,  Lwidth)) != eslOK) croak("out of memory");
-  free(Lstr);
+      /* fetch the window once */
+      source = SvPV_nolen(*(av_fetch((AV *) SvRV(*(av_fetch(subseqsAV, sA[k].idx, 0))), 3, 0)));
+      esl_sq_Reuse(sq);
+      if (esl_sqio_FetchSubseq(sqfp, source, wstart, wend, sq) != eslOK) croak("Failed to fetch subseq: %s", esl_sqfile_GetErrorBuf(sqfp));
+      if (sq->n != wend - wstart + 1) croak("whoa, internal error; fetched %" PRId64 " residues of %s, expected %" PRId64 "\n", sq->n, source, wend - wstart + 1);
+
+      /* cut out and output each subseq in the window */
+      for(; k < w; k++) { 
+        newname = SvPV_nolen(*(av_fetch((AV *) SvRV(*(av_fetch(subseqsAV, sA[k].idx, 0))), 0, 0)));
+        _c_subseq_from_window(sq, sA[k].start - wstart, sA[k].end - sA[k].start + 1, newname, sA[k].do_revcomp, piece);
+
+        n = _c_sq_fasta_length(piece, textw);
+        if((! do_file_order) || ofp != NULL) { 
+          if(nbuf + n > nalloc) { 
+            nalloc = ESL_MAX(nalloc * 2, nbuf + n);
+            ESL_REALLOC(buf, sizeof(char) * nalloc);
+          }
+          _c_sq_write_fasta(piece, textw, buf + nbuf);
+        }
+        if(do_file_order) { 
+          if(ofp != NULL) { if(fwrite(buf, sizeof(char), n, ofp) != n) croak("error writing to %s", outfile); }
+          else            { _c_sv_append_fasta(retSV, piece, textw); }
+        }
+        else { 
+          rstartA[sA[k].idx - i0] = nbuf;
+          rlenA[sA[k].idx - i0]   = n;
+          nbuf += n;
+        }
+      }
+    }
 
-  key_and_LSV = newSVpv(key_and_L, strlen(key_and_L));
-  free(key_and_L);
+    /* output the window in the order of subseqsAR */
+    if(! do_file_order) { 
+      for(i = 0; i < i1 - i0; i++) { 
+        if(ofp != NULL) { if(fwrite(buf + rstartA[i], sizeof(char), rlenA[i], ofp) != rlenA[i]) croak("error writing to %s", outfile); }
+        else            { sv_catpvn(retSV, buf + rstartA[i], rlenA[i]); }
+      }
+    }
+  }
 
-  return key_and_LSV;
+  if(ofp != NULL && fclose(ofp) != 0) croak("error closing %s", outfile);
+  esl_sq_Destroy(piece);
+  if(buf     != NULL) free(buf);
+  if(rstartA != NULL) free(rstartA);
+  if(rlenA   != NULL) free(rlenA);
+  free(sA);
 
- ERROR: 
+  return retSV;
+
+ ERROR:
   croak("out of memory");
   return NULL; /* NEVER REACHED */
 }
-
 /* Function:  _c_fetch_seq_length_given_name()
  * Incept:    EPN, Mon Nov 25 05:09:35 2013
  * Purpose:   Fetch the length of a sequence given its name (primary key).
@@ -760,60 +1597,900 @@ long _c_nseq_ssi(ESL_SQFILE *sqfp) {
   return sqfp->data.ascii.ssi->nprimary;
 }
 
-/* Function:  _c_nres_ssi
- * Incept:    EPN, Thu Dec  5 06:14:02 2013
- * Purpose:   Return the number of residues in a sequence file.
- *            
- * Args:      sqfp - open ESL_SQFILE
- *
- * Returns:   Number of residues in the file.
+/* BESQ_KEYTAB: the primary key table of an SSI index (name, record
+ * offset and length of every sequence), loaded once by
+ * _c_keytab_create() so per-key and whole-file queries don't
+ * need SSI lookups. Keys are in SSI order, the order used by
+ * esl_ssi_FindNumber().
  */
-
-SV * _c_nres_ssi(ESL_SQFILE *sqfp) { 
-  int status;
-  int i;                    /* counter over seqs */
-  int64_t nseq;             /* number of seqs in sqfp */
-  int64_t nres = 0;         /* summed length of all seqs */
-  int64_t nres_dup;         /* duplicate of nres, used to create nres_str */
-  char   *nres_str = NULL;  /* string version of nres, to return */
-  int     nres_wid = 0;     /* num digits in nres */
-  SV     *nres_str_SV;      /* SV version of nres_str, to return */
-  int64_t L;                /* length of current seq */
+typedef struct {
+  int64_t   nkey;       /* number of primary keys */
+  char     *nameblock;  /* all names, each NUL terminated */
+  int64_t  *noffA;      /* [0..i..nkey-1] offset of name i in nameblock */
+  off_t    *roffA;      /* [0..i..nkey-1] offset of record i in the sequence file */
+  int64_t  *LA;         /* [0..i..nkey-1] length of sequence i, 0 if unset */
+  int64_t   nres;       /* summed length of all sequences */
+  int64_t  *lorderA;    /* [0..i..nkey-1] key indices sorted by decreasing length, NULL until needed */
+} BESQ_KEYTAB;
+
+/* Function:  _c_keytab_create()
+ * Purpose:   Read every primary key of the SSI index of <sqfp> 
+ *            into a BESQ_KEYTAB, in a single sequential pass
+ *            over the index.
+ * Args:      sqfp - open ESL_SQFILE with an open SSI index
+ * Returns:   The new BESQ_KEYTAB.
+ * Dies:      with croak if there's a problem reading the SSI index
+ *            or we run out of memory
+ */
+SV *_c_keytab_create (ESL_SQFILE *sqfp)
+{
+  int          status;            /* Easel status code */
+  BESQ_KEYTAB *kt     = NULL;     /* the table */
+  int64_t      i;                 /* counter over keys */
+  char        *name   = NULL;     /* name of key i */
+  int64_t      n;                 /* length of name, including NUL */
+  int64_t      nblock = 0;        /* used length of nameblock */
+  int64_t      nalloc = 0;        /* allocated length of nameblock */
 
   /* make sure SSI is valid */
   if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
-  
-  nseq = sqfp->data.ascii.ssi->nprimary;
-  
-  for(i = 0; i < nseq; i++) { 
-    status = esl_ssi_FindNumber(sqfp->data.ascii.ssi, i, NULL, NULL, NULL, &L, NULL);
+
+  ESL_ALLOC(kt, sizeof(BESQ_KEYTAB));
+  kt->nkey      = sqfp->data.ascii.ssi->nprimary;
+  kt->nameblock = NULL;
+  kt->noffA     = NULL;
+  kt->roffA     = NULL;
+  kt->LA        = NULL;
+  kt->nres      = 0;
+  kt->lorderA   = NULL;
+
+  ESL_ALLOC(kt->noffA, sizeof(int64_t) * (kt->nkey+1));
+  ESL_ALLOC(kt->roffA, sizeof(off_t)   * (kt->nkey+1));
+  ESL_ALLOC(kt->LA,    sizeof(int64_t) * (kt->nkey+1));
+  nalloc = 16 * (kt->nkey+1);
+  ESL_ALLOC(kt->nameblock, sizeof(char) * nalloc);
+
+  for(i = 0; i < kt->nkey; i++) { 
+    status = esl_ssi_FindNumber(sqfp->data.ascii.ssi, i, NULL, &(kt->roffA[i]), NULL, &(kt->LA[i]), &name);
     if     (status == eslEMEM)      croak("out of memory");
-    else if(status == eslENOTFOUND) croak("there is no sequence %d\n", i);
-    else if(status == eslEFORMAT)   croak("error fetching sequence num %d, something wrong with SSI index?\n", i);
-    else if(status != eslOK)        croak("error fetching sequence num %d\n", i);
-    /* EPN, Fri Nov  6 08:44:29 2015: we allow length 0 sequences, NCBI commonly puts them in as some type 
-     *                                of sequence divider for separating assembly projects, for example.
-     *                                I'm leaving the following line of code here though commented out
-     *                                in case it causes some unforeseen issue in the future and having it
-     *                                here commented out lends some clue.
-     * if(L == 0)                      croak("error fetching sequence num %d, seq length unknown\n", i); 
-     */
-    nres += L;
-  }
-  /* convert nres to a string to return (so we don't overflow an int or a long) */
-  /* determine number of digits in nres */
-  nres_dup = nres;
-  nres_wid = 1;
-  while(nres_dup >= 10) { nres_dup/=10; nres_wid++; }
-  ESL_ALLOC(nres_str, sizeof(char) * (nres_wid + 1));
-  snprintf(nres_str, nres_wid+1, "%" PRId64 "", nres);
-
-  nres_str_SV = newSVpv(nres_str, nres_wid);
-  free(nres_str);
-
-  return nres_str_SV;
+    else if(status == eslENOTFOUND) croak("there is no sequence %" PRId64 "\n", i);
+    else if(status == eslEFORMAT)   croak("error fetching sequence num %" PRId64 ", something wrong with SSI index?\n", i);
+    else if(status != eslOK)        croak("error fetching sequence num %" PRId64 "\n", i);
+
+    n = strlen(name) + 1;
+    if(nblock + n > nalloc) { 
+      nalloc = ESL_MAX(nalloc * 2, nblock + n);
+      ESL_REALLOC(kt->nameblock, sizeof(char) * nalloc);
+    }
+    memcpy(kt->nameblock + nblock, name, n);
+    kt->noffA[i] = nblock;
+    nblock      += n;
+    kt->nres    += kt->LA[i];
+    free(name);
+    name = NULL;
+  }
+
+  return perl_obj(kt, "BESQ_KEYTAB");
+
+ ERROR: 
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_keytab_destroy()
+ * Synopsis:  Free a BESQ_KEYTAB.
+ * Returns:   void
+ */
+void _c_keytab_destroy (BESQ_KEYTAB *kt)
+{
+  if(kt == NULL) return;
+  if(kt->nameblock != NULL) free(kt->nameblock);
+  if(kt->noffA     != NULL) free(kt->noffA);
+  if(kt->roffA     != NULL) free(kt->roffA);
+  if(kt->LA        != NULL) free(kt->LA);
+  if(kt->lorderA   != NULL) free(kt->lorderA);
+  free(kt);
+  return;
+}
+
+/* Function:  _c_keytab_check_idx()
+ * Synopsis:  Croak if <idx> is not a valid key index in <kt>.
+ */
+void _c_keytab_check_idx (BESQ_KEYTAB *kt, long idx)
+{
+  if(idx < 0 || idx >= kt->nkey) croak("there is no sequence %ld\n", idx);
+  return;
+}
+
+/* Function:  _c_keytab_nres()
+ * Purpose:   Return the number of residues in the sequence file,
+ *            as a string so as not to overflow a 32-bit int.
+ */
+SV *_c_keytab_nres (BESQ_KEYTAB *kt)
+{
+  return newSVpvf("%" PRId64, kt->nres);
+}
+
+/* Function:  _c_keytab_name()
+ * Purpose:   Return the name (primary key) of key <idx>.
+ */
+SV *_c_keytab_name (BESQ_KEYTAB *kt, long idx)
+{
+  _c_keytab_check_idx(kt, idx);
+  return newSVpv(kt->nameblock + kt->noffA[idx], 0);
+}
+
+/* Function:  _c_keytab_length()
+ * Purpose:   Return the sequence length of key <idx>, 0 if 
+ *            lengths are unset in the SSI index.
+ */
+SV *_c_keytab_length (BESQ_KEYTAB *kt, long idx)
+{
+  _c_keytab_check_idx(kt, idx);
+  return newSViv(kt->LA[idx]);
+}
+
+/* Function:  _c_keytab_lengths_packed()
+ * Purpose:   Return the lengths of all keys, in SSI order, 
+ *            as a single string of native int64s (Perl 
+ *            unpack() template "q*").
+ */
+SV *_c_keytab_lengths_packed (BESQ_KEYTAB *kt)
+{
+  return newSVpvn((char *) kt->LA, sizeof(int64_t) * kt->nkey);
+}
+
+/* BESQ_LORDER: a sequence length and its index, for _c_length_order() */
+typedef struct {
+  int64_t L;    /* length */
+  int64_t idx;  /* index */
+} BESQ_LORDER;
+
+/* Function:  _c_lorder_compare()
+ * Synopsis:  qsort() comparison function for BESQ_LORDER, sorts
+ *            by decreasing length, then increasing index.
+ */
+int _c_lorder_compare(const void *a, const void *b)
+{
+  const BESQ_LORDER *la = (const BESQ_LORDER *) a;
+  const BESQ_LORDER *lb = (const BESQ_LORDER *) b;
+
+  if(la->L != lb->L) return (la->L > lb->L) ? -1 : 1;
+  return (la->idx < lb->idx) ? -1 : ((la->idx > lb->idx) ? 1 : 0);
+}
+
+/* Function:  _c_length_order()
+ * Synopsis:  Fill <orderA> with the indices 0..n-1 sorted by 
+ *            decreasing <LA> value, ties broken by index.
+ * Args:      LA     - [0..i..n-1] lengths
+ *            n      - number of lengths
+ *            orderA - [0..n-1] RETURN: indices in order, allocated by caller
+ * Returns:   void
+ * Dies:      with croak if out of memory
+ */
+void _c_length_order(const int64_t *LA, int64_t n, int64_t *orderA)
+{
+  int          status;        /* Easel status code */
+  BESQ_LORDER *loA = NULL;    /* [0..i..n-1] lengths and indices */
+  int64_t      i;             /* counter */
+
+  ESL_ALLOC(loA, sizeof(BESQ_LORDER) * (n+1));
+  for(i = 0; i < n; i++) { loA[i].L = LA[i]; loA[i].idx = i; }
+  qsort(loA, n, sizeof(BESQ_LORDER), _c_lorder_compare);
+  for(i = 0; i < n; i++) orderA[i] = loA[i].idx;
+  free(loA);
+  return;
 
  ERROR: 
+  croak("out of memory");
+  return; /* NEVER REACHED */
+}
+
+/* Function:  _c_keytab_length_order_packed()
+ * Purpose:   Return the key indices sorted by decreasing sequence 
+ *            length (ties broken by index), as a single string of
+ *            native int64s (Perl unpack() template "q*"). The order
+ *            is computed on the first call and cached in <kt>.
+ */
+SV *_c_keytab_length_order_packed (BESQ_KEYTAB *kt)
+{
+  int     status;   /* Easel status code */
+
+  if(kt->lorderA == NULL) { 
+    ESL_ALLOC(kt->lorderA, sizeof(int64_t) * (kt->nkey+1));
+    _c_length_order(kt->LA, kt->nkey, kt->lorderA);
+  }
+
+  return newSVpvn((char *) kt->lorderA, sizeof(int64_t) * kt->nkey);
+
+ ERROR: 
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Modes for _c_split(), deciding which output file each sequence goes to. 
+ * They correspond to esl-ssplit.pl's default mode, -n, -n -r, -n -r -z and -n -b.
+ */
+#define BESQ_SPLIT_NSEQ        0  /* <n> consecutive seqs per file */
+#define BESQ_SPLIT_NFILES      1  /* <n> files of consecutive seqs, same number of seqs in each */
+#define BESQ_SPLIT_NRES        2  /* <n> files of consecutive seqs, roughly same number of residues in each */
+#define BESQ_SPLIT_NRES_RANDOM 3  /* <n> files, each seq to a random open file, roughly same number of residues in each */
+#define BESQ_SPLIT_LPT         4  /* <n> files, longest-processing-time bin packing of residues */
+
+/* BESQ_SPLITSEQ: record offset and length of one sequence, for _c_split() */
+typedef struct {
+  off_t    roff;  /* offset of the start of the record */
+  int64_t  L;     /* sequence length */
+} BESQ_SPLITSEQ;
+
+/* Function:  _c_split_compare()
+ * Synopsis:  qsort() comparison function for BESQ_SPLITSEQ, sorts by record offset.
+ */
+int _c_split_compare(const void *a, const void *b)
+{
+  const BESQ_SPLITSEQ *sa = (const BESQ_SPLITSEQ *) a;
+  const BESQ_SPLITSEQ *sb = (const BESQ_SPLITSEQ *) b;
+
+  if(sa->roff != sb->roff) return (sa->roff < sb->roff) ? -1 : 1;
+  return 0;
+}
+
+/* Function:  _c_split_prescan()
+ * Purpose:   Get the record offset and length of every sequence in
+ *            <sqfp>, in file order. If <kt> is non-NULL, they are 
+ *            taken from it (the SSI index's key table) and sorted
+ *            by offset, else they are read in a single pass over
+ *            the file with esl_sqio_ReadInfo() and the file is 
+ *            rewound.
+ * Args:      sqfp     - open ESL_SQFILE
+ *            sq       - scratch ESL_SQ for <sqfp>
+ *            kt       - key table of <sqfp>'s SSI index, NULL if none
+ *            ret_ssA  - RETURN: [0..i..nseq-1] offsets and lengths, in file order
+ *            ret_nres - RETURN: total number of residues
+ * Returns:   number of sequences
+ * Dies:      with croak if there's a problem reading <sqfp>
+ */
+int64_t _c_split_prescan(ESL_SQFILE *sqfp, ESL_SQ *sq, BESQ_KEYTAB *kt, BESQ_SPLITSEQ **ret_ssA, int64_t *ret_nres)
+{
+  int            status;          /* Easel status code */
+  BESQ_SPLITSEQ *ssA    = NULL;   /* offsets and lengths */
+  int64_t        nseq   = 0;      /* number of seqs */
+  int64_t        nalloc = 0;      /* allocated size of ssA */
+  int64_t        nres   = 0;      /* total number of residues */
+  int64_t        i;               /* counter over seqs */
+
+  if(kt != NULL) { 
+    nseq = kt->nkey;
+    ESL_ALLOC(ssA, sizeof(BESQ_SPLITSEQ) * (nseq+1));
+    for(i = 0; i < nseq; i++) { 
+      ssA[i].roff = kt->roffA[i];
+      ssA[i].L    = kt->LA[i];
+    }
+    qsort(ssA, nseq, sizeof(BESQ_SPLITSEQ), _c_split_compare);
+  }
+  else { 
+    nalloc = 4096;
+    ESL_ALLOC(ssA, sizeof(BESQ_SPLITSEQ) * nalloc);
+    esl_sq_Reuse(sq);
+    while((status = esl_sqio_ReadInfo(sqfp, sq)) == eslOK) { 
+      if(nseq == nalloc) { 
+        nalloc *= 2;
+        ESL_REALLOC(ssA, sizeof(BESQ_SPLITSEQ) * nalloc);
+      }
+      ssA[nseq].roff = sq->roff;
+      ssA[nseq].L    = sq->L;
+      nseq++;
+      esl_sq_Reuse(sq);
+    }
+    if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+    else if (status != eslEOF)     croak("Unexpected error %d reading sequence file %s", status, sqfp->filename);
+    if(esl_sqfile_Position(sqfp, 0) != eslOK) croak("Failed to rewind sequence file %s", sqfp->filename);
+  }
+  for(i = 0; i < nseq; i++) nres += ssA[i].L;
+
+  *ret_ssA  = ssA;
+  *ret_nres = nres;
+  return nseq;
+
+ ERROR:
+  croak("out of memory");
+  return 0; /* NEVER REACHED */
+}
+
+/* Function:  _c_split_assign()
+ * Purpose:   Decide which output file each sequence goes to, with
+ *            exactly the same rules (and for BESQ_SPLIT_NRES_RANDOM,
+ *            the same random number stream) as esl-ssplit.pl used 
+ *            when it fetched one sequence at a time.
+ *
+ *            In BESQ_SPLIT_NRES mode a file is finished once it has
+ *            at least ceil(nres/n) residues. In BESQ_SPLIT_NRES_RANDOM
+ *            mode each sequence goes to a file chosen uniformly at
+ *            random from the open files, which are closed once they 
+ *            have ceil(nres/n) residues (except the last one).
+ *
+ *            BESQ_SPLIT_LPT mode is longest-processing-time bin
+ *            packing: sequences are taken in order of decreasing 
+ *            length (ties in file order) and each one goes to the 
+ *            file with the fewest residues so far (ties to the lowest
+ *            numbered file), found with a min-heap. This keeps the
+ *            maximum number of residues in a file within 4/3 of 
+ *            optimal, however skewed the lengths are.
+ *
+ * Args:      ssA    - [0..i..nseq-1] offsets and lengths, in file order
+ *            nseq   - number of sequences
+ *            nres   - total number of residues
+ *            n      - number of seqs per file (BESQ_SPLIT_NSEQ) or number of files
+ *            mode   - BESQ_SPLIT_*
+ *            seed   - RNG seed for BESQ_SPLIT_NRES_RANDOM
+ *            fidxA  - [0..i..nseq-1] RETURN: output file index of each seq, 
+ *                     allocated by caller
+ * Returns:   number of output files to create
+ * Dies:      with croak if there are no residues in an NRES mode
+ */
+int _c_split_assign(BESQ_SPLITSEQ *ssA, int64_t nseq, int64_t nres, long n, int mode, long seed, int *fidxA)
+{
+  int             status;         /* Easel status code */
+  ESL_RANDOMNESS *rng     = NULL; /* RNG, BESQ_SPLIT_NRES_RANDOM only */
+  int            *mapA    = NULL; /* [0..r..nopen-1] open file indices, BESQ_SPLIT_NRES_RANDOM only */
+  int64_t        *nresA   = NULL; /* [0..f..] number of residues in each file so far */
+  int64_t         nper;           /* number of seqs or residues per file */
+  int64_t         i;              /* counter over seqs */
+  int             fidx   = 0;     /* current output file */
+  int             ridx   = 0;     /* index in mapA of fidx */
+  int             nopen;          /* number of open files, BESQ_SPLIT_NRES_RANDOM only */
+  int             nout   = 0;     /* number of output files */
+  int64_t        *LA      = NULL; /* [0..i..nseq-1] seq lengths, BESQ_SPLIT_LPT only */
+  int64_t        *orderA  = NULL; /* [0..i..nseq-1] seqs by decreasing length, BESQ_SPLIT_LPT only */
+  int            *heapA   = NULL; /* [0..h..n-1] min-heap of files by (residues, index), BESQ_SPLIT_LPT only */
+  int             h, c;           /* heap positions, BESQ_SPLIT_LPT only */
+
+  if(mode == BESQ_SPLIT_NSEQ || mode == BESQ_SPLIT_NFILES) { 
+    nper = (mode == BESQ_SPLIT_NSEQ) ? n : (nseq + n - 1) / n;
+    if(nper < 1) nper = 1;
+    for(i = 0; i < nseq; i++) fidxA[i] = (int) (i / nper);
+    nout = (int) ((nseq + nper - 1) / nper);
+    return nout;
+  }
+
+  if(nres == 0) croak("0 residues read in sequence file.");
+  nper = (nres + n - 1) / n;
+  ESL_ALLOC(nresA, sizeof(int64_t) * (ESL_MAX(n, nseq) + 1));
+  for(i = 0; i < ESL_MAX(n, nseq) + 1; i++) nresA[i] = 0;
+
+  if(mode == BESQ_SPLIT_LPT) { 
+    ESL_ALLOC(LA,     sizeof(int64_t) * (nseq+1));
+    ESL_ALLOC(orderA, sizeof(int64_t) * (nseq+1));
+    ESL_ALLOC(heapA,  sizeof(int)     * n);
+    for(i = 0; i < nseq; i++) LA[i] = ssA[i].L;
+    _c_length_order(LA, nseq, orderA);
+    for(h = 0; h < n; h++) heapA[h] = h; /* all files empty, ordered by index: a valid heap */
+
+    for(i = 0; i < nseq; i++) { 
+      fidx = heapA[0];
+      fidxA[orderA[i]] = fidx;
+      nresA[fidx]     += LA[orderA[i]];
+      /* sift the root down */
+      h = 0;
+      while((c = 2*h+1) < n) { 
+        if(c+1 < n && (nresA[heapA[c+1]] < nresA[heapA[c]] || (nresA[heapA[c+1]] == nresA[heapA[c]] && heapA[c+1] < heapA[c]))) c++;
+        if(nresA[heapA[c]] > nresA[heapA[h]] || (nresA[heapA[c]] == nresA[heapA[h]] && heapA[c] > heapA[h])) break;
+        fidx = heapA[c]; heapA[c] = heapA[h]; heapA[h] = fidx;
+        h = c;
+      }
+    }
+    free(LA);
+    free(orderA);
+    free(heapA);
+    free(nresA);
+    return n;
+  }
+
+  if(mode == BESQ_SPLIT_NRES_RANDOM) { 
+    if((rng = esl_randomness_Create((uint32_t) seed)) == NULL) croak("unable to create ESL_RANDOMNESS object, probably out of memory"); 
+    ESL_ALLOC(mapA, sizeof(int) * n);
+    for(i = 0; i < n; i++) mapA[i] = i;
+    nopen = n;
+  }
+
+  for(i = 0; i < nseq; i++) { 
+    if(mode == BESQ_SPLIT_NRES_RANDOM) { 
+      ridx = (int) (esl_random(rng) * nopen); /* as Bio::Easel::Random::roll() */
+      fidx = mapA[ridx];
+    }
+    fidxA[i]     = fidx;
+    nresA[fidx] += ssA[i].L;
+
+    /* finish this file? */
+    if(nresA[fidx] >= nper || i == nseq-1) { 
+      if(mode == BESQ_SPLIT_NRES_RANDOM) { 
+        if(nopen > 1 || i == nseq-1) { 
+          if(ridx != nopen-1) mapA[ridx] = mapA[nopen-1];
+          nopen--;
+        }
+      }
+      else if(i < nseq-1) { 
+        fidx++;
+      }
+    }
+  }
+  nout = (mode == BESQ_SPLIT_NRES_RANDOM) ? n : fidx+1;
+
+  free(nresA);
+  if(mapA != NULL) free(mapA);
+  if(rng  != NULL) esl_randomness_Destroy(rng);
+  return nout;
+
+ ERROR:
+  croak("out of memory");
+  return 0; /* NEVER REACHED */
+}
+
+/* Function:  _c_split()
+ * Synopsis:  Split a sequence file into smaller files, the engine of
+ *            esl-ssplit.pl.
+ * Purpose:   First get the offset and length of every sequence, 
+ *            from the SSI key table <ktSV> if the caller passes one,
+ *            else with a pre-scan of <sqfp> that needs no index. 
+ *            Then assign each sequence to an output file with 
+ *            _c_split_assign(), and make one streaming pass over 
+ *            the file writing each sequence to its output file
+ *            <outroot>.<f>, f = 1..nout.
+ *
+ *            FASTA records are copied byte for byte. Records in 
+ *            other formats are written as FASTA with the whole 
+ *            sequence on one line.
+ *
+ *            With BESQ_SPLIT_NRES_RANDOM and BESQ_SPLIT_LPT all output
+ *            files are open at once, otherwise only one is open at a
+ *            time.
+ *
+ * Args:      sqfp    - open ESL_SQFILE, must not be gzipped or stdin
+ *            sq      - scratch ESL_SQ for <sqfp>, from _c_create_scratch_sq()
+ *            ktSV    - BESQ_KEYTAB of <sqfp>'s SSI index, or undef for no index
+ *            outroot - root of output file names
+ *            n       - number of seqs per file (BESQ_SPLIT_NSEQ) or number of files
+ *            mode    - BESQ_SPLIT_*
+ *            seed    - RNG seed for BESQ_SPLIT_NRES_RANDOM
+ *
+ * Returns:   Reference to an array with one element per output file,
+ *            each a reference to [file name, number of seqs, number 
+ *            of residues].
+ * Dies:      with croak if <sqfp> can't be read or split, or an 
+ *            output file can't be written
+ */
+SV *_c_split (ESL_SQFILE *sqfp, ESL_SQ *sq, SV *ktSV, char *outroot, long n, int mode, long seed)
+{
+  int             status;          /* Easel status code */
+  BESQ_KEYTAB    *kt      = c_obj(ktSV, BESQ_KEYTAB); /* SSI key table, NULL if none */
+  BESQ_SPLITSEQ  *ssA     = NULL;  /* [0..i..nseq-1] offsets and lengths, in file order */
+  int64_t         nseq;            /* number of seqs */
+  int64_t         nres;            /* total number of residues */
+  int            *fidxA   = NULL;  /* [0..i..nseq-1] output file of each seq */
+  int             nout;            /* number of output files */
+  char          **fileA   = NULL;  /* [0..f..nout-1] output file names */
+  FILE          **ofpA    = NULL;  /* [0..f..nout-1] open output files, NULL if not open */
+  int64_t        *onseqA  = NULL;  /* [0..f..nout-1] number of seqs in each output file */
+  int64_t        *onresA  = NULL;  /* [0..f..nout-1] number of residues in each output file */
+  int             do_raw;          /* TRUE to copy FASTA records byte for byte */
+  FILE           *ifp     = NULL;  /* input file, if do_raw */
+  off_t           ipos;            /* current position in ifp */
+  off_t           iend;            /* end of current record in ifp, -1 for EOF */
+  char           *buf     = NULL;  /* copy buffer if do_raw, else FASTA record */
+  int64_t         nalloc  = 0;     /* allocated size of buf */
+  int64_t         nrec;            /* number of bytes in current record or chunk of it */
+  int64_t         i;               /* counter over seqs */
+  int             f;               /* counter over output files */
+  int             prvf    = -1;    /* output file of previous seq */
+  int             do_all_open;     /* TRUE to open all output files at once */
+  AV             *retAV;           /* array to return */
+  AV             *fileAV;          /* [file name, nseq, nres] for one output file */
+
+  if(sqfp->data.ascii.do_gzip || sqfp->data.ascii.do_stdin) croak("can't split sequence file %s, it's gzipped or stdin", sqfp->filename);
+  if(n < 1) croak("invalid number of sequences or files %ld", n);
+
+  nseq = _c_split_prescan(sqfp, sq, kt, &ssA, &nres);
+  ESL_ALLOC(fidxA, sizeof(int) * (nseq+1));
+  nout = _c_split_assign(ssA, nseq, nres, n, mode, seed, fidxA);
+
+  ESL_ALLOC(fileA,  sizeof(char *)  * (nout+1));
+  ESL_ALLOC(ofpA,   sizeof(FILE *)  * (nout+1));
+  ESL_ALLOC(onseqA, sizeof(int64_t) * (nout+1));
+  ESL_ALLOC(onresA, sizeof(int64_t) * (nout+1));
+  for(f = 0; f < nout; f++) { 
+    if(esl_sprintf(&(fileA[f]), "%s.%d", outroot, f+1) != eslOK) croak("out of memory");
+    ofpA[f]   = NULL;
+    onseqA[f] = 0;
+    onresA[f] = 0;
+  }
+  do_all_open = (mode == BESQ_SPLIT_NRES_RANDOM || mode == BESQ_SPLIT_LPT) ? TRUE : FALSE;
+  if(do_all_open) { 
+    for(f = 0; f < nout; f++) { 
+      if((ofpA[f] = fopen(fileA[f], "w")) == NULL) croak("unable to open %s for writing", fileA[f]);
+    }
+  }
+
+  do_raw = (sqfp->format == eslSQFILE_FASTA) ? TRUE : FALSE;
+  if(do_raw) { 
+    nalloc = 1048576;
+    ESL_ALLOC(buf, sizeof(char) * nalloc);
+    if((ifp = fopen(sqfp->filename, "rb")) == NULL) croak("failed to open sequence file %s", sqfp->filename);
+    ipos = (nseq > 0) ? ssA[0].roff : 0;
+    if(fseeko(ifp, ipos, SEEK_SET) != 0) croak("failed to position sequence file %s", sqfp->filename);
+  }
+  else if(esl_sqfile_Position(sqfp, 0) != eslOK) croak("Failed to rewind sequence file %s", sqfp->filename);
+
+  for(i = 0; i < nseq; i++) { 
+    f = fidxA[i];
+    /* open the next file, closing the previous one, unless they're all open */
+    if(f != prvf && (! do_all_open)) { 
+      if(prvf != -1 && fclose(ofpA[prvf]) != 0) croak("error closing %s", fileA[prvf]);
+      if(prvf != -1) ofpA[prvf] = NULL;
+      if((ofpA[f] = fopen(fileA[f], "w")) == NULL) croak("unable to open %s for writing", fileA[f]);
+    }
+    prvf = f;
+
+    if(do_raw) { 
+      iend = (i < nseq-1) ? ssA[i+1].roff : -1;
+      while(iend == -1 || ipos < iend) { 
+        nrec = (iend == -1) ? nalloc : ESL_MIN(nalloc, (int64_t) (iend - ipos));
+        nrec = fread(buf, sizeof(char), nrec, ifp);
+        if(nrec == 0) { 
+          if(iend != -1) croak("unexpected end of sequence file %s", sqfp->filename);
+          break;
+        }
+        if(fwrite(buf, sizeof(char), nrec, ofpA[f]) != nrec) croak("error writing to %s", fileA[f]);
+        ipos += nrec;
+      }
+    }
+    else { 
+      esl_sq_Reuse(sq);
+      status = esl_sqio_Read(sqfp, sq);
+      if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n",  sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+      else if (status == eslEOF)     croak("Unexpected EOF reading sequence file %s\n", sqfp->filename);
+      else if (status != eslOK)      croak("Unexpected error %d reading sequence file %s\n", status, sqfp->filename);
+      nrec = _c_sq_fasta_length(sq, -1);
+      if(nrec > nalloc) { 
+        nalloc = nrec;
+        ESL_REALLOC(buf, sizeof(char) * nalloc);
+      }
+      _c_sq_write_fasta(sq, -1, buf);
+      if(fwrite(buf, sizeof(char), nrec, ofpA[f]) != nrec) croak("error writing to %s", fileA[f]);
+    }
+    onseqA[f]++;
+    onresA[f] += ssA[i].L;
+  }
+
+  /* close all output files and return their names and sizes */
+  retAV = newAV();
+  for(f = 0; f < nout; f++) { 
+    if(ofpA[f] != NULL && fclose(ofpA[f]) != 0) croak("error closing %s", fileA[f]);
+    fileAV = newAV();
+    av_push(fileAV, newSVpv(fileA[f], 0));
+    av_push(fileAV, newSViv(onseqA[f]));
+    av_push(fileAV, newSViv(onresA[f]));
+    av_push(retAV, newRV_noinc((SV *) fileAV));
+    free(fileA[f]);
+  }
+  if(ifp != NULL) fclose(ifp);
+  if(! do_raw && esl_sqfile_Position(sqfp, 0) != eslOK) croak("Failed to rewind sequence file %s", sqfp->filename);
+
+  if(buf != NULL) free(buf);
+  free(fileA);
+  free(ofpA);
+  free(onseqA);
+  free(onresA);
+  free(fidxA);
+  free(ssA);
+
+  return newRV_noinc((SV *) retAV);
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_copy_byte_range()
+ * Purpose:   Copy <len> bytes starting at offset <off> of open file 
+ *            descriptor <ifd> to the end of <ofd>. On Linux the 
+ *            copy_file_range() system call is tried first, which 
+ *            copies inside the kernel (or the filesystem, without
+ *            touching the data at all on some); if it isn't available 
+ *            for these files we fall back to large read()/write()s
+ *            through <buf>.
+ * Args:      ifd    - input file descriptor
+ *            off    - offset of first byte to copy
+ *            len    - number of bytes to copy
+ *            ofd    - output file descriptor
+ *            buf    - copy buffer
+ *            nbuf   - size of <buf>
+ * Returns:   eslOK on success, eslEWRITE if a read or write fails
+ */
+int _c_copy_byte_range(int ifd, off_t off, int64_t len, int ofd, char *buf, int64_t nbuf)
+{
+  ssize_t nr, nw;   /* bytes read and written */
+  ssize_t w;        /* bytes written in one write() */
+
+#if defined(__linux__) && defined(SYS_copy_file_range)
+  int64_t ioff = off;  /* input offset, advanced by copy_file_range() */
+  while(len > 0) { 
+    nr = syscall(SYS_copy_file_range, ifd, &ioff, ofd, NULL, (size_t) ESL_MIN(len, (int64_t) 1 << 30), 0);
+    if(nr <= 0) break; /* unsupported here, or short file: finish with read()/write() */
+    len -= nr;
+  }
+  off = ioff;
+#endif
+
+  while(len > 0) { 
+    nr = pread(ifd, buf, (size_t) ESL_MIN(len, nbuf), off);
+    if(nr <= 0) return eslEWRITE;
+    for(nw = 0; nw < nr; nw += w) { 
+      if((w = write(ofd, buf + nw, nr - nw)) <= 0) return eslEWRITE;
+    }
+    off += nr;
+    len -= nr;
+  }
+  return eslOK;
+}
+
+/* Function:  _c_split_bytes()
+ * Synopsis:  Split a FASTA file into <n> files of roughly equal size
+ *            in bytes, without parsing it.
+ * Purpose:   The file is cut at <n-1> evenly spaced byte offsets, 
+ *            each moved forward to the next line that starts with 
+ *            '>' with _c_ssi_resync(), and the byte ranges between
+ *            cuts are copied unchanged to <outroot>.1, <outroot>.2, ...
+ *            by _c_copy_byte_range(). Only the bytes around each cut
+ *            are read to find it, no residue is decoded.
+ *
+ *            Fewer than <n> files are created if two cuts move to
+ *            the same record, e.g. when a sequence is longer than 
+ *            the file size over <n>.
+ *
+ * Args:      sqfp    - open ESL_SQFILE, FASTA, not gzipped or stdin
+ *            outroot - root of output file names
+ *            n       - number of files
+ *
+ * Returns:   Reference to an array with one element per output file,
+ *            each a reference to [file name, number of bytes].
+ * Dies:      with croak if <sqfp> isn't a plain FASTA file, or a 
+ *            file can't be read or written
+ */
+SV *_c_split_bytes (ESL_SQFILE *sqfp, char *outroot, long n)
+{
+  int         status;           /* Easel status code */
+  struct stat st;               /* for file size */
+  FILE       *fp     = NULL;    /* input file, for finding cuts */
+  int         ifd    = -1;      /* input file descriptor, for copying */
+  int         ofd;              /* output file descriptor */
+  off_t      *cutA   = NULL;    /* [0..f..nout] start of output file f, cutA[nout] is file size */
+  int         nout   = 0;       /* number of output files */
+  off_t       cut;              /* a cut point */
+  char       *buf    = NULL;    /* copy buffer */
+  int64_t     nbuf   = 8388608; /* size of copy buffer */
+  char       *file   = NULL;    /* name of current output file */
+  int         f;                /* counter over cuts and output files */
+  AV         *retAV;            /* array to return */
+  AV         *fileAV;           /* [file name, nbytes] for one output file */
+
+  if(sqfp->format != eslSQFILE_FASTA) croak("can only split FASTA files by bytes, %s is not FASTA", sqfp->filename);
+  if(sqfp->data.ascii.do_gzip || sqfp->data.ascii.do_stdin) croak("can't split sequence file %s, it's gzipped or stdin", sqfp->filename);
+  if(n < 1) croak("invalid number of files %ld", n);
+  if(stat(sqfp->filename, &st) != 0) croak("failed to stat sequence file %s", sqfp->filename);
+
+  /* find the cuts, dropping any that move to the same record as the previous one */
+  ESL_ALLOC(cutA, sizeof(off_t) * (n+1));
+  if((fp = fopen(sqfp->filename, "rb")) == NULL) croak("failed to open sequence file %s", sqfp->filename);
+  cutA[nout++] = 0;
+  for(f = 1; f < n; f++) { 
+    cut = _c_ssi_resync(fp, (off_t) ((double) st.st_size * f / n));
+    if(cut == -1) break;
+    if(cut > cutA[nout-1]) cutA[nout++] = cut;
+  }
+  cutA[nout] = st.st_size;
+  fclose(fp);
+
+  /* copy each byte range */
+  if((ifd = open(sqfp->filename, O_RDONLY)) == -1) croak("failed to open sequence file %s", sqfp->filename);
+  ESL_ALLOC(buf, sizeof(char) * nbuf);
+  retAV = newAV();
+  for(f = 0; f < nout; f++) { 
+    if(esl_sprintf(&file, "%s.%d", outroot, f+1) != eslOK) croak("out of memory");
+    if((ofd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1) croak("unable to open %s for writing", file);
+    if(_c_copy_byte_range(ifd, cutA[f], cutA[f+1] - cutA[f], ofd, buf, nbuf) != eslOK) croak("error copying %s to %s", sqfp->filename, file);
+    if(close(ofd) != 0) croak("error closing %s", file);
+
+    fileAV = newAV();
+    av_push(fileAV, newSVpv(file, 0));
+    av_push(fileAV, newSViv(cutA[f+1] - cutA[f]));
+    av_push(retAV, newRV_noinc((SV *) fileAV));
+    free(file);
+    file = NULL;
+  }
+  close(ifd);
+
+  free(buf);
+  free(cutA);
+
+  return newRV_noinc((SV *) retAV);
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVER REACHED */
+}
+
+/* Function:  _c_sample_uniform_positive()
+ * Synopsis:  Return a uniform random double in (0,1), for
+ *            _c_sample_seqs(), which takes its log.
+ */
+double _c_sample_uniform_positive(ESL_RANDOMNESS *r)
+{
+  double u;
+
+  do { u = esl_random(r); } while(u == 0.);
+  return u;
+}
+
+/* Function:  _c_sample_skip()
+ * Synopsis:  Return the number of sequences Algorithm L skips 
+ *            before the next one it takes, given <W>, capped 
+ *            so it fits in an int64_t.
+ */
+int64_t _c_sample_skip(ESL_RANDOMNESS *r, double W)
+{
+  double skip;
+
+  if(W <= 0.) return INT64_MAX / 2;
+  skip = floor(log(_c_sample_uniform_positive(r)) / log1p(-W));
+  return (skip < (double) (INT64_MAX / 2)) ? (int64_t) skip : INT64_MAX / 2;
+}
+
+/* BESQ_SAMPLE: one sequence in _c_sample_seqs()'s reservoir */
+typedef struct {
+  ESL_SQ  *sq;   /* the sequence */
+  int64_t  idx;  /* its index in the file */
+} BESQ_SAMPLE;
+
+/* Function:  _c_sample_compare()
+ * Synopsis:  qsort() comparison function for BESQ_SAMPLE, sorts by index in the file.
+ */
+int _c_sample_compare(const void *a, const void *b)
+{
+  const BESQ_SAMPLE *sa = (const BESQ_SAMPLE *) a;
+  const BESQ_SAMPLE *sb = (const BESQ_SAMPLE *) b;
+
+  return (sa->idx < sb->idx) ? -1 : ((sa->idx > sb->idx) ? 1 : 0);
+}
+
+/* Function:  _c_sample_seqs()
+ * Synopsis:  Sample <k> sequences uniformly at random from the rest
+ *            of <sqfp> in a single pass, and either output them to
+ *            a FASTA file or return them as a FASTA formatted string.
+ * Purpose:   Reservoir sampling with Li's Algorithm L: the first <k>
+ *            sequences fill the reservoir, then a geometrically 
+ *            distributed number of sequences are skipped before 
+ *            the next one replaces a random member of the reservoir,
+ *            with the skip lengths growing as the file goes on. 
+ *            Skipped sequences are only parsed with 
+ *            esl_sqio_ReadInfo(), never stored, and a taken sequence
+ *            is read into a spare ESL_SQ which is then swapped into
+ *            the reservoir. The reservoir grows as it is filled, so
+ *            memory is O(min(k, nseq)) sequences, and no SSI index
+ *            or seeking is needed: this works on stdin and gzipped
+ *            files. The sample is output in file order.
+ *
+ *            The sample is determined by <r>'s seed and state. If
+ *            the file has <k> or fewer sequences, all are output.
+ *            Afterwards <sqfp> is positioned back at the first
+ *            sequence sampled from, unless it is stdin or gzipped.
+ *
+ * Args:      sqfp    - open ESL_SQFILE
+ *            sq      - scratch ESL_SQ for <sqfp>, from _c_create_scratch_sq()
+ *            k       - number of sequences to sample
+ *            r       - ESL_RANDOMNESS
+ *            textw   - width for each sequence of FASTA record, -1 for unlimited.
+ *            outfile - name of FASTA file to output to, "" to return the seqs as a string
+ * Returns:   String of all sampled seqs if <outfile> is "", else "" (empty string).
+ * Dies:      with croak if <k> is invalid, there's a problem reading <sqfp>
+ *            or <outfile> can't be written
+ */
+SV *_c_sample_seqs (ESL_SQFILE *sqfp, ESL_SQ *sq, long k, ESL_RANDOMNESS *r, int textw, char *outfile)
+{
+  int          status;          /* Easel status code */
+  BESQ_SAMPLE *resA   = NULL;   /* [0..j..nres-1] the reservoir, at most <k> */
+  int64_t      ralloc = 0;      /* allocated size of resA */
+  ESL_SQ      *spare  = NULL;   /* sequence read before it is swapped into the reservoir */
+  ESL_SQ      *tmp;             /* for swapping */
+  int64_t      nres   = 0;      /* number of sequences in the reservoir */
+  off_t        start  = -1;     /* offset of first sequence read, -1 if none */
+  int64_t      i      = 0;      /* index of next sequence in the file */
+  int64_t      next;            /* index of next sequence to take */
+  double       W;               /* Algorithm L's running weight */
+  int64_t      j;               /* counter over reservoir */
+  FILE        *ofp    = NULL;   /* output file, NULL to return a string */
+  SV          *retSV  = NULL;   /* string to return */
+  char        *buf    = NULL;   /* FASTA record, if outputting to a file */
+  int64_t      nalloc = 0;      /* allocated size of buf */
+  int64_t      n;               /* length of FASTA record */
+
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
+  if(k < 1) croak("invalid number of sequences to sample %ld", k);
+
+  spare = (sqfp->do_digital) ? esl_sq_CreateDigital(sqfp->abc) : esl_sq_Create();
+  if(spare == NULL) croak("out of memory");
+
+  /* fill the reservoir, creating each entry as it is read */
+  status = eslOK;
+  while(nres < k && (status = esl_sqio_Read(sqfp, spare)) == eslOK) { 
+    if(nres == 0) start = spare->roff;
+    if(nres == ralloc) { 
+      ralloc = ESL_MIN(k, ESL_MAX(16, ralloc * 2));
+      ESL_REALLOC(resA, sizeof(BESQ_SAMPLE) * ralloc);
+    }
+    resA[nres].sq  = spare;
+    resA[nres].idx = i++;
+    nres++;
+    spare = (sqfp->do_digital) ? esl_sq_CreateDigital(sqfp->abc) : esl_sq_Create();
+    if(spare == NULL) croak("out of memory");
+  }
+
+  /* Algorithm L */
+  if(nres == k) { 
+    W    = exp(log(_c_sample_uniform_positive(r)) / k);
+    next = i + _c_sample_skip(r, W);
+    while(TRUE) { 
+      for(; i < next; i++) { 
+        esl_sq_Reuse(sq);
+        if((status = esl_sqio_ReadInfo(sqfp, sq)) != eslOK) break;
+      }
+      if(i < next) break; /* end of file, or an error, checked below */
+      esl_sq_Reuse(spare);
+      if((status = esl_sqio_Read(sqfp, spare)) != eslOK) break;
+      j = (int64_t) (esl_random(r) * k);
+      tmp = resA[j].sq; resA[j].sq = spare; spare = tmp;
+      resA[j].idx = i++;
+      W   *= exp(log(_c_sample_uniform_positive(r)) / k);
+      next = i + _c_sample_skip(r, W);
+    }
+  }
+  if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+  else if (status != eslEOF)     croak("Unexpected error %d reading sequence file %s\n", status, sqfp->filename);
+
+  /* output the sample in file order */
+  if(nres > 0) qsort(resA, nres, sizeof(BESQ_SAMPLE), _c_sample_compare);
+  retSV = newSVpvn("", 0);
+  if(outfile[0] != '\0') { 
+    if((ofp = fopen(outfile, "w")) == NULL) croak("unable to open %s for writing", outfile);
+  }
+  for(j = 0; j < nres; j++) { 
+    if(ofp != NULL) { 
+      n = _c_sq_fasta_length(resA[j].sq, textw);
+      if(n > nalloc) { 
+        nalloc = n;
+        ESL_REALLOC(buf, sizeof(char) * nalloc);
+      }
+      _c_sq_write_fasta(resA[j].sq, textw, buf);
+      if(fwrite(buf, sizeof(char), n, ofp) != n) croak("error writing to %s", outfile);
+    }
+    else { 
+      _c_sv_append_fasta(retSV, resA[j].sq, textw);
+    }
+  }
+  if(ofp != NULL && fclose(ofp) != 0) croak("error closing %s", outfile);
+
+  /* go back to where we started, if we can */
+  if(start != -1 && (! (sqfp->data.ascii.do_stdin || sqfp->data.ascii.do_gzip))) { 
+    if(esl_sqfile_Position(sqfp, start) != eslOK) croak("Failed to reposition sequence file %s", sqfp->filename);
+  }
+
+  for(j = 0; j < nres; j++) esl_sq_Destroy(resA[j].sq);
+  esl_sq_Destroy(spare);
+  if(resA != NULL) free(resA);
+  if(buf != NULL) free(buf);
+
+  return retSV;
+
+ ERROR:
   croak("out of memory");
   return NULL; /* NEVER REACHED */
 }
@@ -48,6 +48,13 @@ our $ESLEWRITE =         '27';    # write failed (fprintf, etc)
 
 our $FASTATEXTW =        '60';    # 60 characters per line in FASTA seq output
 
+# split() modes, these must be consistent with #define's in SqFile.c
+our $SPLIT_NSEQ =        '0';     # n consecutive seqs per file
+our $SPLIT_NFILES =      '1';     # n files, same number of seqs in each
+our $SPLIT_NRES =        '2';     # n files, roughly same number of residues in each
+our $SPLIT_NRES_RANDOM = '3';     # n files, roughly same number of residues in each, seqs in random order
+our $SPLIT_LPT =         '4';     # n files, residues bin packed by longest-processing-time
+
 my $src_file      = undef;
 my $typemaps      = undef;
 my $easel_src_dir = undef;
@@ -69,7 +76,7 @@ use Inline
   VERSION  => '0.01',
   ENABLE   => 'AUTOWRAP',
   INC      => "-I$easel_src_dir",
-  LIBS     => "-L$easel_src_dir -leasel",
+  LIBS     => "-L$easel_src_dir -leasel -lpthread",
   TYPEMAPS => $typemaps,
   NAME     => 'Bio::Easel::SqFile';
 
@@ -98,12 +105,16 @@ No functions currently exported.
   Incept   : EPN, Mon Feb  4 14:36:57 2013
   Usage    : Bio::Easel::SqFile->new
   Function : Generates a new Bio::Easel::SqFile object
-  Args     : <fileLocation>: file location of sequence file, <fileLocation.ssi> is index file
+  Args     : <fileLocation>: file location of sequence file, <fileLocation.ssi> is index file,
+           :                 "-" for stdin
+           : <format>:       format of the sequence file, e.g. "fasta"; required for
+           :                 stdin and gzipped files, which can't be autodetected
            : <forceDigital>: '1' to read the sequences in digital mode
            : <forceIndex>:   '1' to index the file, even if .ssi file already exists
            : <isRna>:        '1' to force RNA alphabet
            : <isDna>:        '1' to force DNA alphabet
            : <isAmino>:      '1' to force protein alphabet
+           : <nthreads>:     number of threads for indexing, see set_num_threads()
   Returns  : Bio::Easel::SqFile object
 
 =cut
@@ -132,10 +143,16 @@ sub new {
   if ( defined $args->{isAmino} ) { 
     $self->{isAmino} = $args->{isAmino};
   }
+  if ( defined $args->{nthreads} ) { 
+    $self->set_num_threads($args->{nthreads});
+  }
+  if ( defined $args->{format} ) { 
+    $self->{format} = $args->{format};
+  }
 
   # check that the file exists and it has a .ssi file associated with it.
   if(defined $args->{fileLocation}) { 
-    if(-e $args->{fileLocation}){
+    if($args->{fileLocation} eq "-" || -e $args->{fileLocation}){
       eval{
         $self->{path} = $args->{fileLocation};
         $self->open_sqfile();
@@ -205,7 +222,8 @@ sub path {
   Incept   : EPN, Mon Mar  4 11:10:33 2013
   Usage    : Bio::Easel::SqFile->open_sqfile
   Function : Opens a sequence file and its SSI index file (if no SSI file exists, it creates one)
-           : and creates a ESL_SQFILE pointer to it.
+           : and creates a ESL_SQFILE pointer to it, and a scratch ESL_SQ the fetch
+           : functions read sequences into.
   Args     : <fileLocation>: file location of sequence file, <fileLocation.ssi> is index file.
   Returns  : void
   Dies     : if unable to open sequence file
@@ -234,11 +252,18 @@ sub open_sqfile {
   if (! defined $self->{isAmino}) { 
     $self->{isAmino} = 0;
   }
+  # default is to autodetect format
+  if (! defined $self->{format}) { 
+    $self->{format} = "";
+  }
 
-  $self->{esl_sqfile} = _c_open_sqfile( $self->{path}, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino} );
+  $self->{esl_sqfile} = _c_open_sqfile( $self->{path}, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino}, $self->{format} );
 
   if ( ! defined $self->{esl_sqfile} ) { die "_c_open_sqfile returned, but esl_sqfile still undefined"; }
 
+  # scratch sequence reused by all the fetch functions
+  $self->{esl_sq} = _c_create_scratch_sq( $self->{esl_sqfile} );
+
   return;
 }
 
@@ -247,7 +272,8 @@ sub open_sqfile {
   Title    : close_sqfile
   Incept   : EPN, Thu Mar 28 10:36:06 2013
   Usage    : Bio::Easel::SqFile->close_sqfile
-  Function : Closes a sequence file and its SSI index file, and free ESL_SQFILE associated object.
+  Function : Closes a sequence file and its SSI index file, and free ESL_SQFILE associated object
+           : and scratch ESL_SQ.
            : If the file is not already open, we simply return (we do not throw an error).
   Args     : none
   Returns  : void
@@ -258,6 +284,14 @@ sub open_sqfile {
 sub close_sqfile {
   my ( $self ) = @_;
 
+  if(defined $self->{esl_sq}) { 
+    _c_destroy_sq( $self->{esl_sq} );
+    $self->{esl_sq} = undef;
+  }
+  if(defined $self->{ssi_keytab}) { 
+    _c_keytab_destroy( $self->{ssi_keytab} );
+    $self->{ssi_keytab} = undef;
+  }
   if(defined $self->{esl_sqfile}) { 
     _c_close_sqfile( $self->{esl_sqfile} );
     $self->{esl_sqfile} = undef;
@@ -310,6 +344,9 @@ sub open_ssi_index {
   Incept   : EPN, Fri Mar  8 06:09:51 2013
   Usage    : Bio::Easel::SqFile->create_ssi_index
   Function : Creates an SSI file for a given sequence file.
+           : Large FASTA files are indexed in parallel with
+           : set_num_threads() threads, the index is the same
+           : regardless of the number of threads.
   Args     : None
   Returns  : void
   Dies     : if SSI index creation fails, via croak in _c_create_ssi_index()
@@ -323,11 +360,51 @@ sub create_ssi_index {
   if ( ! defined $self->{path} )                       { die "trying to create SSI file but path is not set"; }
   if ( ! defined $self->{esl_sqfile} )                 { die "trying to open SSI for non-open sqfile"; }
 
-  _c_create_ssi_index( $self->{esl_sqfile} ); # this C function calls 'croak' if there's an error
+  _c_create_ssi_index( $self->{esl_sqfile}, $self->get_num_threads() ); # this C function calls 'croak' if there's an error
+
+  return;
+}
+
+=head2 set_num_threads
+
+  Title    : set_num_threads
+  Usage    : $sqfile->set_num_threads($n)
+  Function : Set the number of threads used by create_ssi_index().
+           : Only plain (not gzipped) FASTA files of at least a few 
+           : megabytes are indexed in parallel. Default is 1.
+  Args     : $n: number of threads, must be >= 1
+  Returns  : void
+  Dies     : if $n is not a positive integer, with croak
+
+=cut
+
+sub set_num_threads {
+  my ( $self, $n ) = @_;
+
+  if(! defined $n || $n !~ m/^\d+$/ || $n < 1) { 
+    croak "set_num_threads(): number of threads must be a positive integer";
+  }
+  $self->{nthreads} = $n;
 
   return;
 }
 
+=head2 get_num_threads
+
+  Title    : get_num_threads
+  Usage    : $n = $sqfile->get_num_threads()
+  Function : Return the number of threads set by set_num_threads().
+  Args     : None
+  Returns  : number of threads, 1 if never set
+
+=cut
+
+sub get_num_threads {
+  my ( $self ) = @_;
+
+  return ( defined $self->{nthreads} ) ? $self->{nthreads} : 1;
+}
+
 =head2 fetch_seqs_given_names
 
   Title    : fetch_seqs_given_names
@@ -337,35 +414,35 @@ sub create_ssi_index {
            : sequence file and either return them as a string (if 
            : $outfile is !defined) or output them to a new FASTA file 
            : called $outfile (if defined).
-  Args     : $seqnameAR: ref to array of seqnames to fetch
-           : $textw:     width of FASTA seq lines, usually $FASTATEXTW, -1 for unlimited
-           : $outfile:   OPTIONAL; name of output FASTA file to create
+           : All sequences are fetched in a single C call that
+           : reads the file in order of the sequences' positions in
+           : it. By default they are still output in the order of
+           : $seqnameAR: the names are taken in windows of about
+           : 64Mb of output, each read in file order and buffered
+           : before it is output, so at most one window is held in
+           : memory. Pass $in_file_order as '1' to output them in 
+           : the order they occur in the file instead, which reads
+           : the whole list in file order and buffers nothing.
+  Args     : $seqnameAR:     ref to array of seqnames to fetch
+           : $textw:         width of FASTA seq lines, usually $FASTATEXTW, -1 for unlimited
+           : $outfile:       OPTIONAL; name of output FASTA file to create
+           : $in_file_order: OPTIONAL; '1' to output seqs in the order they occur in the file
   Returns  : if $outfile is defined: "" (empty string)
              else                  : string of all concatenated seqs
-  Dies     : if unable to open sequence file
+  Dies     : if unable to open sequence file, or a sequence does not exist
 
 =cut
 
 sub fetch_seqs_given_names { 
-  my ( $self, $seqnameAR, $textw, $outfile ) = @_;
+  my ( $self, $seqnameAR, $textw, $outfile, $in_file_order ) = @_;
 
   $self->_check_sqfile();
   $self->_check_ssi();    # fetching sequences by name requires SSI index
 
-  my $retstring = "";
-  if(defined $outfile) { 
-    open(OUT, '>', $outfile) || die "ERROR unable to open $outfile for writing";
-  }
+  if(! defined $in_file_order) { $in_file_order = 0; }
 
-  my ($seqname, $seqstring);
-  foreach $seqname (@{$seqnameAR}) { 
-    $seqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, $textw); 
-    if(defined $outfile) { print OUT $seqstring; }
-    else                 { $retstring .= $seqstring; }
-  }
-  if(defined $outfile) { close(OUT); }
-  
-  return $retstring; # this will be "" if $outfile is defined, else it is all fetched seqs concatenated
+  # this will be "" if $outfile is defined, else it is all fetched seqs concatenated
+  return _c_fetch_seqs_batch($self->{esl_sqfile}, $self->{esl_sq}, $seqnameAR, $textw, (defined $outfile) ? $outfile : "", $in_file_order);
 }
 
 =head2 fetch_consecutive_seqs
@@ -407,10 +484,10 @@ sub fetch_consecutive_seqs {
   for($i = 1; $i <= $n; $i++) { 
     # we fetch first seq in special way if $startname ne ""
     if($i == 1 && $startname ne "") { 
-      $seqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $startname, $textw); 
+      $seqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $self->{esl_sq}, $startname, $textw); 
     }
     else { 
-      $seqstring = _c_fetch_next_seq_to_fasta_string($self->{esl_sqfile}, $textw); 
+      $seqstring = _c_fetch_next_seq_to_fasta_string($self->{esl_sqfile}, $self->{esl_sq}, $textw); 
     }
     if(defined $outfile) { print OUT $seqstring; }
     else                 { $retstring .= $seqstring; }
@@ -466,7 +543,7 @@ sub fetch_seq_to_fasta_string {
 
   if(! defined $textw) { $textw = $FASTATEXTW; }
 
-  return _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, $textw); 
+  return _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $self->{esl_sq}, $seqname, $textw); 
 }
 
 =head2 fetch_seq_to_sqstring
@@ -488,7 +565,7 @@ sub fetch_seq_to_sqstring {
   $self->_check_sqfile();
   $self->_check_ssi();
 
-  my $sqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, -1);
+  my $sqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $self->{esl_sq}, $seqname, -1);
   
   # remove the header line 
   $sqstring =~ s/^\>\S+.*\n//;
@@ -517,7 +594,7 @@ sub fetch_next_seq_to_sqstring {
   $self->_check_sqfile();
   $self->_check_ssi();
 
-  my $sqstring = _c_fetch_next_seq_to_fasta_string($self->{esl_sqfile}, -1);
+  my $sqstring = _c_fetch_next_seq_to_fasta_string($self->{esl_sqfile}, $self->{esl_sq}, -1);
   
   # remove the header line 
   $sqstring =~ s/^\>\S+.*\n//;
@@ -534,12 +611,13 @@ sub fetch_next_seq_to_sqstring {
   Usage    : Bio::Easel::SqFile->fetch_next_seq_name_length
   Function : Fetches the next sequence from a sequence file 
            : and returns its name and length (WITHOUT the actual sequence)
+           : The sequence's residues are never read, see next_name_length().
   Args     : none
   Returns  : Two values:
            : name: string, the name of the next sequence (no desc)
            : length: length of the next sequence
-  Dies     : upon error in _c_fetch_next_seq_to_fasta_string(), with C croak() call
-           : upon error parsing fasta string returned from _c_fetch_next_seq_to_fasta_string
+  Dies     : upon error in _c_next_name_length(), with C croak() call
+           : if there are no more sequences in the file
 =cut
 
 sub fetch_next_seq_name_length {
@@ -548,25 +626,61 @@ sub fetch_next_seq_name_length {
   $self->_check_sqfile();
   $self->_check_ssi();
 
-  my $sqstring = _c_fetch_next_seq_to_fasta_string($self->{esl_sqfile}, -1);
-  
-  my $name = undef;
-  if($sqstring =~ /^\>(\S+).*\n/) { 
-    $name = $1; 
+  my ($name, $len) = _c_next_name_length($self->{esl_sqfile}, $self->{esl_sq});
+  if(! defined $name) { 
+    die "unexpected EOF reading sequence file $self->{path}"; 
   }
-  else { 
-    die "unable to parse fetched fasta sequence:\n$sqstring"; 
-  }
-
-  # remove the header line 
-  $sqstring =~ s/^\>\S+.*\n//;
-  # remove the new line
-  chomp $sqstring;
-  my $len = length($sqstring);
 
   return ($name, $len);
 }
 
+=head2 next_name_length
+
+  Title    : next_name_length
+  Usage    : while(my ($name, $len) = $sqfile->next_name_length()) { }
+  Function : Read the name and length of the next sequence in 
+           : the file without reading its residues, using
+           : esl_sqio_ReadInfo(). Does not require an SSI index
+           : and works on any readable sequence file.
+  Args     : none
+  Returns  : Two values, name and length of the next sequence,
+           : or an empty list if there are no more sequences.
+  Dies     : upon error in _c_next_name_length(), with C croak() call
+
+=cut
+
+sub next_name_length {
+  my ( $self ) = @_;
+
+  $self->_check_sqfile();
+
+  return _c_next_name_length($self->{esl_sqfile}, $self->{esl_sq});
+}
+
+=head2 all_names_lengths
+
+  Title    : all_names_lengths
+  Usage    : ($nameAR, $lenAR) = $sqfile->all_names_lengths()
+  Function : Read the names and lengths of all sequences in 
+           : the file, in file order, in a single scan that never
+           : reads residues (esl_sqio_ReadInfo()). The file is
+           : rewound before and after the scan.
+  Args     : none
+  Returns  : Two values: ref to array of names and ref to 
+           : array of lengths.
+  Dies     : upon error in _c_all_names_lengths(), with C croak() call,
+           : including if the file can't be rewound (stdin or gzipped)
+
+=cut
+
+sub all_names_lengths {
+  my ( $self ) = @_;
+
+  $self->_check_sqfile();
+
+  return _c_all_names_lengths($self->{esl_sqfile}, $self->{esl_sq});
+}
+
 =head2 fetch_seq_to_fasta_string_given_ssi_number
 
   Title    : fetch_seq_to_fasta_string_given_ssi_number
@@ -588,7 +702,7 @@ sub fetch_seq_to_fasta_string_given_ssi_number {
 
   if(! defined $textw) { $textw = $FASTATEXTW; }
 
-  return _c_fetch_seq_to_fasta_string_given_ssi_number($self->{esl_sqfile}, $num, $textw); 
+  return _c_fetch_seq_to_fasta_string_given_ssi_number($self->{esl_sqfile}, $self->{esl_sq}, $num, $textw); 
 }
 
 =head2 fetch_subseqs
@@ -614,41 +728,41 @@ sub fetch_seq_to_fasta_string_given_ssi_number {
            : $end == 0, the sequence will be fetched all the way until
            : the end. If $start > $end and $end != 0, we will reverse
            : complement the subsequence before passing it back.
-  Args     : $AAR    : ref to 2D array with subsequence new names, start, ends, and source names
-           : $textw  : width of FASTA seq lines, usually $FASTATEXTW, -1 for unlimited
-           : $outfile: OPTIONAL; name of output FASTA file to create
+           :
+           : All subsequences are fetched in a single C call that
+           : groups them by source sequence and coordinate, and reads
+           : each region of a source sequence needed by one or more
+           : overlapping subsequences only once. By default they are
+           : still output in the order of $AAR: the subsequences are
+           : taken in windows of about 64Mb of output, each read in
+           : file and coordinate order and buffered before it is 
+           : output, so at most one window is held in memory, and
+           : regions are only shared within a window. Pass 
+           : $in_file_order as '1' to output them in order of source
+           : sequence position in the file and then coordinate 
+           : instead, which writes each one straight to $outfile 
+           : without buffering.
+  Args     : $AAR          : ref to 2D array with subsequence new names, start, ends, and source names
+           : $textw        : width of FASTA seq lines, usually $FASTATEXTW, -1 for unlimited
+           : $outfile      : OPTIONAL; name of output FASTA file to create
+           : $in_file_order: OPTIONAL; '1' to output subseqs in file and coordinate order
   Returns  : if $outfile is !defined: string of all concatenated subseqs
            : else                   : "" (empty string)
-  Dies     : if unable to open sequence file
+  Dies     : if unable to open sequence file, or a subsequence can't be fetched
 
 =cut
 
 sub fetch_subseqs { 
-  my ( $self, $AAR, $textw, $outfile ) = @_;
+  my ( $self, $AAR, $textw, $outfile, $in_file_order ) = @_;
 
   $self->_check_sqfile();
   $self->_check_ssi();    # fetching sequences by name requires SSI index
 
-  my $retstring = "";
-  if(defined $outfile) { 
-    open(OUT, ">" . $outfile) || die "ERROR unable to open $outfile for writing";
-  }
-  
-  if(! defined $textw) { $textw = $FASTATEXTW; }
+  if(! defined $textw)         { $textw = $FASTATEXTW; }
+  if(! defined $in_file_order) { $in_file_order = 0; }
 
-  my ($i, $seqname, $start, $end, $newname, $nseq, $listsize, $seqstring);
-  $nseq = scalar(@{$AAR});
-  for($i = 0; $i < $nseq; $i++) { 
-    $listsize = scalar(@{$AAR->[$i]});
-    if($listsize < 4) { die "ERROR fetch_subseqs, array too small (< 4 elements)"; }
-    ($newname, $start, $end, $seqname) = ($AAR->[$i][0], $AAR->[$i][1], $AAR->[$i][2], $AAR->[$i][3]);
-    $seqstring = _c_fetch_subseq_to_fasta_string($self->{esl_sqfile}, $seqname, $newname, $start, $end, $textw, 0); 
-    if(defined $outfile) { print OUT $seqstring; }
-    else                 { $retstring .= $seqstring; }
-  }
-  if(defined $outfile) { close(OUT); }
-  
-  return $retstring; # this will be "" if $outfile is defined, else it is all fetched subseqs concatenated
+  # this will be "" if $outfile is defined, else it is all fetched subseqs concatenated
+  return _c_fetch_subseqs_batch($self->{esl_sqfile}, $self->{esl_sq}, $AAR, $textw, (defined $outfile) ? $outfile : "", $in_file_order);
 }
 
 =head2 fetch_subseq_to_fasta_string
@@ -736,28 +850,17 @@ sub fetch_subseq_to_sqstring {
   Returns  : List of values:
            : 1st value: name of sequence <$num> in index
            : 2nd value  length of sequence <$num> in index
-  Dies     : upon error in _c_fetch_seq_name_and_length_given_ssi_number() with C croak() call
+  Dies     : upon error in _c_keytab_name() or _c_keytab_length() with C croak() call,
+           : including if there are not $num sequences in the SSI index.
 
 =cut
   
 sub fetch_seq_name_and_length_given_ssi_number {
   my ( $self, $num ) = @_;
 
-  $self->_check_sqfile();
-  $self->_check_ssi();
+  $self->_check_keytab();
   
-  my $seqname_and_L = _c_fetch_seq_name_and_length_given_ssi_number($self->{esl_sqfile}, $num);
-  # remove " " . $L;
-  my ($seqname, $L);
-  if($seqname_and_L =~ /^(\S+) (\d+)$/) { 
-    ($seqname, $L) = ($1, $2);
-    # printf STDERR ("seqname: $seqname L: $L\n");
-  }
-  else { 
-    die "ERROR _c_fetch_seq_name_and_length_given_ssi_number() returned unexpected string: $seqname_and_L"; 
-  }
-
-  return ($seqname, $L);
+  return (_c_keytab_name($self->{ssi_keytab}, $num), _c_keytab_length($self->{ssi_keytab}, $num));
 }
 
 =head2 fetch_seq_name_given_ssi_number
@@ -771,20 +874,16 @@ sub fetch_seq_name_and_length_given_ssi_number {
            : appears in the sequence file.
   Args     : $num: index in SSI file
   Returns  : string, the primary key (seq name) of sequence <$num> in the SSI index
-  Dies     : upon error in _c_fetch_seq_name_and_length_given_ssi_number() with C croak() call
+  Dies     : upon error in _c_keytab_name() with C croak() call
 
 =cut
     
 sub fetch_seq_name_given_ssi_number {
   my ( $self, $num ) = @_;
 
-  $self->_check_sqfile();
-  $self->_check_ssi();
+  $self->_check_keytab();
   
-  my $seqname; 
-  ($seqname, undef) = $self->fetch_seq_name_and_length_given_ssi_number($num);
-
-  return $seqname;
+  return _c_keytab_name($self->{ssi_keytab}, $num);
 }
 
 =head2 fetch_seq_length_given_ssi_number
@@ -798,20 +897,16 @@ sub fetch_seq_name_given_ssi_number {
            : appears in the sequence file.
   Args     : $num: index in SSI file
   Returns  : the length of of sequence <$num> in the SSI index, 0 if lengths are unset
-  Dies     : upon error in _c_fetch_seq_name_and_length_given_ssi_number() with C croak() call
+  Dies     : upon error in _c_keytab_length() with C croak() call
            : including if there are not $num sequences in the SSI index.
 =cut
     
 sub fetch_seq_length_given_ssi_number {
   my ( $self, $num ) = @_;
 
-  $self->_check_sqfile();
-  $self->_check_ssi();
+  $self->_check_keytab();
   
-  my $L;
-  (undef, $L) = $self->fetch_seq_name_and_length_given_ssi_number($num);
-
-  return $L;
+  return _c_keytab_length($self->{ssi_keytab}, $num);
 }
 
 =head2 fetch_seq_length_given_name
@@ -988,20 +1083,218 @@ sub nseq_ssi {
            : using its SSI index.
   Args     : NONE
   Returns  : number of residues in the file.
-  Dies     : upon error in _c_nres_ssi with C croak() call
+  Dies     : upon error in _c_keytab_create() with C croak() call
 
 =cut
     
 sub nres_ssi { 
   my ( $self ) = @_;
 
-  $self->_check_sqfile();
-  $self->_check_ssi();
+  $self->_check_keytab();
   
-  my $Lstr; # _c_nres_ssi returns length as a string, so as not to overflow a 32-bit int
-  $Lstr = _c_nres_ssi($self->{esl_sqfile});
+  # _c_keytab_nres returns length as a string, so as not to overflow a 32-bit int
+  return _c_keytab_nres($self->{ssi_keytab});
+}
+
+=head2 ssi_lengths
+
+  Title    : ssi_lengths
+  Usage    : Bio::Easel::SqFile->ssi_lengths($ret_type)
+  Function : Return the lengths of all sequences in the file, in
+           : SSI index order (the order used by the *_given_ssi_number()
+           : functions), from the cached SSI key table.
+  Args     : $ret_type: OPTIONAL: "list" (default) for a list of lengths,
+           :            "packed" for a single string of native int64s
+           :            (unpack with "q*")
+  Returns  : list of lengths, or string of packed lengths
+  Dies     : if $ret_type is invalid
+
+=cut
+    
+sub ssi_lengths { 
+  my ( $self, $ret_type ) = @_;
+
+  $self->_check_keytab();
+
+  my $packed = _c_keytab_lengths_packed($self->{ssi_keytab});
+  if(defined $ret_type && $ret_type eq "packed") { return $packed; }
+  if(defined $ret_type && $ret_type ne "list")   { croak "invalid return type $ret_type, must be \"list\" or \"packed\""; }
+
+  return unpack("q*", $packed);
+}
+
+=head2 ssi_length_order
+
+  Title    : ssi_length_order
+  Usage    : Bio::Easel::SqFile->ssi_length_order($ret_type)
+  Function : Return SSI index numbers of all sequences sorted by
+           : decreasing sequence length (ties broken by SSI index),
+           : from the cached SSI key table. Useful for planning
+           : how to split a file without any per-sequence lookups.
+  Args     : $ret_type: OPTIONAL: "list" (default) for a list of indices,
+           :            "packed" for a single string of native int64s
+           :            (unpack with "q*")
+  Returns  : list of SSI indices, or string of packed SSI indices
+  Dies     : if $ret_type is invalid
+
+=cut
+    
+sub ssi_length_order { 
+  my ( $self, $ret_type ) = @_;
+
+  $self->_check_keytab();
+
+  my $packed = _c_keytab_length_order_packed($self->{ssi_keytab});
+  if(defined $ret_type && $ret_type eq "packed") { return $packed; }
+  if(defined $ret_type && $ret_type ne "list")   { croak "invalid return type $ret_type, must be \"list\" or \"packed\""; }
+
+  return unpack("q*", $packed);
+}
+
+=head2 split
+
+  Title    : split
+  Usage    : $fileAR = $sqfile->split($outroot, $n, $do_nfiles, $do_nres, $do_randomize, $seed, $do_binpack)
+  Function : Split the sequence file into smaller files named
+           : $outroot.1, $outroot.2, ..., the way esl-ssplit.pl 
+           : does. By default each file gets $n consecutive 
+           : sequences. With $do_nfiles, $n files are created with
+           : the same number of sequences in each, adding $do_nres
+           : gives them roughly the same number of residues instead,
+           : and adding $do_randomize sends each sequence to a 
+           : randomly chosen file, using the same random numbers as
+           : Bio::Easel::Random seeded with $seed. $do_binpack 
+           : (with $do_nfiles) instead assigns sequences to the $n
+           : files by longest-processing-time bin packing: longest
+           : sequence first, each to the file with the fewest
+           : residues so far. This minimizes the maximum number of
+           : residues in a file much better than $do_nres when a 
+           : few sequences are very long. Sequences stay in file
+           : order within each output file.
+           :
+           : Done in C, in one streaming pass over the file after a
+           : pass to get sequence lengths. If an SSI index already
+           : exists it is used instead of the first pass, but one
+           : is never created. FASTA records are copied unchanged,
+           : other formats are output as FASTA with unwrapped 
+           : sequences. 
+  Args     : $outroot:      root for output file names, undef for the sequence file's path
+           : $n:            number of seqs per file, or number of files if $do_nfiles
+           : $do_nfiles:    OPTIONAL: '1' if $n is the number of files (esl-ssplit.pl -n)
+           : $do_nres:      OPTIONAL: '1' to balance residues, requires $do_nfiles (-r)
+           : $do_randomize: OPTIONAL: '1' to randomize, requires $do_nres (-z)
+           : $seed:         OPTIONAL: RNG seed if $do_randomize, default 1801
+           : $do_binpack:   OPTIONAL: '1' to bin pack residues, requires $do_nfiles,
+           :                incompatible with $do_nres (esl-ssplit.pl -b)
+  Returns  : ref to array with one element per output file, a ref to 
+           : [file name, number of seqs, number of residues]
+  Dies     : if arguments are invalid, the file is gzipped or stdin, 
+           : or upon error in _c_split(), with croak
 
-  return $Lstr;
+=cut
+
+sub split { 
+  my ( $self, $outroot, $n, $do_nfiles, $do_nres, $do_randomize, $seed, $do_binpack ) = @_;
+
+  $self->_check_sqfile();
+
+  if(! defined $outroot)      { $outroot      = $self->{path}; }
+  if(! defined $do_nfiles)    { $do_nfiles    = 0; }
+  if(! defined $do_nres)      { $do_nres      = 0; }
+  if(! defined $do_randomize) { $do_randomize = 0; }
+  if(! defined $seed)         { $seed         = 1801; }
+  if(! defined $do_binpack)   { $do_binpack   = 0; }
+  if(! defined $n || $n !~ m/^\d+$/ || $n < 1) { croak "split(): number of seqs or files must be a positive integer"; }
+  if($do_nres      && (! $do_nfiles)) { croak "split(): do_nres requires do_nfiles"; }
+  if($do_randomize && (! $do_nres))   { croak "split(): do_randomize requires do_nres"; }
+  if($do_binpack   && (! $do_nfiles)) { croak "split(): do_binpack requires do_nfiles"; }
+  if($do_binpack   && $do_nres)       { croak "split(): do_binpack and do_nres are incompatible"; }
+
+  my $mode = $SPLIT_NSEQ;
+  if   ($do_binpack)   { $mode = $SPLIT_LPT; }
+  elsif($do_randomize) { $mode = $SPLIT_NRES_RANDOM; }
+  elsif($do_nres)      { $mode = $SPLIT_NRES; }
+  elsif($do_nfiles)    { $mode = $SPLIT_NFILES; }
+
+  # use the SSI key table if there's already an index, but don't create one
+  my $keytab = undef;
+  if((defined $self->{has_ssi} && $self->{has_ssi}) || -e $self->{path} . ".ssi") { 
+    $self->_check_keytab();
+    $keytab = $self->{ssi_keytab};
+  }
+
+  return _c_split($self->{esl_sqfile}, $self->{esl_sq}, $keytab, $outroot, $n, $mode, $seed);
+}
+
+=head2 split_by_bytes
+
+  Title    : split_by_bytes
+  Usage    : $fileAR = $sqfile->split_by_bytes($outroot, $n)
+  Function : Split a FASTA file into $n files named $outroot.1,
+           : $outroot.2, ... of roughly equal size in bytes, without
+           : parsing it: the file is cut at evenly spaced byte 
+           : offsets, each moved forward to the next line starting
+           : with '>', and the byte ranges are copied unchanged. 
+           : Much faster than split() for big files, but files only
+           : get roughly the same number of bytes, not sequences or
+           : residues. Fewer than $n files are created if two cuts
+           : land in the same sequence.
+  Args     : $outroot: root for output file names, undef for the sequence file's path
+           : $n:       number of files
+  Returns  : ref to array with one element per output file, a ref to 
+           : [file name, number of bytes]
+  Dies     : if $n is invalid, the file is not FASTA, or is gzipped
+           : or stdin, or upon error in _c_split_bytes(), with croak
+
+=cut
+
+sub split_by_bytes { 
+  my ( $self, $outroot, $n ) = @_;
+
+  $self->_check_sqfile();
+
+  if(! defined $outroot) { $outroot = $self->{path}; }
+  if(! defined $n || $n !~ m/^\d+$/ || $n < 1) { croak "split_by_bytes(): number of files must be a positive integer"; }
+
+  return _c_split_bytes($self->{esl_sqfile}, $outroot, $n);
+}
+
+=head2 sample_seqs
+
+  Title    : sample_seqs
+  Usage    : $seqstring = $sqfile->sample_seqs($k, $rng, $outfile, $textw)
+  Function : Sample $k sequences uniformly at random from the rest of
+           : the file in a single pass with reservoir sampling, and
+           : output them in file order, in FASTA format, to $outfile
+           : or a returned string. At most $k sequences are held in 
+           : memory at once and no SSI index is used, so this works
+           : on stdin and gzipped files, which are left at their end
+           : afterwards; other files are positioned back at the first
+           : sequence sampled from, so a second call samples from the
+           : same sequences. If the file has $k or fewer sequences,
+           : all of them are output. The sample is determined by the
+           : seed of $rng.
+  Args     : $k:       number of sequences to sample
+           : $rng:     Bio::Easel::Random object
+           : $outfile: name of output file, undef to return a string
+           : $textw:   width of sequence lines, -1 for unlimited,
+           :           undef for default of 60
+  Returns  : string of sampled sequences in FASTA format, "" if $outfile is defined
+  Dies     : if $k or $rng is invalid, or upon error in _c_sample_seqs(), with croak
+
+=cut
+
+sub sample_seqs { 
+  my ( $self, $k, $rng, $outfile, $textw ) = @_;
+
+  $self->_check_sqfile();
+
+  if(! defined $k || $k !~ m/^\d+$/ || $k < 1) { croak "sample_seqs(): number of sequences must be a positive integer"; }
+  if(! defined $rng) { croak "sample_seqs(): Bio::Easel::Random object undefined"; }
+  if(! defined $outfile) { $outfile = ""; }
+  if(! defined $textw)   { $textw = $FASTATEXTW; }
+
+  return _c_sample_seqs($self->{esl_sqfile}, $self->{esl_sq}, $k, $rng->randomness(), $textw, $outfile);
 }
 
 =head2 DESTROY
@@ -1081,6 +1374,30 @@ sub _check_ssi {
   return;
 }
 
+=head2 _check_keytab
+
+  Title    : _check_keytab
+  Usage    : Bio::Easel::SqFile->_check_keytab()
+  Function : Loads the SSI primary key table (names, offsets and
+             lengths) into memory if it's not already loaded, 
+             opening or creating the SSI index if necessary. The 
+             table is freed by close_sqfile().
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub _check_keytab {
+  my ($self) = @_;
+
+  $self->_check_ssi();
+
+  if(! defined $self->{ssi_keytab}) { 
+    $self->{ssi_keytab} = _c_keytab_create($self->{esl_sqfile});
+  }
+  return;
+}
+
 =head2 dl_load_flags
 
 =head1 AUTHORS
@@ -58,10 +58,11 @@ printf("%-30s  %5s  %5s  %5s  %6s  %6s  description\n",
        "#seqname", "rfpos", "sqpos", "apos", "rfchar", "sqchar");
 
 my $nseq = $msa->nseq; 
+my $asqstring_AR = $msa->get_all_sqstrings_aligned();
 # for each sequence, go through each position and output differences with RF
 for(my $i = 0; $i < $nseq; $i++) { 
   my $seq_name = $msa->get_sqname($i);
-  my $asqstring = $msa->get_sqstring_aligned($i);
+  my $asqstring = $asqstring_AR->[$i];
   my @asqstring_A = split("", $asqstring);
   my $rfpos = 0;
   my $sqpos = 0;
@@ -96,11 +96,12 @@ for($apos = 0; $apos < $alen; $apos++) {
 }
 
 my $tot_nseq = 0.; # this will probably be equal to $nseq, but maybe not if $use_weights is TRUE and we have funky weights
+my $sqstrAR  = ($do_pp) ? undef : $msa->get_all_sqstrings_aligned();
 
 for(my $i = 0; $i < $nseq; $i++) { 
   my $ppstr = ($do_pp) ? $msa->get_ppstring_aligned($i) : undef;
   my @ppA   = ($do_pp) ? split("", $ppstr)              : ();
-  my $sqstr = ($do_pp) ? undef : $msa->get_sqstring_aligned($i);
+  my $sqstr = ($do_pp) ? undef : $sqstrAR->[$i];
   my @sqA   = ($do_pp) ? ()    : split("", $sqstr);
   my $seqwt = $use_weights ? $msa->get_sqwgt($i) : 1.0;
   $tot_nseq += $seqwt;
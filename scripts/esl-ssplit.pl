@@ -3,17 +3,15 @@
 # esl-ssplit.pl: split up an input sequence file into smaller files.
 # EPN, Fri Jan 17 14:38:43 2014
 # 
-# This script uses BioEasel's SqFile module and will create a .ssi
-# index file of the input fasta file and then delete it. It would be
-# possible to modify the script to not require an .ssi file (and
-# instead do 2 passes through the input file) but it would require
-# adding code to the SqFile module for a probably negligible
-# improvement in speed.
+# This script uses BioEasel's SqFile module's split() method, which
+# does all the work in C: one pass through the input file to get
+# sequence lengths (skipped if a .ssi index file already exists) and
+# one pass to copy each sequence to its output file. No .ssi index
+# file is created.
 
 use strict;
 use Getopt::Long;
 use Bio::Easel::SqFile;
-use Bio::Easel::Random;
 
 my $version      = "0.16";
 my $date        = "Dec 2022";
@@ -25,8 +23,10 @@ my $do_nfiles    = 0;     # set to 1 if -n, output a specified number of files
 my $nfiles       = 0;     # number of output files, irrelevant unless -n is used
 my $do_nres      = 0;     # set to 1 if -r, output files so they have roughly same # of residues
 my $do_randomize = 0;     # set to 1 if -z, output in random order
+my $do_binpack   = 0;     # set to 1 if -b, bin pack residues into files, longest sequences first
+my $do_bytes     = 0;     # set to 1 if -bytes, split into files of roughly equal size in bytes, without parsing
 my $do_verbose   = 0;     # set to 1 if -v, output some extra info to stdout
-my $do_dirty     = 0;     # 'dirty' mode, don't clean up (e.g. .ssi file).
+my $do_dirty     = 0;     # 'dirty' mode, no longer has any effect, no temporary files are created
 my $outfile_root = undef; # root for name of output file, default is $in_sqfile, changed if -oroot used
 my $outfile_dir  = undef; # dir for output files, pwd unless -odir is used   
 my $seed         = 1801;  # seed for RNG
@@ -36,6 +36,8 @@ my $seed         = 1801;  # seed for RNG
              "n"       => \$do_nfiles, 
              "r"       => \$do_nres,
              "z"       => \$do_randomize, 
+             "b"       => \$do_binpack,
+             "bytes"   => \$do_bytes,
              "s=s"     => \$seed,
              "v"       => \$do_verbose, 
              "d"       => \$do_dirty);
@@ -51,8 +53,10 @@ $usage .= "\t\t-n        : 2nd cmd line arg specifies number of output files, no
 $usage .= "\t\t-r        : requires -n, split sequences so roughly same number of residues are in each output file\n";
 $usage .= "\t\t-z        : requires -r and -n, randomize sequence order when outputting\n";
 $usage .= "\t\t-s <n>    : requires -z, -r and -n, seed random number generator with <n> [1801]\n";
+$usage .= "\t\t-b        : requires -n, incompatible with -r, split so the max number of residues in any file\n\t\t\t    is minimized (longest sequences first, each to the file with fewest residues)\n";
+$usage .= "\t\t-bytes    : requires -n, incompatible with -r, -z and -b, FASTA only: split into files of roughly\n\t\t\t    equal size in bytes, cutting at sequence starts, without parsing the file (fastest)\n";
 $usage .= "\t\t-v        : be verbose with output to stdout, default is to output nothing to stdout\n";
-$usage .= "\t\t-d        : dirty mode: leave temporary files on disk (e.g. .ssi index file)\n";
+$usage .= "\t\t-d        : dirty mode: no effect, kept for backwards compatibility (no temporary files are created)\n";
 $usage .= "\t\t-oroot <s>: name output files <s> with integer suffix, default is to use input seq file name\n";
 $usage .= "\t\t-odir  <s>: output files go into dir <s>, default is pwd\n";
 $usage .= "\n";
@@ -65,6 +69,8 @@ $usage .= "\t\t'esl-ssplit.pl -n -r input.fa 10':\n";
 $usage .= "\t\t\tsplit input.fa into 10 files with roughly same number of residues/nucleotides\n\t\t\tper file; creates files input.fa.1 .. input.fa.10\n\n";
 $usage .= "\t\t'esl-ssplit.pl -n -r -z input.fa 10':\n";
 $usage .= "\t\t\t*randomize order of sequences* and split input.fa into 10 files with roughly same\n\t\t\tnumber of residues/nucleotides per file; creates files: input.fa.1 .. input.fa.10\n\n";
+$usage .= "\t\t'esl-ssplit.pl -n -b input.fa 10':\n";
+$usage .= "\t\t\tsplit input.fa into 10 files with as close to the same number of residues/nucleotides\n\t\t\tas possible, even if a few sequences are very long; creates files input.fa.1 .. input.fa.10\n\n";
 $usage .= "\tNOTE: unless -z is used, sequences will be output in the order they appear in the input file\n";
 
 if(scalar(@ARGV) != 2) { die $usage; }
@@ -83,6 +89,17 @@ if($do_nres && (! $do_nfiles)) { die "ERROR -r only works in combination with -n
 # make sure -r was used if -z used
 if($do_randomize && (! $do_nres)) { die "ERROR -z only works in combination with -r"; }
 
+# make sure -n was used and -r was not if -b used
+if($do_binpack && (! $do_nfiles)) { die "ERROR -b only works in combination with -n"; }
+if($do_binpack && $do_nres)       { die "ERROR -b and -r are incompatible"; }
+
+# make sure -n was used and -r, -z and -b were not if -bytes used
+if($do_bytes && (! $do_nfiles)) { die "ERROR -bytes only works in combination with -n"; }
+if($do_bytes && ($do_nres || $do_randomize || $do_binpack)) { die "ERROR -bytes is incompatible with -r, -z and -b"; }
+
+# if -b was used make sure $nseq_per (which will become $nfiles) is at most 500, all files are open at once
+if($do_binpack && ($nseq_per > 500)) { die "ERROR, with -b, 2nd cmdline arg (# new files) must be <= 500"; }
+
 # if -z was used make sure $nseq_per (which will become $nfiles) is at most 500
 if($do_randomize && ($nseq_per > 500)) { die "ERROR, with -z, 2nd cmdline arg (# new files) must be <= 500"; }
 
@@ -95,14 +112,7 @@ if(defined $outfile_dir) {
   $outfile_root = $outfile_dir . $outfile_root;
 }
 
-# determine if we should remove .ssi file we're about to create at end of script, we do remove unless in dirty mode or .ssi file already exists.
-my $cleanup_ssi = 1;
-if($do_dirty || (-e $in_sqfile . ".ssi")) { $cleanup_ssi = 0; }
-
 # initialize
-my $fctr = 1;
-my $sctr = 0;
-my $cur_file = $outfile_root . "." . $fctr;
 if($do_nfiles) { 
   $nfiles = $nseq_per; 
   $nseq_per = 0; 
@@ -112,181 +122,33 @@ if($do_nfiles) {
 # open file 
 my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $in_sqfile });
 
-# determine number of sequences or residues to output to each file, if nec
-my $tot_nseq = $sqfile->nseq_ssi(); # this will create the .ssi index if necessary
-my $tot_nres = 0; # we only need to know this if -r set at cmdline ($do_nres will be TRUE)
-my $nres_per = 0; # we only need to know this if -r set at cmdline ($do_nres will be TRUE)
-if($do_nfiles) { 
-  $nseq_per = int($tot_nseq / $nfiles); 
-  if($tot_nseq % $nfiles != 0) { $nseq_per++; }
-}
-if($do_nres) { 
-  $tot_nres = $sqfile->nres_ssi();
-  if($tot_nres == 0) { die "ERROR 0 residues read in sequence file."; }
-  $nres_per = int($tot_nres / $nfiles);
-  if($tot_nres % $nfiles != 0) { $nres_per++; }
-}
-
-# if $do_randomize, create RNG
-my $rng = undef;
-if($do_randomize) { 
-  $rng = Bio::Easel::Random->new({ seed => $seed });
-}
-
-# do the work, fetch and output sequences to new files
-my $nseq_remaining = $tot_nseq;
-my $cur_nseq = 0;
-my $cur_nres = 0;
-if(! $do_nres) { 
-  # simple case: fetch and output $nseq_per seqs at a time
-  while($nseq_remaining > 0) { 
-    my $cur_file = $outfile_root. "." . $fctr;
-    $fctr++;
-    $cur_nseq = ($nseq_remaining < $nseq_per) ? $nseq_remaining : $nseq_per;
-    $sqfile->fetch_consecutive_seqs($cur_nseq, "", -1, $cur_file);
-    $nseq_remaining -= $cur_nseq;
-    if($do_verbose) { printf("$cur_file finished (%d seqs)\n", $cur_nseq); }
+# do the work, split the file up, all at once in C
+if($do_bytes) { 
+  my $fileAR = $sqfile->split_by_bytes($outfile_root, $nfiles);
+  if($do_verbose) { 
+    foreach my $fileR (@{$fileAR}) { printf("$fileR->[0] finished (%d bytes)\n", $fileR->[1]); }
   }
+  $sqfile->close_sqfile;
+  exit 0;
 }
-else { 
-  # less simple case: $do_nres is TRUE, we need to keep track of
-  # sequence lengths output do a check to see if we can get the length
-  # of all sequences, if not it's probably because there are some that
-  # are length 0, which causes problems with the indexing...
-  #
-  # if $do_randomize is also TRUE we need to open up all output file
-  # handles at once, we'll randomly choose which one to print each
-  # sequence to. We need to keep track of total length of all
-  # sequences output to each file so we know when to close them. Once
-  # a file is closed, we won't choose to write to it anymore, using
-  # the @map_A array as follows:
-  #
-  # We define an array @map_A with an element for each of the $nfiles
-  # output files. For each sequence, we randomly choose a number
-  # between 0 and $nfiles-1 to pick which output file to write the
-  # sequence to. Initially $map_A[$i] == $i, but when if we close file
-  # $i we set $map_A[$i] to $map_A[$nremaining-1], then choose a
-  # random int between 0 and $nremaining-1. This gets us a random
-  # sample without replacement.
-  my @map_A = ();
-  my @nres_per_out_A = ();
-  my $nres_tot_out = 0;  # total number of sequences output thus far
-  my @nseq_per_out_A = ();
-  my @out_filename_A = (); # array of file names
-  my @out_FH_A = ();
-  my $nopen = 0; # number of files that are still open
-  my $checkpoint_fraction_step = 0.05; # if($do_randomize) we will output update each time this fraction of total sequence has been output
-  my $checkpoint_fraction = $checkpoint_fraction_step;
-  my $checkpoint_nres = $checkpoint_fraction * $tot_nres;
-  my $fidx; # file index of current file in @out_filename_A and file handle in @out_FH_A
-  my $nres_this_seq = 0; # number of residues in current file
-  
-  # variables only used if $do_randomize
-  my $ridx; # randomly selected index in @map_A for current sequence
-  my $FH; # pointer to current file handle to print to
-
-  for($fidx = 0; $fidx < $nfiles; $fidx++) { $map_A[$fidx] = $fidx; }
-  for($fidx = 0; $fidx < $nfiles; $fidx++) { $nres_per_out_A[$fidx] = 0; }
-  for($fidx = 0; $fidx < $nfiles; $fidx++) { $nseq_per_out_A[$fidx] = 0; }
-  for($fidx = 0; $fidx < $nfiles; $fidx++) { $out_filename_A[$fidx] = $outfile_root. "." . ($fidx+1); } 
-
-  # if $do_randomize, open up all output file handles, else open only the first
-  if($do_randomize) { 
-    for($fidx = 0; $fidx < $nfiles; $fidx++) { 
-      open($out_FH_A[$fidx], ">", $out_filename_A[$fidx]) || die "ERROR, unable to open file $out_filename_A[$fidx] for writing";
-    }
-    $nopen = $nfiles; # will be decremented as we close files
-  }
-  else { 
-    $fidx = 0;
-    open(OUT, ">", $out_filename_A[$fidx]) || die "ERROR, unable to open file $out_filename_A[$fidx] for writing";
-    $nopen = 1; # will not be changed
-  }
-
-  while($nseq_remaining > 0) { 
-
-    # if $do_randomize, choose the file to output to
-    if($do_randomize) { 
-      $ridx = $rng->roll($nopen);
-      $fidx = $map_A[$ridx];
-      $FH = $out_FH_A[$fidx];
-    }
-    # else $fidx is not changed, only changed when we open a new file below
-
-    # fetch sequence and output it to the appropriate file handle
-    my $seqstring = $sqfile->fetch_consecutive_seqs(1, "", -1, undef);
-    # $seqstring is in this format: "><seqname><description of any length>\n<actual sequence>\n"
-    # with exactly two newlines, we want to know the length of actual sequence
-    chomp $seqstring;
-    if($seqstring =~ m/\n/g) { 
-      $nres_this_seq = length($seqstring) - pos($seqstring);
-      if($do_randomize) { 
-        print $FH $seqstring . "\n"; # appending \n is nec b/c we chomped it above
-      }
-      else { 
-        print OUT $seqstring . "\n"; # appending \n is nec b/c we chomped it above
-      }
-    }
-    else { die "ERROR error reading sequence number $sctr\n"; }
-    $nseq_remaining--;
-    
-    # update counts of sequences and residues for the file we just printed to
-    $nres_per_out_A[$fidx] += $nres_this_seq;
-    $nseq_per_out_A[$fidx]++;
-    $nres_tot_out += $nres_this_seq;
-
-    # if $do_randomize and we've reached our checkpoint output update
-    if($do_verbose && $do_randomize && ($nres_tot_out > $checkpoint_nres)) { 
-      my $nfiles_above_fract = 0;
-      for($fidx = 0; $fidx < $nfiles; $fidx++) { 
-        if($nres_per_out_A[$fidx] > ($checkpoint_fraction * $nres_per)) { $nfiles_above_fract++; }
-      }
-      printf("%.2f fraction of nucleotides output, %3d of %3d files are %.2f fraction complete.\n", $checkpoint_fraction, $nfiles_above_fract, $nfiles, $checkpoint_fraction);
-      $checkpoint_fraction += $checkpoint_fraction_step;
-      $checkpoint_nres = $checkpoint_fraction * $tot_nres;
-    }
-
-    # check if we need to close this file now, if so close it and open a new one (if nec)
-    if(($nres_per_out_A[$fidx] >= $nres_per) || ($nseq_remaining == 0)) { 
-      if($do_randomize) { 
-        if(($nopen > 1) || ($nseq_remaining == 0)) { 
-          # don't close the final file unless we have zero sequences left
-          close($out_FH_A[$fidx]);
-          if($do_verbose) { printf("$out_filename_A[$fidx] finished (%d seqs, %d residues)\n", $nseq_per_out_A[$fidx], $nres_per_out_A[$fidx]); }
-          # update map_A so we can no longer choose the file handle we just closed
-          if($ridx != ($nopen-1)) { # edge case
-            $map_A[$ridx] = $map_A[($nopen-1)];
-          }
-          $nopen--;
-        }
-      }
-      else { # $do_randomize is FALSE, need to open next file
-        close OUT;
-        if($do_verbose) { printf("$out_filename_A[$fidx] finished (%d seqs, %d residues)\n", $nseq_per_out_A[$fidx], $nres_per_out_A[$fidx]); }
-        if($nseq_remaining > 0) { 
-          $fidx++;
-          open(OUT, ">", $out_filename_A[$fidx]) || die "ERROR, unable to open file $out_filename_A[$fidx] for writing";
-        }
-      }
-    }
+my $fileAR = $sqfile->split($outfile_root, ($do_nfiles ? $nfiles : $nseq_per), $do_nfiles, $do_nres, $do_randomize, $seed, $do_binpack);
+if($do_verbose) { 
+  my $tot_nres = 0; # total number of residues in all files, only used if -r or -b
+  my $max_nres = 0; # max number of residues in any file, only used if -r or -b
+  foreach my $fileR (@{$fileAR}) { 
+    my ($cur_file, $cur_nseq, $cur_nres) = @{$fileR};
+    if($do_nres || $do_binpack) { printf("$cur_file finished (%d seqs, %d residues)\n", $cur_nseq, $cur_nres); }
+    else                        { printf("$cur_file finished (%d seqs)\n", $cur_nseq); }
+    $tot_nres += $cur_nres;
+    if($cur_nres > $max_nres) { $max_nres = $cur_nres; }
   }
-
-  # go through and close any files that are still open
-  if($do_randomize) { 
-    for($fidx = 0; $fidx < $nfiles; $fidx++) { 
-      if(! (tell($out_FH_A[$fidx]) == -1)) { 
-        # file still open, close it
-        close($out_FH_A[$fidx]);
-        if($do_verbose) { printf("$out_filename_A[$fidx] finished (%d seqs, %d residues)\n", $nseq_per_out_A[$fidx], $nres_per_out_A[$fidx]); }
-      }
-    }
+  # imbalance ratio: max residues in a file over mean residues per file, 1.0 is perfectly balanced
+  if(($do_nres || $do_binpack) && $tot_nres > 0) { 
+    printf("imbalance ratio (max/mean residues per file): %.3f\n", $max_nres / ($tot_nres / scalar(@{$fileAR})));
   }
 }
 
-# close sequence file and remove the ssi file if nec
+# close sequence file
 $sqfile->close_sqfile;
-if($cleanup_ssi) { 
-  if(-e "$in_sqfile.ssi") { unlink "$in_sqfile.ssi"; }
-}
 
 exit 0;
@@ -1,6 +1,6 @@
 use strict;
 use warnings FATAL => 'all';
-use Test::More tests => 54;
+use Test::More tests => 60;
 
 BEGIN {
     use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
@@ -81,6 +81,18 @@ for($mode = 0; $mode <= 1; $mode++) {
   $sqstring = $sqfile->fetch_seq_to_fasta_string("tRNA5-sample33");
   is ($sqstring, ">tRNA5-sample33\nAUAACCACAGCGAAGUGGCAUCGCACUUGACUUCCGAUCAAGAGACCGCGGUUCGAUUCC\nGCUUGGUGAUA\n");
 
+  # test fetch_seq_to_fasta_string with a description
+  $sqstring = $sqfile->fetch_seq_to_fasta_string("tRNA5-sample1");
+  is ($sqstring, ">tRNA5-sample1 description of this sequence\nGACGGGAUAGCGCAAUGGGCGCACCUCCCUACUCAGGAGGAGGCAGGGGUUCGUUUCCCC\nUUCCCGUCA\n");
+
+  # test fetch_seq_to_fasta_string with length a multiple of line length
+  $sqstring = $sqfile->fetch_seq_to_fasta_string("tRNA5-sample1", 23);
+  is ($sqstring, ">tRNA5-sample1 description of this sequence\nGACGGGAUAGCGCAAUGGGCGCA\nCCUCCCUACUCAGGAGGAGGCAG\nGGGUUCGUUUCCCCUUCCCGUCA\n");
+
+  # test fetch_seq_to_fasta_string with invalid line length
+  eval { $sqstring = $sqfile->fetch_seq_to_fasta_string("tRNA5-sample1", 0); };
+  like ($@, qr/invalid value for textw/);
+
   # test fetch_seq_to_sqstring
   $sqstring = $sqfile->fetch_seq_to_sqstring("tRNA5-sample33");
   is ($sqstring, "AUAACCACAGCGAAGUGGCAUCGCACUUGACUUCCGAUCAAGAGACCGCGGUUCGAUUCCGCUUGGUGAUA");
@@ -1,6 +1,6 @@
 use strict;
 use warnings FATAL => 'all';
-use Test::More tests => 18;
+use Test::More tests => 22;
 
 
 BEGIN {
@@ -20,6 +20,7 @@ my $seqstring;
 my @AA = ();
 my $tmpfile;
 my $tmpsqfile;
+my ($i, $expstring);
 
 # first test new without a forceDigital value
 $sqfile = Bio::Easel::SqFile->new({
@@ -93,5 +94,28 @@ for($mode = 0; $mode <= 1; $mode++) {
   # clean up files we just created
   unlink ($tmpfile);
   unlink ($tmpfile . ".ssi");
+
+  # overlapping, nested, adjacent and reverse complemented subseqs on several
+  # sources, out of file order, give the same result as fetching one at a time
+  @AA = ();
+  push(@AA, ["tRNA5-sample50/10-40", 10, 40, "tRNA5-sample50"]);
+  push(@AA, ["tRNA5-sample3/5-20",    5, 20, "tRNA5-sample3"]);
+  push(@AA, ["tRNA5-sample50/35-20", 35, 20, "tRNA5-sample50"]);
+  push(@AA, ["tRNA5-sample50/41-50", 41, 50, "tRNA5-sample50"]);
+  push(@AA, ["tRNA5-sample3/1-0",     1,  0, "tRNA5-sample3"]);
+  push(@AA, ["tRNA5-sample50/15-25", 15, 25, "tRNA5-sample50"]);
+  push(@AA, ["tRNA5-sample3/5-20",    5, 20, "tRNA5-sample3"]);
+  $expstring = "";
+  for($i = 0; $i < scalar(@AA); $i++) { 
+    $expstring .= $sqfile->fetch_subseq_to_fasta_string($AA[$i][3], $AA[$i][1], $AA[$i][2], 60);
+  }
+  is($sqfile->fetch_subseqs(\@AA, 60), $expstring, "fetch_subseqs() with overlapping subseqs out of order (mode: $mode)");
+
+  # in file order: sample3 subseqs sorted by coordinate, then sample50's
+  $expstring = "";
+  foreach $i (4, 1, 6, 0, 5, 2, 3) { 
+    $expstring .= $sqfile->fetch_subseq_to_fasta_string($AA[$i][3], $AA[$i][1], $AA[$i][2], 60);
+  }
+  is($sqfile->fetch_subseqs(\@AA, 60, undef, 1), $expstring, "fetch_subseqs() in file order (mode: $mode)");
 }
 
@@ -1,6 +1,6 @@
 use strict;
 use warnings FATAL => 'all';
-use Test::More tests => 18;
+use Test::More tests => 40;
 
 
 BEGIN {
@@ -65,4 +65,36 @@ for($mode = 0; $mode <= 1; $mode++) {
   # test fetch_seq_length_given_name
   my $L = $sqfile->fetch_seq_length_given_name("tRNA5-sample31");
   is ($L, 73, "fetch_seq_length_given_name() failed");
+
+  # test ssi_lengths and ssi_length_order, from the cached SSI key table
+  my @ssiLA = $sqfile->ssi_lengths();
+  is (scalar(@ssiLA), 100, "ssi_lengths() returned correct number of lengths");
+  is ($ssiLA[33], 72, "ssi_lengths() correct for SSI index 33");
+  my @unpackedA = unpack("q*", $sqfile->ssi_lengths("packed"));
+  is_deeply (\@unpackedA, \@ssiLA, "ssi_lengths() packed values identical to list values");
+  my @orderA = $sqfile->ssi_length_order();
+  my $is_sorted = 1;
+  for(my $i = 1; $i < scalar(@orderA); $i++) { 
+    if($ssiLA[$orderA[$i-1]] < $ssiLA[$orderA[$i]]) { $is_sorted = 0; }
+  }
+  is ($is_sorted . ":" . scalar(@orderA), "1:100", "ssi_length_order() sorted by decreasing length");
+  eval { $sqfile->fetch_seq_name_given_ssi_number(100); };
+  like ($@, qr/there is no sequence 100/, "fetch_seq_name_given_ssi_number() dies for out of range index");
+
+  # test all_names_lengths
+  my ($nameAR, $lenAR) = $sqfile->all_names_lengths();
+  is (scalar(@{$nameAR}), 100, "all_names_lengths() returned correct number of names");
+  $nres = 0;
+  foreach $L (@{$lenAR}) { $nres += $L; }
+  is ($nres, 7087, "all_names_lengths() lengths sum to correct number of residues");
+  is ($nameAR->[2] . ":" . $lenAR->[2], "tRNA5-sample3:67", "all_names_lengths() correct for 3rd seq");
+
+  # test next_name_length, file was rewound by all_names_lengths()
+  ($seqname, $L) = $sqfile->next_name_length();
+  is ($seqname . ":" . $L, "tRNA5-sample1:69", "next_name_length() correct for 1st seq");
+  ($seqname, $L) = $sqfile->fetch_next_seq_name_length();
+  is ($seqname . ":" . $L, "tRNA5-sample2:72", "fetch_next_seq_name_length() correct for 2nd seq");
+  $nseq = 2;
+  while(($seqname, $L) = $sqfile->next_name_length()) { $nseq++; }
+  is ($nseq, 100, "next_name_length() returns empty list at end of file");
 }
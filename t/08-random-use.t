@@ -1,6 +1,6 @@
 use strict;
 use warnings FATAL => 'all';
-use Test::More tests => 5;
+use Test::More tests => 20;
 
 BEGIN {
     use_ok( 'Bio::Easel::Random' ) || print "Bail out!\n";
@@ -23,3 +23,58 @@ is ($roll, 5);
 $roll = $rng->roll(6);
 is ($roll, 0);
 
+
+# test sample_indices(), both algorithms (Floyd's for k < n/4, partial Fisher-Yates otherwise)
+my ($idxAR, %seen, $ok, $k);
+foreach $k (10, 600) { 
+  $idxAR = $rng->sample_indices(1000, $k);
+  %seen = ();
+  $ok = (scalar(@{$idxAR}) == $k) ? 1 : 0;
+  foreach my $idx (@{$idxAR}) { 
+    if($idx < 0 || $idx >= 1000 || exists $seen{$idx}) { $ok = 0; }
+    $seen{$idx} = 1;
+  }
+  is($ok, 1, "sample_indices() returns $k distinct indices in range");
+}
+
+# deterministic for a given seed, for both return types
+my $rng1 = Bio::Easel::Random->new({ seed => 33 });
+my $rng2 = Bio::Easel::Random->new({ seed => 33 });
+is(join(",", @{$rng1->sample_indices(100000, 50)}), join(",", unpack("q*", $rng2->sample_indices(100000, 50, "packed"))), "sample_indices() deterministic for a given seed");
+is(scalar(@{$rng1->sample_indices(5, 5)}), 5, "sample_indices() with k == n");
+
+# test shuffle_indices()
+$idxAR = $rng1->shuffle_indices(1000);
+is(join(",", sort { $a <=> $b } @{$idxAR}), join(",", (0..999)), "shuffle_indices() returns a permutation");
+isnt(join(",", @{$idxAR}), join(",", (0..999)), "shuffle_indices() permutation is shuffled");
+$rng2->sample_indices(5, 5);
+is(join(",", @{$rng2->shuffle_indices(1000)}), join(",", @{$idxAR}), "shuffle_indices() deterministic for a given seed");
+
+# test spawn(): child streams depend only on the parent seed and the child's index
+my $parent1 = Bio::Easel::Random->new({ seed => 33 });
+my $parent2 = Bio::Easel::Random->new({ seed => 33 });
+$parent2->roll(6);
+my $spawn1AR = $parent1->spawn(8);
+my $spawn2AR = $parent2->spawn(3);
+is(scalar(@{$spawn1AR}), 8, "spawn() returns k generators");
+isa_ok($spawn1AR->[0], "Bio::Easel::Random");
+$ok = 1;
+for($k = 0; $k < 3; $k++) { 
+  if(join(",", map { $spawn1AR->[$k]->roll(1000000) } (1..20)) ne join(",", map { $spawn2AR->[$k]->roll(1000000) } (1..20))) { $ok = 0; }
+}
+is($ok, 1, "spawn() child i is the same regardless of number spawned or parent state");
+%seen = ();
+for($k = 0; $k < 8; $k++) { $seen{join(",", map { $spawn1AR->[$k]->roll(1000000) } (1..20))} = 1; }
+is(scalar(keys %seen), 8, "spawn() children have different streams");
+$spawn2AR = $parent2->spawn(1);
+my $spawn3AR = Bio::Easel::Random->new({ seed => 33 })->spawn(4);
+is(join(",", map { $spawn2AR->[0]->roll(1000000) } (1..20)), join(",", map { $spawn3AR->[3]->roll(1000000) } (1..20)), "spawn() numbering continues across calls");
+$spawn3AR = Bio::Easel::Random->new({ seed => 33 })->spawn(6);
+my $reseeded = Bio::Easel::Random->new({ seed => $spawn3AR->[5]->{seed} });
+is(join(",", map { $spawn3AR->[5]->roll(1000000) } (1..20)), join(",", map { $reseeded->roll(1000000) } (1..20)), "spawn() child's seed reproduces its stream");
+
+# invalid arguments
+eval { $rng->sample_indices(5, 6); };
+ok($@ =~ m/trying to choose 6 elements/, "sample_indices() dies with k > n");
+eval { $rng->shuffle_indices(5, "list"); };
+ok($@ =~ m/invalid return type/, "shuffle_indices() dies with invalid return type");
@@ -1,9 +1,10 @@
 use strict;
 use warnings FATAL => 'all';
-use Test::More tests => 3;
+use Test::More tests => 11;
 
 BEGIN {
     use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+    use_ok( 'Bio::Easel::Random' ) || print "Bail out!\n";
 }
 
 # test new 
@@ -21,3 +22,49 @@ my $wgt = $msa->get_sqwgt(2);
 $wgt = sprintf("%.2f", $wgt);
 is($wgt, "0.95");
 
+
+# test weighted_sample, with the GSC weights
+my ($i, $sample, $sample2, $rng, $ok);
+my %wgt_H = ();
+my $totwgt = 0.;
+my @nameA = ();
+for($i = 0; $i < $msa->nseq; $i++) { 
+  push(@nameA, $msa->get_sqname($i));
+  $wgt_H{$nameA[$i]} = $msa->get_sqwgt($i);
+  $totwgt += $msa->get_sqwgt($i);
+}
+
+# without replacement
+$rng    = Bio::Easel::Random->new({ seed => 7 });
+$sample = $msa->weighted_sample(2, $rng);
+is($sample->nseq, 2, "weighted_sample() without replacement returns k seqs");
+$ok = 1;
+my $prv = -1;
+for($i = 0; $i < $sample->nseq; $i++) { 
+  my $name = $sample->get_sqname($i);
+  my ($idx) = grep { $nameA[$_] eq $name } (0..$#nameA);
+  if(! defined $idx || $idx <= $prv) { $ok = 0; }
+  else { $prv = $idx; }
+  if($sample->get_sqwgt($i) != $wgt_H{$name}) { $ok = 0; }
+}
+is($ok, 1, "weighted_sample() without replacement returns distinct seqs in original order with their weights");
+is($msa->weighted_sample($msa->nseq, $rng)->nseq, $msa->nseq, "weighted_sample() without replacement with k == nseq returns all seqs");
+
+$rng     = Bio::Easel::Random->new({ seed => 7 });
+$sample2 = $msa->weighted_sample(2, $rng);
+is(join(",", map { $sample2->get_sqname($_) } (0..1)), join(",", map { $sample->get_sqname($_) } (0..1)), "weighted_sample() deterministic for a given seed");
+
+# with replacement, counts are weights of new msa, and proportional to original weights
+$sample = $msa->weighted_sample(10000, $rng, 1);
+my $totcount = 0;
+$ok = 1;
+for($i = 0; $i < $sample->nseq; $i++) { 
+  my $count = $sample->get_sqwgt($i);
+  $totcount += $count;
+  if(abs(($count / 10000.) - ($wgt_H{$sample->get_sqname($i)} / $totwgt)) > 0.03) { $ok = 0; }
+}
+is($totcount, 10000, "weighted_sample() with replacement: weights are counts that sum to k");
+is($ok, 1, "weighted_sample() with replacement: counts proportional to weights");
+
+eval { $msa->weighted_sample($msa->nseq + 1, $rng); };
+ok($@ =~ m/only \d+ have positive weight/, "weighted_sample() without replacement dies with k > nseq");
@@ -6,7 +6,7 @@
 # EPN, Thu Jan 16 09:49:03 2014
 use strict;
 use warnings FATAL => 'all';
-use Test::More tests => 17;
+use Test::More tests => 23;
 
 BEGIN {
   use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
@@ -61,6 +61,16 @@ for(my $f = 0; $f < $ntestfiles; $f++) {
   # note we pass in $zarg1, this is the version of the file with sequences in random order
   $diff = concatenate_reformat_maybe_sort_and_diff($miniappdir, "$tmpdir/$zarg1", "$tmpdir/$arg1", $nfiles4A[$f], 1); # 1: do sort before diff
   is($diff, "", "esl-ssplit $arg1 split correctly with -n and -r and -z options");
+
+  # test -n and -b, sequences are no longer in input order across files, so compare sorted like -z
+  run_command($scriptdir . "/esl-ssplit.pl -n -b $tmpdir/$arg1 $arg2");
+  $diff = concatenate_reformat_maybe_sort_and_diff($miniappdir, "$tmpdir/$zarg1", "$tmpdir/$arg1", $nfiles4A[$f], 1); # 1: do sort before diff
+  is($diff, "", "esl-ssplit $arg1 split correctly with -n and -b options");
+
+  # test -n and -bytes, sequences stay in input order
+  run_command($scriptdir . "/esl-ssplit.pl -n -bytes $tmpdir/$arg1 $arg2");
+  $diff = concatenate_reformat_maybe_sort_and_diff($miniappdir, "$tmpdir/$arg1", "$tmpdir/$arg1", $nfiles2A[$f], 0); # 0: don't sort before diff
+  is($diff, "", "esl-ssplit $arg1 split correctly with -n and -bytes options");
 }
 
 # now test other options: -d -oroot and -odir
@@ -72,7 +82,7 @@ run_command($scriptdir . "/esl-ssplit.pl -d $tmpdir/$arg1 $arg2");
 my $diff = concatenate_reformat_maybe_sort_and_diff($miniappdir, "$tmpdir/$arg1", "$tmpdir/$arg1", $nfiles1A[0], 0); # 0: don't sort before diff 
 is($diff, "", "esl-ssplit $arg1 split correctly with -d");
 my $ssi_exists = (-e "$tmpdir/$arg1.ssi") ? 1 : 0;
-is($ssi_exists, 1, "esl-ssplit -d correctly leaves .ssi file with -d option.");
+is($ssi_exists, 0, "esl-ssplit -d does not create a .ssi file, none is needed");
 push(@unlinkA, "$tmpdir/$arg1.ssi");
 
 # test -oroot
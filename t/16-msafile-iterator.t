@@ -0,0 +1,38 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 25;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSAFile' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/test-multi.sto";
+my @nameA   = ("test-three", "DsrA", "SSU_rRNA_bacteria");
+my @nseqA   = (3, 5, 3);
+my ($msafile, $msa, $i, $line);
+
+# do all tests in both digital (mode == 0) and text (mode == 1) modes
+for(my $mode = 0; $mode <= 1; $mode++) {
+  $msafile = Bio::Easel::MSAFile->new({
+      fileLocation => $alnfile,
+      forceText    => $mode,
+  });
+  isa_ok($msafile, "Bio::Easel::MSAFile");
+  is($msafile->format, "Stockholm", "format() returned correct format (mode $mode)");
+
+  $i = 0;
+  while($msa = $msafile->next_msa()) {
+    is($msa->get_name, $nameA[$i], "next_msa() read MSA $i correctly (mode $mode)");
+    is($msa->nseq,     $nseqA[$i], "next_msa() read MSA $i nseq correctly (mode $mode)");
+
+    # make sure offset points at the beginning of the record
+    open(IN, $alnfile) || die "ERROR unable to open $alnfile";
+    seek(IN, $msafile->offset, 0);
+    $line = <IN>;
+    close(IN);
+    is($line, "# STOCKHOLM 1.0\n", "offset() points at start of MSA $i (mode $mode)");
+    $i++;
+  }
+  is($msafile->nread, 3, "nread() correct after reading all MSAs (mode $mode)");
+  $msafile->close_msafile();
+}
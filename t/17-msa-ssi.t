@@ -0,0 +1,102 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 15;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/test-multi.sto";
+my $ssifile = $alnfile . ".ssi";
+my ($msa, $nali, $name);
+
+if(-e $ssifile) { unlink $ssifile; }
+
+# test create_ssi_index
+$nali = Bio::Easel::MSA::create_ssi_index($alnfile);
+is($nali, 3, "create_ssi_index indexed correct number of MSAs");
+ok(-e $ssifile, "create_ssi_index created SSI file");
+
+# do all tests in both digital (mode == 0) and text (mode == 1) modes
+for(my $mode = 0; $mode <= 1; $mode++) {
+  # read by name
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+      name         => "DsrA",
+      forceText    => $mode,
+  });
+  is($msa->get_name, "DsrA", "new() with name read correct MSA (mode $mode)");
+  is($msa->nseq,     5,      "new() with name read correct nseq (mode $mode)");
+
+  # read by accession
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+      name         => "RF00177",
+      forceText    => $mode,
+  });
+  is($msa->get_name, "SSU_rRNA_bacteria", "new() with accession read correct MSA (mode $mode)");
+
+  # revert_to_original rereads the same MSA
+  $msa->set_sqname(0, "Sauron");
+  $msa->revert_to_original;
+  is($msa->get_sqname(0), "AY138309.1/1-1552", "revert_to_original rereads named MSA (mode $mode)");
+}
+
+# nonexistent name
+eval { 
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+      name         => "Balrog",
+  });
+};
+ok($@, "new() with nonexistent name dies");
+
+unlink $ssifile;
+
+# a copy of the alignment file with the MSAs in reverse order,
+# indexed before the MSAs were reordered
+my $tmpfile = "./t/data/tmp.multi.sto";
+my $tmpssi  = $tmpfile . ".ssi";
+my @aliA    = ();
+open(IN, $alnfile) || die "ERROR unable to open $alnfile";
+{ local $/ = "//\n"; @aliA = <IN>; }
+close(IN);
+open(OUT, ">", $tmpfile) || die "ERROR unable to open $tmpfile for writing";
+print OUT @aliA;
+close(OUT);
+Bio::Easel::MSA::create_ssi_index($tmpfile);
+open(OUT, ">", $tmpfile) || die "ERROR unable to open $tmpfile for writing";
+print OUT reverse @aliA;
+close(OUT);
+
+# index older than alignment file is recreated
+utime(time - 100, time - 100, $tmpssi);
+$msa = Bio::Easel::MSA->new({
+    fileLocation => $tmpfile,
+    name         => "DsrA",
+});
+is($msa->get_name, "DsrA", "new() with name recreates out of date SSI index");
+
+# stale index not older than alignment file is detected
+open(OUT, ">", $tmpfile) || die "ERROR unable to open $tmpfile for writing";
+print OUT @aliA;
+close(OUT);
+utime(time + 100, time + 100, $tmpssi);
+eval { 
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $tmpfile,
+      name         => "SSU_rRNA_bacteria",
+  });
+};
+ok($@, "new() with name and stale SSI index dies");
+
+# unless forceIndex is set
+$msa = Bio::Easel::MSA->new({
+    fileLocation => $tmpfile,
+    name         => "SSU_rRNA_bacteria",
+    forceIndex   => 1,
+});
+is($msa->get_name, "SSU_rRNA_bacteria", "new() with name and forceIndex recreates SSI index");
+
+unlink $tmpfile;
+unlink $tmpssi;
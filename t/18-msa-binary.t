@@ -0,0 +1,69 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 12;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile  = "./t/data/test-pp-sa-ss.sto";
+my $binfile  = "./t/data/test-pp-sa-ss.bin";
+my $outfile1 = "./t/data/test-pp-sa-ss.1.sto";
+my $outfile2 = "./t/data/test-pp-sa-ss.2.sto";
+my ($msa1, $msa2, $line1, $line2, $bytes);
+
+$msa1 = Bio::Easel::MSA->new({
+    fileLocation => $alnfile,
+});
+isa_ok($msa1, "Bio::Easel::MSA");
+
+# test save_binary and load_binary as a class method
+$msa1->weight_GSC();
+$msa1->save_binary($binfile);
+ok(-e $binfile, "save_binary created binary file");
+
+$msa2 = Bio::Easel::MSA->load_binary($binfile);
+isa_ok($msa2, "Bio::Easel::MSA");
+is($msa2->nseq,     $msa1->nseq,     "load_binary() nseq matches");
+is($msa2->alen,     $msa1->alen,     "load_binary() alen matches");
+is($msa2->checksum, $msa1->checksum, "load_binary() checksum matches");
+is(sprintf("%.4f", $msa2->get_sqwgt(1)), sprintf("%.4f", $msa1->get_sqwgt(1)), "load_binary() weights match");
+
+# make sure all annotation was preserved by comparing Stockholm output
+$msa1->write_msa($outfile1);
+$msa2->write_msa($outfile2);
+open(IN1, $outfile1) || die "ERROR unable to open $outfile1";
+open(IN2, $outfile2) || die "ERROR unable to open $outfile2";
+$line1 = join("", <IN1>);
+$line2 = join("", <IN2>);
+close(IN1);
+close(IN2);
+is($line2, $line1, "load_binary() preserved all annotation");
+
+# test revert_to_original reloads binary file
+$msa2->set_sqname(0, "Sauron");
+$msa2->revert_to_original();
+is($msa2->get_sqname(0), "se-sample1", "revert_to_original reloads binary file");
+
+# corrupt the file and make sure the checksum catches it
+open(BIN, "+<", $binfile) || die "ERROR unable to open $binfile";
+binmode(BIN);
+seek(BIN, -5, 2);
+read(BIN, $bytes, 1);
+seek(BIN, -5, 2);
+print BIN chr((ord($bytes) + 1) % 256);
+close(BIN);
+eval { $msa2 = Bio::Easel::MSA->load_binary($binfile); };
+like($@, qr/checksum/, "load_binary() detects corrupt file");
+
+# text mode MSAs can't be saved
+$msa1 = Bio::Easel::MSA->new({
+    fileLocation => $alnfile,
+    forceText    => 1,
+});
+eval { $msa1->save_binary($binfile); };
+ok($@, "save_binary() dies for text mode MSA");
+
+unlink $binfile;
+unlink $outfile1;
+unlink $outfile2;
@@ -0,0 +1,52 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 15;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/RF00014-seed.sto";
+my ($msa, $pidmxHR, $i, $j, $nseq, $nmismatch);
+my (@usemeA, @keepmeA, @keepme2A, @avgA, @avg2A);
+
+# do all tests in both digital (mode == 0) and text (mode == 1) modes
+for(my $mode = 0; $mode <= 1; $mode++) {
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+      forceText    => $mode,
+  });
+  $nseq = $msa->nseq;
+
+  # full matrix must match pairwise_identity() exactly
+  $pidmxHR = $msa->pid_matrix();
+  is(length($pidmxHR->{"packed"}), 8 * $nseq * $nseq, "pid_matrix() returned full matrix (mode $mode)");
+  $nmismatch = 0;
+  for($i = 0; $i < $nseq; $i++) { 
+    for($j = 0; $j < $nseq; $j++) { 
+      if($msa->pid_matrix_get($pidmxHR, $i, $j) != $msa->pairwise_identity($i, $j)) { $nmismatch++; }
+    }
+  }
+  is($nmismatch, 0, "pid_matrix() values identical to pairwise_identity() (mode $mode)");
+
+  # single row matrix, queried in both orientations
+  $pidmxHR = $msa->pid_matrix([2]);
+  is(length($pidmxHR->{"packed"}), 8 * $nseq, "pid_matrix() returned single row (mode $mode)");
+  is($msa->pid_matrix_get($pidmxHR, 0, 2), $msa->pairwise_identity(0, 2), "pid_matrix_get() symmetric lookup (mode $mode)");
+  eval { $msa->pid_matrix_get($pidmxHR, 0, 1); };
+  like($@, qr/not a row/, "pid_matrix_get() dies if neither seq is a row (mode $mode)");
+
+  # find_most_divergent_seq_from_subset() gives same result with and without precomputed matrix
+  @usemeA = ();
+  for($i = 0; $i < $nseq; $i++) { $usemeA[$i] = ($i < 2) ? 1 : 0; }
+  $pidmxHR = $msa->pid_matrix();
+  @keepmeA  = $msa->find_most_divergent_seq_from_subset(\@usemeA);
+  @keepme2A = $msa->find_most_divergent_seq_from_subset(\@usemeA, $pidmxHR);
+  is(scalar(@keepme2A), 3, "find_most_divergent_seq_from_subset() with matrix returned 3 values (mode $mode)");
+  is_deeply(\@keepmeA, \@keepme2A, "find_most_divergent_seq_from_subset() with matrix gives same result (mode $mode)");
+
+  # avg_min_max_pid_to_seq() gives same result with full matrix
+  @avgA  = $msa->avg_min_max_pid_to_seq(1);
+  @avg2A = $msa->avg_min_max_pid_to_seq(1, undef, $pidmxHR);
+  is_deeply(\@avgA, \@avg2A, "avg_min_max_pid_to_seq() with matrix gives same result (mode $mode)");
+}
@@ -0,0 +1,55 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 14;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/RF00014-seed.sto";
+my @outfileA = ("./t/data/tmp-qc.fam", "./t/data/tmp-qc.seq", "./t/data/tmp-qc.bp");
+my ($msa, $nthreads, $i, $nseq, $idf, $n, @usemeA, @keepmeA);
+my %pidmxH   = (); # key: nthreads, value: packed pid matrix
+my %avgidH   = (); # key: nthreads, value: average_id()
+my %qcH      = (); # key: nthreads, value: concatenated rfam_qc_stats() output
+my %filterH  = (); # key: nthreads, value: filter_msa_subset_target_nseq() results
+
+$msa = Bio::Easel::MSA->new({
+    fileLocation => $alnfile,
+});
+is($msa->get_num_threads(), 1, "get_num_threads() default is 1");
+eval { $msa->set_num_threads(0); };
+like($@, qr/positive integer/, "set_num_threads(0) dies");
+
+foreach $nthreads (1, 2, 4) { 
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+  });
+  $msa->set_num_threads($nthreads);
+  is($msa->get_num_threads(), $nthreads, "set_num_threads($nthreads) worked");
+
+  $pidmxH{$nthreads} = $msa->pid_matrix()->{"packed"};
+  $avgidH{$nthreads} = $msa->average_id(100);
+
+  $msa->rfam_qc_stats(@outfileA);
+  $qcH{$nthreads} = "";
+  foreach my $outfile (@outfileA) { 
+    open(IN, $outfile) || die "ERROR unable to open $outfile";
+    while(my $line = <IN>) { $qcH{$nthreads} .= $line; }
+    close(IN);
+    unlink $outfile;
+  }
+
+  $nseq = $msa->nseq;
+  @usemeA = ();
+  for($i = 0; $i < $nseq; $i++) { $usemeA[$i] = 1; }
+  ($idf, $n) = $msa->filter_msa_subset_target_nseq(\@usemeA, 3, \@keepmeA);
+  $filterH{$nthreads} = join(",", $idf, $n, @keepmeA);
+}
+
+foreach $nthreads (2, 4) { 
+  ok($pidmxH{$nthreads} eq $pidmxH{1},   "pid_matrix() identical with $nthreads threads");
+  is($avgidH{$nthreads},  $avgidH{1},    "average_id() identical with $nthreads threads");
+  is($qcH{$nthreads},     $qcH{1},       "rfam_qc_stats() identical with $nthreads threads");
+  is($filterH{$nthreads}, $filterH{1},   "filter_msa_subset_target_nseq() identical with $nthreads threads");
+}
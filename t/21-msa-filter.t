@@ -0,0 +1,81 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 17;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/RF00014-seed.sto";
+my ($msa, $nseq, $i, $idf, $n, $exp_idf, $exp_n);
+my (@usemeA, @keepmeA, @expA);
+
+# reference implementation of the greedy filter, using pairwise_identity()
+sub ref_filter { 
+  my ($msa, $usemeAR, $idf, $keepmeAR) = @_;
+  my $nseq  = $msa->nseq;
+  my $nkeep = 0;
+  for(my $i = 0; $i < $nseq; $i++) { 
+    $keepmeAR->[$i] = ($usemeAR->[$i]) ? 1 : 0;
+    if($keepmeAR->[$i]) { $nkeep++; }
+  }
+  for(my $i = 0; $i < $nseq; $i++) { 
+    next if(! $keepmeAR->[$i]);
+    for(my $j = $i+1; $j < $nseq; $j++) { 
+      if($keepmeAR->[$j] && $msa->pairwise_identity($i, $j) > $idf) { 
+        $keepmeAR->[$j] = 0;
+        $nkeep--;
+      }
+    }
+  }
+  return $nkeep;
+}
+
+# reference implementation of the binary search over thresholds
+sub ref_filter_target_nseq { 
+  my ($msa, $usemeAR, $nseq, $keepmeAR) = @_;
+  my $f_min = 0.01;
+  my $f_opt = 0.01;
+  my $f_prv = 1.0;
+  my $f_cur = $f_min;
+  my $diff  = abs($f_prv - $f_cur);
+  my $n;
+  while($diff > 0.00999) { 
+    $n = ref_filter($msa, $usemeAR, $f_cur, $keepmeAR);
+    $f_prv = $f_cur;
+    if($n > $nseq) { $f_cur -= ($diff / 2.); }
+    else { 
+      if($f_cur > $f_opt) { $f_opt = $f_cur; }
+      $f_cur += ($diff / 2.); 
+    }
+    $f_cur = (int(($f_cur * 100) + 0.5)) / 100;
+    $diff = abs($f_prv - $f_cur);
+  }
+  $n = ref_filter($msa, $usemeAR, $f_opt, $keepmeAR);
+  return ($f_opt, $n);
+}
+
+# do all tests in both digital (mode == 0) and text (mode == 1) modes
+for(my $mode = 0; $mode <= 1; $mode++) {
+  $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+      forceText    => $mode,
+  });
+  $nseq = $msa->nseq;
+
+  # all seqs used, and every other seq used
+  foreach my $every (1, 2) { 
+    @usemeA = ();
+    for($i = 0; $i < $nseq; $i++) { $usemeA[$i] = ($i % $every == 0) ? 1 : 0; }
+
+    $exp_n = ref_filter($msa, \@usemeA, 0.7, \@expA);
+    $n     = $msa->filter_msa_subset(\@usemeA, 0.7, \@keepmeA);
+    is($n, $exp_n, "filter_msa_subset() kept correct number of seqs (every $every, mode $mode)");
+    is_deeply(\@keepmeA, \@expA, "filter_msa_subset() kept correct seqs (every $every, mode $mode)");
+
+    ($exp_idf, $exp_n) = ref_filter_target_nseq($msa, \@usemeA, 2, \@expA);
+    ($idf, $n)         = $msa->filter_msa_subset_target_nseq(\@usemeA, 2, \@keepmeA);
+    is($idf, $exp_idf, "filter_msa_subset_target_nseq() found correct threshold (every $every, mode $mode)");
+    is_deeply(\@keepmeA, \@expA, "filter_msa_subset_target_nseq() kept correct seqs (every $every, mode $mode)");
+  }
+}
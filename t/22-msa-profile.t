@@ -0,0 +1,53 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 20;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+    use_ok( 'Bio::Easel::MSA::Profile' ) || print "Bail out!\n";
+}
+
+###########################################################
+# Profiles only work on digitized alignments, so we force #
+# digital mode for these tests.                           #
+###########################################################
+my $alnfile         = "./t/data/test.sto";
+my $rfamfile_allgap = "./t/data/RF00014-seed-allgap.sto";
+my ($msa, $profile, @entA, @consA, @covA);
+
+$msa = Bio::Easel::MSA->new({
+    fileLocation => $alnfile, 
+});
+$profile = $msa->profile();
+isa_ok($profile, "Bio::Easel::MSA::Profile");
+is($profile->alen, $msa->alen, "profile alen() correct");
+is($profile->nseq, $msa->nseq, "profile nseq() correct");
+is($profile->use_weights, 0,   "profile use_weights() correct");
+is($profile->most_informative_sequence(0.5), "-WRSWCUUCGGMWSKSRCV-MMA-BYS-", "profile most_informative_sequence() worked");
+is($profile->most_informative_sequence(0.5), $msa->most_informative_sequence(0.5, 0), "profile MIS matches most_informative_sequence()");
+is(length($profile->consensus(0.5)), $msa->alen, "profile consensus() has correct length");
+
+$msa = Bio::Easel::MSA->new({
+    fileLocation => $rfamfile_allgap, 
+});
+$profile = Bio::Easel::MSA::Profile->new({ msa => $msa });
+@entA = $profile->entropy();
+is(int(($entA[1] * 100) + 0.5), 200, "profile entropy() worked (pos 2)");
+is(int(($entA[2] * 100) + 0.5), 137, "profile entropy() worked (pos 3)");
+is(int(($entA[4] * 100) + 0.5), 72,  "profile entropy() worked (pos 5)");
+is_deeply(\@entA, [$msa->pos_entropy()], "profile entropy() matches pos_entropy()");
+
+@consA = $profile->conservation();
+is(int(($consA[2] * 100) + 0.5),  60, "profile conservation() worked (pos 3)");
+is(int(($consA[4] * 100) + 0.5),  80, "profile conservation() worked (pos 5)");
+is_deeply(\@consA, [$msa->pos_conservation()], "profile conservation() matches pos_conservation()");
+
+@covA = $profile->coverage();
+is(int(($covA[1] * 100) + 0.5), 0, "profile coverage() worked for all gap column");
+is_deeply(\@covA, [$msa->alignment_coverage()], "profile coverage() matches alignment_coverage()");
+
+# weighted profile
+$msa->weight_GSC();
+$profile = $msa->profile(1);
+is($profile->use_weights, 1, "weighted profile use_weights() correct");
+is_deeply([$profile->entropy()], [$msa->pos_entropy(1)], "weighted profile entropy() matches pos_entropy(1)");
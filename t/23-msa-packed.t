@@ -0,0 +1,54 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 16;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+###########################################################
+# The 'stats' functions only work on digitized alignments #
+# so we force digital mode for these tests.               #
+###########################################################
+my $alnfile = "./t/data/test.sto";
+my ($packed, @listA, @unpackedA);
+
+my $msa = Bio::Easel::MSA->new({
+    fileLocation => $alnfile, 
+});
+my $alen = $msa->alen;
+
+# each per-position function returns the same values packed as in a list
+my %doubleH = (
+  "pos_fcbp"           => sub { return $msa->pos_fcbp(@_); },
+  "pos_covariation"    => sub { return $msa->pos_covariation(@_); },
+  "pos_entropy"        => sub { return $msa->pos_entropy(0, @_); },
+  "pos_conservation"   => sub { return $msa->pos_conservation(0, @_); },
+  "alignment_coverage" => sub { return $msa->alignment_coverage(undef, @_); },
+);
+foreach my $func (sort keys %doubleH) { 
+  @listA  = $doubleH{$func}->();
+  $packed = $doubleH{$func}->("packed");
+  is(length($packed), 8 * $alen, "$func() packed return has alen doubles");
+  @unpackedA = unpack("d*", $packed);
+  is_deeply(\@unpackedA, \@listA, "$func() packed values identical to list values");
+}
+
+@listA  = $msa->get_ss_cons_ct();
+$packed = $msa->get_ss_cons_ct("packed");
+is(length($packed), 4 * ($alen+1), "get_ss_cons_ct() packed return has alen+1 int32s");
+@unpackedA = unpack("l*", $packed);
+is_deeply(\@unpackedA, \@listA, "get_ss_cons_ct() packed values identical to list values");
+
+is_deeply([$msa->alignment_coverage(0.5)], [$msa->alignment_coverage()], "alignment_coverage() ignores its legacy idf argument");
+
+eval { $msa->pos_entropy(0, "bogus"); };
+like($@, qr/invalid return type/, "invalid return type dies");
+
+# PDL return, only if PDL is installed
+SKIP: {
+  skip "PDL not installed", 1 unless eval { require PDL; 1; };
+  my $pdl = $msa->pos_entropy(0, "pdl");
+  @listA  = $msa->pos_entropy(0);
+  is_deeply([$pdl->list], \@listA, "pos_entropy() pdl values identical to list values");
+}
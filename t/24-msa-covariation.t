@@ -0,0 +1,69 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 7;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my @alnfileA = ("./t/data/test.sto", "./t/data/RF00014-seed.sto", "./t/data/RF00014-seed-allgap.sto");
+my ($alnfile, $msa, $do_weights, $maxdiff, $apos);
+my (@covA, @expA);
+
+# reference implementation of the pairwise (O(N^2)) covariation statistic
+# that pos_covariation() used to calculate, from the text sequences
+sub ref_bp_canonical { 
+  my ($bp) = @_;
+  return ($bp =~ m/^(AU|UA|CG|GC|GU|UG|RY|YR|MK|KM|SS|WW)$/) ? 1 : 0;
+}
+sub ref_covariation { 
+  my ($msa) = @_;
+  my $nseq = $msa->nseq;
+  my $alen = $msa->alen;
+  my @ctA  = $msa->get_ss_cons_ct();
+  my (@sqA, @wgtA, @retA);
+  for(my $i = 0; $i < $nseq; $i++) { 
+    my $sq = uc($msa->get_sqstring_aligned($i));
+    $sq =~ tr/T._/U\-\-/;
+    push(@sqA,  $sq);
+    push(@wgtA, $msa->get_sqwgt($i));
+  }
+  for(my $apos = 1; $apos <= $alen; $apos++) { 
+    my $rpos = $ctA[$apos];
+    if(! defined $retA[($apos-1)]) { $retA[($apos-1)] = 0.; }
+    if($rpos <= $apos) { next; }
+    my ($cov, $cnt) = (0., 0.);
+    for(my $i = 0; $i < $nseq; $i++) { 
+      my $bp1 = substr($sqA[$i], $apos-1, 1) . substr($sqA[$i], $rpos-1, 1);
+      if($bp1 eq "--") { next; }
+      for(my $j = $i+1; $j < $nseq; $j++) { 
+        my $bp2 = substr($sqA[$j], $apos-1, 1) . substr($sqA[$j], $rpos-1, 1);
+        my $d = 0;
+        if(substr($bp1, 0, 1) ne substr($bp2, 0, 1)) { $d++; }
+        if(substr($bp1, 1, 1) ne substr($bp2, 1, 1)) { $d++; }
+        if(! (ref_bp_canonical($bp1) && ref_bp_canonical($bp2))) { $d *= -1; }
+        $cov += $d * ($wgtA[$i] + $wgtA[$j]);
+        $cnt += ($wgtA[$i] + $wgtA[$j]);
+      }
+    }
+    $retA[($apos-1)] = (abs($cnt) > 1E-10) ? $cov / $cnt : $cov;
+    $retA[($rpos-1)] = $retA[($apos-1)];
+  }
+  return @retA;
+}
+
+foreach $alnfile (@alnfileA) { 
+  foreach $do_weights (0, 1) { 
+    $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile, 
+    });
+    if($do_weights) { $msa->weight_GSC(); }
+    @covA = $msa->pos_covariation();
+    @expA = ref_covariation($msa);
+    $maxdiff = 0.;
+    for($apos = 0; $apos < $msa->alen; $apos++) { 
+      if(abs($covA[$apos] - $expA[$apos]) > $maxdiff) { $maxdiff = abs($covA[$apos] - $expA[$apos]); }
+    }
+    ok($maxdiff < 1E-6, "pos_covariation() matches pairwise reference ($alnfile, weights: $do_weights)");
+  }
+}
@@ -0,0 +1,67 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 13;
+
+BEGIN {
+    use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+##################################################################
+# We do all tests twice, once reading the sqfile read in text    #
+# mode and again reading the sqfile in digital mode - that's     # 
+# what the big for loop is for.                                  #
+##################################################################
+my $infile  = "./t/data/trna-100.fa";
+my $tmpfile = "t/data/tmp.batch.fa";
+my ($sqfile, $mode, $sqstring, $expstring, $seqname);
+
+# out of file order, with a duplicate
+my @nameA       = ("tRNA5-sample77", "tRNA5-sample3", "tRNA5-sample1", "tRNA5-sample50", "tRNA5-sample3", "tRNA5-sample100");
+my @sortednameA = sort { ($a =~ m/(\d+)$/)[0] <=> ($b =~ m/(\d+)$/)[0] } @nameA;
+
+sub slurp { 
+  my ($file) = @_;
+  open(IN, $file) || die "ERROR unable to open $file";
+  local $/ = undef;
+  my $ret = <IN>;
+  close(IN);
+  return $ret;
+}
+
+for($mode = 0; $mode <= 1; $mode++) { 
+  undef $sqfile;
+  $sqfile = Bio::Easel::SqFile->new({
+      fileLocation => $infile, 
+      forceDigital => $mode,
+      forceIndex   => 1, 
+  });
+
+  # batch fetch in order of names gives same result as fetching one at a time
+  $expstring = "";
+  foreach $seqname (@nameA) { $expstring .= $sqfile->fetch_seq_to_fasta_string($seqname, 60); }
+  $sqstring = $sqfile->fetch_seqs_given_names(\@nameA, 60);
+  is($sqstring, $expstring, "fetch_seqs_given_names() returns seqs in given order (mode $mode)");
+
+  $sqfile->fetch_seqs_given_names(\@nameA, 60, $tmpfile);
+  is(slurp($tmpfile), $expstring, "fetch_seqs_given_names() outputs seqs in given order (mode $mode)");
+
+  $expstring = "";
+  foreach $seqname (@nameA) { $expstring .= $sqfile->fetch_seq_to_fasta_string($seqname, -1); }
+  $sqstring = $sqfile->fetch_seqs_given_names(\@nameA, -1);
+  is($sqstring, $expstring, "fetch_seqs_given_names() works with unlimited line length (mode $mode)");
+
+  # batch fetch in file order
+  $expstring = "";
+  foreach $seqname (@sortednameA) { $expstring .= $sqfile->fetch_seq_to_fasta_string($seqname, 60); }
+  $sqstring = $sqfile->fetch_seqs_given_names(\@nameA, 60, undef, 1);
+  is($sqstring, $expstring, "fetch_seqs_given_names() returns seqs in file order (mode $mode)");
+
+  $sqfile->fetch_seqs_given_names(\@nameA, 60, $tmpfile, 1);
+  is(slurp($tmpfile), $expstring, "fetch_seqs_given_names() outputs seqs in file order (mode $mode)");
+
+  # a missing seq is an error
+  eval { $sqfile->fetch_seqs_given_names(["tRNA5-sample1", "tRNA6-sample1"], 60); };
+  like($@, qr/not found/, "fetch_seqs_given_names() dies for missing seq (mode $mode)");
+
+  unlink($tmpfile);
+}
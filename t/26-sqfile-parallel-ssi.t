@@ -0,0 +1,114 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 18;
+
+BEGIN {
+    use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+##################################################################
+# Index large FASTA files serially and in parallel and check     #
+# that the SSI indices are identical. We do this for a file with #
+# uniform line lengths (subseq lookup enabled) and one without.  #
+##################################################################
+my $tmpfile = "t/data/tmp.parallel-ssi.fa";
+my ($sqfile, $uniform, $nthreads, $serial_ssi, $parallel_ssi, $i, $j, $name, $seq);
+
+my @resA = ("A", "C", "G", "U");
+
+sub slurp {
+  my ($file) = @_;
+  open(IN, $file) || die "ERROR unable to open $file";
+  local $/ = undef;
+  my $ret = <IN>;
+  close(IN);
+  return $ret;
+}
+
+# write 3000 seqs of 1000 residues (about 3Mb), line length 60 if
+# $uniform, else line lengths vary between sequences
+sub write_fasta {
+  my ($file, $uniform) = @_;
+  srand(7);
+  open(OUT, ">", $file) || die "ERROR unable to open $file for writing";
+  for($i = 1; $i <= 3000; $i++) {
+    $seq = "";
+    for($j = 0; $j < 1000; $j++) { $seq .= $resA[int(rand(4))]; }
+    my $linelen = ($uniform) ? 60 : 50 + ($i % 20);
+    printf OUT (">seq%d%s\n", $i, ($i % 3 == 0) ? " description of seq$i" : "");
+    for($j = 0; $j < 1000; $j += $linelen) { print OUT substr($seq, $j, $linelen) . "\n"; }
+  }
+  close(OUT);
+}
+
+for($uniform = 1; $uniform >= 0; $uniform--) {
+  write_fasta($tmpfile, $uniform);
+
+  # serial index
+  $sqfile = Bio::Easel::SqFile->new({
+      fileLocation => $tmpfile,
+      forceIndex   => 1,
+  });
+  is($sqfile->get_num_threads(), 1, "get_num_threads() default is 1 (uniform: $uniform)");
+  $serial_ssi = slurp($tmpfile . ".ssi");
+  $sqfile->close_sqfile();
+  unlink $tmpfile . ".ssi";
+
+  # parallel index
+  $nthreads = 4;
+  $sqfile = Bio::Easel::SqFile->new({
+      fileLocation => $tmpfile,
+      forceIndex   => 1,
+      nthreads     => $nthreads,
+  });
+  is($sqfile->get_num_threads(), $nthreads, "get_num_threads() after nthreads passed to new() (uniform: $uniform)");
+  $parallel_ssi = slurp($tmpfile . ".ssi");
+  ok($serial_ssi eq $parallel_ssi, "parallel SSI index identical to serial SSI index (uniform: $uniform)");
+
+  # keys from every chunk can be fetched
+  is($sqfile->nseq_ssi(), 3000, "nseq_ssi() after parallel indexing (uniform: $uniform)");
+  is($sqfile->fetch_seq_length_given_name("seq2999"), 1000, "fetch_seq_length_given_name() after parallel indexing (uniform: $uniform)");
+  is($sqfile->fetch_seq_name_given_ssi_number(1500), "seq1501", "fetch_seq_name_given_ssi_number() after parallel indexing (uniform: $uniform)");
+  is(length($sqfile->fetch_subseq_to_sqstring("seq2000", 101, 200)), 100, "fetch_subseq_to_sqstring() after parallel indexing (uniform: $uniform)");
+
+  $sqfile->close_sqfile();
+  unlink $tmpfile;
+  unlink $tmpfile . ".ssi";
+}
+
+# A chunk of multi-line records followed by a chunk of single line
+# records, longer than the first chunk's line length. Both halves
+# are the same size so the second chunk starts at the first single
+# line record. Reading serially, those records make residues per 
+# line inconsistent, so subseq lookup must be disabled in both 
+# indices.
+srand(11);
+my @longA = ();
+open(OUT, ">", $tmpfile) || die "ERROR unable to open $tmpfile for writing";
+for($i = 1; $i <= 2200; $i++) {
+  my $len = ($i <= 1100) ? 1000 : 1016; # 1017 bytes of sequence data either way
+  $seq = "";
+  for($j = 0; $j < $len; $j++) { $seq .= $resA[int(rand(4))]; }
+  printf OUT (">seq%05d\n", $i);
+  if($i <= 1100) { for($j = 0; $j < $len; $j += 60) { print OUT substr($seq, $j, 60) . "\n"; } }
+  else           { print OUT $seq . "\n"; push(@longA, $seq); }
+}
+close(OUT);
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $tmpfile, forceIndex => 1 });
+$serial_ssi = slurp($tmpfile . ".ssi");
+$sqfile->close_sqfile();
+unlink $tmpfile . ".ssi";
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $tmpfile, forceIndex => 1, nthreads => 2 });
+$parallel_ssi = slurp($tmpfile . ".ssi");
+ok($serial_ssi eq $parallel_ssi, "parallel SSI index identical to serial SSI index (multi-line chunk then long single line chunk)");
+is($sqfile->fetch_subseq_to_sqstring("seq02000", 101, 200), substr($longA[899], 100, 100), "fetch_subseq_to_sqstring() from long single line record after parallel indexing");
+$sqfile->close_sqfile();
+unlink $tmpfile;
+unlink $tmpfile . ".ssi";
+
+# set_num_threads() rejects non-positive-integers
+eval {
+  $sqfile = Bio::Easel::SqFile->new({ fileLocation => "./t/data/trna-100.fa" });
+  $sqfile->set_num_threads(0);
+};
+ok($@ =~ m/number of threads must be a positive integer/, "set_num_threads(0) dies");
@@ -0,0 +1,160 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 28;
+
+BEGIN {
+    use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+    use_ok( 'Bio::Easel::Random' ) || print "Bail out!\n";
+}
+
+##################################################################
+# Test split() in each of its modes. We split a copy of          #
+# trna-100.fa so an existing .ssi index for it isn't used.       #
+##################################################################
+my $origfile = "./t/data/trna-100.fa";
+my $infile   = "t/data/tmp.split.fa";
+my $outroot  = "t/data/tmp.split.out";
+my ($sqfile, $fileAR, $i, $f, $ok, $mode);
+
+sub slurp {
+  my ($file) = @_;
+  open(IN, $file) || die "ERROR unable to open $file";
+  local $/ = undef;
+  my $ret = <IN>;
+  close(IN);
+  return $ret;
+}
+
+sub concat_and_unlink {
+  my ($fileAR) = @_;
+  my $ret = "";
+  foreach my $fileR (@{$fileAR}) {
+    $ret .= slurp($fileR->[0]);
+    unlink $fileR->[0];
+  }
+  return $ret;
+}
+
+my $orig = slurp($origfile);
+open(OUT, ">", $infile) || die "ERROR unable to open $infile for writing";
+print OUT $orig;
+close(OUT);
+
+# raw records and lengths, in file order
+my @recA = map { ">" . $_ } grep { $_ ne "" } split(/^>/m, $orig);
+my @lenA = ();
+foreach my $rec (@recA) {
+  my ($hdr, @lines) = split(/\n/, $rec);
+  push(@lenA, length(join("", @lines)));
+}
+
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $infile });
+
+# default: 30 seqs per file
+$fileAR = $sqfile->split($outroot, 30);
+is(scalar(@{$fileAR}), 4, "split() n seqs per file: correct number of files");
+is(join(",", map { $_->[1] } @{$fileAR}), "30,30,30,10", "split() n seqs per file: correct number of seqs per file");
+is(concat_and_unlink($fileAR), $orig, "split() n seqs per file: files concatenate to original");
+ok(! -e $infile . ".ssi", "split() does not create an SSI index");
+
+# n files
+$fileAR = $sqfile->split($outroot, 3, 1);
+is(join(",", map { $_->[1] } @{$fileAR}), "34,34,32", "split() n files: correct number of seqs per file");
+is(concat_and_unlink($fileAR), $orig, "split() n files: files concatenate to original");
+
+# n files, balanced residues
+$fileAR = $sqfile->split($outroot, 3, 1, 1);
+is(scalar(@{$fileAR}), 3, "split() n files balanced residues: correct number of files");
+$ok = 1;
+for($f = 0; $f < 2; $f++) { if($fileAR->[$f][2] < int((7087 + 2) / 3)) { $ok = 0; } }
+is($ok, 1, "split() n files balanced residues: all but the last file have at least nres/n residues");
+is($fileAR->[0][2] + $fileAR->[1][2] + $fileAR->[2][2], 7087, "split() n files balanced residues: residue counts add up");
+is(concat_and_unlink($fileAR), $orig, "split() n files balanced residues: files concatenate to original");
+
+# n files, balanced residues, random order, first without and then with an SSI index;
+# compare against the assignment made by esl-ssplit.pl's original per-sequence loop
+my $nfiles  = 5;
+my $nres_per = int((7087 + $nfiles - 1) / $nfiles);
+my $rng     = Bio::Easel::Random->new({ seed => 33 });
+my @map_A   = (0..($nfiles-1));
+my @nres_A  = (0) x $nfiles;
+my @exp_A   = ("") x $nfiles;
+my $nopen   = $nfiles;
+for($i = 0; $i < scalar(@recA); $i++) {
+  my $ridx = $rng->roll($nopen);
+  my $fidx = $map_A[$ridx];
+  $exp_A[$fidx]  .= $recA[$i];
+  $nres_A[$fidx] += $lenA[$i];
+  if(($nres_A[$fidx] >= $nres_per) || ($i == scalar(@recA)-1)) {
+    if(($nopen > 1) || ($i == scalar(@recA)-1)) {
+      if($ridx != ($nopen-1)) { $map_A[$ridx] = $map_A[($nopen-1)]; }
+      $nopen--;
+    }
+  }
+}
+for($mode = 0; $mode <= 1; $mode++) {
+  if($mode == 1) { $sqfile->create_ssi_index(); }
+  $fileAR = $sqfile->split($outroot, $nfiles, 1, 1, 1, 33);
+  is(scalar(@{$fileAR}), $nfiles, "split() random: correct number of files (ssi: $mode)");
+  $ok = 1;
+  for($f = 0; $f < $nfiles; $f++) {
+    if(slurp($fileAR->[$f][0]) ne $exp_A[$f]) { $ok = 0; }
+    if($fileAR->[$f][2] != $nres_A[$f])      { $ok = 0; }
+    unlink $fileAR->[$f][0];
+  }
+  is($ok, 1, "split() random: same assignment as esl-ssplit.pl's per-sequence loop with the same seed (ssi: $mode)");
+}
+
+# n files, longest-processing-time bin packing, compare against a
+# straightforward implementation
+$nfiles = 7;
+my @lpt_nres_A = (0) x $nfiles;
+my @lpt_fidx_A = ();
+foreach $i (sort { ($lenA[$b] <=> $lenA[$a]) || ($a <=> $b) } (0..(scalar(@recA)-1))) {
+  my $fidx = 0;
+  for($f = 1; $f < $nfiles; $f++) { if($lpt_nres_A[$f] < $lpt_nres_A[$fidx]) { $fidx = $f; } }
+  $lpt_fidx_A[$i] = $fidx;
+  $lpt_nres_A[$fidx] += $lenA[$i];
+}
+@exp_A = ("") x $nfiles;
+for($i = 0; $i < scalar(@recA); $i++) { $exp_A[$lpt_fidx_A[$i]] .= $recA[$i]; }
+$fileAR = $sqfile->split($outroot, $nfiles, 1, 0, 0, undef, 1);
+is(scalar(@{$fileAR}), $nfiles, "split() bin packing: correct number of files");
+$ok = 1;
+my $lpt_max = 0;
+for($f = 0; $f < $nfiles; $f++) {
+  if(slurp($fileAR->[$f][0]) ne $exp_A[$f]) { $ok = 0; }
+  if($fileAR->[$f][2] > $lpt_max) { $lpt_max = $fileAR->[$f][2]; }
+  unlink $fileAR->[$f][0];
+}
+is($ok, 1, "split() bin packing: same assignment as longest-processing-time bin packing");
+my $max_len = 0;
+foreach my $len (@lenA) { if($len > $max_len) { $max_len = $len; } }
+ok($lpt_max <= (7087 / $nfiles) + $max_len, "split() bin packing: max residues per file at most mean plus longest sequence");
+
+# n files by bytes
+$fileAR = $sqfile->split_by_bytes($outroot, 4);
+is(scalar(@{$fileAR}), 4, "split_by_bytes(): correct number of files");
+$ok = 1;
+foreach my $fileR (@{$fileAR}) { if(substr(slurp($fileR->[0]), 0, 1) ne ">" || -s $fileR->[0] != $fileR->[1]) { $ok = 0; } }
+is($ok, 1, "split_by_bytes(): each file starts with a sequence and has the reported size");
+is(concat_and_unlink($fileAR), $orig, "split_by_bytes(): files concatenate to original");
+$fileAR = $sqfile->split_by_bytes($outroot, 1000);
+is(scalar(@{$fileAR}), 100, "split_by_bytes(): at most one file per sequence");
+concat_and_unlink($fileAR);
+
+# invalid arguments
+eval { $sqfile->split($outroot, 0); };
+ok($@ =~ m/positive integer/, "split() dies with 0 seqs per file");
+eval { $sqfile->split($outroot, 3, 0, 1); };
+ok($@ =~ m/requires do_nfiles/, "split() dies with do_nres but not do_nfiles");
+eval { $sqfile->split($outroot, 3, 1, 0, 1); };
+ok($@ =~ m/requires do_nres/, "split() dies with do_randomize but not do_nres");
+eval { $sqfile->split($outroot, 3, 0, 0, 0, undef, 1); };
+ok($@ =~ m/requires do_nfiles/, "split() dies with do_binpack but not do_nfiles");
+eval { $sqfile->split($outroot, 3, 1, 1, 0, undef, 1); };
+ok($@ =~ m/incompatible/, "split() dies with do_binpack and do_nres");
+
+$sqfile->close_sqfile();
+unlink $infile;
+unlink $infile . ".ssi";
@@ -0,0 +1,109 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 16;
+
+BEGIN {
+    use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+    use_ok( 'Bio::Easel::Random' ) || print "Bail out!\n";
+}
+
+##################################################################
+# Test sample_seqs() reservoir sampling on a plain file and a    #
+# gzipped copy of it, which can only be read once.               #
+##################################################################
+my $infile  = "./t/data/trna-100.fa";
+my $gzfile  = "t/data/tmp.sample.fa.gz";
+my $outfile = "t/data/tmp.sample.out";
+my ($sqfile, $rng, $sample, $sample2, $ok, $i);
+
+sub slurp {
+  my ($file) = @_;
+  open(IN, $file) || die "ERROR unable to open $file";
+  local $/ = undef;
+  my $ret = <IN>;
+  close(IN);
+  return $ret;
+}
+
+# names of the seqs in a FASTA string
+sub names {
+  my ($str) = @_;
+  my @nameA = ();
+  while($str =~ m/^>(\S+)/mg) { push(@nameA, $1); }
+  return @nameA;
+}
+
+# all seqs unwrapped, so we can compare against sample_seqs() with textw -1
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $infile });
+my $all = $sqfile->fetch_consecutive_seqs(100, "", -1);
+$sqfile->close_sqfile();
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $infile });
+my @allnameA = names($all);
+my %idx_H = ();
+for($i = 0; $i < scalar(@allnameA); $i++) { $idx_H{$allnameA[$i]} = $i; }
+
+# k < nseq
+$rng    = Bio::Easel::Random->new({ seed => 11 });
+$sample = $sqfile->sample_seqs(10, $rng, undef, -1);
+my @nameA = names($sample);
+is(scalar(@nameA), 10, "sample_seqs() returns k seqs");
+my %seen_H = ();
+$ok = 1;
+for($i = 0; $i < scalar(@nameA); $i++) {
+  if(exists $seen_H{$nameA[$i]}) { $ok = 0; }
+  $seen_H{$nameA[$i]} = 1;
+  if($i > 0 && $idx_H{$nameA[$i]} <= $idx_H{$nameA[$i-1]}) { $ok = 0; }
+}
+is($ok, 1, "sample_seqs() returns distinct seqs in file order");
+$ok = 1;
+while($sample =~ m/^(>[^\n]*\n[^\n]*\n)/mg) { if(index($all, $1) == -1) { $ok = 0; } }
+is($ok, 1, "sample_seqs() returns seqs identical to the originals");
+
+# the file is rewound, so the same seed gives the same sample
+$rng     = Bio::Easel::Random->new({ seed => 11 });
+$sample2 = $sqfile->sample_seqs(10, $rng, undef, -1);
+is($sample2, $sample, "sample_seqs() is deterministic for a seed");
+$rng     = Bio::Easel::Random->new({ seed => 12 });
+$sample2 = $sqfile->sample_seqs(10, $rng, undef, -1);
+isnt($sample2, $sample, "sample_seqs() differs for a different seed");
+
+# k >= nseq
+$rng    = Bio::Easel::Random->new({ seed => 11 });
+is($sqfile->sample_seqs(100, $rng, undef, -1), $all, "sample_seqs() with k == nseq returns all seqs");
+is($sqfile->sample_seqs(500, $rng, undef, -1), $all, "sample_seqs() with k > nseq returns all seqs");
+
+# output to a file
+$rng = Bio::Easel::Random->new({ seed => 11 });
+is($sqfile->sample_seqs(10, $rng, $outfile, -1), "", "sample_seqs() to a file returns empty string");
+is(slurp($outfile), $sample, "sample_seqs() to a file writes the same sample");
+unlink $outfile;
+
+# every seq is sampled at some point
+%seen_H = ();
+$rng    = Bio::Easel::Random->new({ seed => 3 });
+for($i = 0; $i < 100; $i++) {
+  foreach my $name (names($sqfile->sample_seqs(5, $rng, undef, -1))) { $seen_H{$name} = 1; }
+}
+ok(scalar(keys %seen_H) > 90, "sample_seqs() samples from the whole file");
+
+# sampling from the middle of the file, which is repositioned there afterwards
+$sqfile->fetch_consecutive_seqs(50, "", -1);
+$sample2 = $sqfile->sample_seqs(100, $rng, undef, -1);
+is(join(",", names($sample2)), join(",", @allnameA[50..99]), "sample_seqs() samples from the rest of the file");
+is($sqfile->sample_seqs(100, $rng, undef, -1), $sample2, "sample_seqs() repositions the file where sampling started");
+
+eval { $sqfile->sample_seqs(0, $rng); };
+ok($@ =~ m/positive integer/, "sample_seqs() dies with k of 0");
+$sqfile->close_sqfile();
+
+# gzipped file, which can't be autodetected or rewound
+SKIP: {
+  skip "gzip not available", 2 if system("gzip -c $infile > $gzfile 2>/dev/null") != 0;
+  $sqfile = Bio::Easel::SqFile->new({ fileLocation => $gzfile, format => "fasta" });
+  $rng    = Bio::Easel::Random->new({ seed => 11 });
+  is($sqfile->sample_seqs(10, $rng, undef, -1), $sample, "sample_seqs() on gzipped file gives same sample");
+  $sqfile->close_sqfile();
+  eval { $sqfile = Bio::Easel::SqFile->new({ fileLocation => $gzfile, format => "notaformat" }); };
+  ok($@ =~ m/Unrecognized sequence file format/, "new() dies with an invalid format");
+  unlink $gzfile;
+}
@@ -0,0 +1,96 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 24;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+    use_ok( 'Bio::Easel::MSA::View' ) || print "Bail out!\n";
+}
+
+##################################################################
+# Compare views against the equivalent subset MSAs made by       #
+# copying with sequence_subset_and_reorder() and column_subset(),#
+# in digital and then in text mode.                              #
+##################################################################
+my $alnfile  = "./t/data/RF00014-seed.sto";
+my $tmpfile1 = "t/data/tmp.view1.sto";
+my $tmpfile2 = "t/data/tmp.view2.sto";
+my ($msa, $view, $sub, $mode, $i, $ok, @nameA, @colmaskA);
+
+sub slurp {
+  my ($file) = @_;
+  open(IN, $file) || die "ERROR unable to open $file";
+  local $/ = undef;
+  my $ret = <IN>;
+  close(IN);
+  return $ret;
+}
+
+for($mode = 0; $mode <= 1; $mode++) {
+  $msa = Bio::Easel::MSA->new({
+    fileLocation => $alnfile,
+    forceText    => $mode,
+  });
+  @nameA    = map { $msa->get_sqname($_) } (3, 0, 2);
+  @colmaskA = map { ($_ % 3 == 0) ? 0 : 1 } (0..$msa->alen-1);
+
+  $view = $msa->view([3, 0, 2], \@colmaskA);
+  $sub  = $msa->sequence_subset_and_reorder(\@nameA);
+  $sub->column_subset(\@colmaskA);
+
+  isa_ok($view, "Bio::Easel::MSA::View");
+  is($view->nseq . " " . $view->alen, $sub->nseq . " " . $sub->alen, "view nseq() and alen() correct (text: $mode)");
+
+  $ok = 1;
+  for($i = 0; $i < $view->nseq; $i++) {
+    if($view->get_sqname($i)             ne $sub->get_sqname($i))             { $ok = 0; }
+    if($view->get_sqstring_aligned($i)   ne $sub->get_sqstring_aligned($i))   { $ok = 0; }
+    if($view->get_sqstring_unaligned($i) ne $sub->get_sqstring_unaligned($i)) { $ok = 0; }
+  }
+  is($ok, 1, "view names and sequence strings match subset MSA (text: $mode)");
+
+  is($view->pid_matrix()->{"packed"}, $sub->pid_matrix()->{"packed"}, "view pid_matrix() matches subset MSA (text: $mode)");
+  is($view->pid_matrix_get($view->pid_matrix([1]), 1, 2), $sub->pairwise_identity(1, 2), "view pid_matrix_get() matches pairwise_identity() of subset MSA (text: $mode)");
+
+  $view->write_msa($tmpfile1);
+  $sub->write_msa($tmpfile2);
+  is(slurp($tmpfile1), slurp($tmpfile2), "view write_msa() matches subset MSA (text: $mode)");
+  unlink $tmpfile1;
+  unlink $tmpfile2;
+
+  if($mode == 0) {
+    is(join(",", $view->profile()->entropy()), join(",", $sub->profile()->entropy()), "view profile() entropy matches subset MSA");
+    is($view->profile()->most_informative_sequence(0.5), $sub->profile()->most_informative_sequence(0.5), "view profile() most informative sequence matches subset MSA");
+  }
+}
+
+# names instead of indices, and a view of everything
+$view = Bio::Easel::MSA::View->new({ msa => $msa, names => \@nameA });
+is($view->get_msa_sqidx(0), 3, "view created from names");
+$view = $msa->view();
+is($view->nseq . " " . $view->alen, $msa->nseq . " " . $msa->alen, "view of all sequences and columns");
+
+# invalid arguments
+eval { $view = $msa->view([0, 1, 0]); };
+ok($@ =~ m/listed twice/, "view with a sequence listed twice dies");
+eval { $view = $msa->view(undef, [1, 0]); };
+ok($@ =~ m/column mask of length/, "view with a column mask of the wrong length dies");
+
+# modifying the parent invalidates the view
+$view = $msa->view([0, 1]);
+@colmaskA = map { ($_ % 2 == 0) ? 1 : 0 } (0..$msa->alen-1);
+$msa->column_subset(\@colmaskA);
+eval { $view->get_sqstring_aligned(0); };
+ok($@ =~ m/parent MSA of view was modified/, "view dies after its parent's columns are removed");
+$msa->read_msa();
+eval { $view->nseq(); };
+ok($@ =~ m/parent MSA of view was freed or replaced/, "view dies after its parent is reread");
+$view = $msa->view([0, 1]);
+$msa->revert_to_original();
+eval { $view->nseq(); };
+ok($@ =~ m/parent MSA of view was freed or replaced/, "view dies after its parent is reverted to the original");
+$view = $msa->view([0, 1]);
+$msa->free_msa();
+eval { $view->get_sqstring_unaligned(0); };
+ok($@ =~ m/parent MSA of view was freed or replaced/, "view dies after its parent is freed");
+$msa->read_msa();
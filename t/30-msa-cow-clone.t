@@ -0,0 +1,83 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 23;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+##################################################################
+# Test copy-on-write clones made by clone_msa(1): edits to a     #
+# clone must not change its parent, or other clones, and vice    #
+# versa, in digital and then in text mode.                       #
+##################################################################
+my $alnfile = "./t/data/test-pp-sa-ss.sto";
+my $tmpfile = "t/data/tmp.cow.sto";
+my ($msa, $ref, $full, $cow, $cow2, $cow3, $cow4, $orig, $mode, @nameA, @colmaskA);
+
+# the alignment as a Stockholm string
+sub msa_string {
+  my ($msa) = @_;
+  $msa->write_msa($tmpfile, "stockholm");
+  open(IN, $tmpfile) || die "ERROR unable to open $tmpfile";
+  local $/ = undef;
+  my $ret = <IN>;
+  close(IN);
+  unlink $tmpfile;
+  return $ret;
+}
+
+for($mode = 0; $mode <= 1; $mode++) {
+  $msa = Bio::Easel::MSA->new({
+    fileLocation => $alnfile,
+    forceText    => $mode,
+  });
+  $orig = msa_string($msa);
+
+  $cow = $msa->clone_msa(1);
+  is(msa_string($cow), $orig, "clone_msa(1) creates an identical MSA (text: $mode)");
+
+  # edit the clone, compare against a full clone with the same edit
+  $full = $msa->clone_msa();
+  $cow->swap_gap_and_closest_residue(1, 12, 1);
+  $full->swap_gap_and_closest_residue(1, 12, 1);
+  is(msa_string($msa), $orig,              "parent unchanged after editing copy-on-write clone (text: $mode)");
+  is(msa_string($cow), msa_string($full), "copy-on-write clone edited like a full clone (text: $mode)");
+
+  # edit the parent, after making a clone and a clone of that clone
+  $cow2 = $msa->clone_msa(1);
+  $cow3 = $cow2->clone_msa(1);
+  $msa->swap_gap_and_closest_residue(0, 10, 0);
+  is(msa_string($cow2), $orig, "copy-on-write clone unchanged after editing parent (text: $mode)");
+
+  # remove columns from a clone
+  @colmaskA = map { ($_ % 2 == 0) ? 1 : 0 } (0..$msa->alen-1);
+  $ref = Bio::Easel::MSA->new({
+    fileLocation => $alnfile,
+    forceText    => $mode,
+  });
+  $ref->column_subset(\@colmaskA);
+  $cow2->column_subset(\@colmaskA);
+  is(msa_string($cow2), msa_string($ref), "column_subset() on copy-on-write clone (text: $mode)");
+  is(msa_string($cow3), $orig,            "clone of clone unchanged after column_subset() on its parent (text: $mode)");
+
+  # reorder a clone and then put it back
+  @nameA = map { $cow3->get_sqname($_) } (0..$cow3->nseq-1);
+  $cow3->reorder_all([reverse @nameA]);
+  is($cow3->get_sqname(0), $nameA[-1], "reorder_all() on copy-on-write clone (text: $mode)");
+  $cow3->reorder_all(\@nameA);
+  is(msa_string($cow3), $orig, "reorder_all() on copy-on-write clone and back (text: $mode)");
+
+  # free everything the remaining clone shared buffers with
+  undef $msa;
+  undef $cow;
+  undef $cow2;
+  is(msa_string($cow3), $orig, "copy-on-write clone valid after its parents are freed (text: $mode)");
+
+  # per-column annotation
+  $cow4 = $cow3->clone_msa(1);
+  $cow4->set_blank_ss_cons();
+  if($mode == 1) { $cow4->capitalize_based_on_rf(); }
+  is(msa_string($cow3), $orig, "parent unchanged after editing annotation of copy-on-write clone (text: $mode)");
+  isnt(msa_string($cow4), $orig, "copy-on-write clone annotation edited (text: $mode)");
+}
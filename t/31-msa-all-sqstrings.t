@@ -0,0 +1,86 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 25;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+##################################################################
+# Compare get_all_sqstrings_aligned(), get_sqstring_aligned(),   #
+# get_all_sqstrings_unaligned() and get_sqstring_unaligned()     #
+# against references that don't share their code: the aligned   #
+# sequences parsed from the Stockholm file here, and the         #
+# unaligned sequences written by write_msa() in "fasta" format,  #
+# in digital and then in text mode.                              #
+##################################################################
+my @alnfileA = ("./t/data/RF00014-seed.sto", "./t/data/test-pp-sa-ss.sto");
+my $tmpfile  = "t/data/tmp.all-sqstrings.fa";
+my ($alnfile, $msa, $mode, $i, $ok, $seqAR, $buffer, $stride, $offsetAR, @expA);
+
+# aligned sequences from a Stockholm file, in order, as Easel
+# would textize them in digital mode if $do_digital
+sub stockholm_aseqs {
+  my ($file, $do_digital) = @_;
+  my @nameA = ();
+  my %seqH  = ();
+  open(IN, $file) || die "ERROR unable to open $file";
+  while(my $line = <IN>) {
+    if($line =~ m/^#/ || $line =~ m/^\/\// || $line !~ m/\S/) { next; }
+    my ($name, $seq) = split(/\s+/, $line);
+    if(! exists $seqH{$name}) { push(@nameA, $name); $seqH{$name} = ""; }
+    $seqH{$name} .= $seq;
+  }
+  close(IN);
+  my @retA = map { $seqH{$_} } @nameA;
+  if($do_digital) { foreach (@retA) { $_ = uc($_); tr/._/--/; } }
+  return @retA;
+}
+
+# unaligned sequences from a FASTA file, in order
+sub fasta_seqs {
+  my ($file) = @_;
+  my @retA = ();
+  open(IN, $file) || die "ERROR unable to open $file";
+  while(my $line = <IN>) {
+    chomp $line;
+    if($line =~ m/^>/) { push(@retA, ""); }
+    else               { $retA[-1] .= $line; }
+  }
+  close(IN);
+  return @retA;
+}
+
+foreach $alnfile (@alnfileA) {
+  for($mode = 0; $mode <= 1; $mode++) {
+    $msa = Bio::Easel::MSA->new({
+      fileLocation => $alnfile,
+      forceText    => $mode,
+    });
+
+    # aligned
+    @expA  = stockholm_aseqs($alnfile, ($mode == 0) ? 1 : 0);
+    is_deeply([map { $msa->get_sqstring_aligned($_) } (0..$msa->nseq-1)], \@expA, "get_sqstring_aligned() matches alignment file ($alnfile, text: $mode)");
+    $seqAR = $msa->get_all_sqstrings_aligned();
+    is_deeply($seqAR, \@expA, "get_all_sqstrings_aligned() matches alignment file ($alnfile, text: $mode)");
+    ($buffer, $stride) = $msa->get_all_sqstrings_aligned(1);
+    $ok = ($stride == $msa->alen && length($buffer) == $msa->nseq * $msa->alen) ? 1 : 0;
+    for($i = 0; $i < $msa->nseq; $i++) { if(substr($buffer, $i * $stride, $stride) ne $expA[$i]) { $ok = 0; } }
+    is($ok, 1, "get_all_sqstrings_aligned(1) matches alignment file ($alnfile, text: $mode)");
+
+    # unaligned
+    $msa->write_msa($tmpfile, "fasta");
+    @expA = fasta_seqs($tmpfile);
+    unlink $tmpfile;
+    is_deeply([map { $msa->get_sqstring_unaligned($_) } (0..$msa->nseq-1)], \@expA, "get_sqstring_unaligned() matches write_msa() fasta ($alnfile, text: $mode)");
+    $seqAR = $msa->get_all_sqstrings_unaligned();
+    is_deeply($seqAR, \@expA, "get_all_sqstrings_unaligned() matches write_msa() fasta ($alnfile, text: $mode)");
+    ($buffer, $offsetAR) = $msa->get_all_sqstrings_unaligned(1);
+    $ok = (scalar(@{$offsetAR}) == $msa->nseq + 1 && $offsetAR->[$msa->nseq] == length($buffer)) ? 1 : 0;
+    for($i = 0; $i < $msa->nseq; $i++) {
+      if(substr($buffer, $offsetAR->[$i], $offsetAR->[$i+1] - $offsetAR->[$i]) ne $expA[$i]) { $ok = 0; }
+      if(length($expA[$i]) != $msa->get_sqlen($i)) { $ok = 0; }
+    }
+    is($ok, 1, "get_all_sqstrings_unaligned(1) matches write_msa() fasta and get_sqlen() ($alnfile, text: $mode)");
+  }
+}